@@ -17,7 +17,7 @@ BOOT_MODE_ADDR  equ 0x614
 
     jmp short start
     nop
-kernel_sectors: db 64           ; Patched by build script
+kernel_sectors: dw 64           ; Patched by build script (16-bit count)
 
 start:
     cli
@@ -41,20 +41,23 @@ start:
     mov si, msg
     call puts
 
+    ; TSC stamps around the load, for the kernel's bootchart
+    rdtsc
+    mov [BOOT_TSC_LOAD_START], eax
+    mov [BOOT_TSC_LOAD_START + 4], edx
+
     ; Load kernel via LBA
     mov word [dap_seg], KERNEL_LOAD_SEG
     mov word [dap_off], 0
 
 %ifdef CDROM_MODE
     mov dword [dap_lba], 21         ; CD: kernel at sector 21
-    xor cx, cx
-    mov cl, [kernel_sectors]
+    mov cx, [kernel_sectors]
     add cx, 3
     shr cx, 2                       ; Convert to 2048-byte sectors
 %else
     mov dword [dap_lba], 1          ; HDD: kernel at sector 1
-    xor cx, cx
-    mov cl, [kernel_sectors]
+    mov cx, [kernel_sectors]
 %endif
 
 .load:
@@ -88,6 +91,9 @@ start:
     jmp .load
 
 .done:
+    rdtsc
+    mov [BOOT_TSC_LOAD_END], eax
+    mov [BOOT_TSC_LOAD_END + 4], edx
     call detect_mem
     call setup_vesa
     
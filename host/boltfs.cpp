@@ -0,0 +1,396 @@
+/* ===========================================================================
+ * BOLT OS - boltfs: storage stack on a disk image (host build)
+ * ===========================================================================
+ * Runs the kernel's VFS, FAT32 and partition code against an image file so
+ * it can be exercised, timed and profiled (perf, valgrind) at native speed.
+ *
+ *   boltfs [-r] [-p N] <image> <command> [args]
+ *
+ * The image is either a bare filesystem (mkfs.vfat -F 32 -C disk.img 65536),
+ * a partitioned disk, or a BOLT harddisk.img with FAT32 after the kernel.
+ * =========================================================================== */
+
+#include "image_device.hpp"
+#include "drivers/timer/tsc.hpp"
+#include "storage/bench.hpp"
+#include "storage/block.hpp"
+#include "storage/detect.hpp"
+#include "storage/partition.hpp"
+#include "storage/ramfs.hpp"
+#include "storage/vfs.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+using namespace bolt;
+using namespace bolt::storage;
+
+static host::ImageFileBlockDevice image;
+
+static u64 now_ns() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u64>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+static bool check(VFSResult result, const char* what, const char* path) {
+    if (result == VFSResult::Success) return true;
+    fprintf(stderr, "%s %s: %s\n", what, path, vfs_result_string(result));
+    return false;
+}
+
+// ===========================================================================
+// Mounting
+// ===========================================================================
+
+// Same bring-up order as Storage::init, then the same root choice as
+// Storage::mount_root: a FAT32 partition first, else the whole disk
+static bool mount_image(const char* path, bool read_only, int partition) {
+    BlockDeviceManager::init();
+    PartitionManager::init();
+    FilesystemRegistry::init();
+    FilesystemDetector::init();
+    VFS::init();
+    
+    if (!image.open(path, read_only)) return false;
+    BlockDeviceManager::register_device(&image);
+    PartitionManager::scan_device(&image);
+    
+    const char* device = nullptr;
+    if (partition > 0) {
+        static char name[48];
+        snprintf(name, sizeof(name), "%s%d", image.get_info().name, partition);
+        if (!BlockDeviceManager::get_device_by_name(name)) {
+            fprintf(stderr, "%s: no partition %d\n", path, partition);
+            return false;
+        }
+        device = name;
+    } else {
+        for (u32 i = 0; i < BlockDeviceManager::get_device_count() && !device; i++) {
+            BlockDevice* dev = BlockDeviceManager::get_device(i);
+            if (dev->get_info().type == DeviceType::Partition &&
+                FilesystemDetector::detect(dev) == FilesystemType::FAT32) {
+                device = dev->get_info().name;
+            }
+        }
+        if (!device) device = image.get_info().name;
+    }
+    
+    return check(VFS::mount(device, "/", FilesystemType::Unknown), "mount", device);
+}
+
+// ===========================================================================
+// Commands
+// ===========================================================================
+
+static int cmd_info() {
+    const DeviceInfo& info = image.get_info();
+    printf("device      %s, %llu sectors (%llu MB)\n", info.name,
+           static_cast<unsigned long long>(info.total_sectors),
+           static_cast<unsigned long long>(image.size_mb()));
+    
+    for (u32 i = 0; i < BlockDeviceManager::get_device_count(); i++) {
+        BlockDevice* dev = BlockDeviceManager::get_device(i);
+        if (dev->get_info().type != DeviceType::Partition) continue;
+        PartitionDevice* part = static_cast<PartitionDevice*>(dev);
+        printf("partition   %s at LBA %llu, %llu sectors, %s\n", dev->get_info().name,
+               static_cast<unsigned long long>(part->get_start_lba()),
+               static_cast<unsigned long long>(dev->sector_count()),
+               FilesystemDetector::type_name(FilesystemDetector::detect(dev)));
+    }
+    
+    MountPoint* root = VFS::get_mount("/");
+    Filesystem* fs = root->fs;
+    printf("filesystem  %s on %s\n", fs->name(), root->device ? root->device->get_info().name : "-");
+    printf("space       %llu KB total, %llu KB free\n",
+           static_cast<unsigned long long>(fs->total_space() / 1024),
+           static_cast<unsigned long long>(fs->free_space() / 1024));
+    return 0;
+}
+
+static int cmd_ls(const char* path) {
+    u32 fd;
+    if (!check(VFS::opendir(path, fd), "opendir", path)) return 1;
+    
+    FileInfo info;
+    while (VFS::readdir(fd, info) == VFSResult::Success) {
+        if (info.is_directory()) {
+            printf("%-32s <DIR>\n", info.name);
+        } else {
+            printf("%-32s %llu\n", info.name, static_cast<unsigned long long>(info.size));
+        }
+    }
+    VFS::closedir(fd);
+    return 0;
+}
+
+// Copy a BOLT file to a host stream
+static int copy_out(const char* path, FILE* out) {
+    u32 fd;
+    if (!check(VFS::open(path, FileMode::Read, fd), "open", path)) return 1;
+    
+    static u8 buffer[64 * 1024];
+    u64 got = 0;
+    while (VFS::read(fd, buffer, sizeof(buffer), got) == VFSResult::Success && got > 0) {
+        fwrite(buffer, 1, got, out);
+    }
+    VFS::close(fd);
+    return 0;
+}
+
+static int cmd_get(const char* path, const char* host_path) {
+    FILE* out = fopen(host_path, "wb");
+    if (!out) {
+        perror(host_path);
+        return 1;
+    }
+    int rc = copy_out(path, out);
+    fclose(out);
+    return rc;
+}
+
+static int cmd_put(const char* host_path, const char* path) {
+    FILE* in = fopen(host_path, "rb");
+    if (!in) {
+        perror(host_path);
+        return 1;
+    }
+    
+    u32 fd;
+    if (!check(VFS::open(path, FileMode::Write | FileMode::Create | FileMode::Truncate, fd),
+               "open", path)) {
+        fclose(in);
+        return 1;
+    }
+    
+    static u8 buffer[64 * 1024];
+    int rc = 0;
+    usize got;
+    while ((got = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        u64 written = 0;
+        if (!check(VFS::write(fd, buffer, got, written), "write", path) || written != got) {
+            rc = 1;
+            break;
+        }
+    }
+    VFS::close(fd);
+    fclose(in);
+    return rc;
+}
+
+// ===========================================================================
+// Workload
+// ===========================================================================
+
+// Fill pattern that differs per file and per offset, so misplaced
+// clusters show up as mismatches
+static void fill_pattern(u8* buffer, usize size, u32 file, u64 offset) {
+    for (usize i = 0; i < size; i++) {
+        buffer[i] = static_cast<u8>((offset + i) * 31 + file * 7);
+    }
+}
+
+static void report(const char* phase, u64 ns, u64 bytes, u32 ops) {
+    double ms = ns / 1e6;
+    printf("%-8s %10.2f ms", phase, ms);
+    if (bytes) printf("  %9.1f MB/s", bytes / 1048576.0 / (ns / 1e9));
+    if (ops) printf("  %9.0f ops/s", ops / (ns / 1e9));
+    printf("\n");
+}
+
+// Create, read back, list and delete `files` files of `kb` KB each in a
+// scratch directory, writing and reading in 4 KB chunks
+static int cmd_workload(u32 files, u32 kb) {
+    static const char* dir = "/BOLTWL";
+    constexpr u32 CHUNK = 4096;
+    static u8 buffer[CHUNK];
+    static u8 expect[CHUNK];
+    char path[64];
+    u64 file_bytes = static_cast<u64>(kb) * 1024;
+    u64 total = file_bytes * files;
+    
+    if (VFS::exists(dir)) {
+        fprintf(stderr, "%s already exists\n", dir);
+        return 1;
+    }
+    if (!check(VFS::mkdir(dir), "mkdir", dir)) return 1;
+    
+    u64 start = now_ns();
+    for (u32 f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/F%05u.DAT", dir, f);
+        u32 fd;
+        if (!check(VFS::open(path, FileMode::Write | FileMode::Create, fd), "open", path)) return 1;
+        for (u64 off = 0; off < file_bytes; off += CHUNK) {
+            u32 n = file_bytes - off < CHUNK ? static_cast<u32>(file_bytes - off) : CHUNK;
+            fill_pattern(buffer, n, f, off);
+            u64 written = 0;
+            if (!check(VFS::write(fd, buffer, n, written), "write", path)) return 1;
+        }
+        VFS::close(fd);
+    }
+    VFS::sync_all();
+    report("write", now_ns() - start, total, files);
+    
+    start = now_ns();
+    u32 mismatches = 0;
+    for (u32 f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/F%05u.DAT", dir, f);
+        u32 fd;
+        if (!check(VFS::open(path, FileMode::Read, fd), "open", path)) return 1;
+        u64 off = 0;
+        u64 got = 0;
+        while (VFS::read(fd, buffer, CHUNK, got) == VFSResult::Success && got > 0) {
+            fill_pattern(expect, got, f, off);
+            if (memcmp(buffer, expect, got) != 0) mismatches++;
+            off += got;
+        }
+        if (off != file_bytes) mismatches++;
+        VFS::close(fd);
+    }
+    report("read", now_ns() - start, total, files);
+    
+    start = now_ns();
+    u32 listed = 0;
+    u32 fd;
+    if (!check(VFS::opendir(dir, fd), "opendir", dir)) return 1;
+    FileInfo info;
+    while (VFS::readdir(fd, info) == VFSResult::Success) {
+        if (info.is_file()) listed++;
+    }
+    VFS::closedir(fd);
+    report("readdir", now_ns() - start, 0, listed);
+    
+    start = now_ns();
+    for (u32 f = 0; f < files; f++) {
+        snprintf(path, sizeof(path), "%s/F%05u.DAT", dir, f);
+        if (!check(VFS::unlink(path), "unlink", path)) return 1;
+    }
+    VFS::rmdir(dir);
+    VFS::sync_all();
+    report("delete", now_ns() - start, 0, files);
+    
+    const DeviceStats& stats = image.get_stats();
+    printf("device   %llu sectors read, %llu written, %u requests\n",
+           static_cast<unsigned long long>(stats.sectors_read),
+           static_cast<unsigned long long>(stats.sectors_written), stats.io_operations);
+    
+    if (mismatches || listed != files) {
+        fprintf(stderr, "FAILED: %u mismatched files, %u of %u listed\n", mismatches, listed, files);
+        return 1;
+    }
+    return 0;
+}
+
+// ===========================================================================
+// Benchmarks
+// ===========================================================================
+
+static void print_csv(const BenchResult& result, void*) {
+    char line[StorageBench::CSV_LINE];
+    StorageBench::format_csv(result, line);
+    printf("%s\n", line);
+}
+
+// The storage benchmark suite, as the kernel's bench command runs it:
+// the image's filesystem, then a RAMFS mounted for the run. CSV on stdout.
+static int cmd_bench(bool quick) {
+    drivers::TSC::calibrate();
+    BenchConfig cfg = quick ? BenchConfig::quick() : BenchConfig::defaults();
+    
+    printf("%s\n", StorageBench::csv_header());
+    bool ok = StorageBench::run("/", VFS::get_root_fs()->name(), cfg, print_csv, nullptr);
+    
+    RAMFilesystem* ramfs = new RAMFilesystem();
+    if (!check(VFS::mount(ramfs, "/RAMBENCH"), "mount", "/RAMBENCH")) {
+        delete ramfs;
+        return 1;
+    }
+    ok &= StorageBench::run("/RAMBENCH", ramfs->name(), cfg, print_csv, nullptr);
+    VFS::unmount("/RAMBENCH");
+    return ok ? 0 : 1;
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+static void usage() {
+    fprintf(stderr,
+        "usage: boltfs [-r] [-p N] <image> <command> [args]\n"
+        "  -r                     open the image read-only\n"
+        "  -p N                   mount partition N instead of auto-detecting\n"
+        "commands:\n"
+        "  info                   device, partitions and filesystem\n"
+        "  ls [path]              list a directory\n"
+        "  cat <path>             print a file\n"
+        "  get <path> <host>      copy a file out of the image\n"
+        "  put <host> <path>      copy a file into the image\n"
+        "  mkdir <path>           create a directory\n"
+        "  rm <path>              delete a file or empty directory\n"
+        "  workload [files] [kb]  timed write/read/readdir/delete (default 64 x 256 KB)\n"
+        "  bench [quick]          storage benchmark suite, CSV on stdout\n"
+        "BOLT_LOW_WATER=1 runs memory reclaim on every allocation\n");
+}
+
+int main(int argc, char** argv) {
+    bool read_only = false;
+    int partition = 0;
+    int arg = 1;
+    
+    while (arg < argc && argv[arg][0] == '-') {
+        if (strcmp(argv[arg], "-r") == 0) {
+            read_only = true;
+            arg++;
+        } else if (strcmp(argv[arg], "-p") == 0 && arg + 1 < argc) {
+            partition = atoi(argv[arg + 1]);
+            arg += 2;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (argc - arg < 2) {
+        usage();
+        return 2;
+    }
+    
+    const char* cmd = argv[arg + 1];
+    int nargs = argc - arg - 2;
+    char** args = argv + arg + 2;
+    
+    if (!mount_image(argv[arg], read_only, partition)) return 1;
+    
+    int rc;
+    if (strcmp(cmd, "info") == 0) {
+        rc = cmd_info();
+    } else if (strcmp(cmd, "ls") == 0) {
+        rc = cmd_ls(nargs > 0 ? args[0] : "/");
+    } else if (strcmp(cmd, "cat") == 0 && nargs == 1) {
+        rc = copy_out(args[0], stdout);
+    } else if (strcmp(cmd, "get") == 0 && nargs == 2) {
+        rc = cmd_get(args[0], args[1]);
+    } else if (strcmp(cmd, "put") == 0 && nargs == 2) {
+        rc = cmd_put(args[0], args[1]);
+    } else if (strcmp(cmd, "mkdir") == 0 && nargs == 1) {
+        rc = check(VFS::mkdir(args[0]), "mkdir", args[0]) ? 0 : 1;
+    } else if (strcmp(cmd, "rm") == 0 && nargs == 1) {
+        VFSResult result = VFS::is_directory(args[0]) ? VFS::rmdir(args[0]) : VFS::unlink(args[0]);
+        rc = check(result, "rm", args[0]) ? 0 : 1;
+    } else if (strcmp(cmd, "workload") == 0) {
+        u32 files = nargs > 0 ? static_cast<u32>(atoi(args[0])) : 64;
+        u32 kb = nargs > 1 ? static_cast<u32>(atoi(args[1])) : 256;
+        rc = cmd_workload(files, kb);
+    } else if (strcmp(cmd, "bench") == 0) {
+        rc = cmd_bench(nargs > 0 && strcmp(args[0], "quick") == 0);
+    } else {
+        usage();
+        rc = 2;
+    }
+    
+    VFS::sync_all();
+    VFS::unmount("/");
+    image.close();
+    return rc;
+}
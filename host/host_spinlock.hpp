@@ -0,0 +1,36 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Host Spinlock
+ * ===========================================================================
+ * Stand-in for core/sys/spinlock.hpp in the host programs, which run the
+ * kernel allocators on one thread. There is nothing to wait for, so the
+ * lock only checks that the kernel code pairs its lock and unlock calls.
+ * =========================================================================== */
+
+#include "lib/types.hpp"
+
+#include <stdlib.h>
+
+namespace bolt {
+
+class Spinlock {
+public:
+    static constexpr u32 NO_OWNER = 0xFFFFFFFF;
+    
+    u32 lock() {
+        depth++;
+        return 0;
+    }
+    
+    void unlock(u32) {
+        if (depth == 0) abort();  // Unlock without a matching lock
+        depth--;
+    }
+    
+    bool is_held() const { return depth != 0; }
+
+private:
+    u32 depth = 0;
+};
+
+} // namespace bolt
@@ -0,0 +1,129 @@
+/* ===========================================================================
+ * BOLT OS - Image File Block Device Implementation (host build)
+ * =========================================================================== */
+
+#include "image_device.hpp"
+#include "lib/string.hpp"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace bolt::host {
+
+using namespace storage;
+
+ImageFileBlockDevice::ImageFileBlockDevice()
+    : fd(-1), data(nullptr), length(0), dirty(false)
+{
+    memset(&info, 0, sizeof(info));
+    init_stats();
+}
+
+ImageFileBlockDevice::~ImageFileBlockDevice() {
+    close();
+}
+
+bool ImageFileBlockDevice::open(const char* path, bool read_only) {
+    close();
+    
+    fd = ::open(path, read_only ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+        perror(path);
+        return false;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(SECTOR_SIZE) ||
+        st.st_size % SECTOR_SIZE != 0) {
+        fprintf(stderr, "%s: not a whole number of %u-byte sectors\n", path, SECTOR_SIZE);
+        close();
+        return false;
+    }
+    
+    // MAP_SHARED so writes land in the image file itself
+    int prot = read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* map = mmap(nullptr, st.st_size, prot, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        close();
+        return false;
+    }
+    
+    data = static_cast<u8*>(map);
+    length = st.st_size;
+    
+    // Looks like a hard disk to the rest of the stack: the manager names
+    // it hda and partitions become hda1, hda2...
+    info.type = DeviceType::ATA_HDD;
+    info.state = DeviceState::Ready;
+    info.sector_size = SECTOR_SIZE;
+    info.total_sectors = length / SECTOR_SIZE;
+    info.total_bytes = length;
+    info.read_only = read_only;
+    info.supports_lba48 = true;
+    str::cpy(info.model, "Image file");
+    info.name[0] = '\0';
+    return true;
+}
+
+void ImageFileBlockDevice::close() {
+    if (data) {
+        flush();
+        munmap(data, length);
+        data = nullptr;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+    length = 0;
+    info.state = DeviceState::Removed;
+}
+
+IOResult ImageFileBlockDevice::read_sectors(u64 lba, u32 count, void* buffer) {
+    if (!data) return IOResult::DeviceNotReady;
+    if (!buffer || count == 0) return IOResult::InvalidParameter;
+    if (lba + count > info.total_sectors) {
+        stats.read_errors++;
+        return IOResult::OutOfBounds;
+    }
+    
+    memcpy(buffer, data + lba * SECTOR_SIZE, static_cast<usize>(count) * SECTOR_SIZE);
+    stats.sectors_read += count;
+    stats.io_operations++;
+    return IOResult::Success;
+}
+
+IOResult ImageFileBlockDevice::write_sectors(u64 lba, u32 count, const void* buffer) {
+    if (!data) return IOResult::DeviceNotReady;
+    if (info.read_only) return IOResult::WriteProtected;
+    if (!buffer || count == 0) return IOResult::InvalidParameter;
+    if (lba + count > info.total_sectors) {
+        stats.write_errors++;
+        return IOResult::OutOfBounds;
+    }
+    
+    memcpy(data + lba * SECTOR_SIZE, buffer, static_cast<usize>(count) * SECTOR_SIZE);
+    stats.sectors_written += count;
+    stats.io_operations++;
+    dirty = true;
+    return IOResult::Success;
+}
+
+IOResult ImageFileBlockDevice::flush() {
+    if (!data) return IOResult::DeviceNotReady;
+    if (!dirty) return IOResult::Success;
+    
+    if (msync(data, length, MS_SYNC) != 0) {
+        stats.write_errors++;
+        return IOResult::WriteError;
+    }
+    dirty = false;
+    return IOResult::Success;
+}
+
+} // namespace bolt::host
@@ -0,0 +1,40 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Image File Block Device (host build)
+ * ===========================================================================
+ * A BlockDevice over a raw disk image mapped with mmap, so the kernel's
+ * storage stack can run against mkfs.vfat images (or a whole BOLT
+ * harddisk.img) as an ordinary Linux process.
+ * =========================================================================== */
+
+#include "storage/block.hpp"
+
+namespace bolt::host {
+
+class ImageFileBlockDevice : public storage::BlockDevice {
+public:
+    ImageFileBlockDevice();
+    ~ImageFileBlockDevice() override;
+    
+    // Map the image; the size must be a whole number of sectors
+    bool open(const char* path, bool read_only);
+    void close();
+    
+    // BlockDevice interface
+    storage::IOResult read_sectors(u64 lba, u32 count, void* buffer) override;
+    storage::IOResult write_sectors(u64 lba, u32 count, const void* buffer) override;
+    storage::IOResult flush() override;
+    bool is_ready() const override { return data != nullptr; }
+    const storage::DeviceInfo& get_info() const override { return info; }
+    const storage::DeviceStats& get_stats() const override { return stats; }
+    
+    static constexpr u32 SECTOR_SIZE = 512;
+
+private:
+    int fd;
+    u8* data;
+    u64 length;
+    bool dirty;                 // Written since the last flush
+};
+
+} // namespace bolt::host
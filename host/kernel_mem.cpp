@@ -0,0 +1,121 @@
+/* ===========================================================================
+ * BOLT OS - Kernel Allocators on the Host
+ * =========================================================================== */
+
+#include "kernel_mem.hpp"
+#include "core/memory/heap.hpp"
+#include "core/memory/pmm.hpp"
+#include "core/memory/slab.hpp"
+#include "core/memory/vmm.hpp"
+#include "core/sys/system.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+namespace bolt::sys {
+
+// Nothing detected on the host; the PMM skips its report
+SystemInfo* g_system = nullptr;
+
+} // namespace bolt::sys
+
+namespace bolt::mem {
+
+static constexpr u32 WINDOW_PAGES = (config::HEAP_VIRT_LIMIT - config::HEAP_VIRT_BASE) / config::PAGE_SIZE;
+
+// Frame behind each page of the growth window, 0 when unmapped
+static u32 window_frames[WINDOW_PAGES];
+
+static u32* window_slot(u32 virt) {
+    u32 offset = virt - config::HEAP_VIRT_BASE;
+    return offset < config::HEAP_VIRT_LIMIT - config::HEAP_VIRT_BASE ? &window_frames[offset / config::PAGE_SIZE] : nullptr;
+}
+
+static void* at(u32 addr) {
+    return reinterpret_cast<void*>(static_cast<usize>(addr));
+}
+
+// ===========================================================================
+// VMM: pages of the growth window
+// ===========================================================================
+
+bool VMM::is_paging_enabled() { return true; }
+
+bool VMM::is_mapped(u32 virt_addr) {
+    u32* slot = window_slot(virt_addr);
+    return slot && *slot != 0;
+}
+
+u32 VMM::alloc_page(u32 virt_addr, u32) {
+    u32* slot = window_slot(virt_addr);
+    if (!slot || *slot) return 0;
+    
+    u32 frame = PMM::alloc_page();
+    if (frame == 0) return 0;
+    
+    void* page = at(virt_addr & ~(config::PAGE_SIZE - 1));
+    if (mprotect(page, config::PAGE_SIZE, PROT_READ | PROT_WRITE) != 0) {
+        PMM::free_page(frame);
+        return 0;
+    }
+    *slot = frame;
+    return frame;
+}
+
+void VMM::free_range(u32 virt_start, u32 size) {
+    for (u32 offset = 0; offset < size; offset += config::PAGE_SIZE) {
+        u32* slot = window_slot(virt_start + offset);
+        if (!slot || !*slot) continue;
+        
+        // Dropped and made inaccessible, so a stale pointer faults
+        void* page = at(virt_start + offset);
+        madvise(page, config::PAGE_SIZE, MADV_DONTNEED);
+        mprotect(page, config::PAGE_SIZE, PROT_NONE);
+        PMM::free_page(*slot);
+        *slot = 0;
+    }
+}
+
+// ===========================================================================
+// Slab: never ready on the host
+// ===========================================================================
+
+void* Slab::alloc(usize, MemTag) { return nullptr; }
+
+void Slab::free(void*) {
+    abort();  // Slab::alloc never hands anything out
+}
+
+} // namespace bolt::mem
+
+namespace bolt::host {
+
+using namespace mem;
+
+static bool map_fixed(u32 addr, u32 size, int prot, int extra) {
+    void* want = at(addr);
+    void* got = mmap(want, size, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | extra, -1, 0);
+    if (got == want) return true;
+    
+    if (got != MAP_FAILED) munmap(got, size);
+    fprintf(stderr, "membench: cannot map 0x%08X-0x%08X\n", addr, addr + size);
+    return false;
+}
+
+bool boot_kernel_mem(u32 memory) {
+    // PMM bitmap slot, then the bootstrap heap
+    u32 low_size = config::HEAP_START + config::HEAP_SIZE - config::PMM_BITMAP_START;
+    if (!map_fixed(config::PMM_BITMAP_START, low_size, PROT_READ | PROT_WRITE, 0)) return false;
+    if (!map_fixed(config::HEAP_VIRT_BASE, config::HEAP_VIRT_LIMIT - config::HEAP_VIRT_BASE,
+                   PROT_NONE, MAP_NORESERVE)) {
+        return false;
+    }
+    
+    Heap::init(memory);
+    PMM::init_flat(memory);
+    Heap::enable_growth();
+    return true;
+}
+
+} // namespace bolt::host
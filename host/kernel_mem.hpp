@@ -0,0 +1,25 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Kernel Allocators on the Host
+ * ===========================================================================
+ * Runs the kernel's own Heap and PMM (core/memory/heap.cpp, pmm.cpp) in a
+ * Linux process. The bitmap slot and bootstrap heap get an mmap'd arena at
+ * their kernel addresses; the heap's growth window is reserved without
+ * access, and the VMM stand-in maps and unmaps pages of it as the heap
+ * grows and trims, so a touch of a returned chunk faults as it would on
+ * real hardware.
+ *
+ * Slab pages need per-CPU state, so on the host small allocations stay on
+ * the heap's block list.
+ * =========================================================================== */
+
+#include "lib/types.hpp"
+
+namespace bolt::host {
+
+// Map the arena and bring up Heap and PMM over `memory` bytes of pretend
+// RAM, as kernel_main does; false (with a message) if the fixed addresses
+// are taken
+bool boot_kernel_mem(u32 memory);
+
+} // namespace bolt::host
@@ -0,0 +1,54 @@
+/* ===========================================================================
+ * BOLT OS - Host Heap on malloc
+ * ===========================================================================
+ * The heap boltfs runs the storage stack on: Heap on malloc and a VMM
+ * without paging, so callers take their heap paths instead of reserving
+ * demand-paged areas.
+ *
+ * With BOLT_LOW_WATER set, every allocation runs the PMM's low-water
+ * reclaim the way kernel heap growth can, so the shrinkers fire in the
+ * middle of filesystem operations (run under the asan build).
+ * =========================================================================== */
+
+#include "core/memory/heap.hpp"
+#include "core/memory/reclaim.hpp"
+#include "core/memory/vmm.hpp"
+
+#include <stdlib.h>
+
+namespace bolt::mem {
+
+static void low_water(MemTag tag) {
+    static int cached = -1;
+    if (cached < 0) cached = getenv("BOLT_LOW_WATER") ? 1 : 0;
+    if (!cached) return;
+    
+    // Heap::grow -> VMM::alloc_page -> PMM::alloc_page at the mark
+    MemTag previous = Reclaim::begin_alloc(tag);
+    Reclaim::reclaim_for_pmm(config::PMM_LOW_WATER_PAGES * config::PAGE_SIZE);
+    Reclaim::end_alloc(previous);
+}
+
+void* Heap::alloc(usize size, MemTag tag) {
+    low_water(tag);
+    return malloc(size ? size : 1);
+}
+
+void* Heap::alloc_zeroed(usize size, MemTag tag) {
+    low_water(tag);
+    return calloc(1, size ? size : 1);
+}
+
+void Heap::free(void* ptr) {
+    ::free(ptr);
+}
+
+// The host never runs short; reclaim sees plenty of room and stays idle
+usize Heap::get_free() { return 256u << 20; }
+usize Heap::trim() { return 0; }
+
+bool VMM::is_paging_enabled() { return false; }
+u32 VMM::reserve(u32, u32, const char*) { return 0; }
+void VMM::release(u32) {}
+
+} // namespace bolt::mem
@@ -0,0 +1,196 @@
+/* ===========================================================================
+ * BOLT OS - Host Shim
+ * ===========================================================================
+ * Stand-ins for the kernel services every host program links against:
+ * Serial and Logger on stderr, Console on stdout, and the PIT and TSC rate
+ * on the monotonic clock. The heap comes from malloc_heap.cpp (boltfs) or
+ * from the kernel allocators on kernel_mem.cpp's arena (membench).
+ *
+ * Serial output is dropped unless BOLT_VERBOSE is set; Logger prints
+ * warnings and up (BOLT_VERBOSE lowers that to debug).
+ * =========================================================================== */
+
+#include "core/memory/heap.hpp"
+#include "core/sys/log.hpp"
+#include "drivers/serial/serial.hpp"
+#include "drivers/video/console.hpp"
+#include "drivers/timer/pit.hpp"
+#include "drivers/timer/tsc.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+static bool verbose() {
+    static int cached = -1;
+    if (cached < 0) cached = getenv("BOLT_VERBOSE") ? 1 : 0;
+    return cached;
+}
+
+// Tagged objects are released with plain delete, so they come from the
+// C++ runtime here rather than from Heap::alloc
+void* operator new(bolt::usize size, bolt::mem::MemTag) {
+    return ::operator new(size);
+}
+
+void* operator new[](bolt::usize size, bolt::mem::MemTag) {
+    return ::operator new[](size);
+}
+
+// ===========================================================================
+// Serial / Console / PIT
+// ===========================================================================
+
+namespace bolt::drivers {
+
+static const char* log_type_tag(LogType type) {
+    switch (type) {
+        case LogType::Debug:   return "DBG";
+        case LogType::Loading: return "...";
+        case LogType::Success: return " OK";
+        case LogType::Warning: return "WRN";
+        case LogType::Error:   return "ERR";
+        default:               return "INF";
+    }
+}
+
+void Serial::write_char(char c) { if (verbose()) fputc(c, stderr); }
+void Serial::write(const char* str) { if (verbose()) fputs(str, stderr); }
+void Serial::write_hex(u32 value) { if (verbose()) fprintf(stderr, "0x%08X", value); }
+void Serial::write_dec(i32 value) { if (verbose()) fprintf(stderr, "%d", value); }
+void Serial::writeln(const char* str) { if (verbose()) fprintf(stderr, "%s\n", str); }
+
+void Serial::log(const char* module, LogType type, const char* msg) {
+    if (verbose()) fprintf(stderr, "[%s] %-8s %s\n", log_type_tag(type), module, msg);
+}
+
+void Serial::log(const char* module, LogType type, const char* msg1, const char* msg2) {
+    if (verbose()) fprintf(stderr, "[%s] %-8s %s%s\n", log_type_tag(type), module, msg1, msg2);
+}
+
+void Serial::log_hex(const char* module, LogType type, const char* msg, u32 value) {
+    if (verbose()) fprintf(stderr, "[%s] %-8s %s0x%08X\n", log_type_tag(type), module, msg, value);
+}
+
+void Serial::log_module(const char* module, const char* msg) { log(module, LogType::Info, msg); }
+void Serial::log_ok(const char* module, const char* msg) { log(module, LogType::Success, msg); }
+void Serial::log_loading(const char* module, const char* msg) { log(module, LogType::Loading, msg); }
+void Serial::log_module_hex(const char* module, const char* msg, u32 value) {
+    log_hex(module, LogType::Info, msg, value);
+}
+
+// Failures and warnings always reach the terminal
+void Serial::log_fail(const char* module, const char* msg) {
+    fprintf(stderr, "[ERR] %-8s %s\n", module, msg);
+}
+
+void Serial::log_warn(const char* module, const char* msg) {
+    fprintf(stderr, "[WRN] %-8s %s\n", module, msg);
+}
+
+void Console::print(const char* str) { fputs(str, stdout); }
+void Console::println(const char* str) { printf("%s\n", str); }
+void Console::print_dec(i32 num) { printf("%d", num); }
+void Console::print_hex(u32 num) { printf("0x%08X", num); }
+void Console::set_color(Color, Color) {}
+
+u32 PIT::get_milliseconds() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<u32>(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+u32 PIT::get_ticks() { return get_milliseconds(); }
+u32 PIT::get_seconds() { return get_milliseconds() / 1000; }
+
+// rdtsc itself is the inline one from tsc.hpp; only the rate comes from
+// the host clock
+u32 TSC::khz = 0;
+
+void TSC::calibrate() {
+    timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    u64 cycles = read();
+    u64 elapsed_ns;
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        elapsed_ns = (now.tv_sec - start.tv_sec) * 1000000000ull + now.tv_nsec - start.tv_nsec;
+    } while (elapsed_ns < CALIBRATE_US * 1000ull);
+    khz = static_cast<u32>((read() - cycles) * 1000000 / elapsed_ns);
+}
+
+u32 TSC::to_us(u64 cycles) {
+    if (!khz) return 0;
+    u64 us = cycles * 1000 / khz;
+    return us > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<u32>(us);
+}
+
+u32 TSC::to_ns(u64 cycles) {
+    if (!khz) return 0;
+    u64 ns = cycles * 1000000 / khz;
+    return ns > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<u32>(ns);
+}
+
+} // namespace bolt::drivers
+
+// ===========================================================================
+// Logger
+// ===========================================================================
+
+namespace bolt::log {
+
+char Logger::format_buffer[Logger::FORMAT_BUFFER_SIZE];
+LogConfig Logger::config = Logger::default_config();
+bool Logger::initialized = false;
+
+static const char* host_level_name(Level level) {
+    switch (level) {
+        case Level::Trace: return "TRACE";
+        case Level::Debug: return "DEBUG";
+        case Level::Info:  return "INFO";
+        case Level::Warn:  return "WARN";
+        case Level::Error: return "ERROR";
+        case Level::Fatal: return "FATAL";
+        default:           return "?";
+    }
+}
+
+void Logger::init(LogConfig cfg) {
+    config = cfg;
+    config.min_level = verbose() ? Level::Debug : Level::Warn;
+    initialized = true;
+}
+
+void Logger::log(Level level, const char* message) {
+    if (!initialized) init();
+    if (level < config.min_level) return;
+    fprintf(stderr, "[%s] %s\n", host_level_name(level), message);
+}
+
+void Logger::log(Level level, const char* message, const SourceLocation& loc) {
+    if (!initialized) init();
+    if (level < config.min_level) return;
+    fprintf(stderr, "[%s] %s (%s:%u)\n", host_level_name(level), message, loc.file, loc.line);
+}
+
+void Logger::logf(Level level, const char* format, ...) {
+    if (!initialized) init();
+    if (level < config.min_level) return;
+    
+    va_list args;
+    va_start(args, format);
+    vsnprintf(format_buffer, FORMAT_BUFFER_SIZE, format, args);
+    va_end(args);
+    fprintf(stderr, "[%s] %s\n", host_level_name(level), format_buffer);
+}
+
+void Logger::fatal(const char* msg) {
+    fprintf(stderr, "[FATAL] %s\n", msg);
+    abort();
+}
+
+void Logger::set_level(Level level) { config.min_level = level; }
+void Logger::set_targets(Target targets) { config.targets = targets; }
+
+} // namespace bolt::log
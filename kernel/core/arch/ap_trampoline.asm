@@ -0,0 +1,87 @@
+; ===========================================================================
+; BOLT OS - Application Processor Trampoline
+; ===========================================================================
+; Copied to AP_TRAMPOLINE_ADDR by SMP::start_aps. An AP starts here in real
+; mode at CS:IP = 0x0800:0000 after the start-up IPI, switches to protected
+; mode, takes the kernel's CR3/CR4/CR0 and stack from the parameter block
+; and calls SMP::ap_entry.
+; ===========================================================================
+
+TRAMPOLINE_ADDR equ 0x8000
+
+; Address of a trampoline label once copied to TRAMPOLINE_ADDR
+%define REL(x) (TRAMPOLINE_ADDR + (x) - ap_trampoline_start)
+
+section .text
+
+global ap_trampoline_start
+global ap_trampoline_params
+global ap_trampoline_end
+
+[bits 16]
+
+ap_trampoline_start:
+    cli
+    cld
+    xor ax, ax
+    mov ds, ax
+    
+    lgdt [REL(ap_gdt_desc)]
+    
+    mov eax, cr0
+    or eax, 1               ; PE
+    mov cr0, eax
+    
+    jmp dword 0x08:REL(ap_protected)
+
+[bits 32]
+
+ap_protected:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    
+    ; Same address space as the boot CPU: CR3 first, then CR4, then paging
+    mov eax, [REL(ap_param_cr3)]
+    mov cr3, eax
+    mov eax, [REL(ap_param_cr4)]
+    mov cr4, eax
+    mov eax, [REL(ap_param_cr0)]
+    mov cr0, eax
+    
+    mov esp, [REL(ap_param_stack)]
+    xor ebp, ebp
+    
+    mov eax, [REL(ap_param_entry)]
+    call eax                ; Does not return
+    
+.halt:
+    cli
+    hlt
+    jmp .halt
+
+; Flat code/data descriptors, replaced by GDT::init_cpu in ap_entry
+align 8
+ap_gdt:
+    dq 0x0000000000000000
+    dq 0x00CF9A000000FFFF   ; 0x08: Kernel code
+    dq 0x00CF92000000FFFF   ; 0x10: Kernel data
+ap_gdt_end:
+
+ap_gdt_desc:
+    dw ap_gdt_end - ap_gdt - 1
+    dd REL(ap_gdt)
+
+; Parameter block (struct ApParams in smp.cpp)
+align 4
+ap_trampoline_params:
+ap_param_cr0:   dd 0
+ap_param_cr3:   dd 0
+ap_param_cr4:   dd 0
+ap_param_stack: dd 0
+ap_param_entry: dd 0
+
+ap_trampoline_end:
@@ -0,0 +1,217 @@
+/* ===========================================================================
+ * BOLT OS - APIC Implementation
+ * =========================================================================== */
+
+#include "apic.hpp"
+#include "../sys/io.hpp"
+#include "../memory/vmm.hpp"
+#include "../../drivers/timer/pit.hpp"
+
+namespace bolt {
+
+using namespace drivers;
+
+u32 APIC::lapic_base = config::LAPIC_DEFAULT_BASE;
+bool APIC::lapic_enabled = false;
+bool APIC::routing = false;
+u32 APIC::timer_count = 0;
+APIC::IOAPIC APIC::ioapics[APIC::MAX_IOAPICS];
+u32 APIC::ioapic_count = 0;
+APIC::Override APIC::overrides[APIC::MAX_OVERRIDES];
+u32 APIC::override_count = 0;
+
+constexpr u32 IA32_APIC_BASE_MSR = 0x1B;
+constexpr u32 ICR_INIT           = 0x00004500;  // INIT, level assert
+constexpr u32 ICR_STARTUP        = 0x00004600;  // Start-up IPI
+constexpr u32 ICR_PENDING        = 1 << 12;     // Delivery status
+constexpr u32 IOAPIC_REG_VERSION = 0x01;
+constexpr u32 IOAPIC_REG_REDTBL  = 0x10;
+constexpr u32 REDIR_ACTIVE_LOW   = 1 << 13;
+constexpr u32 REDIR_LEVEL        = 1 << 15;
+constexpr u32 REDIR_MASKED       = 1 << 16;
+constexpr u32 TIMER_PERIODIC     = 1 << 17;
+constexpr u32 TIMER_DIV_16       = 0x3;
+constexpr u32 TIMER_CALIBRATE_US = 10000;
+
+bool APIC::add_ioapic(u8 id, u32 phys, u32 gsi_base) {
+    if (ioapic_count >= MAX_IOAPICS) return false;
+    ioapics[ioapic_count++] = {id, phys, gsi_base, 0};
+    return true;
+}
+
+void APIC::add_override(u8 irq, u32 gsi, u16 flags) {
+    if (override_count >= MAX_OVERRIDES) return;
+    overrides[override_count++] = {irq, gsi, flags};
+}
+
+bool APIC::init() {
+    if (!mem::VMM::is_paging_enabled()) return false;
+    
+    // Both windows are uncached MMIO, identity mapped
+    u32 mmio = mem::PageFlags::KernelPage | mem::PageFlags::CacheDisable | mem::PageFlags::WriteThrough;
+    if (!mem::VMM::map_page(lapic_base, lapic_base, mmio)) return false;
+    for (u32 i = 0; i < ioapic_count; i++) {
+        u32 page = ioapics[i].base & ~(config::PAGE_SIZE - 1);
+        if (!mem::VMM::map_page(page, page, mmio)) return false;
+        ioapics[i].pins = ((ioapic_read(ioapics[i], IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+    }
+    
+    init_local();
+    calibrate_timer();
+    lapic_enabled = true;
+    return true;
+}
+
+void APIC::init_local() {
+    // Hardware-enable through the MSR in case the firmware left it off
+    u32 lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(IA32_APIC_BASE_MSR));
+    lo |= 1 << 11;
+    asm volatile("wrmsr" : : "a"(lo), "d"(hi), "c"(IA32_APIC_BASE_MSR));
+    
+    // Accept everything, keep LINT0/LINT1, the timer and errors masked
+    write(LAPIC_TPR, 0);
+    write(LAPIC_LVT_TIMER, REDIR_MASKED);
+    write(LAPIC_LVT_LINT0, REDIR_MASKED);
+    write(LAPIC_LVT_LINT1, REDIR_MASKED);
+    write(LAPIC_LVT_ERROR, REDIR_MASKED);
+    write(LAPIC_ESR, 0);
+    write(LAPIC_ESR, 0);
+    
+    // Software-enable with the spurious vector
+    write(LAPIC_SVR, 0x100 | config::APIC_SPURIOUS_VECTOR);
+    eoi();
+}
+
+void APIC::calibrate_timer() {
+    // Count down from the top for a PIT-timed interval, masked; every
+    // CPU's timer runs off the same bus clock
+    write(LAPIC_TIMER_DIV, TIMER_DIV_16);
+    write(LAPIC_LVT_TIMER, REDIR_MASKED);
+    write(LAPIC_TIMER_INIT, 0xFFFFFFFF);
+    PIT::delay_us(TIMER_CALIBRATE_US);
+    u32 elapsed = 0xFFFFFFFF - read(LAPIC_TIMER_COUNT);
+    write(LAPIC_TIMER_INIT, 0);
+    
+    timer_count = elapsed * (1000000 / TIMER_CALIBRATE_US) / config::APIC_TIMER_HZ;
+}
+
+bool APIC::start_timer() {
+    if (timer_count == 0) return false;
+    
+    write(LAPIC_TIMER_DIV, TIMER_DIV_16);
+    write(LAPIC_LVT_TIMER, TIMER_PERIODIC | config::APIC_TIMER_VECTOR);
+    write(LAPIC_TIMER_INIT, timer_count);
+    return true;
+}
+
+u32 APIC::id() {
+    return read(LAPIC_ID) >> 24;
+}
+
+bool APIC::wait_icr() {
+    for (u32 i = 0; i < 100000; i++) {
+        if (!(read(LAPIC_ICR_LOW) & ICR_PENDING)) return true;
+        asm volatile("pause");
+    }
+    return false;
+}
+
+void APIC::send_init(u8 apic_id) {
+    write(LAPIC_ESR, 0);
+    write(LAPIC_ICR_HIGH, static_cast<u32>(apic_id) << 24);
+    write(LAPIC_ICR_LOW, ICR_INIT);
+    wait_icr();
+}
+
+void APIC::send_startup(u8 apic_id, u8 vector_page) {
+    write(LAPIC_ICR_HIGH, static_cast<u32>(apic_id) << 24);
+    write(LAPIC_ICR_LOW, ICR_STARTUP | vector_page);
+    PIT::delay_us(200);
+    wait_icr();
+}
+
+void APIC::send_ipi(u8 apic_id, u8 vector) {
+    if (!lapic_enabled) return;
+    
+    // ICR writes must not interleave on this CPU
+    u32 flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    wait_icr();
+    write(LAPIC_ICR_HIGH, static_cast<u32>(apic_id) << 24);
+    write(LAPIC_ICR_LOW, vector);
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+// ===========================================================================
+// I/O APIC
+// ===========================================================================
+
+u32 APIC::ioapic_read(const IOAPIC& io, u32 reg) {
+    *reinterpret_cast<volatile u32*>(io.base) = reg;
+    return *reinterpret_cast<volatile u32*>(io.base + 0x10);
+}
+
+void APIC::ioapic_write(const IOAPIC& io, u32 reg, u32 value) {
+    *reinterpret_cast<volatile u32*>(io.base) = reg;
+    *reinterpret_cast<volatile u32*>(io.base + 0x10) = value;
+}
+
+u32 APIC::get_ioapic_pins(u32 index) {
+    return index < ioapic_count ? ioapics[index].pins : 0;
+}
+
+bool APIC::route_legacy_irqs(u8 dest_apic_id) {
+    if (!lapic_enabled || ioapic_count == 0) return false;
+    
+    // Start from everything masked
+    for (u32 i = 0; i < ioapic_count; i++) {
+        for (u32 pin = 0; pin < ioapics[i].pins; pin++) {
+            ioapic_write(ioapics[i], IOAPIC_REG_REDTBL + pin * 2, REDIR_MASKED);
+            ioapic_write(ioapics[i], IOAPIC_REG_REDTBL + pin * 2 + 1, 0);
+        }
+    }
+    
+    for (u32 irq = 0; irq < 16; irq++) {
+        // ISA defaults: identity GSI, active high, edge triggered
+        u32 gsi = irq;
+        u16 flags = 0;
+        bool overridden = false;
+        for (u32 i = 0; i < override_count; i++) {
+            if (overrides[i].irq == irq) {
+                gsi = overrides[i].gsi;
+                flags = overrides[i].flags;
+                overridden = true;
+            }
+        }
+        
+        // A GSI claimed by another IRQ's override is taken (IRQ0 -> GSI2)
+        bool claimed = false;
+        for (u32 i = 0; i < override_count && !overridden; i++) {
+            if (overrides[i].gsi == gsi && overrides[i].irq != irq) claimed = true;
+        }
+        if (claimed || (irq == 2 && !overridden)) continue;
+        
+        for (u32 i = 0; i < ioapic_count; i++) {
+            IOAPIC& io = ioapics[i];
+            if (gsi < io.gsi_base || gsi >= io.gsi_base + io.pins) continue;
+            
+            u32 low = 32 + irq;
+            if ((flags & 0x3) == 0x3) low |= REDIR_ACTIVE_LOW;
+            if (((flags >> 2) & 0x3) == 0x3) low |= REDIR_LEVEL;
+            
+            u32 pin = gsi - io.gsi_base;
+            ioapic_write(io, IOAPIC_REG_REDTBL + pin * 2 + 1, static_cast<u32>(dest_apic_id) << 24);
+            ioapic_write(io, IOAPIC_REG_REDTBL + pin * 2, low);
+            break;
+        }
+    }
+    
+    // The PIC stays remapped (its spurious IRQs land on 39/47) but silent
+    io::outb(config::PIC1_DATA, 0xFF);
+    io::outb(config::PIC2_DATA, 0xFF);
+    routing = true;
+    return true;
+}
+
+} // namespace bolt
@@ -0,0 +1,107 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Local APIC and I/O APIC
+ * ===========================================================================
+ * The local APIC of each CPU takes EOIs and sends the INIT/SIPI sequence
+ * that starts application processors; on those its timer drives the
+ * scheduler tick. The I/O APICs replace the 8259 PIC
+ * for legacy IRQs once SMP::detect has found them in the MADT/MP table.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+#include "../sys/config.hpp"
+
+namespace bolt {
+
+class APIC {
+public:
+    static constexpr u32 MAX_IOAPICS = 4;
+    static constexpr u32 MAX_OVERRIDES = 16;
+    
+    // Local APIC registers (offsets from the MMIO base)
+    static constexpr u32 LAPIC_ID       = 0x020;
+    static constexpr u32 LAPIC_VERSION  = 0x030;
+    static constexpr u32 LAPIC_TPR      = 0x080;
+    static constexpr u32 LAPIC_EOI      = 0x0B0;
+    static constexpr u32 LAPIC_SVR      = 0x0F0;
+    static constexpr u32 LAPIC_ESR      = 0x280;
+    static constexpr u32 LAPIC_ICR_LOW  = 0x300;
+    static constexpr u32 LAPIC_ICR_HIGH = 0x310;
+    static constexpr u32 LAPIC_LVT_TIMER = 0x320;
+    static constexpr u32 LAPIC_LVT_LINT0 = 0x350;
+    static constexpr u32 LAPIC_LVT_LINT1 = 0x360;
+    static constexpr u32 LAPIC_LVT_ERROR = 0x370;
+    static constexpr u32 LAPIC_TIMER_INIT  = 0x380;
+    static constexpr u32 LAPIC_TIMER_COUNT = 0x390;
+    static constexpr u32 LAPIC_TIMER_DIV   = 0x3E0;
+    
+    // Filled in by SMP::detect before paging
+    static void set_lapic_base(u32 phys) { lapic_base = phys; }
+    static bool add_ioapic(u8 id, u32 phys, u32 gsi_base);
+    static void add_override(u8 irq, u32 gsi, u16 flags);
+    
+    // Map the MMIO windows and enable the boot CPU's local APIC (paging on)
+    static bool init();
+    static bool is_enabled() { return lapic_enabled; }
+    
+    // Enable the calling CPU's local APIC (BSP from init, APs at startup)
+    static void init_local();
+    
+    static u32 id();
+    static void eoi() { write(LAPIC_EOI, 0); }
+    
+    // Periodic APIC_TIMER_VECTOR on the calling CPU at config::APIC_TIMER_HZ,
+    // using the rate init() measured against the PIT
+    static bool start_timer();
+    
+    // AP startup
+    static void send_init(u8 apic_id);
+    static void send_startup(u8 apic_id, u8 vector_page);
+    
+    // Fixed-delivery IPI to one CPU
+    static void send_ipi(u8 apic_id, u8 vector);
+    
+    // Route ISA IRQs 0-15 through the I/O APIC to one CPU and mask the PIC
+    static bool route_legacy_irqs(u8 dest_apic_id);
+    static bool is_routing() { return routing; }
+    
+    static u32 get_ioapic_count() { return ioapic_count; }
+    static u32 get_ioapic_pins(u32 index);
+
+private:
+    struct IOAPIC {
+        u8 id;
+        u32 base;
+        u32 gsi_base;
+        u32 pins;               // Redirection entries
+    };
+    
+    struct Override {
+        u8 irq;                 // ISA source
+        u32 gsi;
+        u16 flags;              // MPS INTI flags: polarity bits 0-1, trigger bits 2-3
+    };
+    
+    static u32 read(u32 reg) {
+        return *reinterpret_cast<volatile u32*>(lapic_base + reg);
+    }
+    static void write(u32 reg, u32 value) {
+        *reinterpret_cast<volatile u32*>(lapic_base + reg) = value;
+    }
+    static bool wait_icr();
+    static void calibrate_timer();
+    
+    static u32 ioapic_read(const IOAPIC& io, u32 reg);
+    static void ioapic_write(const IOAPIC& io, u32 reg, u32 value);
+    
+    static u32 lapic_base;
+    static bool lapic_enabled;
+    static bool routing;
+    static u32 timer_count;         // Initial count for one tick, 0 = unknown
+    static IOAPIC ioapics[MAX_IOAPICS];
+    static u32 ioapic_count;
+    static Override overrides[MAX_OVERRIDES];
+    static u32 override_count;
+};
+
+} // namespace bolt
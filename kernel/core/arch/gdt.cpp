@@ -3,44 +3,69 @@
  * =========================================================================== */
 
 #include "gdt.hpp"
+#include "../memory/heap.hpp"
 
 namespace bolt {
 
-GDTEntry GDT::entries[GDT_ENTRIES];
-GDTPointer GDT::pointer;
+GDTEntry GDT::entries[config::MAX_CPUS][GDT_ENTRIES];
+GDTPointer GDT::pointers[config::MAX_CPUS];
+TSS GDT::tss[config::MAX_CPUS];
 
 void GDT::init() {
-    pointer.limit = sizeof(entries) - 1;
-    pointer.base = reinterpret_cast<u32>(&entries);
+    init_cpu(0, 0, 0xFFFFFFFF, 0);
+}
+
+void GDT::init_cpu(u32 cpu, u32 percpu_base, u32 percpu_size, u32 stack_top) {
+    GDTEntry* table = entries[cpu];
     
     // Null segment
-    set_gate(0, 0, 0, 0, 0);
+    set_gate(table, 0, 0, 0, 0, 0);
     
     // Kernel code segment: base=0, limit=4GB, executable, readable
-    set_gate(1, 0, 0xFFFFFFFF, 0x9A, 0xCF);
+    set_gate(table, 1, 0, 0xFFFFFFFF, 0x9A, 0xCF);
     
     // Kernel data segment: base=0, limit=4GB, writable
-    set_gate(2, 0, 0xFFFFFFFF, 0x92, 0xCF);
+    set_gate(table, 2, 0, 0xFFFFFFFF, 0x92, 0xCF);
     
     // User code segment: base=0, limit=4GB, executable, readable, ring 3
-    set_gate(3, 0, 0xFFFFFFFF, 0xFA, 0xCF);
+    set_gate(table, 3, 0, 0xFFFFFFFF, 0xFA, 0xCF);
     
     // User data segment: base=0, limit=4GB, writable, ring 3
-    set_gate(4, 0, 0xFFFFFFFF, 0xF2, 0xCF);
+    set_gate(table, 4, 0, 0xFFFFFFFF, 0xF2, 0xCF);
+    
+    // TSS: 32-bit available, byte granular
+    mem::memset(&tss[cpu], 0, sizeof(TSS));
+    tss[cpu].ss0 = KERNEL_DATA;
+    tss[cpu].esp0 = stack_top;
+    tss[cpu].iomap_base = sizeof(TSS);
+    set_gate(table, 5, reinterpret_cast<u32>(&tss[cpu]), sizeof(TSS) - 1, 0x89, 0x00);
+    
+    // Per-CPU data segment: writable, 32-bit, byte granular unless it spans 4GB
+    set_gate(table, 6, percpu_base, percpu_size == 0xFFFFFFFF ? 0xFFFFF : percpu_size - 1,
+             0x92, percpu_size == 0xFFFFFFFF ? 0xCF : 0x40);
     
-    // Load GDT
-    gdt_flush(reinterpret_cast<u32>(&pointer));
+    pointers[cpu].limit = sizeof(entries[cpu]) - 1;
+    pointers[cpu].base = reinterpret_cast<u32>(table);
+    
+    // Load GDT, then the selectors gdt_flush doesn't know about
+    gdt_flush(reinterpret_cast<u32>(&pointers[cpu]));
+    asm volatile("ltr %w0" : : "r"(static_cast<u16>(TSS_SEL)));
+    asm volatile("mov %w0, %%gs" : : "r"(static_cast<u16>(PERCPU)) : "memory");
+}
+
+void GDT::set_kernel_stack(u32 cpu, u32 esp0) {
+    if (cpu < config::MAX_CPUS) tss[cpu].esp0 = esp0;
 }
 
-void GDT::set_gate(u32 num, u32 base, u32 limit, u8 access, u8 gran) {
-    entries[num].base_low    = base & 0xFFFF;
-    entries[num].base_middle = (base >> 16) & 0xFF;
-    entries[num].base_high   = (base >> 24) & 0xFF;
+void GDT::set_gate(GDTEntry* table, u32 num, u32 base, u32 limit, u8 access, u8 gran) {
+    table[num].base_low    = base & 0xFFFF;
+    table[num].base_middle = (base >> 16) & 0xFF;
+    table[num].base_high   = (base >> 24) & 0xFF;
     
-    entries[num].limit_low   = limit & 0xFFFF;
-    entries[num].granularity = ((limit >> 16) & 0x0F) | (gran & 0xF0);
+    table[num].limit_low   = limit & 0xFFFF;
+    table[num].granularity = ((limit >> 16) & 0x0F) | (gran & 0xF0);
     
-    entries[num].access      = access;
+    table[num].access      = access;
 }
 
 } // namespace bolt
@@ -2,10 +2,12 @@
 /* ===========================================================================
  * BOLT OS - Global Descriptor Table (GDT)
  * ===========================================================================
- * Defines memory segments for protected mode
+ * Defines memory segments for protected mode. Every CPU gets its own table
+ * so its TSS and per-CPU GS segment can live at the same selectors.
  * =========================================================================== */
 
 #include "../../lib/types.hpp"
+#include "../sys/config.hpp"
 
 // External assembly function - uses uint32_t directly to avoid namespace issues
 extern "C" void gdt_flush(uint32_t gdtr);
@@ -26,21 +28,44 @@ struct GDTPointer {
     u32 base;
 } __attribute__((packed));
 
+// Task state segment: only ss0/esp0 matter without hardware task switching
+struct TSS {
+    u32 prev_tss;
+    u32 esp0;
+    u32 ss0;
+    u32 esp1, ss1, esp2, ss2;
+    u32 cr3, eip, eflags;
+    u32 eax, ecx, edx, ebx, esp, ebp, esi, edi;
+    u32 es, cs, ss, ds, fs, gs;
+    u32 ldt;
+    u16 trap;
+    u16 iomap_base;
+} __attribute__((packed));
+
 class GDT {
 public:
     static constexpr u8 KERNEL_CODE = 0x08;
     static constexpr u8 KERNEL_DATA = 0x10;
     static constexpr u8 USER_CODE   = 0x18;
     static constexpr u8 USER_DATA   = 0x20;
+    static constexpr u8 TSS_SEL     = 0x28;
+    static constexpr u8 PERCPU      = 0x30;     // GS: base = this CPU's PerCpu block
     
+    // Boot CPU table with a zero-based GS until SMP::init_bsp runs
     static void init();
     
+    // Build and load the table, TSS and GS for one CPU (runs on that CPU)
+    static void init_cpu(u32 cpu, u32 percpu_base, u32 percpu_size, u32 stack_top);
+    
+    static void set_kernel_stack(u32 cpu, u32 esp0);
+    
 private:
-    static constexpr u32 GDT_ENTRIES = 5;
-    static GDTEntry entries[GDT_ENTRIES];
-    static GDTPointer pointer;
+    static constexpr u32 GDT_ENTRIES = 7;
+    static GDTEntry entries[config::MAX_CPUS][GDT_ENTRIES];
+    static GDTPointer pointers[config::MAX_CPUS];
+    static TSS tss[config::MAX_CPUS];
     
-    static void set_gate(u32 num, u32 base, u32 limit, u8 access, u8 gran);
+    static void set_gate(GDTEntry* table, u32 num, u32 base, u32 limit, u8 access, u8 gran);
 };
 
 } // namespace bolt
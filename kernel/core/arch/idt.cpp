@@ -3,6 +3,9 @@
  * =========================================================================== */
 
 #include "idt.hpp"
+#include "apic.hpp"
+#include "smp.hpp"
+#include "../sched/task.hpp"
 #include "../sys/io.hpp"
 #include "../../drivers/video/vga.hpp"
 
@@ -90,7 +93,23 @@ void IDT::init() {
     set_gate(46, reinterpret_cast<u32>(irq14), 0x08, 0x8E);
     set_gate(47, reinterpret_cast<u32>(irq15), 0x08, 0x8E);
     
+    // Local APIC spurious interrupts need no EOI
+    set_gate(config::APIC_SPURIOUS_VECTOR, reinterpret_cast<u32>(isr_spurious), 0x08, 0x8E);
+    
+    // Reschedule IPI: only wakes an idle CPU out of hlt
+    set_gate(config::RESCHED_VECTOR, reinterpret_cast<u32>(isr_resched), 0x08, 0x8E);
+    
+    // TLB shootdown IPI: another CPU unmapped kernel memory
+    set_gate(config::TLB_SHOOTDOWN_VECTOR, reinterpret_cast<u32>(isr_tlb_shootdown), 0x08, 0x8E);
+    
+    // Local APIC timer: time slices on the application processors
+    set_gate(config::APIC_TIMER_VECTOR, reinterpret_cast<u32>(isr_apic_timer), 0x08, 0x8E);
+    
     // Load IDT
+    load();
+}
+
+void IDT::load() {
     asm volatile("lidt %0" : : "m"(pointer));
 }
 
@@ -170,9 +189,31 @@ extern "C" void irq_handler(bolt::InterruptFrame* frame) {
         IDT::handlers[frame->int_no](frame);
     }
     
-    // Send EOI (End Of Interrupt)
+    // Send EOI (End Of Interrupt) to whichever controller delivered it
+    if (APIC::is_routing()) {
+        APIC::eoi();
+        return;
+    }
     if (frame->int_no >= 40) {
         io::outb(0xA0, 0x20);  // PIC2
     }
     io::outb(0x20, 0x20);  // PIC1
 }
+
+// C handler for the reschedule IPI
+extern "C" void resched_handler() {
+    bolt::APIC::eoi();
+}
+
+// C handler for the TLB shootdown IPI
+extern "C" void tlb_shootdown_handler() {
+    bolt::SMP::poll_tlb_shootdown();
+    bolt::APIC::eoi();
+}
+
+// C handler for the local APIC timer. EOI first: tick() may switch to
+// another task, and this one only returns here once it is resumed.
+extern "C" void apic_timer_handler() {
+    bolt::APIC::eoi();
+    bolt::sched::TaskManager::tick();
+}
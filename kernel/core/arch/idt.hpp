@@ -57,6 +57,7 @@ public:
     static constexpr u8 IRQ_ATA2     = 47;
     
     static void init();
+    static void load();                 // lidt on the calling CPU (APs share the table)
     static void set_gate(u8 num, u32 handler, u16 selector, u8 flags);
     static void register_handler(u8 interrupt, InterruptHandler handler);
     
@@ -91,6 +92,11 @@ extern "C" {
     void irq8();  void irq9();  void irq10(); void irq11();
     void irq12(); void irq13(); void irq14(); void irq15();
     
+    void isr_spurious();
+    void isr_resched();
+    void isr_tlb_shootdown();
+    void isr_apic_timer();
+    
     void isr_handler(bolt::InterruptFrame* frame);
     void irq_handler(bolt::InterruptFrame* frame);
 }
@@ -88,6 +88,41 @@ IRQ 13, 45      ; FPU
 IRQ 14, 46      ; ATA Primary
 IRQ 15, 47      ; ATA Secondary
 
+; Local APIC spurious vector: no handler, no EOI
+global isr_spurious
+isr_spurious:
+    iret
+
+; Reschedule IPI: the idle loop re-checks the run queues after hlt
+extern resched_handler
+global isr_resched
+isr_resched:
+    pusha
+    cld
+    call resched_handler
+    popa
+    iret
+
+; TLB shootdown IPI: flush the range another CPU just unmapped
+extern tlb_shootdown_handler
+global isr_tlb_shootdown
+isr_tlb_shootdown:
+    pusha
+    cld
+    call tlb_shootdown_handler
+    popa
+    iret
+
+; Local APIC timer: scheduler tick on an application processor
+extern apic_timer_handler
+global isr_apic_timer
+isr_apic_timer:
+    pusha
+    cld
+    call apic_timer_handler
+    popa
+    iret
+
 ; External C handlers
 extern isr_handler
 extern irq_handler
@@ -99,11 +134,10 @@ isr_common:
     mov ax, ds
     push eax            ; Save data segment
     
-    mov ax, 0x10        ; Load kernel data segment
+    mov ax, 0x10        ; Load kernel data segment (GS keeps the per-CPU block)
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     push esp            ; Pass pointer to stack frame
     call isr_handler
@@ -113,7 +147,6 @@ isr_common:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     popa                ; Restore registers
     add esp, 8          ; Clean up error code and interrupt number
@@ -130,7 +163,6 @@ irq_common:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     push esp
     call irq_handler
@@ -140,7 +172,6 @@ irq_common:
     mov ds, ax
     mov es, ax
     mov fs, ax
-    mov gs, ax
     
     popa
     add esp, 8
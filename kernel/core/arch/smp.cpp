@@ -0,0 +1,340 @@
+/* ===========================================================================
+ * BOLT OS - SMP Implementation
+ * =========================================================================== */
+
+#include "smp.hpp"
+#include "apic.hpp"
+#include "gdt.hpp"
+#include "idt.hpp"
+#include "../memory/heap.hpp"
+#include "../memory/vmm.hpp"
+#include "../sched/task.hpp"
+#include "../sys/log.hpp"
+#include "../sys/system.hpp"
+#include "../../drivers/timer/pit.hpp"
+
+// Real-mode trampoline (ap_trampoline.asm), copied to AP_TRAMPOLINE_ADDR
+extern "C" {
+    extern bolt::u8 ap_trampoline_start[];
+    extern bolt::u8 ap_trampoline_params[];
+    extern bolt::u8 ap_trampoline_end[];
+    extern bolt::u32 __stack_top;
+}
+
+namespace bolt {
+
+using namespace drivers;
+
+PerCpu SMP::cpus[config::MAX_CPUS];
+u32 SMP::cpu_count = 1;
+volatile u32 SMP::online_count = 1;
+volatile u32 SMP::booting = 0;
+volatile u32 SMP::tlb_lock = 0;
+volatile u32 SMP::tlb_pending = 0;
+volatile u32 SMP::tlb_start = 0;
+volatile u32 SMP::tlb_size = 0;
+SMPSource SMP::source = SMPSource::None;
+
+// Filled in by the BSP before each SIPI; layout matches the trampoline
+struct ApParams {
+    u32 cr0;
+    u32 cr3;
+    u32 cr4;
+    u32 stack;
+    u32 entry;
+};
+
+// Firmware tables are read through their physical addresses (paging off)
+static inline u8 phys8(u32 addr) { return *reinterpret_cast<volatile u8*>(addr); }
+static inline u16 phys16(u32 addr) { return *reinterpret_cast<volatile u16*>(addr); }
+static inline u32 phys32(u32 addr) { return *reinterpret_cast<volatile u32*>(addr); }
+
+void SMP::init_bsp() {
+    PerCpu& bsp = cpus[0];
+    bsp.self = &bsp;
+    bsp.index = 0;
+    bsp.online = true;
+    bsp.current_task = nullptr;
+    bsp.stack_top = reinterpret_cast<u32>(&__stack_top);
+    
+    if (sys::g_system && sys::g_system->cpu.has_apic) {
+        u32 eax, ebx, ecx, edx;
+        asm volatile("cpuid" : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx) : "a"(1));
+        bsp.apic_id = static_cast<u8>(ebx >> 24);
+    }
+    
+    GDT::init_cpu(0, reinterpret_cast<u32>(&bsp), sizeof(PerCpu), bsp.stack_top);
+}
+
+// ===========================================================================
+// Firmware Tables
+// ===========================================================================
+
+bool SMP::checksum_ok(u32 addr, u32 length) {
+    u8 sum = 0;
+    for (u32 i = 0; i < length; i++) sum += phys8(addr + i);
+    return sum == 0;
+}
+
+u32 SMP::find_signature(u32 start, u32 length, const char* sig, u32 sig_len) {
+    for (u32 addr = start; addr + sig_len <= start + length; addr += 16) {
+        u32 i = 0;
+        while (i < sig_len && phys8(addr + i) == static_cast<u8>(sig[i])) i++;
+        if (i == sig_len) return addr;
+    }
+    return 0;
+}
+
+void SMP::add_cpu(u8 apic_id) {
+    if (apic_id == cpus[0].apic_id || cpu_count >= config::MAX_CPUS) return;
+    
+    PerCpu& cpu = cpus[cpu_count];
+    cpu.self = &cpu;
+    cpu.index = cpu_count;
+    cpu.apic_id = apic_id;
+    cpu.online = false;
+    cpu.current_task = nullptr;
+    cpu.stack_top = 0;
+    cpu_count++;
+}
+
+bool SMP::detect() {
+    if (!sys::g_system || !sys::g_system->cpu.has_apic) return false;
+    
+    // The EBDA segment lives at 0x40E in the BIOS data area (hidden from
+    // GCC, which flags constant addresses in the first page)
+    u32 bda_ebda = 0x40E;
+    asm("" : "+r"(bda_ebda));
+    u32 ebda = static_cast<u32>(phys16(bda_ebda)) << 4;
+    
+    u32 rsdp = ebda ? find_signature(ebda, 1024, "RSD PTR ", 8) : 0;
+    if (!rsdp) rsdp = find_signature(0xE0000, 0x20000, "RSD PTR ", 8);
+    if (rsdp && checksum_ok(rsdp, 20) && parse_madt(rsdp)) {
+        source = SMPSource::ACPI;
+        return true;
+    }
+    
+    u32 mp = ebda ? find_signature(ebda, 1024, "_MP_", 4) : 0;
+    if (!mp) mp = find_signature(0x9FC00, 0x400, "_MP_", 4);
+    if (!mp) mp = find_signature(0xF0000, 0x10000, "_MP_", 4);
+    if (mp && checksum_ok(mp, phys8(mp + 8) * 16) && parse_mp(mp)) {
+        source = SMPSource::MPTable;
+        return true;
+    }
+    
+    return false;
+}
+
+bool SMP::parse_madt(u32 rsdp) {
+    u32 rsdt = phys32(rsdp + 16);
+    if (!rsdt || phys32(rsdt) != 0x54445352) return false;  // "RSDT"
+    
+    u32 rsdt_len = phys32(rsdt + 4);
+    if (!checksum_ok(rsdt, rsdt_len)) return false;
+    
+    u32 madt = 0;
+    for (u32 entry = rsdt + 36; entry + 4 <= rsdt + rsdt_len; entry += 4) {
+        u32 table = phys32(entry);
+        if (table && phys32(table) == 0x43495041) {          // "APIC"
+            madt = table;
+            break;
+        }
+    }
+    if (!madt) return false;
+    
+    u32 madt_len = phys32(madt + 4);
+    if (!checksum_ok(madt, madt_len)) return false;
+    APIC::set_lapic_base(phys32(madt + 36));
+    
+    for (u32 entry = madt + 44; entry + 2 <= madt + madt_len;) {
+        u8 type = phys8(entry);
+        u8 len = phys8(entry + 1);
+        if (len < 2) break;
+        
+        switch (type) {
+            case 0:     // Processor local APIC: enabled or online-capable
+                if (phys32(entry + 4) & 0x3) add_cpu(phys8(entry + 3));
+                break;
+            case 1:     // I/O APIC
+                APIC::add_ioapic(phys8(entry + 2), phys32(entry + 4), phys32(entry + 8));
+                break;
+            case 2:     // Interrupt source override (bus 0 = ISA)
+                if (phys8(entry + 2) == 0) {
+                    APIC::add_override(phys8(entry + 3), phys32(entry + 4), phys16(entry + 8));
+                }
+                break;
+            default:
+                break;
+        }
+        entry += len;
+    }
+    
+    return true;
+}
+
+bool SMP::parse_mp(u32 floating) {
+    u32 table = phys32(floating + 4);
+    if (!table || phys8(floating + 11) != 0) return false;  // Default configurations unsupported
+    if (phys32(table) != 0x504D4350) return false;          // "PCMP"
+    if (!checksum_ok(table, phys16(table + 4))) return false;
+    
+    APIC::set_lapic_base(phys32(table + 36));
+    
+    // Bus IDs whose type string starts with "ISA"
+    u32 isa_buses = 0;
+    
+    u32 entry = table + 44;
+    u16 count = phys16(table + 34);
+    for (u16 i = 0; i < count; i++) {
+        switch (phys8(entry)) {
+            case 0:     // Processor (20 bytes)
+                if (phys8(entry + 3) & 0x1) add_cpu(phys8(entry + 1));
+                entry += 20;
+                break;
+            case 1:     // Bus
+                if (phys8(entry + 2) == 'I' && phys8(entry + 3) == 'S' && phys8(entry + 4) == 'A' &&
+                    phys8(entry + 1) < 32) {
+                    isa_buses |= 1u << phys8(entry + 1);
+                }
+                entry += 8;
+                break;
+            case 2:     // I/O APIC, GSIs numbered from zero in table order
+                if (phys8(entry + 3) & 0x1) {
+                    APIC::add_ioapic(phys8(entry + 1), phys32(entry + 4), APIC::get_ioapic_count() * 24);
+                }
+                entry += 8;
+                break;
+            case 3:     // I/O interrupt assignment: ISA IRQ wired to another pin
+                if (phys8(entry + 1) == 0 && phys8(entry + 4) < 32 &&
+                    (isa_buses & (1u << phys8(entry + 4))) && phys8(entry + 5) != phys8(entry + 7)) {
+                    APIC::add_override(phys8(entry + 5), phys8(entry + 7), phys16(entry + 2));
+                }
+                entry += 8;
+                break;
+            default:    // Local interrupt assignment and the rest
+                entry += 8;
+                break;
+        }
+    }
+    
+    return true;
+}
+
+// ===========================================================================
+// AP Startup
+// ===========================================================================
+
+void SMP::start_aps() {
+    if (source == SMPSource::None) return;
+    
+    if (!APIC::init()) {
+        LOG_WARN("SMP: Local APIC unusable, staying on the PIC");
+        return;
+    }
+    if (APIC::route_legacy_irqs(cpus[0].apic_id)) {
+        LOGF_INFO("SMP: %u I/O APIC(s) routing legacy IRQs", APIC::get_ioapic_count());
+    }
+    if (cpu_count < 2) return;
+    
+    // Install the trampoline and the values every AP shares
+    u32 size = static_cast<u32>(ap_trampoline_end - ap_trampoline_start);
+    mem::memcpy(reinterpret_cast<void*>(config::AP_TRAMPOLINE_ADDR), ap_trampoline_start, size);
+    ApParams* params = reinterpret_cast<ApParams*>(
+        config::AP_TRAMPOLINE_ADDR + static_cast<u32>(ap_trampoline_params - ap_trampoline_start));
+    asm volatile("mov %%cr0, %0" : "=r"(params->cr0));
+    asm volatile("mov %%cr3, %0" : "=r"(params->cr3));
+    asm volatile("mov %%cr4, %0" : "=r"(params->cr4));
+    params->entry = reinterpret_cast<u32>(&SMP::ap_entry);
+    
+    for (u32 i = 1; i < cpu_count; i++) {
+        PerCpu& cpu = cpus[i];
+        void* stack = mem::Heap::alloc(AP_STACK_SIZE, mem::MemTag::Kernel);
+        if (!stack) break;
+        cpu.stack_top = reinterpret_cast<u32>(stack) + AP_STACK_SIZE;
+        params->stack = cpu.stack_top;
+        booting = i;
+        
+        // INIT, 10ms, SIPI, and a second SIPI if the first one was missed
+        APIC::send_init(cpu.apic_id);
+        PIT::delay_us(10000);
+        for (u32 sipi = 0; sipi < 2 && !cpu.online; sipi++) {
+            APIC::send_startup(cpu.apic_id, static_cast<u8>(config::AP_TRAMPOLINE_ADDR >> 12));
+            u32 timeout = sipi == 0 ? 1000 : AP_BOOT_TIMEOUT_US;
+            for (u32 waited = 0; waited < timeout && !cpu.online; waited += 100) {
+                PIT::delay_us(100);
+            }
+        }
+        
+        if (!cpu.online) {
+            // The stack stays allocated: a late AP may still be running on it
+            LOGF_WARN("SMP: CPU %u (APIC %u) did not start", i, cpu.apic_id);
+        }
+    }
+    
+    booting = 0;
+    LOGF_INFO("SMP: %u of %u CPUs online", online_count, cpu_count);
+}
+
+void SMP::ap_entry() {
+    PerCpu* cpu = &cpus[booting];
+    
+    GDT::init_cpu(cpu->index, reinterpret_cast<u32>(cpu), sizeof(PerCpu), cpu->stack_top);
+    IDT::load();
+    APIC::init_local();
+    
+    __atomic_add_fetch(&online_count, 1, __ATOMIC_SEQ_CST);
+    cpu->online = true;
+    
+    // From here on this CPU takes tasks from its run queue or steals them,
+    // and its timer preempts them (interrupts come on in the idle loop)
+    sched::TaskManager::init_cpu();
+    if (!APIC::start_timer()) {
+        LOGF_WARN("SMP: CPU %u has no timer, its tasks run until they yield", cpu->index);
+    }
+    sched::TaskManager::idle_loop();
+}
+
+// ===========================================================================
+// TLB Shootdown
+// ===========================================================================
+
+void SMP::flush_tlb_others(u32 start, u32 size) {
+    if (online_count < 2) return;
+    
+    u32 flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    
+    // A CPU waiting its turn still serves the request in flight
+    while (__atomic_exchange_n(&tlb_lock, 1, __ATOMIC_ACQUIRE)) {
+        poll_tlb_shootdown();
+        asm volatile("pause");
+    }
+    
+    u32 self = this_cpu()->index;
+    u32 targets = 0;
+    for (u32 i = 0; i < cpu_count; i++) {
+        if (i != self && cpus[i].online) targets |= 1u << i;
+    }
+    
+    tlb_start = start;
+    tlb_size = size;
+    __atomic_store_n(&tlb_pending, targets, __ATOMIC_RELEASE);
+    for (u32 i = 0; i < cpu_count; i++) {
+        if (targets & (1u << i)) APIC::send_ipi(cpus[i].apic_id, config::TLB_SHOOTDOWN_VECTOR);
+    }
+    while (tlb_pending) asm volatile("pause");
+    
+    __atomic_store_n(&tlb_lock, 0, __ATOMIC_RELEASE);
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+void SMP::serve_tlb_shootdown() {
+    if (tlb_size == 0) {
+        mem::VMM::flush_tlb_all();
+    } else {
+        mem::VMM::flush_tlb_range_local(tlb_start, tlb_size);
+    }
+    __atomic_and_fetch(&tlb_pending, ~(1u << this_cpu()->index), __ATOMIC_RELEASE);
+}
+
+} // namespace bolt
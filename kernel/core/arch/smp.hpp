@@ -0,0 +1,90 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Symmetric Multiprocessing
+ * ===========================================================================
+ * Finds the processors in the ACPI MADT (or the older MP table), starts the
+ * application processors with INIT-SIPI-SIPI through a real-mode trampoline
+ * and gives every CPU a PerCpu block that GS points at.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+#include "../sys/config.hpp"
+
+namespace bolt::sched { struct Task; }
+
+namespace bolt {
+
+// Per-CPU data, reached through GS on the CPU that owns it
+struct PerCpu {
+    PerCpu* self;                   // %gs:0, so this_cpu() is a single load
+    u32 index;                      // Logical CPU number (0 = boot CPU)
+    u8 apic_id;
+    volatile bool online;
+    sched::Task* current_task;      // Task running on this CPU
+    u32 stack_top;                  // Kernel stack (TSS esp0)
+};
+
+enum class SMPSource : u8 {
+    None,                           // Uniprocessor, PIC only
+    ACPI,                           // MADT
+    MPTable                         // Intel MultiProcessor Specification
+};
+
+class SMP {
+public:
+    static constexpr u32 AP_STACK_SIZE = 0x2000;
+    static constexpr u32 AP_BOOT_TIMEOUT_US = 100000;
+    
+    // Boot CPU's per-CPU block and GS (right after GDT::init)
+    static void init_bsp();
+    
+    // Read the MADT/MP table from physical memory (before paging)
+    static bool detect();
+    
+    // APIC setup, IRQ routing and AP startup (after paging and heap growth)
+    static void start_aps();
+    
+    static PerCpu* this_cpu() {
+        PerCpu* cpu;
+        asm volatile("mov %%gs:0, %0" : "=r"(cpu));
+        return cpu;
+    }
+    static PerCpu* get_cpu(u32 index) { return index < cpu_count ? &cpus[index] : nullptr; }
+    static u32 get_cpu_count() { return cpu_count; }
+    static u32 get_online_count() { return online_count; }
+    static SMPSource get_source() { return source; }
+    
+    // TLB shootdown: drop [start, start + size) from every other online
+    // CPU's TLB (size 0 = everything) and wait until they have. Unmap
+    // before calling and free the frames after it returns.
+    static void flush_tlb_others(u32 start, u32 size);
+    
+    // Serve a shootdown aimed at this CPU: from the IPI, and from lock
+    // spinners that wait with interrupts off
+    static void poll_tlb_shootdown() {
+        if (tlb_pending & (1u << this_cpu()->index)) serve_tlb_shootdown();
+    }
+
+private:
+    static bool parse_madt(u32 rsdp);
+    static bool parse_mp(u32 floating);
+    static u32 find_signature(u32 start, u32 length, const char* sig, u32 sig_len);
+    static bool checksum_ok(u32 addr, u32 length);
+    static void add_cpu(u8 apic_id);
+    static void ap_entry();
+    static void serve_tlb_shootdown();
+    
+    static PerCpu cpus[config::MAX_CPUS];
+    static u32 cpu_count;
+    static volatile u32 online_count;
+    static volatile u32 booting;        // Index of the AP being started
+    static SMPSource source;
+    
+    // One shootdown in flight at a time
+    static volatile u32 tlb_lock;
+    static volatile u32 tlb_pending;    // CPUs that still have to flush
+    static volatile u32 tlb_start;
+    static volatile u32 tlb_size;
+};
+
+} // namespace bolt
@@ -3,30 +3,65 @@
  * =========================================================================== */
 
 #include "heap.hpp"
+#include "reclaim.hpp"
+#include "slab.hpp"
+#include "vmm.hpp"
+#include "../sys/io.hpp"
 
 namespace bolt::mem {
 
+Spinlock mm_lock;
+
 Heap::Block* Heap::head = nullptr;
 u32 Heap::heap_used = 0;
+u32 Heap::slab_used = 0;
 u32 Heap::heap_size = 0;
 u32 Heap::total_system_memory = 0;
+u32 Heap::bootstrap_size = 0;
+Heap::Chunk Heap::chunks[Heap::MAX_CHUNKS];
+bool Heap::can_grow = false;
+u32 Heap::freed_since_trim = 0;
+HeapGrowthStats Heap::growth = {0, 0, 0, 0, 0, 0};
+HeapTagStats Heap::tag_stats[static_cast<u32>(MemTag::Count)];
+HeapAllocSite Heap::sites[config::HEAP_DEBUG ? config::HEAP_DEBUG_SITES : 1];
+u32 Heap::alloc_seq = 0;
+u32 Heap::leak_mark = 0;
+
+static const char* const tag_names[] = {
+    "general", "kernel", "task", "vfs", "fat32", "ramfs", "device", "shell"
+};
+
+const char* mem_tag_name(MemTag tag) {
+    u32 index = static_cast<u32>(tag);
+    return index < static_cast<u32>(MemTag::Count) ? tag_names[index] : "?";
+}
+
+// Heap addresses are 32-bit wherever the heap runs, the host harness's
+// arena included
+static u32 address_of(const void* ptr) {
+    return static_cast<u32>(reinterpret_cast<usize>(ptr));
+}
 
 void Heap::init() {
     // Read total memory from bootloader (stored at 0x500)
-    total_system_memory = *reinterpret_cast<volatile u32*>(MEMINFO_ADDR);
+    init(io::read_fixed<u32>(MEMINFO_ADDR));
+}
+
+void Heap::init(u32 system_memory) {
+    total_system_memory = system_memory;
     
     // Sanity check - if detection failed, assume 16MB
-    if (total_system_memory < 0x200000 || total_system_memory > 0x40000000) {
+    if (total_system_memory < 0x200000) {
         total_system_memory = 0x1000000;  // 16MB fallback
     }
     
-    // Calculate heap size: total memory - 1MB (for kernel, stack, etc.)
-    // Leave some room at the top for safety
-    heap_size = total_system_memory - HEAP_START - 0x10000;  // Reserve 64KB at top
-    
-    // Clamp to reasonable limits
+    // The bootstrap heap is identity-mapped and claimed before the PMM
+    // exists; everything past it is grown from PMM frames once paging is up
+    heap_size = BOOTSTRAP_SIZE;
+    u32 room = total_system_memory - HEAP_START - 0x10000;  // Reserve 64KB at top
+    if (heap_size > room) heap_size = room;
     if (heap_size < MIN_HEAP_SIZE) heap_size = MIN_HEAP_SIZE;
-    if (heap_size > MAX_HEAP_SIZE) heap_size = MAX_HEAP_SIZE;
+    bootstrap_size = heap_size;
     
     // Initialize heap
     head = reinterpret_cast<Block*>(HEAP_START);
@@ -36,7 +71,51 @@ void Heap::init() {
     heap_used = 0;
 }
 
-void* Heap::alloc(usize size) {
+void* Heap::alloc(usize size, MemTag tag) {
+    return alloc_traced(size, tag, __builtin_return_address(0));
+}
+
+void* Heap::alloc_traced(usize size, MemTag tag, void* caller) {
+    // Small objects come from the slab magazines (not with leak
+    // tracking: it wants every allocation on the block list)
+    if (!config::HEAP_DEBUG && size <= Slab::MAX_OBJECT) {
+        void* obj = Slab::alloc(size, tag);
+        if (obj) return obj;
+    }
+    
+    u32 flags = mm_lock.lock();
+    void* ptr = take_block(size, tag, caller);
+    if (!ptr) {
+        // Out of room: grow from the PMM, then squeeze the caches once
+        MemTag previous = Reclaim::begin_alloc(tag);
+        bool grown = grow(size);
+        Reclaim::end_alloc(previous);
+        if (grown) {
+            ptr = take_block(size, tag, caller);
+        }
+        if (!ptr && Reclaim::reclaim_for_heap(size + sizeof(Block), tag) > 0) {
+            ptr = take_block(size, tag, caller);
+        }
+        if (!ptr) {
+            __atomic_add_fetch(&tag_stats[static_cast<u32>(tag)].failed_allocs, 1, __ATOMIC_RELAXED);
+            mm_lock.unlock(flags);
+            return nullptr;
+        }
+    }
+    
+    // Refill to the low-water mark while there is still room to spare;
+    // free frames count as room once the heap can grow into them
+    u64 free_bytes = heap_size - heap_used;
+    if (can_grow) free_bytes += PMM::get_free_memory();
+    if (free_bytes < config::HEAP_LOW_WATER) {
+        Reclaim::reclaim_for_heap(config::HEAP_LOW_WATER - static_cast<u32>(free_bytes), tag);
+    }
+    
+    mm_lock.unlock(flags);
+    return ptr;
+}
+
+void* Heap::take_block(usize size, MemTag tag, void* caller) {
     // Align to 8 bytes
     size = (size + 7) & ~7;
     
@@ -57,34 +136,57 @@ void* Heap::alloc(usize size) {
             }
             
             block->used = true;
+            block->tag = tag;
             heap_used += block->size;
-            return reinterpret_cast<u8*>(block) + sizeof(Block);
+            count_alloc(tag, block->size);
+            
+            void* ptr = reinterpret_cast<u8*>(block) + sizeof(Block);
+            if (config::HEAP_DEBUG) track(ptr, block->size, tag, caller);
+            return ptr;
         }
         block = block->next;
     }
+    
     return nullptr;
 }
 
-void* Heap::alloc_zeroed(usize size) {
-    void* ptr = alloc(size);
+void* Heap::alloc_zeroed(usize size, MemTag tag) {
+    void* ptr = alloc_traced(size, tag, __builtin_return_address(0));
     if (ptr) memset(ptr, 0, size);
     return ptr;
 }
 
 void Heap::free(void* ptr) {
     if (!ptr) return;
+    if (Slab::owns(ptr)) {
+        Slab::free(ptr);
+        return;
+    }
     
+    u32 flags = mm_lock.lock();
     Block* block = reinterpret_cast<Block*>(
         static_cast<u8*>(ptr) - sizeof(Block)
     );
     block->used = false;
     heap_used -= block->size;
+    count_free(block->tag, block->size);
+    if (config::HEAP_DEBUG) untrack(ptr);
     
-    // Coalesce with next block if free
-    if (block->next && !block->next->used) {
+    // Coalesce with next block if free (and not in another chunk)
+    if (block->next && !block->next->used && adjacent(block, block->next)) {
         block->size += sizeof(Block) + block->next->size;
         block->next = block->next->next;
     }
+    
+    // Hand whole chunks back once enough of the grown heap is free again
+    if (address_of(block) >= config::HEAP_VIRT_BASE) {
+        freed_since_trim += block->size;
+        if (freed_since_trim >= config::HEAP_GROW_MIN) {
+            freed_since_trim = 0;
+            trim();
+        }
+    }
+    mm_lock.unlock(flags);
 }
 
 usize Heap::get_used() { return heap_used; }
@@ -92,15 +194,296 @@ usize Heap::get_free() { return heap_size - heap_used; }
 usize Heap::get_total() { return heap_size; }
 usize Heap::get_total_system_memory() { return total_system_memory; }
 
+// ===========================================================================
+// Growth
+// ===========================================================================
+
+void Heap::enable_growth() {
+    can_grow = VMM::is_paging_enabled();
+}
+
+Heap::Chunk* Heap::chunk_at(Block* block) {
+    u32 base = address_of(block);
+    for (u32 i = 0; i < MAX_CHUNKS; i++) {
+        if (chunks[i].size && chunks[i].base == base) return &chunks[i];
+    }
+    return nullptr;
+}
+
+bool Heap::grow(usize size) {
+    if (!can_grow) return false;
+    
+    u32 bytes = (static_cast<u32>(size) + sizeof(Block) + 7 + PMM::PAGE_SIZE - 1) & ~(PMM::PAGE_SIZE - 1);
+    if (bytes < config::HEAP_GROW_MIN) bytes = config::HEAP_GROW_MIN;
+    if (bytes > PMM::get_free_memory()) {
+        growth.failed_grows++;
+        return false;
+    }
+    
+    Chunk* slot = nullptr;
+    for (u32 i = 0; i < MAX_CHUNKS && !slot; i++) {
+        if (!chunks[i].size) slot = &chunks[i];
+    }
+    if (!slot) {
+        growth.failed_grows++;
+        return false;
+    }
+    
+    // First fit in the window, leaving an unmapped guard page between
+    // chunks so blocks never coalesce across them
+    u32 base = config::HEAP_VIRT_BASE;
+    for (u32 i = 0; i < MAX_CHUNKS; i++) {
+        const Chunk& c = chunks[i];
+        if (!c.size) continue;
+        if (base < c.base + c.size + PMM::PAGE_SIZE && c.base < base + bytes + PMM::PAGE_SIZE) {
+            base = c.base + c.size + PMM::PAGE_SIZE;
+            i = static_cast<u32>(-1);   // Rescan against the new candidate
+        }
+    }
+    if (base + bytes > config::HEAP_VIRT_LIMIT || base + bytes < base) {
+        growth.failed_grows++;
+        return false;
+    }
+    
+    // Claim the range before mapping: the PMM may run reclaim (and trim)
+    // while the frames are being allocated
+    slot->base = base;
+    slot->size = bytes;
+    for (u32 offset = 0; offset < bytes; offset += PMM::PAGE_SIZE) {
+        if (VMM::is_mapped(base + offset) || !VMM::alloc_page(base + offset)) {
+            VMM::free_range(base, offset);
+            slot->size = 0;
+            growth.failed_grows++;
+            return false;
+        }
+    }
+    
+    Block* chunk_block = reinterpret_cast<Block*>(base);
+    chunk_block->size = bytes - sizeof(Block);
+    chunk_block->used = false;
+    chunk_block->tag = MemTag::General;
+    
+    // Keep the list in address order
+    Block* prev = head;
+    while (prev->next && prev->next < chunk_block) prev = prev->next;
+    chunk_block->next = prev->next;
+    prev->next = chunk_block;
+    
+    heap_size += bytes;
+    growth.chunks++;
+    growth.grows++;
+    growth.grown_bytes += bytes;
+    return true;
+}
+
+void Heap::release_chunk(Chunk& chunk) {
+    // Unmapped (and shot down on the other CPUs) before the frames go back
+    VMM::free_range(chunk.base, chunk.size);
+    
+    heap_size -= chunk.size;
+    growth.chunks--;
+    growth.trims++;
+    growth.returned_bytes += chunk.size;
+    chunk.size = 0;
+}
+
+usize Heap::trim() {
+    usize returned = 0;
+    u32 flags = mm_lock.lock();
+    
+    // head is the bootstrap region and never a chunk
+    Block* prev = head;
+    Block* block = head ? head->next : nullptr;
+    while (block) {
+        // free() only merges forward, so finish the job here
+        while (!block->used && block->next && !block->next->used && adjacent(block, block->next)) {
+            block->size += sizeof(Block) + block->next->size;
+            block->next = block->next->next;
+        }
+        
+        Chunk* chunk = block->used ? nullptr : chunk_at(block);
+        if (chunk && chunk->size == sizeof(Block) + block->size &&
+            heap_size - heap_used - chunk->size >= config::HEAP_LOW_WATER) {
+            prev->next = block->next;
+            returned += chunk->size;
+            release_chunk(*chunk);
+            block = prev->next;
+            continue;
+        }
+        
+        prev = block;
+        block = block->next;
+    }
+    
+    mm_lock.unlock(flags);
+    return returned;
+}
+
+// ===========================================================================
+// Accounting
+// ===========================================================================
+
+const HeapTagStats& Heap::get_tag_stats(MemTag tag) {
+    u32 index = static_cast<u32>(tag);
+    if (index >= static_cast<u32>(MemTag::Count)) index = 0;
+    return tag_stats[index];
+}
+
+// Slab objects are charged from the magazine fast path, outside mm_lock,
+// so the counters are only ever updated atomically
+void Heap::count_alloc(MemTag tag, u32 bytes) {
+    HeapTagStats& ts = tag_stats[static_cast<u32>(tag)];
+    u32 live = __atomic_add_fetch(&ts.live_bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ts.live_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ts.total_allocs, 1, __ATOMIC_RELAXED);
+    
+    u32 peak = __atomic_load_n(&ts.peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&ts.peak_bytes, &peak, live, true,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+void Heap::count_free(MemTag tag, u32 bytes) {
+    HeapTagStats& ts = tag_stats[static_cast<u32>(tag)];
+    __atomic_sub_fetch(&ts.live_bytes, bytes, __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&ts.live_allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ts.total_frees, 1, __ATOMIC_RELAXED);
+}
+
+void Heap::charge_slab(MemTag tag, u32 bytes) {
+    count_alloc(tag, bytes);
+    __atomic_add_fetch(&slab_used, bytes, __ATOMIC_RELAXED);
+}
+
+void Heap::uncharge_slab(MemTag tag, u32 bytes) {
+    count_free(tag, bytes);
+    __atomic_sub_fetch(&slab_used, bytes, __ATOMIC_RELAXED);
+}
+
+void Heap::get_class_stats(HeapClassStats& out) {
+    memset(&out, 0, sizeof(out));
+    
+    for (Block* block = head; block; block = block->next) {
+        u32 cls = 0;
+        while (cls + 1 < HeapClassStats::CLASSES && block->size > HeapClassStats::class_size(cls)) {
+            cls++;
+        }
+        
+        if (block->used) {
+            out.live_blocks[cls]++;
+            out.live_bytes[cls] += block->size;
+        } else {
+            out.free_blocks[cls]++;
+            out.free_bytes[cls] += block->size;
+            if (block->size > out.largest_free) out.largest_free = block->size;
+        }
+    }
+}
+
+bool Heap::check(HeapCheck& out) {
+    memset(&out, 0, sizeof(out));
+    u32 flags = mm_lock.lock();
+    
+    // Blocks tile the bootstrap region and every chunk, in address order
+    u32 tiled = 0;
+    u32 used = 0;
+    u32 max_blocks = heap_size / sizeof(Block);
+    u32 bootstrap_end = address_of(head) + bootstrap_size;
+    for (Block* block = head; block && !out.error; block = block->next) {
+        u32 start = address_of(block);
+        u32 end = start + sizeof(Block) + block->size;
+        
+        bool inside = start >= address_of(head) && end <= bootstrap_end;
+        for (u32 i = 0; i < MAX_CHUNKS && !inside; i++) {
+            inside = chunks[i].size && start >= chunks[i].base && end <= chunks[i].base + chunks[i].size;
+        }
+        
+        if (!inside) out.error = "block outside the heap";
+        else if (block->next && block->next <= block) out.error = "block list out of order";
+        else if (++out.blocks > max_blocks) out.error = "block list loops";
+        else if (block->used && static_cast<u32>(block->tag) >= static_cast<u32>(MemTag::Count)) {
+            out.error = "bad tag on used block";
+        }
+        
+        tiled += sizeof(Block) + block->size;
+        if (block->used) {
+            used += block->size;
+        } else {
+            out.free_blocks++;
+            out.free_bytes += block->size;
+            if (block->size > out.largest_free) out.largest_free = block->size;
+        }
+    }
+    
+    u32 tagged = 0;
+    for (u32 t = 0; t < static_cast<u32>(MemTag::Count); t++) {
+        tagged += tag_stats[t].live_bytes;
+    }
+    
+    // Sums are meaningless past a broken link
+    if (!out.error) {
+        if (tiled != heap_size) out.error = "blocks do not cover the heap";
+        else if (used != heap_used) out.error = "used bytes disagree with block list";
+        else if (tagged != heap_used + slab_used) out.error = "tag counters disagree with used bytes";
+    }
+    
+    mm_lock.unlock(flags);
+    return out.error == nullptr;
+}
+
+// ===========================================================================
+// Leak Tracking
+// ===========================================================================
+
+void Heap::track(void* ptr, u32 size, MemTag tag, void* caller) {
+    alloc_seq++;
+    for (u32 i = 0; i < config::HEAP_DEBUG_SITES; i++) {
+        if (!sites[i].ptr) {
+            sites[i] = {ptr, caller, size, alloc_seq, tag};
+            return;
+        }
+    }
+    // Table full: the allocation simply goes unrecorded
+}
+
+void Heap::untrack(void* ptr) {
+    for (u32 i = 0; i < config::HEAP_DEBUG_SITES; i++) {
+        if (sites[i].ptr == ptr) {
+            sites[i].ptr = nullptr;
+            return;
+        }
+    }
+}
+
+u32 Heap::mark() {
+    leak_mark = alloc_seq;
+    return leak_mark;
+}
+
+const HeapAllocSite* Heap::get_site(u32 index) {
+    if (!config::HEAP_DEBUG || index >= config::HEAP_DEBUG_SITES || !sites[index].ptr) {
+        return nullptr;
+    }
+    return &sites[index];
+}
+
 } // namespace bolt::mem
 
-// Global new/delete operators
+// Global new/delete operators; host programs keep the C++ runtime's
+#ifndef BOLT_HOST
 void* operator new(bolt::usize size) {
-    return bolt::mem::Heap::alloc(size);
+    return bolt::mem::Heap::alloc_traced(size, bolt::mem::MemTag::General, __builtin_return_address(0));
 }
 
 void* operator new[](bolt::usize size) {
-    return bolt::mem::Heap::alloc(size);
+    return bolt::mem::Heap::alloc_traced(size, bolt::mem::MemTag::General, __builtin_return_address(0));
+}
+
+void* operator new(bolt::usize size, bolt::mem::MemTag tag) {
+    return bolt::mem::Heap::alloc_traced(size, tag, __builtin_return_address(0));
+}
+
+void* operator new[](bolt::usize size, bolt::mem::MemTag tag) {
+    return bolt::mem::Heap::alloc_traced(size, tag, __builtin_return_address(0));
 }
 
 void operator delete(void* ptr) noexcept {
@@ -118,3 +501,4 @@ void operator delete(void* ptr, bolt::usize) noexcept {
 void operator delete[](void* ptr, bolt::usize) noexcept {
     bolt::mem::Heap::free(ptr);
 }
+#endif // BOLT_HOST
@@ -5,6 +5,7 @@
 
 #include "../../lib/types.hpp"
 #include "../sys/config.hpp"
+#include "../sys/spinlock.hpp"
 
 namespace bolt::mem {
 
@@ -32,6 +33,74 @@ inline int memcmp(const void* s1, const void* s2, usize count) {
     return 0;
 }
 
+// Owner of a heap allocation, for per-subsystem accounting
+enum class MemTag : u8 {
+    General = 0,    // Untagged new/alloc
+    Kernel,         // PMM/VMM metadata
+    Task,           // Task stacks
+    VFS,            // VFS buffers
+    FAT32,          // FAT32 caches and open-file state
+    RAMFS,          // RAMFS file data and directory state
+    Device,         // Block devices and partitions
+    Shell,          // Command buffers
+    Count
+};
+
+const char* mem_tag_name(MemTag tag);
+
+// Per-tag counters
+struct HeapTagStats {
+    u32 live_bytes;
+    u32 peak_bytes;
+    u32 live_allocs;
+    u32 total_allocs;               // Monotonic, for rates
+    u32 total_frees;
+    u32 failed_allocs;
+};
+
+// Live/free blocks bucketed by power-of-two size class
+struct HeapClassStats {
+    static constexpr u32 CLASSES = 14;  // 16 bytes .. 64KB, last bucket takes the rest
+    u32 live_blocks[CLASSES];
+    u32 live_bytes[CLASSES];
+    u32 free_blocks[CLASSES];
+    u32 free_bytes[CLASSES];
+    u32 largest_free;
+    
+    static u32 class_size(u32 index) { return 16u << index; }
+};
+
+// Live allocation recorded when config::HEAP_DEBUG is on
+struct HeapAllocSite {
+    void* ptr;                      // nullptr = slot free
+    void* caller;                   // Return address of the allocating call
+    u32 size;
+    u32 seq;                        // Allocation sequence number
+    MemTag tag;
+};
+
+// Growth of the heap beyond its bootstrap region
+struct HeapGrowthStats {
+    u32 chunks;                     // Live growth chunks
+    u32 grows;
+    u32 failed_grows;
+    u32 trims;                      // Chunks handed back to the PMM
+    u32 grown_bytes;                // Monotonic
+    u32 returned_bytes;
+};
+
+// Result of Heap::check: the block list walked end to end
+struct HeapCheck {
+    u32 blocks;
+    u32 free_blocks;
+    u32 free_bytes;
+    u32 largest_free;
+    const char* error;              // First broken invariant, or nullptr
+};
+
+// Serializes the heap, the PMM and the slab central lists between CPUs
+extern Spinlock mm_lock;
+
 // Simple heap allocator
 class Heap {
 public:
@@ -40,29 +109,86 @@ public:
     
     // Use config values for heap layout
     static constexpr u32 HEAP_START = config::HEAP_START;
-    static constexpr u32 MIN_HEAP_SIZE = config::HEAP_SIZE;
-    static constexpr u32 MAX_HEAP_SIZE = config::MAX_MEMORY;
+    static constexpr u32 MIN_HEAP_SIZE = 0x100000;
+    static constexpr u32 BOOTSTRAP_SIZE = config::HEAP_SIZE;
+    static constexpr u32 MAX_CHUNKS = 64;
     
     static void init();
-    static void* alloc(usize size);
-    static void* alloc_zeroed(usize size);
+    static void init(u32 system_memory);   // Size given by the caller, not the bootloader
+    static void* alloc(usize size, MemTag tag = MemTag::General);
+    static void* alloc_zeroed(usize size, MemTag tag = MemTag::General);
     static void free(void* ptr);
     static usize get_used();
     static usize get_free();
     static usize get_total();
     static usize get_total_system_memory();
+    static usize get_bootstrap_size() { return bootstrap_size; }
+    
+    // Growth: map PMM frames into the heap window on demand (needs paging)
+    static void enable_growth();
+    static bool growth_enabled() { return can_grow; }
+    static usize trim();                    // Return fully free chunks to the PMM
+    static const HeapGrowthStats& get_growth_stats() { return growth; }
+    
+    // Allocation on behalf of caller (operator new passes its own return address)
+    static void* alloc_traced(usize size, MemTag tag, void* caller);
+    
+    // Accounting
+    static const HeapTagStats& get_tag_stats(MemTag tag);
+    static void charge_slab(MemTag tag, u32 bytes);     // Slab objects count against their tag too
+    static void uncharge_slab(MemTag tag, u32 bytes);
+    static void get_class_stats(HeapClassStats& out);
+    
+    // Verify the block list against the counters (for stress tests)
+    static bool check(HeapCheck& out);
+    
+    // Leak tracking (config::HEAP_DEBUG): live sites allocated after mark()
+    static u32 mark();
+    static u32 get_mark() { return leak_mark; }
+    static const HeapAllocSite* get_site(u32 index);
     
 private:
     struct Block {
         u32 size;
         bool used;
+        MemTag tag;
         Block* next;
     };
     
+    // Run of PMM frames mapped at [base, base + size) in the heap window
+    struct Chunk {
+        u32 base;
+        u32 size;                           // 0 = slot free
+    };
+    
+    static void* take_block(usize size, MemTag tag, void* caller);  // First fit
+    static bool grow(usize size);
+    static void release_chunk(Chunk& chunk);
+    static Chunk* chunk_at(Block* block);
+    static bool adjacent(Block* block, Block* next) {
+        return reinterpret_cast<u8*>(block) + sizeof(Block) + block->size == reinterpret_cast<u8*>(next);
+    }
+    static void count_alloc(MemTag tag, u32 bytes);
+    static void count_free(MemTag tag, u32 bytes);
+    static void track(void* ptr, u32 size, MemTag tag, void* caller);
+    static void untrack(void* ptr);
+    
     static Block* head;
     static u32 heap_used;
+    static u32 slab_used;               // Slab object bytes charged to tags
     static u32 heap_size;
     static u32 total_system_memory;
+    static u32 bootstrap_size;
+    
+    static Chunk chunks[MAX_CHUNKS];
+    static bool can_grow;
+    static u32 freed_since_trim;        // Chunk bytes freed since the last trim
+    static HeapGrowthStats growth;
+    
+    static HeapTagStats tag_stats[static_cast<u32>(MemTag::Count)];
+    static HeapAllocSite sites[config::HEAP_DEBUG ? config::HEAP_DEBUG_SITES : 1];
+    static u32 alloc_seq;
+    static u32 leak_mark;
 };
 
 } // namespace bolt::mem
@@ -70,6 +196,8 @@ private:
 // Global operators for new/delete
 void* operator new(bolt::usize size);
 void* operator new[](bolt::usize size);
+void* operator new(bolt::usize size, bolt::mem::MemTag tag);
+void* operator new[](bolt::usize size, bolt::mem::MemTag tag);
 void operator delete(void* ptr) noexcept;
 void operator delete[](void* ptr) noexcept;
 void operator delete(void* ptr, bolt::usize) noexcept;
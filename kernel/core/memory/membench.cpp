@@ -0,0 +1,353 @@
+/* ===========================================================================
+ * BOLT OS - Allocator Benchmarks Implementation
+ * =========================================================================== */
+
+#include "membench.hpp"
+#include "heap.hpp"
+#include "../../drivers/timer/tsc.hpp"
+#include "../../lib/string.hpp"
+
+namespace bolt::mem {
+
+using namespace drivers;
+
+// Free space is sampled this often outside stress mode
+static constexpr u32 SAMPLE_INTERVAL = 32;
+
+struct LiveBlock {
+    void* ptr;              // nullptr once released
+    u32 size;
+};
+
+// State of one trace replay
+struct TraceRun {
+    const MemTarget* target;
+    const MemBenchConfig* cfg;
+    u32 random;
+    
+    LiveBlock* live;        // cfg->live entries
+    u32 count;
+    
+    u32* alloc_cycles;      // cfg->ops entries each
+    u32* free_cycles;
+    u32 allocs;
+    u32 frees;
+    u64 cycles;
+    
+    u32 ops;
+    u32 failed;
+    u32 frag_failed;
+    u32 peak_frag;
+    const char* error;
+    u32 error_op;
+    
+    bool done() const { return ops >= cfg->ops || error; }
+};
+
+// ===========================================================================
+// Helpers
+// ===========================================================================
+
+static u32 next_random(u32& state) {
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+}
+
+static u32 clamp_cycles(u64 cycles) {
+    return cycles >> 32 ? 0xFFFFFFFF : static_cast<u32>(cycles);
+}
+
+// Shell sort; the sample arrays are too big for insertion sort
+static void sort(u32* values, u32 count) {
+    u32 gap = 1;
+    while (gap < count / 3) gap = gap * 3 + 1;
+    for (; gap > 0; gap /= 3) {
+        for (u32 i = gap; i < count; i++) {
+            u32 v = values[i];
+            u32 j = i;
+            for (; j >= gap && values[j - gap] > v; j -= gap) {
+                values[j] = values[j - gap];
+            }
+            values[j] = v;
+        }
+    }
+}
+
+static u32 percentile(u32* sorted, u32 count, u32 pct) {
+    return count ? sorted[count * pct / 100] : 0;
+}
+
+// Describe free space; also the invariant check in stress mode
+static MemShape sample(TraceRun& run) {
+    MemShape shape = {0, 0};
+    const char* error = nullptr;
+    if (!run.target->check) return shape;
+    
+    if (!run.target->check(shape, error) && !run.error) {
+        run.error = error ? error : "check failed";
+        run.error_op = run.ops;
+    }
+    
+    // Percent outside the largest block; big byte counts would overflow *100
+    u32 free = shape.free_units;
+    u32 outside = free - shape.largest_free;
+    u32 frag = 0;
+    if (free >= 0x1000000) frag = outside / (free / 100);
+    else if (free) frag = outside * 100 / free;
+    if (frag > run.peak_frag) run.peak_frag = frag;
+    return shape;
+}
+
+static void after_op(TraceRun& run) {
+    if (run.cfg->stress || run.ops % SAMPLE_INTERVAL == 0) sample(run);
+}
+
+// ===========================================================================
+// Timed Operations
+// ===========================================================================
+
+static bool op_alloc(TraceRun& run, u32 size) {
+    if (run.count == run.cfg->live) return false;
+    
+    u64 start = TSC::read();
+    void* ptr = run.target->alloc(size);
+    u64 cycles = TSC::read() - start;
+    run.cycles += cycles;
+    run.alloc_cycles[run.allocs++] = clamp_cycles(cycles);
+    run.ops++;
+    
+    if (ptr) {
+        run.live[run.count++] = {ptr, size};
+    } else {
+        run.failed++;
+        if (sample(run).free_units >= size) run.frag_failed++;
+    }
+    after_op(run);
+    return ptr != nullptr;
+}
+
+// Free in place; compact() drops the hole later
+static void op_release(TraceRun& run, u32 index) {
+    LiveBlock& block = run.live[index];
+    
+    u64 start = TSC::read();
+    run.target->free(block.ptr, block.size);
+    u64 cycles = TSC::read() - start;
+    run.cycles += cycles;
+    run.free_cycles[run.frees++] = clamp_cycles(cycles);
+    run.ops++;
+    
+    block.ptr = nullptr;
+    after_op(run);
+}
+
+// Free and fill the hole with the last block (order does not matter)
+static void op_take(TraceRun& run, u32 index) {
+    op_release(run, index);
+    run.live[index] = run.live[--run.count];
+}
+
+static void compact(TraceRun& run) {
+    u32 kept = 0;
+    for (u32 i = 0; i < run.count; i++) {
+        if (run.live[i].ptr) run.live[kept++] = run.live[i];
+    }
+    run.count = kept;
+}
+
+// ===========================================================================
+// Traces
+// ===========================================================================
+
+static u32 uniform_size(TraceRun& run) {
+    const MemTarget& t = *run.target;
+    return t.min_size + next_random(run.random) % (t.max_size - t.min_size + 1);
+}
+
+// Size class k with probability 2^-(k+1), uniform within the class
+static u32 power_size(TraceRun& run) {
+    const MemTarget& t = *run.target;
+    u32 bits = next_random(run.random);
+    u32 base = t.min_size;
+    while ((bits & 1) && base < t.max_size) {
+        base <<= 1;
+        bits >>= 1;
+    }
+    u32 size = base + next_random(run.random) % base;
+    return size < t.max_size ? size : t.max_size;
+}
+
+// Allocate with probability 1 - count/live, so the live set settles at half
+static void trace_random(TraceRun& run, bool power_law) {
+    while (!run.done()) {
+        if (run.count == 0 || next_random(run.random) % run.cfg->live >= run.count) {
+            op_alloc(run, power_law ? power_size(run) : uniform_size(run));
+        } else {
+            op_take(run, next_random(run.random) % run.count);
+        }
+    }
+}
+
+static void trace_prodcons(TraceRun& run) {
+    u32 burst = run.cfg->live / 4 ? run.cfg->live / 4 : 1;
+    while (!run.done()) {
+        if (run.count + burst <= run.cfg->live) {
+            for (u32 i = 0; i < burst && !run.done(); i++) {
+                op_alloc(run, uniform_size(run));
+            }
+        } else {
+            for (u32 i = 0; i < burst && i < run.count && !run.done(); i++) {
+                op_release(run, i);
+            }
+            compact(run);
+        }
+    }
+}
+
+static void trace_storm(TraceRun& run) {
+    const MemTarget& t = *run.target;
+    u32 small = t.max_size / 16 > t.min_size ? t.max_size / 16 : t.min_size;
+    u32 large_tries = run.cfg->live / 8 ? run.cfg->live / 8 : 1;
+    
+    while (!run.done()) {
+        // Fill with small blocks, then punch a hole between every pair
+        while (run.count < run.cfg->live && !run.done()) {
+            if (!op_alloc(run, small)) break;
+        }
+        for (u32 i = 1; i < run.count && !run.done(); i += 2) {
+            op_release(run, i);
+        }
+        compact(run);
+        sample(run);
+        
+        // The holes are too small: these fail unless the allocator can
+        // find or make room elsewhere
+        for (u32 i = 0; i < large_tries && !run.done(); i++) {
+            op_alloc(run, t.max_size);
+        }
+        
+        for (u32 i = 0; i < run.count && !run.done(); i++) {
+            op_release(run, i);
+        }
+        compact(run);
+    }
+}
+
+// ===========================================================================
+// Run
+// ===========================================================================
+
+bool MemBench::run(const MemTarget& target, MemTrace trace, const MemBenchConfig& cfg,
+                   Callback callback, void* ctx) {
+    TraceRun run;
+    memset(&run, 0, sizeof(run));
+    run.target = &target;
+    run.cfg = &cfg;
+    run.random = cfg.seed + static_cast<u32>(trace);
+    
+    MemBenchResult result;
+    memset(&result, 0, sizeof(result));
+    result.target = target.name;
+    result.trace = trace_name(trace);
+    
+    // Bookkeeping comes from the heap before the trace starts, so it never
+    // shows up in the measurements (and when the heap is the target, it is
+    // simply part of the live set)
+    run.live = static_cast<LiveBlock*>(Heap::alloc(cfg.live * sizeof(LiveBlock)));
+    run.alloc_cycles = static_cast<u32*>(Heap::alloc(cfg.ops * sizeof(u32)));
+    run.free_cycles = static_cast<u32*>(Heap::alloc(cfg.ops * sizeof(u32)));
+    if (!run.live || !run.alloc_cycles || !run.free_cycles || cfg.live == 0 ||
+        target.min_size == 0 || target.max_size < target.min_size) {
+        run.error = "no memory for the harness";
+    }
+    
+    if (!run.error) {
+        if (cfg.stress) sample(run);
+        
+        switch (trace) {
+            case MemTrace::Uniform:  trace_random(run, false); break;
+            case MemTrace::PowerLaw: trace_random(run, true); break;
+            case MemTrace::ProdCons: trace_prodcons(run); break;
+            case MemTrace::Storm:    trace_storm(run); break;
+            default: break;
+        }
+        
+        // Leftovers go back untimed; the allocator must be whole afterwards
+        for (u32 i = 0; i < run.count; i++) {
+            if (run.live[i].ptr) target.free(run.live[i].ptr, run.live[i].size);
+        }
+        run.count = 0;
+        if (cfg.stress) sample(run);
+        
+        sort(run.alloc_cycles, run.allocs);
+        sort(run.free_cycles, run.frees);
+    }
+    
+    result.ops = run.ops;
+    result.allocs = run.allocs;
+    result.failed = run.failed;
+    result.frag_failed = run.frag_failed;
+    result.peak_frag = run.peak_frag;
+    result.us = TSC::to_us(run.cycles);
+    result.alloc_p50 = percentile(run.alloc_cycles, run.allocs, 50);
+    result.alloc_p99 = percentile(run.alloc_cycles, run.allocs, 99);
+    result.free_p50 = percentile(run.free_cycles, run.frees, 50);
+    result.free_p99 = percentile(run.free_cycles, run.frees, 99);
+    result.error = run.error;
+    result.error_op = run.error_op;
+    callback(result, ctx);
+    
+    Heap::free(run.free_cycles);
+    Heap::free(run.alloc_cycles);
+    Heap::free(run.live);
+    return run.error == nullptr;
+}
+
+bool MemBench::run_all(const MemTarget& target, const MemBenchConfig& cfg,
+                       Callback callback, void* ctx) {
+    bool ok = true;
+    for (u32 t = 0; t < static_cast<u32>(MemTrace::Count); t++) {
+        ok &= run(target, static_cast<MemTrace>(t), cfg, callback, ctx);
+    }
+    return ok;
+}
+
+// ===========================================================================
+// Reporting
+// ===========================================================================
+
+const char* MemBench::trace_name(MemTrace trace) {
+    switch (trace) {
+        case MemTrace::Uniform:  return "uniform";
+        case MemTrace::PowerLaw: return "powerlaw";
+        case MemTrace::ProdCons: return "prodcons";
+        case MemTrace::Storm:    return "storm";
+        default:                 return "?";
+    }
+}
+
+const char* MemBench::csv_header() {
+    return "membench,target,trace,ops,allocs,failed,frag_failed,peak_frag,us,"
+           "ops_per_s,alloc_p50,alloc_p99,free_p50,free_p99,status";
+}
+
+void MemBench::format_csv(const MemBenchResult& r, char* line) {
+    u32 values[] = {r.ops, r.allocs, r.failed, r.frag_failed, r.peak_frag, r.us,
+                    TSC::per_second(r.ops, r.us), r.alloc_p50, r.alloc_p99,
+                    r.free_p50, r.free_p99};
+    
+    str::cpy(line, "membench,");
+    str::cat(line, r.target);
+    str::cat(line, ",");
+    str::cat(line, r.trace);
+    for (u32 v : values) {
+        char num[12];
+        str::utoa(v, num);
+        str::cat(line, ",");
+        str::cat(line, num);
+    }
+    str::cat(line, ",");
+    str::cat(line, r.error ? r.error : "ok");
+}
+
+} // namespace bolt::mem
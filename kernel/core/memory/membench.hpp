@@ -0,0 +1,100 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Allocator Benchmarks
+ * ===========================================================================
+ * Replays synthetic allocation traces against an allocator: throughput,
+ * per-call latency percentiles in TSC cycles, peak fragmentation and how
+ * often allocations fail while enough memory is free in total. Stress mode
+ * verifies the allocator's invariants after every operation and stops at
+ * the first violation.
+ *
+ * The harness only sees a MemTarget, so the same traces drive the kernel
+ * Heap and PMM (the `membench` command) and the host heap (build/host).
+ *
+ * Each trace becomes one CSV row:
+ *   membench,target,trace,ops,allocs,failed,frag_failed,peak_frag,us,
+ *   ops_per_s,alloc_p50,alloc_p99,free_p50,free_p99,status
+ * where status is ok or the first broken invariant.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+
+namespace bolt::mem {
+
+// Free space as the allocator sees it, in its own unit
+struct MemShape {
+    u32 free_units;
+    u32 largest_free;       // Biggest single allocation that can succeed
+};
+
+// An allocator under test; sizes are in `unit`s (bytes, pages)
+struct MemTarget {
+    const char* name;
+    const char* unit;
+    u32 min_size;
+    u32 max_size;           // Storm fills with max/16, then asks for max
+    void* (*alloc)(u32 size);
+    void (*free)(void* ptr, u32 size);
+    // Describe free space and verify invariants; nullptr if unsupported
+    bool (*check)(MemShape& shape, const char*& error);
+};
+
+enum class MemTrace : u8 {
+    Uniform,                // Sizes uniform in [min, max], random frees
+    PowerLaw,               // Mostly small sizes, rare large ones
+    ProdCons,               // Bursts allocated, then freed oldest first
+    Storm,                  // Fill, free every other block, ask for large ones
+    Count
+};
+
+struct MemBenchConfig {
+    u32 ops;                // Allocations plus frees per trace
+    u32 live;               // Most blocks held at once
+    u32 seed;               // Traces are identical for equal seeds
+    bool stress;            // check() after every operation
+    
+    static MemBenchConfig defaults() {
+        return {20000, 256, 0x2545F491, false};
+    }
+    
+    static MemBenchConfig quick() {
+        return {2000, 64, 0x2545F491, false};
+    }
+};
+
+struct MemBenchResult {
+    const char* target;
+    const char* trace;
+    u32 ops;
+    u32 allocs;
+    u32 failed;             // Allocations that returned nothing
+    u32 frag_failed;        // ...although enough was free in total
+    u32 peak_frag;          // Percent of free space outside the largest block
+    u32 us;                 // Time spent inside the allocator
+    u32 alloc_p50;          // Latencies in cycles
+    u32 alloc_p99;
+    u32 free_p50;
+    u32 free_p99;
+    const char* error;      // First broken invariant, or nullptr
+    u32 error_op;           // Operation after which it was found
+};
+
+class MemBench {
+public:
+    using Callback = void (*)(const MemBenchResult& result, void* ctx);
+    
+    static constexpr u32 CSV_LINE = 224;
+    
+    // Replay one trace; everything allocated is freed again before
+    // returning. Returns false on a broken invariant.
+    static bool run(const MemTarget& target, MemTrace trace, const MemBenchConfig& cfg,
+                    Callback callback, void* ctx);
+    static bool run_all(const MemTarget& target, const MemBenchConfig& cfg,
+                        Callback callback, void* ctx);
+    
+    static const char* trace_name(MemTrace trace);
+    static const char* csv_header();
+    static void format_csv(const MemBenchResult& result, char* line);
+};
+
+} // namespace bolt::mem
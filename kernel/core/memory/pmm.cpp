@@ -6,6 +6,7 @@
 
 #include "pmm.hpp"
 #include "heap.hpp"
+#include "reclaim.hpp"
 #include "../sys/io.hpp"
 #include "../sys/system.hpp"
 
@@ -18,44 +19,83 @@ u64 PMM::total_memory = 0;
 u32 PMM::total_pages = 0;
 u32 PMM::used_pages = 0;
 u32 PMM::free_page_count = 0;
+u8* PMM::extra_refs = nullptr;
+u32 PMM::shared_pages = 0;
+
+// E820 entry left by the bootloader
+static const MemoryMapEntry& memmap_entry(u32 index) {
+    return *reinterpret_cast<const MemoryMapEntry*>(PMM::MEMMAP_ADDR + index * sizeof(MemoryMapEntry));
+}
 
 void PMM::init() {
-    // First try to get memory from System detection
-    if (sys::g_system && sys::g_system->total_memory > 0) {
-        total_memory = sys::g_system->total_memory;
-    } else {
-        // Fallback: Read total memory from bootloader (stored at 0x500 by E820 detection)
-        total_memory = *reinterpret_cast<volatile u32*>(MEMMAP_ADDR);
+    // Top of usable RAM from the E820 map, which also gives the holes
+    u32 regions = io::read_fixed<u32>(MEMMAP_COUNT_ADDR) & 0xFFFF;
+    if (regions > MEMMAP_MAX) regions = 0;
+    total_memory = 0;
+    for (u32 i = 0; i < regions; i++) {
+        const MemoryMapEntry& entry = memmap_entry(i);
+        if (entry.type != MemoryRegionType::Available) continue;
+        u64 end = entry.base + entry.length;
+        if (end > total_memory) total_memory = end;
+    }
+    
+    if (total_memory == 0) {
+        if (sys::g_system && sys::g_system->total_memory > 0) {
+            total_memory = sys::g_system->total_memory;
+        } else {
+            // Fallback: Read total memory from bootloader (stored at 0x500 by E820 detection)
+            total_memory = io::read_fixed<u32>(MEMINFO_ADDR);
+        }
     }
     
     // Sanity check - if detection failed, assume 16MB
     constexpr u64 MIN_REASONABLE_MEMORY = 0x200000;     // 2MB
-    constexpr u64 MAX_REASONABLE_MEMORY = 0x100000000;  // 4GB
     constexpr u64 FALLBACK_MEMORY = 0x1000000;          // 16MB
     
-    if (total_memory < MIN_REASONABLE_MEMORY || total_memory > MAX_REASONABLE_MEMORY) {
+    if (total_memory < MIN_REASONABLE_MEMORY) {
         total_memory = FALLBACK_MEMORY;
+        regions = 0;
     }
     
-    // Cap at max supported memory
+    setup(regions);
+}
+
+void PMM::init_flat(u64 memory) {
+    total_memory = memory;
+    setup(0);
+}
+
+void PMM::setup(u32 regions) {
+    // Frames must have 32-bit physical addresses
     if (total_memory > MAX_MEMORY) {
         total_memory = MAX_MEMORY;
     }
     
-    // Update System info with actual detected value
-    if (sys::g_system) {
-        sys::g_system->total_memory = total_memory;
-        sys::g_system->usable_memory = total_memory - (4 * 1024 * 1024);
-    }
-    
     // Calculate total pages
-    total_pages = static_cast<u32>(total_memory / PAGE_SIZE);
+    total_pages = static_cast<u32>(total_memory >> PAGE_SHIFT);
     
     // Calculate bitmap size (1 bit per page)
     bitmap_size = (total_pages + PAGES_PER_BYTE - 1) / PAGES_PER_BYTE;
     
-    // Place bitmap at fixed location (after heap start)
-    bitmap = reinterpret_cast<u8*>(BITMAP_START);
+    // The fixed slot before the heap covers 2GB; larger maps come from the heap
+    constexpr u32 BITMAP_SLOT = config::HEAP_START - BITMAP_START;
+    if (bitmap_size <= BITMAP_SLOT) {
+        bitmap = reinterpret_cast<u8*>(BITMAP_START);
+    } else {
+        bitmap = static_cast<u8*>(Heap::alloc(bitmap_size, MemTag::Kernel));
+        if (!bitmap) {
+            bitmap = reinterpret_cast<u8*>(BITMAP_START);
+            bitmap_size = BITMAP_SLOT;
+            total_pages = BITMAP_SLOT * PAGES_PER_BYTE;
+            total_memory = static_cast<u64>(total_pages) << PAGE_SHIFT;
+        }
+    }
+    
+    // Update System info with actual detected value
+    if (sys::g_system) {
+        sys::g_system->total_memory = total_memory;
+        sys::g_system->usable_memory = total_memory - (4 * 1024 * 1024);
+    }
     
     // Initialize bitmap: mark ALL pages as used initially
     for (u32 i = 0; i < bitmap_size; i++) {
@@ -69,7 +109,17 @@ void PMM::init() {
     constexpr u32 FREE_MEMORY_START = 0x400000;  // 4MB - everything below is reserved
     u32 free_end = static_cast<u32>(total_memory);
     
-    if (free_end > FREE_MEMORY_START) {
+    if (regions > 0) {
+        // Only what the firmware reported as RAM; PCI holes stay used
+        for (u32 i = 0; i < regions; i++) {
+            const MemoryMapEntry& entry = memmap_entry(i);
+            u64 base = entry.base;
+            if (entry.type != MemoryRegionType::Available || base >= free_end) continue;
+            u64 end = base + entry.length;
+            if (end > free_end) end = free_end;
+            mark_region_free(static_cast<u32>(base), static_cast<u32>(end - base));
+        }
+    } else if (free_end > FREE_MEMORY_START) {
         mark_region_free(FREE_MEMORY_START, free_end - FREE_MEMORY_START);
     }
     
@@ -78,15 +128,29 @@ void PMM::init() {
     
     // Ensure kernel region stays reserved (1MB - 4MB)
     mark_region_used(KERNEL_START, FREE_MEMORY_START - KERNEL_START);
+    
+    // The heap owns its range outright
+    mark_region_used(config::HEAP_START, static_cast<u32>(Heap::get_bootstrap_size()));
+    
+    // Sharing counts for copy-on-write; without them frames are never shared
+    extra_refs = static_cast<u8*>(Heap::alloc_zeroed(total_pages, MemTag::Kernel));
+    shared_pages = 0;
 }
 
 u32 PMM::alloc_page() {
+    u32 flags = mm_lock.lock();
     if (free_page_count == 0) {
-        return 0;  // Out of memory
+        // Last chance: caches may hand frames back
+        Reclaim::reclaim_for_pmm(PAGE_SIZE);
+        if (free_page_count == 0) {
+            mm_lock.unlock(flags);
+            return 0;  // Out of memory
+        }
     }
     
     u32 frame = find_first_free();
     if (frame == 0xFFFFFFFF) {
+        mm_lock.unlock(flags);
         return 0;  // No free page found
     }
     
@@ -94,16 +158,31 @@ u32 PMM::alloc_page() {
     used_pages++;
     free_page_count--;
     
+    // One reclaim pass each time the free count crosses the low-water mark
+    if (free_page_count == config::PMM_LOW_WATER_PAGES) {
+        Reclaim::reclaim_for_pmm(config::PMM_LOW_WATER_PAGES * PAGE_SIZE);
+    }
+    
+    mm_lock.unlock(flags);
     return frame_to_addr(frame);
 }
 
 u32 PMM::alloc_pages(u32 count) {
     if (count == 0) return 0;
     if (count == 1) return alloc_page();
-    if (free_page_count < count) return 0;
+    
+    u32 flags = mm_lock.lock();
+    if (free_page_count < count) {
+        Reclaim::reclaim_for_pmm((count - free_page_count) * PAGE_SIZE);
+        if (free_page_count < count) {
+            mm_lock.unlock(flags);
+            return 0;
+        }
+    }
     
     u32 start_frame = find_first_free_sequence(count);
     if (start_frame == 0xFFFFFFFF) {
+        mm_lock.unlock(flags);
         return 0;  // No contiguous region found
     }
     
@@ -115,6 +194,7 @@ u32 PMM::alloc_pages(u32 count) {
     used_pages += count;
     free_page_count -= count;
     
+    mm_lock.unlock(flags);
     return frame_to_addr(start_frame);
 }
 
@@ -124,12 +204,37 @@ void PMM::free_page(u32 phys_addr) {
     u32 frame = addr_to_frame(phys_addr);
     if (frame >= total_pages) return;
     
-    // Only free if currently used
-    if (bitmap_test(frame)) {
+    u32 flags = mm_lock.lock();
+    if (extra_refs && extra_refs[frame] != 0) {
+        // A shared frame only loses one reference
+        if (extra_refs[frame] != REF_MAX) {
+            extra_refs[frame]--;
+            if (extra_refs[frame] == 0) shared_pages--;
+        }
+    } else if (bitmap_test(frame)) {
+        // Only free if currently used
         bitmap_clear(frame);
         used_pages--;
         free_page_count++;
     }
+    mm_lock.unlock(flags);
+}
+
+bool PMM::ref_page(u32 phys_addr) {
+    u32 frame = addr_to_frame(phys_addr);
+    if (!extra_refs || frame >= total_pages || !bitmap_test(frame)) return false;
+    
+    u32 flags = mm_lock.lock();
+    if (extra_refs[frame] == 0) shared_pages++;
+    if (extra_refs[frame] != REF_MAX) extra_refs[frame]++;
+    mm_lock.unlock(flags);
+    return true;
+}
+
+u32 PMM::get_ref_count(u32 phys_addr) {
+    u32 frame = addr_to_frame(phys_addr);
+    if (frame >= total_pages || !bitmap_test(frame)) return 0;
+    return 1 + (extra_refs ? extra_refs[frame] : 0);
 }
 
 void PMM::free_page_range(u32 phys_addr, u32 count) {
@@ -179,9 +284,42 @@ PhysicalMemoryStats PMM::get_stats() {
     stats.total_pages = total_pages;
     stats.used_pages = used_pages;
     stats.free_pages = free_page_count;
+    stats.shared_pages = shared_pages;
     return stats;
 }
 
+bool PMM::check(PMMCheck& out) {
+    out = {0, 0, 0, 0, nullptr};
+    u32 flags = mm_lock.lock();
+    
+    u32 run = 0;
+    u32 shared = 0;
+    for (u32 frame = 0; frame < total_pages; frame++) {
+        u32 refs = extra_refs ? extra_refs[frame] : 0;
+        if (refs) shared++;
+        
+        if (bitmap_test(frame)) {
+            out.used_pages++;
+            run = 0;
+            continue;
+        }
+        
+        out.free_pages++;
+        if (run++ == 0) out.free_runs++;
+        if (run > out.largest_run) out.largest_run = run;
+        if (refs && !out.error) out.error = "free frame has references";
+    }
+    
+    if (!out.error) {
+        if (out.used_pages != used_pages) out.error = "used count disagrees with bitmap";
+        else if (out.free_pages != free_page_count) out.error = "free count disagrees with bitmap";
+        else if (shared != shared_pages) out.error = "shared count disagrees with references";
+    }
+    
+    mm_lock.unlock(flags);
+    return out.error == nullptr;
+}
+
 void PMM::bitmap_set(u32 frame) {
     if (frame < total_pages) {
         bitmap[frame / PAGES_PER_BYTE] |= (1 << (frame % PAGES_PER_BYTE));
@@ -37,6 +37,16 @@ struct PhysicalMemoryStats {
     u32 total_pages;        // Total page frames
     u32 used_pages;         // Allocated page frames
     u32 free_pages;         // Free page frames
+    u32 shared_pages;       // Frames referenced more than once
+};
+
+// Result of PMM::check: the bitmap recounted from scratch
+struct PMMCheck {
+    u32 used_pages;
+    u32 free_pages;
+    u32 free_runs;          // Maximal runs of free frames
+    u32 largest_run;        // Longest run, the limit for alloc_pages
+    const char* error;      // First broken invariant, or nullptr
 };
 
 class PMM {
@@ -51,9 +61,19 @@ public:
     static constexpr u32 BITMAP_START = config::PMM_BITMAP_START;  // PMM bitmap location
     static constexpr u32 MAX_MEMORY = config::MAX_MEMORY;
     
+    // Memory map from bootloader (usable E820 entries only)
+    static constexpr u32 MEMINFO_ADDR = 0x500;      // Sum of usable lengths
+    static constexpr u32 MEMMAP_COUNT_ADDR = 0x504; // Entry count (16-bit)
+    static constexpr u32 MEMMAP_ADDR = 0x508;       // MemoryMapEntry array
+    static constexpr u32 MEMMAP_MAX = 10;           // Room below the VESA block at 0x600
+    
     // Initialize PMM with memory map from bootloader
     static void init();
     
+    // Initialize with [0, memory) as plain RAM and no firmware map (host
+    // harness); the fixed low ranges are reserved as in init()
+    static void init_flat(u64 memory);
+    
     // Allocate a single physical page
     // Returns physical address or 0 on failure
     static u32 alloc_page();
@@ -62,9 +82,16 @@ public:
     // Returns physical address of first page or 0 on failure
     static u32 alloc_pages(u32 count);
     
-    // Free a single physical page
+    // Free a single physical page (drops one reference if it is shared)
     static void free_page(u32 phys_addr);
     
+    // Add a reference to an allocated page; each reference needs its own
+    // free_page before the frame is released
+    static bool ref_page(u32 phys_addr);
+    
+    // References held on a page (0 if free)
+    static u32 get_ref_count(u32 phys_addr);
+    
     // Free contiguous physical pages
     static void free_page_range(u32 phys_addr, u32 count);
     
@@ -80,6 +107,9 @@ public:
     // Get memory statistics
     static PhysicalMemoryStats get_stats();
     
+    // Recount the bitmap and reference table against the counters
+    static bool check(PMMCheck& out);
+    
     // Get total detected memory
     static u64 get_total_memory() { return total_memory; }
     
@@ -111,19 +141,25 @@ private:
     // Find first sequence of free frames
     static u32 find_first_free_sequence(u32 count);
     
+    // Bitmap and free ranges for total_memory; regions > 0 means the E820
+    // map at MEMMAP_ADDR says which frames are RAM
+    static void setup(u32 regions);
+    
     // Bitmap array (1 bit per page)
     static u8* bitmap;
     static u32 bitmap_size;         // Size in bytes
     
+    // References beyond the first, per frame (saturates: pinned for good)
+    static constexpr u8 REF_MAX = 0xFF;
+    static u8* extra_refs;
+    static u32 shared_pages;        // Frames with extra references
+    
     // Memory tracking
     static u64 total_memory;        // Total detected RAM
     static u32 total_pages;         // Total page frames
     static u32 used_pages;          // Allocated frames
     static u32 free_page_count;     // Free frames
-    
-    // Memory map from bootloader
-    static constexpr u32 MEMMAP_ADDR = 0x500;       // Memory map location
-    static constexpr u32 MEMMAP_COUNT_ADDR = 0x5F0; // Entry count location
+
 };
 
 // Helper macros for page alignment
@@ -0,0 +1,88 @@
+/* ===========================================================================
+ * BOLT OS - Memory Reclaim Implementation
+ * =========================================================================== */
+
+#include "reclaim.hpp"
+
+namespace bolt::mem {
+
+Shrinker* Reclaim::shrinkers[Reclaim::MAX_SHRINKERS];
+ReclaimStats Reclaim::stats = {0, 0, 0, 0, 0};
+bool Reclaim::active = false;
+MemTag Reclaim::alloc_requester = MemTag::Count;
+
+bool Reclaim::register_shrinker(Shrinker* shrinker) {
+    if (!shrinker || !shrinker->count || !shrinker->scan) return false;
+    
+    for (u32 i = 0; i < MAX_SHRINKERS; i++) {
+        if (shrinkers[i] == shrinker) return true;
+    }
+    for (u32 i = 0; i < MAX_SHRINKERS; i++) {
+        if (!shrinkers[i]) {
+            shrinker->calls = 0;
+            shrinker->freed_bytes = 0;
+            shrinkers[i] = shrinker;
+            return true;
+        }
+    }
+    return false;  // Registry full
+}
+
+void Reclaim::unregister_shrinker(Shrinker* shrinker) {
+    for (u32 i = 0; i < MAX_SHRINKERS; i++) {
+        if (shrinkers[i] == shrinker) {
+            shrinkers[i] = nullptr;
+        }
+    }
+}
+
+usize Reclaim::reclaim(usize target, MemTag requester) {
+    if (active || target == 0) return 0;
+    active = true;
+    stats.runs++;
+    
+    usize freed = 0;
+    for (u32 i = 0; i < MAX_SHRINKERS && freed < target; i++) {
+        Shrinker* shrinker = shrinkers[i];
+        if (!shrinker || shrinker->owner == requester) continue;
+        if (shrinker->count(shrinker->ctx) == 0) continue;
+        
+        usize got = shrinker->scan(shrinker->ctx, target - freed);
+        shrinker->calls++;
+        shrinker->freed_bytes += got;
+        freed += got;
+    }
+    
+    stats.freed_bytes += freed;
+    if (freed < target) stats.short_runs++;
+    active = false;
+    return freed;
+}
+
+usize Reclaim::reclaim_for_heap(usize target, MemTag requester) {
+    if (active) return 0;
+    stats.heap_triggers++;
+    return reclaim(target, requester);
+}
+
+usize Reclaim::reclaim_for_pmm(usize target) {
+    if (active) return 0;
+    stats.pmm_triggers++;
+    
+    // A heap or slab allocation may be growing underneath its owner's
+    // cache (a FAT32 index insert, say): that owner is exempt. Whatever the
+    // caches freed in grown chunks is then trimmed back to the PMM
+    usize freed = reclaim(target, alloc_requester);
+    Heap::trim();
+    return freed;
+}
+
+usize Reclaim::reclaimable() {
+    usize total = 0;
+    for (u32 i = 0; i < MAX_SHRINKERS; i++) {
+        if (shrinkers[i]) total += shrinkers[i]->count(shrinkers[i]->ctx);
+    }
+    return total;
+}
+
+} // namespace bolt::mem
@@ -0,0 +1,77 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Memory Reclaim (Shrinker Registry)
+ * ===========================================================================
+ * Caches register a shrinker that can give back heap memory on demand.
+ * Heap::alloc and PMM::alloc_page run the shrinkers when free memory drops
+ * below a low-water mark and once more before reporting failure.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+#include "heap.hpp"
+
+namespace bolt::mem {
+
+struct Shrinker {
+    const char* name;
+    MemTag owner;                                   // Skipped for allocations with this tag
+    usize (*count)(void* ctx);                      // Reclaimable bytes right now
+    usize (*scan)(void* ctx, usize target);         // Release about target bytes, return freed
+    void* ctx;
+    
+    // Statistics
+    u32 calls;                                      // Times scan ran
+    u32 freed_bytes;                                // Total given back
+};
+
+struct ReclaimStats {
+    u32 runs;                   // Reclaim passes
+    u32 heap_triggers;          // Passes started by Heap::alloc
+    u32 pmm_triggers;           // Passes started by PMM::alloc_page
+    u32 freed_bytes;            // Total released by all shrinkers
+    u32 short_runs;             // Passes that fell short of their target
+};
+
+class Reclaim {
+public:
+    static constexpr u32 MAX_SHRINKERS = 16;
+    
+    // Shrinker storage belongs to the caller and must outlive registration
+    static bool register_shrinker(Shrinker* shrinker);
+    static void unregister_shrinker(Shrinker* shrinker);
+    
+    // Ask shrinkers for target bytes, oldest registration first. Shrinkers
+    // owned by the requesting tag are skipped: an allocation from inside a
+    // cache must not pull memory out from under that cache.
+    static usize reclaim(usize target, MemTag requester);
+    
+    // Entry points for the allocators. The PMM has no tag of its own: it
+    // spares the owner of the heap or slab allocation that is taking frames
+    static usize reclaim_for_heap(usize target, MemTag requester);
+    static usize reclaim_for_pmm(usize target);
+    
+    // Bracket heap growth and new slab pages (under mm_lock) so a PMM
+    // reclaim further down knows who is allocating
+    static MemTag begin_alloc(MemTag requester) {
+        MemTag previous = alloc_requester;
+        alloc_requester = requester;
+        return previous;
+    }
+    static void end_alloc(MemTag previous) { alloc_requester = previous; }
+    
+    // Everything currently reclaimable
+    static usize reclaimable();
+    
+    static const Shrinker* get_shrinker(u32 index) {
+        return index < MAX_SHRINKERS ? shrinkers[index] : nullptr;
+    }
+    static const ReclaimStats& get_stats() { return stats; }
+    
+private:
+    static Shrinker* shrinkers[MAX_SHRINKERS];
+    static ReclaimStats stats;
+    static bool active;         // Shrinkers free memory; that must not recurse
+    static MemTag alloc_requester;  // MemTag::Count outside begin/end_alloc
+};
+
+} // namespace bolt::mem
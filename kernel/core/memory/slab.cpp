@@ -0,0 +1,285 @@
+/* ===========================================================================
+ * BOLT OS - Slab Allocator Implementation
+ * =========================================================================== */
+
+#include "slab.hpp"
+#include "heap.hpp"
+#include "vmm.hpp"
+#include "../arch/smp.hpp"
+
+namespace bolt::mem {
+
+bool Slab::ready = false;
+Slab::CpuCache Slab::cpu_caches[config::MAX_CPUS];
+Slab::Cache Slab::caches[Slab::CLASSES];
+u32 Slab::window_map[Slab::WINDOW_PAGES / 32];
+Shrinker Slab::shrinker;
+
+// Magazines are per-CPU state: keep interrupts out while one is touched
+static inline u32 irq_save() {
+    u32 flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void irq_restore(u32 flags) {
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
+
+void Slab::init() {
+    if (!VMM::is_paging_enabled()) return;
+    
+    for (u32 c = 0; c < CLASSES; c++) {
+        caches[c].stats.object_size = class_size(c);
+    }
+    
+    shrinker = {"slab", MemTag::Kernel, shrinker_count, shrinker_scan, nullptr, 0, 0};
+    Reclaim::register_shrinker(&shrinker);
+    ready = true;
+}
+
+Slab::CpuCache& Slab::this_cpu() {
+    return cpu_caches[SMP::this_cpu()->index];
+}
+
+// ===========================================================================
+// Fast Path
+// ===========================================================================
+
+void* Slab::alloc(usize size, MemTag tag) {
+    if (!ready || size > MAX_OBJECT) return nullptr;
+    
+    u32 cls = class_of(size);
+    u32 flags = irq_save();
+    Magazine& mag = this_cpu().magazines[cls];
+    if (mag.count == 0 && !refill(cls, mag, tag)) {
+        irq_restore(flags);
+        return nullptr;
+    }
+    void* obj = mag.objects[--mag.count];
+    tag_of(page_of(obj), obj) = tag;
+    Heap::charge_slab(tag, class_size(cls));
+    irq_restore(flags);
+    return obj;
+}
+
+void Slab::free(void* ptr) {
+    Page* page = page_of(ptr);
+    u32 cls = page->cls;
+    u32 flags = irq_save();
+    Heap::uncharge_slab(tag_of(page, ptr), class_size(cls));
+    Magazine& mag = this_cpu().magazines[cls];
+    if (mag.count == MAGAZINE_SIZE) flush(cls, mag, BATCH);
+    mag.objects[mag.count++] = ptr;
+    irq_restore(flags);
+}
+
+// ===========================================================================
+// Central Slabs
+// ===========================================================================
+
+bool Slab::refill(u32 cls, Magazine& mag, MemTag tag) {
+    Cache& cache = caches[cls];
+    u32 flags = mm_lock.lock();
+    
+    // Re-check the magazine every round: new_page can run reclaim, which
+    // may free objects into it or drain it. It spares the tag the object
+    // is for, as heap growth does
+    while (mag.count < BATCH) {
+        Page* page = cache.partial;
+        if (!page) {
+            MemTag previous = Reclaim::begin_alloc(tag);
+            page = new_page(cls);
+            Reclaim::end_alloc(previous);
+            if (!page) break;
+            continue;
+        }
+        
+        if (page->in_use == 0) cache.empty--;
+        while (page->free_list && mag.count < BATCH) {
+            void* obj = page->free_list;
+            page->free_list = *static_cast<void**>(obj);
+            page->in_use++;
+            mag.objects[mag.count++] = obj;
+        }
+        if (!page->free_list) unlink(cache, page);
+    }
+    
+    cache.stats.refills++;
+    mm_lock.unlock(flags);
+    return mag.count > 0;
+}
+
+void Slab::flush(u32 cls, Magazine& mag, u32 count) {
+    if (count > mag.count) count = mag.count;
+    u32 flags = mm_lock.lock();
+    
+    // The oldest objects go back; the most recently freed stay cache-hot
+    for (u32 i = 0; i < count; i++) {
+        put_object(mag.objects[i]);
+    }
+    for (u32 i = count; i < mag.count; i++) {
+        mag.objects[i - count] = mag.objects[i];
+    }
+    mag.count -= count;
+    caches[cls].stats.flushes++;
+    mm_lock.unlock(flags);
+}
+
+void Slab::put_object(void* obj) {
+    Page* page = page_of(obj);
+    Cache& cache = caches[page->cls];
+    
+    *static_cast<void**>(obj) = page->free_list;
+    page->free_list = obj;
+    page->in_use--;
+    
+    if (!page->partial) {
+        page->prev = nullptr;
+        page->next = cache.partial;
+        if (cache.partial) cache.partial->prev = page;
+        cache.partial = page;
+        page->partial = true;
+    }
+    
+    if (page->in_use == 0) {
+        // Keep one empty page per class to absorb alloc/free churn
+        if (cache.empty > 0) {
+            unlink(cache, page);
+            release_page(page);
+        } else {
+            cache.empty++;
+        }
+    }
+}
+
+Slab::Page* Slab::new_page(u32 cls) {
+    u32 index = 0;
+    while (index < WINDOW_PAGES && window_map[index / 32] == 0xFFFFFFFF) index += 32;
+    while (index < WINDOW_PAGES && (window_map[index / 32] & (1u << (index % 32)))) index++;
+    if (index >= WINDOW_PAGES) return nullptr;
+    
+    // Claim the slot before allocating: the PMM may reclaim in between
+    u32 virt = config::SLAB_VIRT_BASE + index * config::PAGE_SIZE;
+    window_map[index / 32] |= 1u << (index % 32);
+    if (VMM::is_mapped(virt) || !VMM::alloc_page(virt)) {
+        window_map[index / 32] &= ~(1u << (index % 32));
+        return nullptr;
+    }
+    
+    // Each object costs its size plus a tag byte after the header
+    Page* page = reinterpret_cast<Page*>(virt);
+    u32 size = class_size(cls);
+    u32 tags = (config::PAGE_SIZE - sizeof(Page)) / (size + 1);
+    u32 first = (sizeof(Page) + tags + MIN_OBJECT - 1) & ~(MIN_OBJECT - 1);
+    u32 capacity = (config::PAGE_SIZE - first) / size;
+    
+    page->cls = static_cast<u16>(cls);
+    page->in_use = 0;
+    page->capacity = static_cast<u16>(capacity < tags ? capacity : tags);
+    page->first = static_cast<u16>(first);
+    page->free_list = nullptr;
+    for (u32 i = page->capacity; i-- > 0;) {
+        void* obj = reinterpret_cast<u8*>(page) + first + i * size;
+        *static_cast<void**>(obj) = page->free_list;
+        page->free_list = obj;
+    }
+    
+    Cache& cache = caches[cls];
+    page->prev = nullptr;
+    page->next = cache.partial;
+    if (cache.partial) cache.partial->prev = page;
+    cache.partial = page;
+    page->partial = true;
+    cache.empty++;
+    
+    cache.stats.slabs++;
+    cache.stats.capacity += page->capacity;
+    return page;
+}
+
+void Slab::unlink(Cache& cache, Page* page) {
+    if (page->prev) page->prev->next = page->next;
+    else cache.partial = page->next;
+    if (page->next) page->next->prev = page->prev;
+    page->next = page->prev = nullptr;
+    page->partial = false;
+}
+
+void Slab::release_page(Page* page) {
+    Cache& cache = caches[page->cls];
+    cache.stats.slabs--;
+    cache.stats.capacity -= page->capacity;
+    cache.stats.slabs_freed++;
+    
+    u32 virt = reinterpret_cast<u32>(page);
+    u32 index = (virt - config::SLAB_VIRT_BASE) / config::PAGE_SIZE;
+    VMM::free_page(virt);
+    window_map[index / 32] &= ~(1u << (index % 32));
+}
+
+// ===========================================================================
+// Reclaim
+// ===========================================================================
+
+usize Slab::drain() {
+    usize freed = 0;
+    u32 flags = mm_lock.lock();
+    
+    // Only this CPU's magazines can be flushed without an IPI; the
+    // others keep theirs until they flush on their own
+    CpuCache& cpu = this_cpu();
+    for (u32 c = 0; c < CLASSES; c++) {
+        if (cpu.magazines[c].count) flush(c, cpu.magazines[c], MAGAZINE_SIZE);
+    }
+    
+    for (u32 c = 0; c < CLASSES; c++) {
+        Cache& cache = caches[c];
+        Page* page = cache.partial;
+        while (page) {
+            Page* next = page->next;
+            if (page->in_use == 0) {
+                unlink(cache, page);
+                cache.empty--;
+                release_page(page);
+                freed += config::PAGE_SIZE;
+            }
+            page = next;
+        }
+    }
+    
+    mm_lock.unlock(flags);
+    return freed;
+}
+
+usize Slab::shrinker_count(void*) {
+    usize bytes = 0;
+    for (u32 c = 0; c < CLASSES; c++) {
+        bytes += caches[c].empty * config::PAGE_SIZE;
+        bytes += this_cpu().magazines[c].count * class_size(c);
+    }
+    return bytes;
+}
+
+usize Slab::shrinker_scan(void*, usize) {
+    return drain();
+}
+
+void Slab::get_stats(u32 cls, SlabCacheStats& out) {
+    if (cls >= CLASSES) cls = 0;
+    out = caches[cls].stats;
+    
+    u32 free_in_pages = 0;
+    out.cached = 0;
+    for (u32 i = 0; i < config::MAX_CPUS; i++) {
+        out.cached += cpu_caches[i].magazines[cls].count;
+    }
+    for (Page* page = caches[cls].partial; page; page = page->next) {
+        free_in_pages += page->capacity - page->in_use;
+    }
+    
+    // Whatever is neither free in a page nor in a magazine is live
+    out.live = out.capacity - free_in_pages - out.cached;
+}
+
+} // namespace bolt::mem
@@ -0,0 +1,117 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Slab Allocator with Per-CPU Magazines
+ * ===========================================================================
+ * Small objects (up to MAX_OBJECT bytes) come from one-page slabs in their
+ * own virtual window instead of the heap's block list. Each CPU keeps a
+ * magazine (a stack of free objects) per size class: alloc pops and free
+ * pushes with interrupts off, no lock. Only an empty or full magazine goes
+ * to the central slab lists, moving BATCH objects at a time.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+#include "../sys/config.hpp"
+#include "reclaim.hpp"
+
+namespace bolt::mem {
+
+struct SlabCacheStats {
+    u32 object_size;
+    u32 slabs;                  // Pages backing this class
+    u32 capacity;               // Objects those pages hold
+    u32 live;                   // Handed out to callers
+    u32 cached;                 // Sitting in CPU magazines
+    u32 refills;                // Batches moved slabs -> magazine
+    u32 flushes;                // Batches moved magazine -> slabs
+    u32 slabs_freed;            // Empty pages returned to the PMM
+};
+
+class Slab {
+public:
+    static constexpr u32 CLASSES = 6;               // 16, 32, .. 512 bytes
+    static constexpr u32 MIN_OBJECT = 16;
+    static constexpr u32 MAX_OBJECT = MIN_OBJECT << (CLASSES - 1);
+    static constexpr u32 MAGAZINE_SIZE = 16;        // Objects per CPU per class
+    static constexpr u32 BATCH = MAGAZINE_SIZE / 2; // Moved per refill/flush
+    
+    // Needs paging; small allocations stay on the heap until then
+    static void init();
+    static bool is_ready() { return ready; }
+    
+    // nullptr when size is too big or no slab page could be had; the
+    // object's class size is charged to tag until it is freed
+    static void* alloc(usize size, MemTag tag);
+    static void free(void* ptr);
+    
+    static bool owns(const void* ptr) {
+        return reinterpret_cast<usize>(ptr) - config::SLAB_VIRT_BASE < config::SLAB_VIRT_SIZE;
+    }
+    
+    // Flush every magazine and return empty slabs to the PMM
+    static usize drain();
+    
+    static void get_stats(u32 cls, SlabCacheStats& out);
+    static u32 class_size(u32 cls) { return MIN_OBJECT << cls; }
+    
+private:
+    static constexpr u32 WINDOW_PAGES = config::SLAB_VIRT_SIZE / config::PAGE_SIZE;
+    
+    // Header at the start of every slab page, then one tag per object,
+    // then the objects from offset first
+    struct Page {
+        Page* next;                 // Partial list links
+        Page* prev;
+        void* free_list;            // Free objects, linked through their first word
+        u16 cls;
+        u16 in_use;                 // Objects out of this page (callers + magazines)
+        u16 capacity;
+        u16 first;
+        bool partial;               // On the class's partial list
+    };
+    
+    struct Magazine {
+        u32 count;
+        void* objects[MAGAZINE_SIZE];
+    };
+    
+    struct CpuCache {
+        Magazine magazines[CLASSES];
+    };
+    
+    struct Cache {
+        Page* partial;              // Pages with free objects
+        u32 empty;                  // Partial pages with nothing in use
+        SlabCacheStats stats;
+    };
+    
+    static u32 class_of(usize size) {
+        return size <= MIN_OBJECT ? 0 : 28 - __builtin_clz(static_cast<u32>(size) - 1);
+    }
+    static Page* page_of(const void* ptr) {
+        return reinterpret_cast<Page*>(reinterpret_cast<usize>(ptr) & ~(config::PAGE_SIZE - 1));
+    }
+    
+    static MemTag& tag_of(Page* page, const void* obj) {
+        u32 slot = static_cast<u32>(reinterpret_cast<usize>(obj) - reinterpret_cast<usize>(page) - page->first) >> (page->cls + 4);
+        return reinterpret_cast<MemTag*>(page + 1)[slot];
+    }
+    
+    static CpuCache& this_cpu();
+    static bool refill(u32 cls, Magazine& mag, MemTag tag);
+    static void flush(u32 cls, Magazine& mag, u32 count);
+    static Page* new_page(u32 cls);
+    static void put_object(void* obj);
+    static void release_page(Page* page);
+    static void unlink(Cache& cache, Page* page);
+    
+    static usize shrinker_count(void* ctx);
+    static usize shrinker_scan(void* ctx, usize target);
+    
+    static bool ready;
+    static CpuCache cpu_caches[config::MAX_CPUS];
+    static Cache caches[CLASSES];
+    static u32 window_map[WINDOW_PAGES / 32];      // Slab pages in use
+    static Shrinker shrinker;
+};
+
+} // namespace bolt::mem
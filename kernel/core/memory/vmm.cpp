@@ -9,7 +9,9 @@
 #include "heap.hpp"
 #include "../sys/io.hpp"
 #include "../sys/log.hpp"
+#include "../sys/system.hpp"
 #include "../arch/idt.hpp"
+#include "../arch/smp.hpp"
 #include "../../drivers/serial/serial.hpp"
 #include "../../drivers/video/vga.hpp"
 
@@ -18,7 +20,14 @@ namespace bolt::mem {
 // Static member definitions
 PageDirectory* VMM::current_directory = nullptr;
 PageDirectory* VMM::kernel_directory = nullptr;
-VirtualMemoryStats VMM::stats = {0, 0, 0, 0};
+bool VMM::paging_active = false;
+bool VMM::global_pages = false;
+u16 VMM::table_use[1024];
+u32 VMM::live_clones = 0;
+u32 VMM::clones[VMM::MAX_CLONES];
+VirtualMemoryStats VMM::stats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+VMArea VMM::vmas[VMM::MAX_VMAS];
+u32 VMM::zero_page = 0;
 
 // Assembly helpers for CR0/CR3
 extern "C" {
@@ -57,20 +66,26 @@ extern "C" {
         asm volatile("mov %%cr2, %0" : "=r"(val));
         return val;
     }
+    
+    static inline u32 read_cr4() {
+        u32 val;
+        asm volatile("mov %%cr4, %0" : "=r"(val));
+        return val;
+    }
+    
+    static inline void write_cr4(u32 val) {
+        asm volatile("mov %0, %%cr4" : : "r"(val) : "memory");
+    }
 }
 
+static constexpr u32 CR4_PGE = 1 << 7;
+
 // Fixed memory locations for initial paging structures (below heap at 3MB)
 // These MUST be within the identity-mapped region
 static constexpr u32 KERNEL_PD_ADDR = 0x300000;     // 3MB - Page Directory
 static constexpr u32 KERNEL_PT_START = 0x301000;    // 3MB+4KB - Start of Page Tables
 // We need 4 page tables to map 16MB (each PT maps 4MB)
 
-void* VMM::alloc_aligned(u32 size) {
-    // Allocate from PMM (already page-aligned)
-    u32 pages = (size + PMM::PAGE_SIZE - 1) / PMM::PAGE_SIZE;
-    return reinterpret_cast<void*>(PMM::alloc_pages(pages));
-}
-
 void VMM::init() {
     // Use fixed addresses for kernel page structures
     // These are in the first 4MB which we'll identity map with the PD itself
@@ -79,15 +94,38 @@ void VMM::init() {
     // Clear the page directory
     for (int i = 0; i < 1024; i++) {
         kernel_directory->entries[i].value = 0;
+        table_use[i] = 0;
     }
     
+    // Kernel mappings are the same in every directory, so with PGE they
+    // can stay in the TLB across CR3 reloads
+    global_pages = sys::g_system && sys::g_system->cpu.has_pge;
+    
     // Identity map the first 16MB for kernel
     // This maps virtual addresses to same physical addresses
     identity_map_kernel();
     
+    // Self-map so page tables stay reachable wherever their frames live
+    kernel_directory->entries[RECURSIVE_PDE].set(KERNEL_PD_ADDR, PageFlags::KernelPage);
+    
     // Set as current
     current_directory = kernel_directory;
     
+    // Create the temp-slot table now so every cloned directory shares it
+    get_page_table(TEMP_MAP_BASE, true);
+    
+    // Frame shared by every not-yet-written page of every VMA
+    for (u32 i = 0; i < MAX_VMAS; i++) {
+        vmas[i].active = false;
+    }
+    for (u32 i = 0; i < MAX_CLONES; i++) {
+        clones[i] = 0;
+    }
+    zero_page = PMM::alloc_page();
+    if (zero_page) {
+        memset(reinterpret_cast<void*>(zero_page), 0, PMM::PAGE_SIZE);
+    }
+    
     // Load the page directory (but don't enable paging yet)
     load_page_directory(reinterpret_cast<u32>(kernel_directory));
 }
@@ -97,7 +135,7 @@ void VMM::identity_map_kernel() {
     // Using 4KB pages for fine-grained control
     // We use fixed page table addresses to avoid chicken-and-egg problem
     
-    u32 map_size = 0x1000000;  // 16MB
+    u32 map_size = config::IDENTITY_MAP_SIZE;
     u32 num_page_tables = map_size / (1024 * PMM::PAGE_SIZE);  // 4 page tables
     
     for (u32 pt_idx = 0; pt_idx < num_page_tables; pt_idx++) {
@@ -106,13 +144,15 @@ void VMM::identity_map_kernel() {
         PageTable* pt = reinterpret_cast<PageTable*>(pt_phys);
         
         // Fill in the page table entries (identity mapping)
+        u32 flags = PageFlags::KernelPage | (global_pages ? PageFlags::Global : 0);
         for (u32 pte_idx = 0; pte_idx < 1024; pte_idx++) {
             u32 phys_addr = (pt_idx * 1024 + pte_idx) * PMM::PAGE_SIZE;
-            pt->entries[pte_idx].set(phys_addr, PageFlags::KernelPage);
+            pt->entries[pte_idx].set(phys_addr, flags);
         }
         
         // Set the page directory entry
         kernel_directory->entries[pt_idx].set(pt_phys, PageFlags::KernelPage);
+        table_use[pt_idx] = 1024;
         stats.page_tables_allocated++;
     }
     
@@ -123,23 +163,51 @@ void VMM::enable_paging() {
     if (current_directory) {
         load_page_directory(reinterpret_cast<u32>(current_directory));
         enable_paging_cr0();
+        paging_active = true;
+        if (global_pages) {
+            write_cr4(read_cr4() | CR4_PGE);
+        }
     }
 }
 
 void VMM::disable_paging() {
     disable_paging_cr0();
+    paging_active = false;
 }
 
 bool VMM::is_paging_enabled() {
     return (read_cr0() & 0x80000000) != 0;
 }
 
+PageDirectory* VMM::active_directory() {
+    if (paging_active) {
+        return reinterpret_cast<PageDirectory*>(PAGE_DIR_VADDR);
+    }
+    return current_directory;
+}
+
+// Page tables of the VMA window belong to one address space; the rest
+// (kernel identity map, framebuffer) is the same everywhere
+static constexpr u32 PRIVATE_PDE_FIRST = VMM::VMA_BASE >> 22;
+static constexpr u32 PRIVATE_PDE_LAST = VMM::VMA_LIMIT >> 22;
+
+static bool is_private(u32 virt_addr) {
+    return virt_addr >= VMM::VMA_BASE && virt_addr < VMM::VMA_LIMIT;
+}
+
 PageTable* VMM::get_page_table(u32 virt_addr, bool create) {
     u32 pde_index = VIRT_TO_PDE_INDEX(virt_addr);
-    PageDirectoryEntry& pde = current_directory->entries[pde_index];
+    if (pde_index == RECURSIVE_PDE) {
+        return nullptr;  // The window itself is not a mappable range
+    }
+    
+    PageDirectoryEntry& pde = active_directory()->entries[pde_index];
+    PageTable* pt = paging_active
+        ? reinterpret_cast<PageTable*>(PAGE_TABLES_VADDR + pde_index * PMM::PAGE_SIZE)
+        : reinterpret_cast<PageTable*>(pde.get_address());
     
     if (pde.is_present()) {
-        return reinterpret_cast<PageTable*>(pde.get_address());
+        return pt;
     }
     
     if (!create) {
@@ -152,76 +220,281 @@ PageTable* VMM::get_page_table(u32 virt_addr, bool create) {
         return nullptr;  // Out of memory
     }
     
+    // Set up the page directory entry
+    pde.set(pt_phys, PageFlags::Present | PageFlags::ReadWrite);
+    table_use[pde_index] = 0;
+    if (paging_active) {
+        flush_tlb_page(reinterpret_cast<u32>(pt));
+    } else {
+        pt = reinterpret_cast<PageTable*>(pt_phys);
+    }
+    
     // Clear the new page table
-    PageTable* pt = reinterpret_cast<PageTable*>(pt_phys);
     for (int i = 0; i < 1024; i++) {
         pt->entries[i].value = 0;
     }
     
-    // Set up the page directory entry
-    pde.set(pt_phys, PageFlags::Present | PageFlags::ReadWrite);
-    
     stats.page_tables_allocated++;
     
+    if (paging_active && live_clones > 0 && !is_private(virt_addr)) {
+        share_kernel_pde(pde_index);
+    }
+    
     return pt;
 }
 
-bool VMM::map_page(u32 virt_addr, u32 phys_addr, u32 flags) {
+void VMM::share_kernel_pde(u32 pde_index) {
+    u32 value = active_directory()->entries[pde_index].value;
+    
+    // The boot directory sits in the identity map
+    if (current_directory != kernel_directory) {
+        kernel_directory->entries[pde_index].value = value;
+    }
+    
+    for (u32 i = 0; i < MAX_CLONES; i++) {
+        if (clones[i] == 0 || clones[i] == reinterpret_cast<u32>(current_directory)) continue;
+        
+        PageDirectory* pd = static_cast<PageDirectory*>(map_temp(2, clones[i]));
+        if (!pd) continue;
+        pd->entries[pde_index].value = value;
+        unmap_temp(2);
+    }
+}
+
+u32 VMM::temp_slot_address(u32 slot) {
+    u32 index = SMP::this_cpu()->index * TEMP_SLOTS_PER_CPU + slot;
+    return TEMP_MAP_BASE + index * PMM::PAGE_SIZE;
+}
+
+void* VMM::map_temp(u32 slot, u32 phys_addr) {
+    if (slot >= TEMP_SLOTS_PER_CPU) return nullptr;
+    if (!paging_active) {
+        return reinterpret_cast<void*>(phys_addr);
+    }
+    
+    u32 flags = mm_lock.lock();
+    u32 virt = temp_slot_address(slot);
+    bool ok = map_page(virt, phys_addr & ~(PMM::PAGE_SIZE - 1), PageFlags::KernelPage);
+    mm_lock.unlock(flags);
+    return ok ? reinterpret_cast<void*>(virt) : nullptr;
+}
+
+void VMM::unmap_temp(u32 slot) {
+    if (slot >= TEMP_SLOTS_PER_CPU || !paging_active) return;
+    
+    // Only this CPU ever touched the slot, so a local invlpg is enough
+    u32 flags = mm_lock.lock();
+    u32 virt = temp_slot_address(slot);
+    if (clear_pte(virt)) {
+        asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+        stats.tlb_page_flushes++;
+    }
+    mm_lock.unlock(flags);
+}
+
+bool VMM::set_pte(u32 virt_addr, u32 phys_addr, u32 flags, bool& replaced) {
     // Get or create page table
     PageTable* pt = get_page_table(virt_addr, true);
     if (!pt) {
         return false;  // Failed to allocate page table
     }
     
-    u32 pte_index = VIRT_TO_PTE_INDEX(virt_addr);
-    pt->entries[pte_index].set(phys_addr, flags);
-    
-    stats.pages_mapped++;
+    if (global_pages && !is_private(virt_addr) && !(flags & PageFlags::User)) {
+        flags |= PageFlags::Global;
+    }
     
-    // Flush TLB for this page
-    flush_tlb_page(virt_addr);
+    PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(virt_addr)];
+    replaced = pte.is_present();
+    if (!replaced) {
+        table_use[VIRT_TO_PDE_INDEX(virt_addr)]++;
+    }
+    pte.set(phys_addr, flags);
     
+    stats.pages_mapped++;
     return true;
 }
 
-void VMM::unmap_page(u32 virt_addr) {
+bool VMM::clear_pte(u32 virt_addr) {
     PageTable* pt = get_page_table(virt_addr, false);
     if (!pt) {
-        return;  // Not mapped
+        return false;  // Not mapped
     }
     
-    u32 pte_index = VIRT_TO_PTE_INDEX(virt_addr);
-    pt->entries[pte_index].value = 0;
+    PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(virt_addr)];
+    if (!pte.is_present()) {
+        return false;
+    }
+    pte.value = 0;
+    
+    u16& use = table_use[VIRT_TO_PDE_INDEX(virt_addr)];
+    if (use > 0) use--;
     
     stats.pages_unmapped++;
+    return true;
+}
+
+bool VMM::table_reclaimable(u32 pde_index) {
+    // Boot tables are not PMM frames; the temp-slot table is shared on purpose
+    if (pde_index < (config::IDENTITY_MAP_SIZE >> 22) || pde_index == RECURSIVE_PDE ||
+        pde_index == VIRT_TO_PDE_INDEX(TEMP_MAP_BASE)) {
+        return false;
+    }
+    
+    // Kernel tables are linked into every clone
+    return (pde_index >= PRIVATE_PDE_FIRST && pde_index < PRIVATE_PDE_LAST) || live_clones == 0;
+}
+
+void VMM::reclaim_tables(u32 virt_start, u32 virt_end) {
+    if (virt_end <= virt_start) return;
+    
+    PageDirectory* dir = active_directory();
+    u32 last = VIRT_TO_PDE_INDEX(virt_end - 1);
+    for (u32 i = VIRT_TO_PDE_INDEX(virt_start); i <= last; i++) {
+        PageDirectoryEntry& pde = dir->entries[i];
+        if (!pde.is_present() || table_use[i] != 0 || !table_reclaimable(i)) continue;
+        
+        u32 pt_phys = pde.get_address();
+        pde.value = 0;
+        if (paging_active) {
+            flush_tlb_page(PAGE_TABLES_VADDR + i * PMM::PAGE_SIZE);
+        }
+        PMM::free_page(pt_phys);
+        stats.page_tables_freed++;
+    }
+}
+
+void VMM::recount_private_tables() {
+    PageDirectory* dir = active_directory();
+    for (u32 i = PRIVATE_PDE_FIRST; i < PRIVATE_PDE_LAST; i++) {
+        table_use[i] = 0;
+        if (!dir->entries[i].is_present()) continue;
+        
+        PageTable* pt = get_page_table(i << 22, false);
+        for (u32 j = 0; j < 1024; j++) {
+            if (pt->entries[j].is_present()) table_use[i]++;
+        }
+    }
+}
+
+bool VMM::map_page(u32 virt_addr, u32 phys_addr, u32 flags) {
+    u32 lock_flags = mm_lock.lock();
+    bool replaced;
+    if (!set_pte(virt_addr, phys_addr, flags, replaced)) {
+        mm_lock.unlock(lock_flags);
+        return false;
+    }
+    
+    // Not-present entries are never cached, so a fresh mapping needs no flush
+    if (replaced) {
+        flush_tlb_page(virt_addr);
+    }
     
-    // Flush TLB for this page
-    flush_tlb_page(virt_addr);
+    mm_lock.unlock(lock_flags);
+    return true;
+}
+
+void VMM::unmap_page(u32 virt_addr) {
+    u32 flags = mm_lock.lock();
+    if (clear_pte(virt_addr)) {
+        flush_tlb_page(virt_addr);
+        reclaim_tables(virt_addr, virt_addr + 1);
+    }
+    mm_lock.unlock(flags);
 }
 
 bool VMM::map_range(u32 virt_start, u32 phys_start, u32 size, u32 flags) {
     u32 pages = (size + PMM::PAGE_SIZE - 1) / PMM::PAGE_SIZE;
+    bool any_replaced = false;
+    u32 lock_flags = mm_lock.lock();
     
     for (u32 i = 0; i < pages; i++) {
         u32 virt = virt_start + i * PMM::PAGE_SIZE;
         u32 phys = phys_start + i * PMM::PAGE_SIZE;
         
-        if (!map_page(virt, phys, flags)) {
+        bool replaced;
+        if (!set_pte(virt, phys, flags, replaced)) {
             // Failed - unmap what we've done so far
+            if (any_replaced) flush_tlb_range(virt_start, i * PMM::PAGE_SIZE);
             unmap_range(virt_start, i * PMM::PAGE_SIZE);
+            mm_lock.unlock(lock_flags);
             return false;
         }
+        any_replaced |= replaced;
+    }
+    
+    // One batched invalidation for whatever was remapped
+    if (any_replaced) {
+        flush_tlb_range(virt_start, pages * PMM::PAGE_SIZE);
     }
     
+    mm_lock.unlock(lock_flags);
     return true;
 }
 
 void VMM::unmap_range(u32 virt_start, u32 size) {
     u32 pages = (size + PMM::PAGE_SIZE - 1) / PMM::PAGE_SIZE;
+    bool any_cleared = false;
+    u32 flags = mm_lock.lock();
     
     for (u32 i = 0; i < pages; i++) {
-        unmap_page(virt_start + i * PMM::PAGE_SIZE);
+        u32 virt = virt_start + i * PMM::PAGE_SIZE;
+        if (!get_page_table(virt, false)) {
+            // No table means nothing in this 4MB stretch
+            i = (((virt | 0x3FFFFF) + 1 - virt_start) / PMM::PAGE_SIZE) - 1;
+            continue;
+        }
+        any_cleared |= clear_pte(virt);
+    }
+    
+    if (any_cleared) {
+        flush_tlb_range(virt_start, pages * PMM::PAGE_SIZE);
+        reclaim_tables(virt_start, virt_start + pages * PMM::PAGE_SIZE);
+    }
+    mm_lock.unlock(flags);
+}
+
+void VMM::free_range(u32 virt_start, u32 size) {
+    u32 pages = (size + PMM::PAGE_SIZE - 1) / PMM::PAGE_SIZE;
+    u32 frames[TLB_FLUSH_THRESHOLD];
+    bool any_cleared = false;
+    u32 flags = mm_lock.lock();
+    
+    // Clear a batch, flush it on every CPU, and only then free its frames
+    u32 i = 0;
+    while (i < pages) {
+        u32 batch_start = i;
+        u32 count = 0;
+        bool cleared = false;
+        for (; i < pages && count < TLB_FLUSH_THRESHOLD; i++) {
+            u32 virt = virt_start + i * PMM::PAGE_SIZE;
+            PageTable* pt = get_page_table(virt, false);
+            if (!pt) {
+                // No table means nothing in this 4MB stretch
+                i = (((virt | 0x3FFFFF) + 1 - virt_start) / PMM::PAGE_SIZE) - 1;
+                continue;
+            }
+            PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(virt)];
+            if (!pte.is_present()) continue;
+            
+            u32 frame = pte.get_address();
+            clear_pte(virt);
+            cleared = true;
+            if (frame != zero_page) frames[count++] = frame;
+        }
+        
+        if (cleared) {
+            flush_tlb_range(virt_start + batch_start * PMM::PAGE_SIZE, (i - batch_start) * PMM::PAGE_SIZE);
+            any_cleared = true;
+        }
+        for (u32 f = 0; f < count; f++) {
+            PMM::free_page(frames[f]);
+        }
+    }
+    
+    if (any_cleared) {
+        reclaim_tables(virt_start, virt_start + pages * PMM::PAGE_SIZE);
     }
+    mm_lock.unlock(flags);
 }
 
 u32 VMM::alloc_page(u32 virt_addr, u32 flags) {
@@ -241,76 +514,500 @@ u32 VMM::alloc_page(u32 virt_addr, u32 flags) {
 }
 
 void VMM::free_page(u32 virt_addr) {
-    // Get physical address before unmapping
+    // Lookup, unmap and free in one hold so nobody remaps the page between
+    u32 flags = mm_lock.lock();
     u32 phys_addr = get_physical_address(virt_addr);
-    
-    // Unmap the page
     unmap_page(virt_addr);
-    
-    // Free physical page
     if (phys_addr) {
         PMM::free_page(phys_addr);
     }
+    mm_lock.unlock(flags);
 }
 
 u32 VMM::get_physical_address(u32 virt_addr) {
+    u32 flags = mm_lock.lock();
     PageTable* pt = get_page_table(virt_addr, false);
-    if (!pt) {
-        return 0;  // Not mapped
-    }
-    
-    u32 pte_index = VIRT_TO_PTE_INDEX(virt_addr);
-    PageTableEntry& pte = pt->entries[pte_index];
-    
-    if (!pte.is_present()) {
-        return 0;  // Not present
+    u32 phys = 0;
+    if (pt) {
+        PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(virt_addr)];
+        if (pte.is_present()) {
+            phys = pte.get_address() + VIRT_TO_PAGE_OFFSET(virt_addr);
+        }
     }
-    
-    return pte.get_address() + VIRT_TO_PAGE_OFFSET(virt_addr);
+    mm_lock.unlock(flags);
+    return phys;
 }
 
 bool VMM::is_mapped(u32 virt_addr) {
+    u32 flags = mm_lock.lock();
     PageTable* pt = get_page_table(virt_addr, false);
-    if (!pt) {
-        return false;
-    }
-    
-    u32 pte_index = VIRT_TO_PTE_INDEX(virt_addr);
-    return pt->entries[pte_index].is_present();
+    bool mapped = pt && pt->entries[VIRT_TO_PTE_INDEX(virt_addr)].is_present();
+    mm_lock.unlock(flags);
+    return mapped;
 }
 
 void VMM::flush_tlb_page(u32 virt_addr) {
     asm volatile("invlpg (%0)" : : "r"(virt_addr) : "memory");
+    stats.tlb_page_flushes++;
+    SMP::flush_tlb_others(virt_addr, PMM::PAGE_SIZE);
 }
 
 void VMM::flush_tlb() {
     // Reload CR3 to flush entire TLB
     u32 cr3 = read_cr3();
     load_page_directory(cr3);
+    stats.tlb_full_flushes++;
+}
+
+void VMM::flush_tlb_all() {
+    if (!global_pages || !paging_active) {
+        flush_tlb();
+        return;
+    }
+    
+    // Toggling PGE drops global entries too
+    u32 cr4 = read_cr4();
+    write_cr4(cr4 & ~CR4_PGE);
+    write_cr4(cr4);
+    stats.tlb_full_flushes++;
+}
+
+void VMM::flush_tlb_range(u32 virt_start, u32 size) {
+    flush_tlb_range_local(virt_start, size);
+    SMP::flush_tlb_others(virt_start, size);
+}
+
+void VMM::flush_tlb_range_local(u32 virt_start, u32 size) {
+    u32 pages = (size + PMM::PAGE_SIZE - 1) / PMM::PAGE_SIZE;
+    if (pages > TLB_FLUSH_THRESHOLD) {
+        // Past the threshold one reload beats a string of invlpg; kernel
+        // ranges are global and need the heavier flush
+        if (is_private(virt_start) && is_private(virt_start + (pages - 1) * PMM::PAGE_SIZE)) {
+            flush_tlb();
+        } else {
+            flush_tlb_all();
+        }
+        return;
+    }
+    
+    for (u32 i = 0; i < pages; i++) {
+        asm volatile("invlpg (%0)" : : "r"(virt_start + i * PMM::PAGE_SIZE) : "memory");
+    }
+    stats.tlb_page_flushes += pages;
 }
 
 void VMM::switch_directory(PageDirectory* dir) {
+    u32 flags = mm_lock.lock();
     current_directory = dir;
+    
+    // Global kernel translations survive the reload
     load_page_directory(reinterpret_cast<u32>(dir));
+    if (paging_active) {
+        recount_private_tables();
+    }
+    mm_lock.unlock(flags);
 }
 
 PageDirectory* VMM::clone_directory() {
+    // One hold for the whole copy: the parent's tables and PTEs must not
+    // change under it, and the temp slots must stay on this CPU
+    u32 lock_flags = mm_lock.lock();
+    
+    // Every clone is tracked so later kernel tables can be shared into it
+    u32 slot = 0;
+    while (slot < MAX_CLONES && clones[slot] != 0) slot++;
+    
     // Allocate new page directory
-    PageDirectory* new_dir = reinterpret_cast<PageDirectory*>(alloc_aligned(sizeof(PageDirectory)));
+    u32 dir_phys = slot < MAX_CLONES ? PMM::alloc_page() : 0;
+    if (dir_phys == 0) {
+        mm_lock.unlock(lock_flags);
+        return nullptr;
+    }
+    PageDirectory* new_dir = static_cast<PageDirectory*>(map_temp(0, dir_phys));
     if (!new_dir) {
+        PMM::free_page(dir_phys);
+        mm_lock.unlock(lock_flags);
         return nullptr;
     }
+    clones[slot] = dir_phys;
+    live_clones++;
     
-    // Copy entries (shallow copy - shares page tables)
-    for (int i = 0; i < 1024; i++) {
-        new_dir->entries[i].value = current_directory->entries[i].value;
+    PageDirectory* dir = active_directory();
+    bool downgraded = false;
+    bool failed = false;
+    for (u32 i = 0; i < 1024; i++) {
+        PageDirectoryEntry& pde = dir->entries[i];
+        new_dir->entries[i].value = pde.value;
+        if (failed || i < PRIVATE_PDE_FIRST || i >= PRIVATE_PDE_LAST || !pde.is_present()) {
+            if (failed) new_dir->entries[i].value = 0;
+            continue;
+        }
+        
+        // Private table: the child gets its own copy, and every writable
+        // page becomes read-only and shared in both
+        u32 pt_phys = PMM::alloc_page();
+        PageTable* child = pt_phys ? static_cast<PageTable*>(map_temp(1, pt_phys)) : nullptr;
+        if (!child) {
+            if (pt_phys) PMM::free_page(pt_phys);
+            new_dir->entries[i].value = 0;
+            failed = true;
+            continue;
+        }
+        
+        PageTable* parent = get_page_table(i << 22, false);
+        for (u32 j = 0; j < 1024; j++) {
+            PageTableEntry& pte = parent->entries[j];
+            if (pte.is_present()) {
+                u32 frame = pte.get_address();
+                if (frame != zero_page) {
+                    PMM::ref_page(frame);
+                    if (pte.value & PageFlags::ReadWrite) {
+                        pte.value = (pte.value & ~PageFlags::ReadWrite) | PageFlags::CopyOnWrite;
+                        downgraded = true;
+                    }
+                }
+            }
+            child->entries[j].value = pte.value;
+        }
+        unmap_temp(1);
+        new_dir->entries[i].set(pt_phys, pde.get_flags());
+        stats.page_tables_allocated++;
+    }
+    
+    // The clone's window must show the clone
+    new_dir->entries[RECURSIVE_PDE].set(dir_phys, PageFlags::KernelPage);
+    unmap_temp(0);
+    
+    // Parent mappings that lost write access must not linger in any TLB
+    if (downgraded) {
+        flush_tlb();
+        SMP::flush_tlb_others(0, 0);
     }
     
-    return new_dir;
+    if (failed) {
+        destroy_directory(reinterpret_cast<PageDirectory*>(dir_phys));
+        mm_lock.unlock(lock_flags);
+        return nullptr;
+    }
+    mm_lock.unlock(lock_flags);
+    return reinterpret_cast<PageDirectory*>(dir_phys);
+}
+
+void VMM::destroy_directory(PageDirectory* dir) {
+    if (!dir || dir == kernel_directory || dir == current_directory) return;
+    
+    u32 lock_flags = mm_lock.lock();
+    u32 dir_phys = reinterpret_cast<u32>(dir);
+    PageDirectory* pd = static_cast<PageDirectory*>(map_temp(0, dir_phys));
+    if (!pd) {
+        mm_lock.unlock(lock_flags);
+        return;
+    }
+    
+    for (u32 i = PRIVATE_PDE_FIRST; i < PRIVATE_PDE_LAST; i++) {
+        PageDirectoryEntry& pde = pd->entries[i];
+        if (!pde.is_present()) continue;
+        
+        PageTable* pt = static_cast<PageTable*>(map_temp(1, pde.get_address()));
+        if (pt) {
+            for (u32 j = 0; j < 1024; j++) {
+                PageTableEntry& pte = pt->entries[j];
+                if (pte.is_present() && pte.get_address() != zero_page) {
+                    PMM::free_page(pte.get_address());
+                }
+            }
+            unmap_temp(1);
+        }
+        PMM::free_page(pde.get_address());
+        pde.value = 0;
+    }
+    
+    unmap_temp(0);
+    PMM::free_page(dir_phys);
+    for (u32 i = 0; i < MAX_CLONES; i++) {
+        if (clones[i] == dir_phys) {
+            clones[i] = 0;
+            live_clones--;
+        }
+    }
+    mm_lock.unlock(lock_flags);
+}
+
+// Two CPUs can fault on one page; the one that waited for mm_lock finds
+// the PTE already allowing its access and just retries the instruction
+bool VMM::fault_resolved(u32 error_code, u32 fault_addr) {
+    bool write_op = error_code & 0x2;
+    if (error_code & 0x8) return false;  // Reserved bits never fix themselves
+    
+    PageTable* pt = get_page_table(fault_addr, false);
+    if (!pt) return false;
+    PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(fault_addr)];
+    return pte.is_present() && (!write_op || (pte.value & PageFlags::ReadWrite));
+}
+
+// Write to a page shared by clone_directory. The last holder keeps the
+// frame and just regains write access; anyone else takes a private copy.
+bool VMM::handle_cow_fault(u32 error_code, u32 fault_addr) {
+    bool present = error_code & 0x1;
+    bool write_op = error_code & 0x2;
+    if (!present || !write_op) return false;
+    
+    PageTable* pt = get_page_table(fault_addr, false);
+    if (!pt) return false;
+    PageTableEntry& pte = pt->entries[VIRT_TO_PTE_INDEX(fault_addr)];
+    if (!(pte.value & PageFlags::CopyOnWrite)) return false;
+    
+    u32 page = fault_addr & ~(PMM::PAGE_SIZE - 1);
+    u32 frame = pte.get_address();
+    u32 flags = (pte.get_flags() & ~PageFlags::CopyOnWrite) | PageFlags::ReadWrite;
+    stats.cow_faults++;
+    
+    if (PMM::get_ref_count(frame) <= 1) {
+        pte.set(frame, flags);
+        flush_tlb_page(page);
+        return true;
+    }
+    
+    u32 copy = PMM::alloc_page();
+    if (copy == 0) return false;
+    
+    // Copy through a temporary mapping of the new frame
+    void* window = map_temp(0, copy);
+    if (!window) {
+        PMM::free_page(copy);
+        return false;
+    }
+    memcpy(window, reinterpret_cast<void*>(page), PMM::PAGE_SIZE);
+    unmap_temp(0);
+    
+    pte.set(copy, flags);
+    flush_tlb_page(page);
+    PMM::free_page(frame);  // Drops this space's reference
+    
+    stats.cow_copies++;
+    return true;
+}
+
+// ===========================================================================
+// Demand-Paged Areas
+// ===========================================================================
+
+VMArea* VMM::find_vma(u32 addr) {
+    for (u32 i = 0; i < MAX_VMAS; i++) {
+        if (vmas[i].active && vmas[i].contains(addr)) {
+            return &vmas[i];
+        }
+    }
+    return nullptr;
+}
+
+bool VMM::overlaps_vma(u32 start, u32 end) {
+    for (u32 i = 0; i < MAX_VMAS; i++) {
+        if (vmas[i].active && start < vmas[i].end && vmas[i].start < end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VMM::reserve_at(u32 virt_start, u32 size, u32 flags, const char* name) {
+    if (size == 0 || (virt_start & (PMM::PAGE_SIZE - 1)) != 0) return false;
+    
+    u32 end = virt_start + PAGE_ALIGN_UP(size);
+    if (end <= virt_start) return false;
+    
+    u32 lock_flags = mm_lock.lock();
+    if (overlaps_vma(virt_start, end)) {
+        mm_lock.unlock(lock_flags);
+        return false;
+    }
+    
+    for (u32 i = 0; i < MAX_VMAS; i++) {
+        if (!vmas[i].active) {
+            VMArea& vma = vmas[i];
+            vma.start = virt_start;
+            vma.end = end;
+            vma.flags = flags | PageFlags::Present;
+            vma.faults = 0;
+            vma.zero_maps = 0;
+            vma.resident = 0;
+            vma.name = name ? name : "anon";
+            vma.active = true;
+            mm_lock.unlock(lock_flags);
+            return true;
+        }
+    }
+    mm_lock.unlock(lock_flags);
+    return false;  // Area table full
+}
+
+u32 VMM::reserve(u32 size, u32 flags, const char* name) {
+    if (size == 0) return 0;
+    u32 length = PAGE_ALIGN_UP(size);
+    
+    // First fit, leaving an unmapped guard page after each area. The lock
+    // spans the search and the claim so two callers cannot pick one hole.
+    u32 lock_flags = mm_lock.lock();
+    u32 candidate = VMA_BASE;
+    bool moved = true;
+    while (moved) {
+        moved = false;
+        if (candidate + length < candidate || candidate + length > VMA_LIMIT) {
+            mm_lock.unlock(lock_flags);
+            return 0;
+        }
+        for (u32 i = 0; i < MAX_VMAS; i++) {
+            const VMArea& vma = vmas[i];
+            if (vma.active && candidate < vma.end + PMM::PAGE_SIZE && vma.start < candidate + length) {
+                candidate = vma.end + PMM::PAGE_SIZE;
+                moved = true;
+            }
+        }
+    }
+    
+    bool reserved = reserve_at(candidate, length, flags, name);
+    mm_lock.unlock(lock_flags);
+    return reserved ? candidate : 0;
+}
+
+void VMM::release(u32 virt_start) {
+    u32 flags = mm_lock.lock();
+    for (u32 i = 0; i < MAX_VMAS; i++) {
+        VMArea& vma = vmas[i];
+        if (!vma.active || vma.start != virt_start) continue;
+        
+        // Shared zero-page mappings are unmapped but never freed
+        free_range(vma.start, vma.end - vma.start);
+        vma.active = false;
+        break;
+    }
+    mm_lock.unlock(flags);
+}
+
+bool VMM::handle_demand_fault(u32 error_code, u32 fault_addr) {
+    VMArea* vma = find_vma(fault_addr);
+    if (!vma || zero_page == 0) return false;
+    
+    bool present = error_code & 0x1;
+    bool write_op = error_code & 0x2;
+    bool writable = vma->flags & PageFlags::ReadWrite;
+    u32 page = fault_addr & ~(PMM::PAGE_SIZE - 1);
+    
+    if (present) {
+        // The only legal protection fault is the first write over the zero page
+        if (!write_op || !writable) return false;
+        u32 phys = get_physical_address(page);
+        if ((phys & ~(PMM::PAGE_SIZE - 1)) != zero_page) return false;
+    } else if (!write_op || !writable) {
+        // Reads share one frame until something is written
+        if (!map_page(page, zero_page, vma->flags & ~PageFlags::ReadWrite)) return false;
+        vma->faults++;
+        vma->zero_maps++;
+        stats.demand_faults++;
+        return true;
+    }
+    
+    u32 frame = PMM::alloc_page();
+    if (frame == 0) return false;
+    if (!map_page(page, frame, vma->flags)) {
+        PMM::free_page(frame);
+        return false;
+    }
+    
+    // Cleared through the new mapping, so the frame needs no other alias
+    memset(reinterpret_cast<void*>(page), 0, PMM::PAGE_SIZE);
+    
+    vma->faults++;
+    vma->resident++;
+    stats.demand_faults++;
+    return true;
+}
+
+// ===========================================================================
+// Self-Test
+// ===========================================================================
+
+const char* VMM::self_test() {
+    if (!paging_active || zero_page == 0) return "paging is off";
+    
+    // Held throughout: the directory switches must not meet a task switch,
+    // and only this test may move the free frame count
+    u32 lock_flags = mm_lock.lock();
+    u32 free_before = PMM::get_stats().free_pages;
+    const char* error = nullptr;
+    PageDirectory* child = nullptr;
+    
+    u32 area = reserve(2 * PMM::PAGE_SIZE, PageFlags::KernelPage, "selftest");
+    volatile u32* page0 = reinterpret_cast<volatile u32*>(area);
+    volatile u32* page1 = reinterpret_cast<volatile u32*>(area + PMM::PAGE_SIZE);
+    if (!area) error = "no room for a scratch area";
+    
+    // Demand faults: a write populates page 0, a read maps the zero page
+    if (!error) {
+        page0[0] = 0xC0FFEE;
+        if (page1[0] != 0 || get_physical_address(area + PMM::PAGE_SIZE) != zero_page) {
+            error = "read fault did not map the zero page";
+        }
+    }
+    
+    if (!error) {
+        child = clone_directory();
+        if (!child) error = "clone_directory failed";
+    }
+    
+    // The parent's write takes a private copy; the child keeps the old value
+    if (!error) {
+        u32 copies = stats.cow_copies;
+        page0[0] = 0xBADF00D;
+        if (stats.cow_copies != copies + 1) error = "write to a shared page did not copy it";
+    }
+    if (!error) {
+        PageDirectory* parent = current_directory;
+        switch_directory(child);
+        u32 seen = page0[0];
+        switch_directory(parent);
+        if (seen != 0xC0FFEE) error = "child sees the parent's write";
+    }
+    
+    // A kernel table created after the clone must reach the child too.
+    // The top of the heap window is rarely populated; skip if it is.
+    u32 probe = config::HEAP_VIRT_LIMIT - 0x400000;
+    bool probe_mapped = false;
+    if (!error && !get_page_table(probe, false)) {
+        probe_mapped = alloc_page(probe) != 0;
+        if (!probe_mapped) error = "no frame for the kernel table probe";
+    }
+    if (!error && probe_mapped) {
+        u32 expected = active_directory()->entries[VIRT_TO_PDE_INDEX(probe)].value;
+        PageDirectory* pd = static_cast<PageDirectory*>(map_temp(0, reinterpret_cast<u32>(child)));
+        if (!pd || pd->entries[VIRT_TO_PDE_INDEX(probe)].value != expected) {
+            error = "kernel table missing from the clone";
+        }
+        if (pd) unmap_temp(0);
+    }
+    
+    // With the clone gone the probe's table is reclaimable again
+    if (child) destroy_directory(child);
+    if (probe_mapped) free_page(probe);
+    if (area) release(area);
+    
+    if (!error && live_clones == 0 && PMM::get_stats().free_pages != free_before) {
+        error = "frames leaked";
+    }
+    mm_lock.unlock(lock_flags);
+    return error;
 }
 
 void VMM::page_fault_handler(u32 error_code, u32 fault_addr) {
+    u32 flags = mm_lock.lock();
     stats.page_faults++;
+    bool handled = fault_resolved(error_code, fault_addr) ||
+                   handle_cow_fault(error_code, fault_addr) ||
+                   handle_demand_fault(error_code, fault_addr);
+    mm_lock.unlock(flags);
+    if (handled) {
+        return;
+    }
     
     // Decode error code
     bool present = error_code & 0x1;       // Page was present
@@ -343,7 +1040,7 @@ void VMM::page_fault_handler(u32 error_code, u32 fault_addr) {
     bolt::drivers::VGA::println(present ? "Protection violation" : "Page not present");
     bolt::drivers::VGA::set_color(bolt::drivers::Color::LightGray);
     
-    // Halt on page faults - later we can implement demand paging
+    // Anything demand paging could not resolve is fatal
     bolt::drivers::Serial::write("System halted.\n");
     asm volatile("cli; hlt");
 }
@@ -22,6 +22,7 @@ namespace PageFlags {
     constexpr u32 Dirty         = 1 << 6;   // Page has been written to
     constexpr u32 PageSize      = 1 << 7;   // 4MB page (in PDE only)
     constexpr u32 Global        = 1 << 8;   // Global page (not flushed on CR3 reload)
+    constexpr u32 CopyOnWrite   = 1 << 9;   // Available bit: shared until written
     
     // Common flag combinations
     constexpr u32 KernelPage    = Present | ReadWrite;              // Kernel RW
@@ -81,9 +82,31 @@ struct VirtualAddress {
 // VMM statistics
 struct VirtualMemoryStats {
     u32 page_faults;
+    u32 demand_faults;          // Faults resolved by populating a VMA
+    u32 cow_faults;             // Writes to copy-on-write pages
+    u32 cow_copies;             // Of those, the ones that copied a frame
     u32 pages_mapped;
     u32 pages_unmapped;
     u32 page_tables_allocated;
+    u32 page_tables_freed;      // Tables reclaimed once empty
+    u32 tlb_page_flushes;       // invlpg issued
+    u32 tlb_full_flushes;       // Whole-TLB flushes
+};
+
+// Virtual memory area: a reserved range with no frames behind it until a
+// page is touched. Reads map the shared zero page, writes get a private
+// zero-filled frame.
+struct VMArea {
+    u32 start;                  // Page-aligned
+    u32 end;                    // Exclusive
+    u32 flags;                  // PageFlags for populated pages
+    u32 faults;                 // Demand faults taken in this area
+    u32 zero_maps;              // Read faults served by the zero page
+    u32 resident;               // Private frames populated
+    const char* name;
+    bool active;
+    
+    bool contains(u32 addr) const { return addr >= start && addr < end; }
 };
 
 class VMM {
@@ -113,6 +136,10 @@ public:
     // Unmap a range of pages
     static void unmap_range(u32 virt_start, u32 size);
     
+    // Unmap a range and give its frames back to the PMM, each only after
+    // no CPU's TLB can reach it any more
+    static void free_range(u32 virt_start, u32 size);
+    
     // Allocate and map a page (gets physical page from PMM)
     static u32 alloc_page(u32 virt_addr, u32 flags = PageFlags::KernelPage);
     
@@ -126,24 +153,80 @@ public:
     // Check if virtual address is mapped
     static bool is_mapped(u32 virt_addr);
     
-    // Flush TLB for a specific page
+    // Flush TLB for a specific page, on every CPU
     static void flush_tlb_page(u32 virt_addr);
     
-    // Flush entire TLB
+    // Flush this CPU's entire TLB (global kernel pages survive)
     static void flush_tlb();
     
+    // Flush everything on this CPU, global pages included
+    static void flush_tlb_all();
+    
+    // Invalidate a range on every CPU: per page when small, whole TLB when large
+    static void flush_tlb_range(u32 virt_start, u32 size);
+    static void flush_tlb_range_local(u32 virt_start, u32 size);
+    static constexpr u32 TLB_FLUSH_THRESHOLD = 32;  // Pages before a full flush wins
+    
+    static bool global_pages_enabled() { return global_pages; }
+    
     // Get current page directory
     static PageDirectory* get_current_directory() { return current_directory; }
     
     // Switch page directory (for process switching)
     static void switch_directory(PageDirectory* dir);
     
-    // Clone current page directory (for fork)
+    // Clone current page directory (for fork). Kernel page tables are
+    // shared, including ones created later; the VMA window is copy-on-write
+    // in both directories. Fails once MAX_CLONES are live.
     static PageDirectory* clone_directory();
     
+    // Free a directory from clone_directory along with its private tables
+    // and its references on shared frames
+    static void destroy_directory(PageDirectory* dir);
+    static constexpr u32 MAX_CLONES = 16;
+    
+    // Clone, copy-on-write, kernel-table sharing and teardown on a scratch
+    // area; nullptr on success, otherwise what broke
+    static const char* self_test();
+    
     // Get VMM statistics
     static VirtualMemoryStats get_stats() { return stats; }
     
+    // Demand-paged areas
+    static constexpr u32 MAX_VMAS = 64;
+    static constexpr u32 VMA_BASE = 0x40000000;     // Window searched by reserve()
+    static constexpr u32 VMA_LIMIT = 0x80000000;
+    
+    // Recursive mapping: the last PDE points at the directory itself, so
+    // every page table appears in the top 4MB and the directory in its last page
+    static constexpr u32 RECURSIVE_PDE = 1023;
+    static constexpr u32 PAGE_TABLES_VADDR = 0xFFC00000;
+    static constexpr u32 PAGE_DIR_VADDR = 0xFFFFF000;
+    
+    // Short-lived kernel windows onto arbitrary frames, just below the VMAs.
+    // Each CPU owns its own slots, so unmapping one never needs a shootdown.
+    // Slots 0 and 1 copy directories and tables, slot 2 shares new kernel tables.
+    static constexpr u32 TEMP_SLOTS_PER_CPU = 3;
+    static constexpr u32 TEMP_MAP_SLOTS = TEMP_SLOTS_PER_CPU * config::MAX_CPUS;
+    static constexpr u32 TEMP_MAP_BASE = VMA_BASE - TEMP_MAP_SLOTS * 0x1000;
+    
+    // Map a physical frame into one of this CPU's temp slots and return its
+    // virtual address. Hold mm_lock until unmap_temp so the CPU cannot change.
+    static void* map_temp(u32 slot, u32 phys_addr);
+    static void unmap_temp(u32 slot);
+    
+    // Reserve size bytes of address space in the VMA window; 0 on failure
+    static u32 reserve(u32 size, u32 flags, const char* name);
+    
+    // Reserve a caller-chosen page-aligned range
+    static bool reserve_at(u32 virt_start, u32 size, u32 flags, const char* name);
+    
+    // Unmap an area reserved at virt_start and free its frames
+    static void release(u32 virt_start);
+    
+    static const VMArea* get_vma(u32 index) { return index < MAX_VMAS ? &vmas[index] : nullptr; }
+    static u32 get_zero_page() { return zero_page; }
+    
     // Page fault handler (called from IDT)
     static void page_fault_handler(u32 error_code, u32 fault_addr);
     
@@ -154,16 +237,55 @@ private:
     // Get or create page table for a virtual address
     static PageTable* get_page_table(u32 virt_addr, bool create = false);
     
-    // Allocate a page-aligned structure
-    static void* alloc_aligned(u32 size);
+    // The current directory as the CPU can reach it: through the recursive
+    // window once paging is on, by physical address before
+    static PageDirectory* active_directory();
+    
+    // PTE updates without TLB maintenance; callers flush. set_pte returns
+    // false on allocation failure, replaced says a live entry was overwritten
+    static bool set_pte(u32 virt_addr, u32 phys_addr, u32 flags, bool& replaced);
+    static bool clear_pte(u32 virt_addr);
+    
+    // Free the page tables in [virt_start, virt_end) whose use count reached 0.
+    // Only safe once the TLB no longer holds translations through them.
+    static void reclaim_tables(u32 virt_start, u32 virt_end);
+    static bool table_reclaimable(u32 pde_index);
+    
+    // Recount present PTEs of the private tables after a directory switch
+    static void recount_private_tables();
+    
+    // Populate the page behind a fault inside a VMA; false if the fault
+    // is not one demand paging can resolve
+    static bool handle_demand_fault(u32 error_code, u32 fault_addr);
+    static bool handle_cow_fault(u32 error_code, u32 fault_addr);
+    static bool fault_resolved(u32 error_code, u32 fault_addr);
+    static VMArea* find_vma(u32 addr);
+    static bool overlaps_vma(u32 start, u32 end);
+    static u32 temp_slot_address(u32 slot);
+    
+    // Copy a kernel PDE that just came into existence into every other
+    // directory, so tables created after a clone still reach it
+    static void share_kernel_pde(u32 pde_index);
     
     // Current page directory
     static PageDirectory* current_directory;
     static PageDirectory* kernel_directory;
+    static bool paging_active;
+    static bool global_pages;
+    
+    // Present PTEs per table of the current directory; kernel tables are
+    // shared, so only the private window needs recounting on a switch
+    static u16 table_use[1024];
+    static u32 live_clones;             // Directories from clone_directory
+    static u32 clones[MAX_CLONES];      // Their physical addresses, 0 when free
     
     // Statistics
     static VirtualMemoryStats stats;
     
+    // Demand paging
+    static VMArea vmas[MAX_VMAS];
+    static u32 zero_page;               // Shared read-only frame of zeros
+    
     // Identity map the first N megabytes
     static void identity_map_kernel();
 };
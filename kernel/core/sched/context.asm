@@ -11,8 +11,10 @@
 
 section .text
 
-; void switch_context(u32* old_esp, u32 new_esp)
-; Saves current context to old_esp and switches to new_esp
+; void switch_context(u32* old_esp, u32 new_esp, volatile u32* old_on_cpu)
+; Saves current context to old_esp and switches to new_esp. *old_on_cpu is
+; cleared once the old stack is no longer in use, so another CPU may pick
+; the old task up from then on.
 global switch_context
 switch_context:
     ; Save current context
@@ -23,14 +25,17 @@ switch_context:
     push ds
     pusha               ; Push EAX, ECX, EDX, EBX, ESP, EBP, ESI, EDI
     
-    ; Get parameters from stack (after our pushes)
-    ; [ESP + 48] = old_esp pointer
-    ; [ESP + 52] = new_esp
-    mov eax, [esp + 48] ; old_esp pointer
+    ; Get parameters from stack (after our pushes and the return address)
+    ; [ESP + 56] = old_esp pointer
+    ; [ESP + 60] = new_esp
+    ; [ESP + 64] = old_on_cpu pointer
+    mov eax, [esp + 56] ; old_esp pointer
+    mov ecx, [esp + 64] ; old_on_cpu pointer
     mov [eax], esp      ; Save current ESP to *old_esp
     
     ; Switch to new stack
-    mov esp, [esp + 52] ; Load new ESP
+    mov esp, [esp + 60] ; Load new ESP
+    mov dword [ecx], 0  ; Old task is off this CPU
     
     ; Restore new context
     popa                ; Pop EDI, ESI, EBP, (ESP ignored), EBX, EDX, ECX, EAX
@@ -9,6 +9,8 @@
 #include "../memory/heap.hpp"
 #include "../sys/log.hpp"
 #include "../arch/idt.hpp"
+#include "../arch/gdt.hpp"
+#include "../arch/apic.hpp"
 #include "../../drivers/timer/pit.hpp"
 #include "../../lib/string.hpp"
 
@@ -21,12 +23,28 @@ using namespace bolt::drivers;
 // Static member definitions
 Task TaskManager::tasks[MAX_TASKS];
 Task* TaskManager::task_list = nullptr;
-Task* TaskManager::current_task = nullptr;
 u32 TaskManager::next_pid = 1;
-TaskStats TaskManager::stats = {0, 0, 0, 0, 0, 0};
+Spinlock TaskManager::table_lock;
+TaskManager::RunQueue TaskManager::run_queues[config::MAX_CPUS];
+
+// Each CPU runs its own task, kept in its PerCpu block
+static inline Task*& current_task() {
+    return SMP::this_cpu()->current_task;
+}
+
+// The scheduler runs with interrupts off on the CPU it is switching
+static inline u32 irq_save() {
+    u32 flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void irq_restore(u32 flags) {
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+}
 
 // External assembly function for context switch
-extern "C" void switch_context(u32* old_esp, u32 new_esp);
+extern "C" void switch_context(u32* old_esp, u32 new_esp, volatile u32* old_on_cpu);
 
 void TaskManager::init() {
     // Clear all task slots
@@ -35,6 +53,7 @@ void TaskManager::init() {
         tasks[i].pid = 0;
         tasks[i].next = nullptr;
         tasks[i].prev = nullptr;
+        tasks[i].run_next = nullptr;
     }
     
     // Create the kernel/idle task (PID 0)
@@ -47,6 +66,10 @@ void TaskManager::init() {
     kernel_task->priority = Priority::Idle;
     kernel_task->time_slice = DEFAULT_TIME_SLICE;
     kernel_task->total_time = 0;
+    kernel_task->wake_time = 0;
+    kernel_task->cpu = 0;
+    kernel_task->affinity = 1;  // The shell stays on the boot CPU
+    kernel_task->on_cpu = 1;
     kernel_task->stack_base = 0;  // Using existing kernel stack
     kernel_task->stack_top = 0;
     kernel_task->esp = 0;  // Will be filled during first context switch
@@ -56,14 +79,71 @@ void TaskManager::init() {
     kernel_task->prev = kernel_task;
     
     task_list = kernel_task;
-    current_task = kernel_task;
-    
-    stats.total_tasks = 1;
-    stats.running_tasks = 1;
+    current_task() = kernel_task;
+    run_queues[0].idle = kernel_task;
     
     LOG_INFO("Task manager initialized");
 }
 
+void TaskManager::init_cpu() {
+    PerCpu* cpu = SMP::this_cpu();
+    
+    u32 flags = table_lock.lock();
+    Task* task = alloc_task();
+    if (!task) {
+        table_lock.unlock(flags);
+        return;
+    }
+    
+    // The AP's boot stack becomes its idle task
+    task->pid = next_pid++;
+    task->ppid = 0;
+    str::cpy(task->name, "idle/0");
+    task->name[5] = static_cast<char>('0' + cpu->index);
+    task->state = TaskState::Running;
+    task->priority = Priority::Idle;
+    task->time_slice = DEFAULT_TIME_SLICE;
+    task->total_time = 0;
+    task->wake_time = 0;
+    task->cpu = cpu->index;
+    task->affinity = 1u << cpu->index;
+    task->on_cpu = 1;
+    task->stack_base = 0;
+    task->stack_top = cpu->stack_top;
+    task->esp = 0;
+    task->page_directory = 0;
+    task->exit_code = 0;
+    task->wait_queue_next = nullptr;
+    task->run_next = nullptr;
+    
+    task->next = task_list->next;
+    task->prev = task_list;
+    task_list->next->prev = task;
+    task_list->next = task;
+    table_lock.unlock(flags);
+    
+    current_task() = task;
+    run_queues[cpu->index].idle = task;
+}
+
+void TaskManager::idle_loop() {
+    const RunQueue& rq = run_queues[SMP::this_cpu()->index];
+    while (true) {
+        schedule();
+        
+        // Halt until the next tick or a reschedule IPI unless this CPU
+        // has tasks queued; the tick wakes sleepers and steals from other
+        // queues. sti only takes effect after the next instruction, so a
+        // kick can't slip in before hlt.
+        asm volatile("cli");
+        if (rq.count == 0) {
+            asm volatile("sti; hlt");
+        } else {
+            asm volatile("sti; pause");
+        }
+    }
+}
+
 Task* TaskManager::alloc_task() {
     for (u32 i = 0; i < MAX_TASKS; i++) {
         if (tasks[i].state == TaskState::Dead) {
@@ -94,13 +174,11 @@ void TaskManager::free_task(Task* task) {
     
     task->state = TaskState::Dead;
     task->pid = 0;
-    
-    stats.total_tasks--;
 }
 
 void TaskManager::setup_stack(Task* task, void (*entry)()) {
     // Allocate stack
-    void* stack = Heap::alloc(TASK_STACK_SIZE);
+    void* stack = Heap::alloc(TASK_STACK_SIZE, MemTag::Task);
     if (!stack) {
         return;
     }
@@ -123,7 +201,7 @@ void TaskManager::setup_stack(Task* task, void (*entry)()) {
     *(--sp) = 0x202;  // EFLAGS: IF=1 (interrupts enabled)
     
     // Push segment registers (all kernel segments for now)
-    *(--sp) = 0x10;  // GS
+    *(--sp) = GDT::PERCPU;  // GS (per-CPU block, same selector on every CPU)
     *(--sp) = 0x10;  // FS  
     *(--sp) = 0x10;  // ES
     *(--sp) = 0x10;  // DS
@@ -141,68 +219,74 @@ void TaskManager::setup_stack(Task* task, void (*entry)()) {
     task->esp = reinterpret_cast<u32>(sp);
 }
 
-u32 TaskManager::create(const char* name, void (*entry)(), Priority priority) {
+u32 TaskManager::create(const char* name, void (*entry)(), Priority priority, u32 affinity) {
+    if (affinity == 0) affinity = AFFINITY_ALL;
+    
+    u32 flags = table_lock.lock();
     Task* task = alloc_task();
     if (!task) {
+        table_lock.unlock(flags);
         LOG_ERROR("Failed to allocate task slot");
         return 0;
     }
     
     // Initialize task
     task->pid = next_pid++;
-    task->ppid = current_task ? current_task->pid : 0;
+    task->ppid = current_task() ? current_task()->pid : 0;
     str::cpy(task->name, name);
     task->state = TaskState::Ready;
     task->priority = priority;
     task->time_slice = DEFAULT_TIME_SLICE;
     task->total_time = 0;
     task->wake_time = 0;
+    task->cpu = SMP::this_cpu()->index;
+    task->affinity = affinity;
+    task->on_cpu = 0;
     task->page_directory = 0;  // Share kernel page directory for now
     task->exit_code = 0;
     task->wait_queue_next = nullptr;
+    task->run_next = nullptr;
     
     // Set up the stack
     setup_stack(task, entry);
     
     if (task->stack_base == 0) {
-        LOG_ERROR("Failed to allocate task stack");
         task->state = TaskState::Dead;
+        table_lock.unlock(flags);
+        LOG_ERROR("Failed to allocate task stack");
         return 0;
     }
     
-    // Add to task list (insert after current)
-    if (task_list) {
-        task->next = task_list->next;
-        task->prev = task_list;
-        task_list->next->prev = task;
-        task_list->next = task;
-    } else {
-        task->next = task;
-        task->prev = task;
-        task_list = task;
-    }
+    // Add to task list (insert after head)
+    task->next = task_list->next;
+    task->prev = task_list;
+    task_list->next->prev = task;
+    task_list->next = task;
     
-    stats.total_tasks++;
-    stats.ready_tasks++;
+    // Onto the least loaded CPU it may use
+    enqueue(task, place(task));
+    u32 pid = task->pid;
+    table_lock.unlock(flags);
     
-    LOGF_DEBUG("Created task '%s' (PID %u)", name, task->pid);
+    LOGF_DEBUG("Created task '%s' (PID %u)", name, pid);
     
-    return task->pid;
+    return pid;
 }
 
 void TaskManager::exit(i32 exit_code) {
-    if (!current_task || current_task->pid == 0) {
-        // Can't exit kernel task
+    Task* task = current_task();
+    if (!task || task == run_queues[task->cpu].idle) {
+        // Can't exit kernel or idle tasks
         return;
     }
     
     LOGF_DEBUG("Task '%s' (PID %u) exiting with code %d", 
-               current_task->name, current_task->pid, exit_code);
-    
-    current_task->exit_code = exit_code;
-    current_task->state = TaskState::Zombie;
+               task->name, task->pid, exit_code);
     
-    stats.running_tasks--;
+    u32 flags = table_lock.lock();
+    task->exit_code = exit_code;
+    task->state = TaskState::Zombie;
+    table_lock.unlock(flags);
     
     // Switch to another task
     schedule();
@@ -214,40 +298,27 @@ void TaskManager::exit(i32 exit_code) {
 }
 
 bool TaskManager::kill(u32 pid) {
-    if (pid == 0) {
-        return false;  // Can't kill kernel task
-    }
-    
+    u32 flags = table_lock.lock();
     Task* task = get_task(pid);
-    if (!task || task->state == TaskState::Dead) {
+    if (!task || task->state == TaskState::Dead || task->state == TaskState::Zombie ||
+        task == run_queues[task->cpu].idle) {
+        // Can't kill kernel or idle tasks
+        table_lock.unlock(flags);
         return false;
     }
     
     LOGF_DEBUG("Killing task '%s' (PID %u)", task->name, pid);
     
-    // Update stats based on old state
-    switch (task->state) {
-        case TaskState::Running:
-            stats.running_tasks--;
-            break;
-        case TaskState::Ready:
-            stats.ready_tasks--;
-            break;
-        case TaskState::Blocked:
-            stats.blocked_tasks--;
-            break;
-        case TaskState::Sleeping:
-            stats.sleeping_tasks--;
-            break;
-        default:
-            break;
-    }
-    
-    if (task == current_task) {
-        task->state = TaskState::Zombie;
+    // A queued task leaves its run queue now; one running on another CPU
+    // stops at that CPU's next tick. Zombies are freed once off every CPU.
+    if (task->state == TaskState::Ready) remove(task);
+    task->state = TaskState::Zombie;
+    table_lock.unlock(flags);
+    
+    if (task == current_task()) {
         schedule();
     } else {
-        free_task(task);
+        reap_zombies();
     }
     
     return true;
@@ -263,148 +334,328 @@ Task* TaskManager::get_task(u32 pid) {
 }
 
 void TaskManager::block() {
-    if (!current_task) return;
+    if (!current_task()) return;
     
-    current_task->state = TaskState::Blocked;
-    stats.running_tasks--;
-    stats.blocked_tasks++;
+    u32 flags = table_lock.lock();
+    current_task()->state = TaskState::Blocked;
+    table_lock.unlock(flags);
     
     schedule();
 }
 
 void TaskManager::unblock(u32 pid) {
+    u32 flags = table_lock.lock();
     Task* task = get_task(pid);
     if (task && task->state == TaskState::Blocked) {
         task->state = TaskState::Ready;
         task->time_slice = DEFAULT_TIME_SLICE;
-        stats.blocked_tasks--;
-        stats.ready_tasks++;
+        enqueue(task, place(task));
     }
+    table_lock.unlock(flags);
 }
 
 void TaskManager::sleep(u32 ms) {
-    if (!current_task) return;
+    if (!current_task()) return;
     
     // Calculate wake time in ticks (assuming 1000Hz timer = 1 tick per ms)
     u32 ticks = ms;
     if (ticks == 0) ticks = 1;
     
-    current_task->wake_time = PIT::get_ticks() + ticks;
-    current_task->state = TaskState::Sleeping;
-    stats.running_tasks--;
-    stats.sleeping_tasks++;
+    u32 flags = table_lock.lock();
+    current_task()->wake_time = PIT::get_ticks() + ticks;
+    current_task()->state = TaskState::Sleeping;
+    table_lock.unlock(flags);
     
     schedule();
 }
 
 void TaskManager::yield() {
-    if (!current_task) return;
+    if (!current_task()) return;
     
     // Reset time slice and give up CPU
-    current_task->time_slice = 0;
+    current_task()->time_slice = 0;
     schedule();
 }
 
+bool TaskManager::set_affinity(u32 pid, u32 mask) {
+    if (mask == 0) return false;
+    
+    u32 flags = table_lock.lock();
+    Task* task = get_task(pid);
+    if (!task || task == run_queues[task->cpu].idle) {
+        table_lock.unlock(flags);
+        return false;
+    }
+    
+    // A queued task moves now; a running one when it is next switched out
+    task->affinity = mask;
+    if (task->state == TaskState::Ready && !(mask & (1u << task->cpu)) && remove(task)) {
+        enqueue(task, place(task));
+    }
+    table_lock.unlock(flags);
+    return true;
+}
+
 TaskStats TaskManager::get_stats() {
+    TaskStats stats = {0, 0, 0, 0, 0, 0};
+    for (u32 i = 0; i < MAX_TASKS; i++) {
+        switch (tasks[i].state) {
+            case TaskState::Running:  stats.running_tasks++; break;
+            case TaskState::Ready:    stats.ready_tasks++; break;
+            case TaskState::Blocked:  stats.blocked_tasks++; break;
+            case TaskState::Sleeping: stats.sleeping_tasks++; break;
+            default: break;
+        }
+        if (tasks[i].state != TaskState::Dead) stats.total_tasks++;
+    }
+    for (u32 i = 0; i < config::MAX_CPUS; i++) {
+        stats.context_switches += run_queues[i].context_switches;
+    }
     return stats;
 }
 
+void TaskManager::get_cpu_stats(u32 cpu, CpuSchedStats& out) {
+    out = {0, 0, false, 0, 0, 0};
+    PerCpu* info = SMP::get_cpu(cpu);
+    if (!info) return;
+    
+    const RunQueue& rq = run_queues[cpu];
+    Task* current = info->current_task;
+    out.queued = rq.count;
+    out.current_pid = current ? current->pid : 0;
+    out.idle = !current || current == rq.idle;
+    out.context_switches = rq.context_switches;
+    out.steals = rq.steals;
+    out.stolen = rq.stolen;
+}
+
 void TaskManager::tick() {
-    if (!current_task) return;
+    if (!current_task()) return;
     
     // Update current task's time
-    current_task->total_time++;
+    current_task()->total_time++;
     
     // Decrease time slice
-    if (current_task->time_slice > 0) {
-        current_task->time_slice--;
+    if (current_task()->time_slice > 0) {
+        current_task()->time_slice--;
     }
     
     // Check sleeping tasks
-    u32 current_ticks = PIT::get_ticks();
+    wake_sleepers();
+    
+    // Preempt if time slice expired, or at once if it was killed
+    if (current_task()->time_slice == 0 || current_task()->state != TaskState::Running) {
+        schedule();
+    }
+}
+
+u32 TaskManager::wake_sleepers() {
+    u32 flags = table_lock.lock();
+    u32 waiting = 0;
+    u32 current_ticks = 0;
+    bool have_ticks = false;
     for (u32 i = 0; i < MAX_TASKS; i++) {
         if (tasks[i].state == TaskState::Sleeping) {
+            // The clock is the RTC behind a port pair every CPU shares,
+            // so it is only read when someone sleeps, not on every tick
+            if (!have_ticks) {
+                current_ticks = PIT::get_ticks();
+                have_ticks = true;
+            }
             if (current_ticks >= tasks[i].wake_time) {
                 tasks[i].state = TaskState::Ready;
                 tasks[i].time_slice = DEFAULT_TIME_SLICE;
-                stats.sleeping_tasks--;
-                stats.ready_tasks++;
+                enqueue(&tasks[i], place(&tasks[i]));
+            } else {
+                waiting++;
             }
         }
     }
+    table_lock.unlock(flags);
+    return waiting;
+}
+
+void TaskManager::reap_zombies() {
+    u32 flags = table_lock.lock();
+    for (u32 i = 0; i < MAX_TASKS; i++) {
+        if (tasks[i].state == TaskState::Zombie && !tasks[i].on_cpu) {
+            free_task(&tasks[i]);
+        }
+    }
+    table_lock.unlock(flags);
+}
+
+// ===========================================================================
+// Run Queues
+// ===========================================================================
+
+void TaskManager::enqueue(Task* task, u32 cpu) {
+    RunQueue& rq = run_queues[cpu];
+    u32 flags = rq.lock.lock();
+    task->cpu = cpu;
+    task->run_next = nullptr;
+    if (rq.tail) rq.tail->run_next = task;
+    else rq.head = task;
+    rq.tail = task;
+    rq.count++;
+    rq.lock.unlock(flags);
+    
+    if (cpu != SMP::this_cpu()->index) kick(cpu);
+}
+
+Task* TaskManager::dequeue(u32 cpu, u32 for_cpu) {
+    RunQueue& rq = run_queues[cpu];
+    u32 flags = rq.lock.lock();
+    
+    // Skip tasks still switching off another CPU or not allowed here
+    Task* prev = nullptr;
+    Task* task = rq.head;
+    while (task && (task->on_cpu || !(task->affinity & (1u << for_cpu)))) {
+        prev = task;
+        task = task->run_next;
+    }
     
-    // Preempt if time slice expired
-    if (current_task->time_slice == 0) {
-        schedule();
+    if (task) {
+        if (prev) prev->run_next = task->run_next;
+        else rq.head = task->run_next;
+        if (rq.tail == task) rq.tail = prev;
+        task->run_next = nullptr;
+        rq.count--;
+        if (cpu != for_cpu) rq.stolen++;
     }
+    
+    rq.lock.unlock(flags);
+    return task;
 }
 
-Task* TaskManager::pick_next() {
-    if (!task_list) return nullptr;
+bool TaskManager::remove(Task* task) {
+    RunQueue& rq = run_queues[task->cpu];
+    u32 flags = rq.lock.lock();
+    
+    Task* prev = nullptr;
+    Task* it = rq.head;
+    while (it && it != task) {
+        prev = it;
+        it = it->run_next;
+    }
     
-    // Simple round-robin: start from current and find next ready task
-    Task* start = current_task ? current_task->next : task_list;
-    Task* task = start;
+    if (it) {
+        if (prev) prev->run_next = it->run_next;
+        else rq.head = it->run_next;
+        if (rq.tail == it) rq.tail = prev;
+        it->run_next = nullptr;
+        rq.count--;
+    }
     
-    do {
-        if (task->state == TaskState::Ready) {
-            return task;
+    rq.lock.unlock(flags);
+    return it != nullptr;
+}
+
+u32 TaskManager::place(Task* task) {
+    // Fewest queued tasks, counting a busy CPU's running task; ties stay
+    // on the CPU the task last used
+    u32 best = SMP::this_cpu()->index;
+    u32 best_load = 0xFFFFFFFF;
+    for (u32 i = 0; i < SMP::get_cpu_count(); i++) {
+        PerCpu* cpu = SMP::get_cpu(i);
+        const RunQueue& rq = run_queues[i];
+        if (!cpu->online || !rq.idle || !(task->affinity & (1u << i))) continue;
+        
+        u32 load = rq.count + (cpu->current_task != rq.idle ? 1 : 0);
+        if (load < best_load || (load == best_load && i == task->cpu)) {
+            best = i;
+            best_load = load;
         }
-        task = task->next;
-    } while (task != start);
+    }
+    return best;
+}
+
+void TaskManager::kick(u32 cpu) {
+    // Only a halted idle CPU needs waking; a busy one checks at its next switch
+    PerCpu* target = SMP::get_cpu(cpu);
+    if (target && target->online && target->current_task == run_queues[cpu].idle) {
+        APIC::send_ipi(target->apic_id, config::RESCHED_VECTOR);
+    }
+}
+
+Task* TaskManager::pick_next(u32 cpu) {
+    Task* task = run_queues[cpu].count ? dequeue(cpu, cpu) : nullptr;
+    return task ? task : steal(cpu);
+}
+
+Task* TaskManager::steal(u32 cpu) {
+    // Take from the busiest queue: its CPU is the one falling behind
+    u32 victim = cpu;
+    u32 most = 0;
+    for (u32 i = 0; i < SMP::get_cpu_count(); i++) {
+        if (i != cpu && run_queues[i].count > most) {
+            most = run_queues[i].count;
+            victim = i;
+        }
+    }
+    if (victim == cpu) return nullptr;
     
-    // No ready task found, return kernel/idle task (PID 0)
-    return &tasks[0];
+    Task* task = dequeue(victim, cpu);
+    if (task) run_queues[cpu].steals++;
+    return task;
 }
 
 void TaskManager::schedule() {
-    if (!current_task) return;
+    Task* prev = current_task();
+    if (!prev) return;
     
-    // Clean up zombie tasks
-    for (u32 i = 0; i < MAX_TASKS; i++) {
-        if (tasks[i].state == TaskState::Zombie && &tasks[i] != current_task) {
-            free_task(&tasks[i]);
-        }
-    }
+    u32 irq = irq_save();
+    u32 cpu = SMP::this_cpu()->index;
+    RunQueue& rq = run_queues[cpu];
     
-    // Find next task to run
-    Task* next = pick_next();
+    reap_zombies();
+    wake_sleepers();
     
-    if (next == current_task && current_task->state == TaskState::Running) {
-        // No switch needed
-        current_task->time_slice = DEFAULT_TIME_SLICE;
-        return;
+    // Find next task to run; one killed while we dequeued it is skipped
+    Task* next = nullptr;
+    while (true) {
+        next = pick_next(cpu);
+        if (!next) break;
+        
+        u32 flags = table_lock.lock();
+        bool runnable = next->state == TaskState::Ready;
+        if (runnable) next->state = TaskState::Running;
+        table_lock.unlock(flags);
+        if (runnable) break;
     }
     
-    // Update states
-    if (current_task->state == TaskState::Running) {
-        current_task->state = TaskState::Ready;
-        stats.running_tasks--;
-        stats.ready_tasks++;
+    u32 flags = table_lock.lock();
+    if (!next) {
+        if (prev->state == TaskState::Running || prev == rq.idle) {
+            // Nothing else to run (an idle task can't block either)
+            prev->state = TaskState::Running;
+            prev->time_slice = DEFAULT_TIME_SLICE;
+            table_lock.unlock(flags);
+            irq_restore(irq);
+            return;
+        }
+        next = rq.idle;
+        next->state = TaskState::Running;
     }
     
-    Task* old_task = current_task;
-    current_task = next;
-    
-    if (next->state == TaskState::Ready) {
-        stats.ready_tasks--;
+    // A preempted task goes to the back of a queue it may run on
+    if (prev->state == TaskState::Running) {
+        prev->state = TaskState::Ready;
+        if (prev != rq.idle) {
+            enqueue(prev, (prev->affinity & (1u << cpu)) ? cpu : place(prev));
+        }
     }
-    next->state = TaskState::Running;
-    next->time_slice = DEFAULT_TIME_SLICE;
-    stats.running_tasks++;
+    table_lock.unlock(flags);
     
-    stats.context_switches++;
+    next->time_slice = DEFAULT_TIME_SLICE;
+    next->cpu = cpu;
+    next->on_cpu = 1;
+    current_task() = next;
+    rq.context_switches++;
     
     // Perform the actual context switch
-    if (old_task != next) {
-        switch_context(&old_task->esp, next->esp);
-    }
-}
-
-void TaskManager::idle_task() {
-    while (true) {
-        asm volatile("hlt");  // Wait for interrupt
-    }
+    switch_context(&prev->esp, next->esp, &prev->on_cpu);
+    irq_restore(irq);
 }
 
 } // namespace bolt::sched
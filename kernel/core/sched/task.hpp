@@ -6,6 +6,8 @@
  * =========================================================================== */
 
 #include "../../lib/types.hpp"
+#include "../arch/smp.hpp"
+#include "../sys/spinlock.hpp"
 
 namespace bolt::sched {
 
@@ -15,6 +17,9 @@ constexpr u32 MAX_TASKS = 64;
 // Stack size for each task (4KB)
 constexpr u32 TASK_STACK_SIZE = 4096;
 
+// CPU affinity mask allowing every CPU
+constexpr u32 AFFINITY_ALL = 0xFFFFFFFF;
+
 // Task states
 enum class TaskState : u8 {
     Ready,          // Ready to run
@@ -75,6 +80,9 @@ struct Task {
     u32 time_slice;             // Remaining time slice (ticks)
     u32 total_time;             // Total CPU time used (ticks)
     u32 wake_time;              // Tick count to wake up (if sleeping)
+    u32 cpu;                    // CPU running it, or whose run queue holds it
+    u32 affinity;               // Bit n set = may run on CPU n
+    volatile u32 on_cpu;        // Stack in use until its CPU has switched away
     
     // Memory
     u32 stack_base;             // Bottom of stack
@@ -86,6 +94,9 @@ struct Task {
     Task* next;
     Task* prev;
     
+    // Link in a CPU's run queue
+    Task* run_next;
+    
     // Wait queue for blocking operations
     Task* wait_queue_next;
     
@@ -103,14 +114,34 @@ struct TaskStats {
     u32 context_switches;
 };
 
+// Per-CPU scheduler statistics
+struct CpuSchedStats {
+    u32 queued;                 // Ready tasks in this CPU's run queue
+    u32 current_pid;
+    bool idle;                  // Running its idle task
+    u32 context_switches;
+    u32 steals;                 // Tasks taken from other CPUs' queues
+    u32 stolen;                 // Tasks other CPUs took from this queue
+};
+
 class TaskManager {
 public:
     // Initialize the task manager
     static void init();
     
+    // Give an application processor its idle task (from SMP::ap_entry)
+    static void init_cpu();
+    
+    // Idle loop of a CPU with nothing else to run: schedule, else halt
+    [[noreturn]] static void idle_loop();
+    
     // Create a new task
     // Returns PID or 0 on failure
-    static u32 create(const char* name, void (*entry)(), Priority priority = Priority::Normal);
+    static u32 create(const char* name, void (*entry)(), Priority priority = Priority::Normal,
+                      u32 affinity = AFFINITY_ALL);
+    
+    // Restrict a task to the CPUs in mask (moves it if queued elsewhere)
+    static bool set_affinity(u32 pid, u32 mask);
     
     // Terminate current task
     static void exit(i32 exit_code);
@@ -119,7 +150,7 @@ public:
     static bool kill(u32 pid);
     
     // Get current running task
-    static Task* current() { return current_task; }
+    static Task* current() { return SMP::this_cpu()->current_task; }
     
     // Get task by PID
     static Task* get_task(u32 pid);
@@ -138,6 +169,7 @@ public:
     
     // Get task statistics
     static TaskStats get_stats();
+    static void get_cpu_stats(u32 cpu, CpuSchedStats& out);
     
     // Get list of all tasks (for ps command)
     static Task* get_task_list() { return task_list; }
@@ -161,27 +193,49 @@ private:
     // Set up initial stack for new task
     static void setup_stack(Task* task, void (*entry)());
     
-    // Pick next task to run
-    static Task* pick_next();
-    
-    // Idle task (runs when no other task is ready)
-    static void idle_task();
+    // A CPU's queue of ready tasks, FIFO
+    struct RunQueue {
+        Spinlock lock;
+        Task* head;
+        Task* tail;
+        u32 count;
+        Task* idle;             // Runs when the queue is empty
+        u32 context_switches;
+        u32 steals;
+        u32 stolen;
+    };
+    
+    // Run queue operations
+    static void enqueue(Task* task, u32 cpu);
+    static Task* dequeue(u32 cpu, u32 for_cpu);
+    static bool remove(Task* task);
+    static u32 place(Task* task);
+    static void kick(u32 cpu);
+    
+    // Pick next task to run: own queue first, then steal from the busiest
+    static Task* pick_next(u32 cpu);
+    static Task* steal(u32 cpu);
+    
+    // Make sleepers whose time has come ready again
+    static u32 wake_sleepers();         // Returns how many still sleep
+    
+    // Free zombies that no CPU is still switching away from
+    static void reap_zombies();
     
     // Task array
     static Task tasks[MAX_TASKS];
     
-    // Task list head (circular doubly-linked list of ready tasks)
+    // Task list head (circular doubly-linked list of all tasks)
     static Task* task_list;
     
-    // Currently running task
-    static Task* current_task;
+    // Guards the task table, task_list and task state changes
+    static Spinlock table_lock;
+    
+    static RunQueue run_queues[config::MAX_CPUS];
     
     // Next available PID
     static u32 next_pid;
     
-    // Statistics
-    static TaskStats stats;
-    
     // Default time slice (in timer ticks)
     static constexpr u32 DEFAULT_TIME_SLICE = 10;  // ~100ms at 100Hz
 };
@@ -0,0 +1,76 @@
+/* ===========================================================================
+ * BOLT OS - Boot Trace Implementation
+ * =========================================================================== */
+
+#include "boottrace.hpp"
+#include "config.hpp"
+#include "io.hpp"
+#include "../../drivers/timer/tsc.hpp"
+#include "../../drivers/serial/serial.hpp"
+#include "../../lib/string.hpp"
+
+namespace bolt::sys {
+
+using namespace drivers;
+
+BootPhase BootTrace::phases[BootTrace::MAX_PHASES];
+u32 BootTrace::count = 0;
+u64 BootTrace::finished = 0;
+
+void BootTrace::init() {
+    u64 entry = TSC::read();
+    count = 0;
+    finished = 0;
+    
+    // Low memory may hold anything if another loader started us, so only
+    // trust stamps that are in order
+    u64 load_start = io::read_fixed<u64>(config::BOOT_TSC_ADDR);
+    u64 load_end = io::read_fixed<u64>(config::BOOT_TSC_ADDR + 8);
+    if (load_start && load_start < load_end && load_end < entry) {
+        phases[count++] = {"disk load", load_start, load_end};
+        phases[count++] = {"e820/vesa/pmode", load_end, entry};
+    }
+}
+
+u32 BootTrace::begin(const char* name) {
+    if (count == MAX_PHASES) return MAX_PHASES;
+    phases[count] = {name, TSC::read(), 0};
+    return count++;
+}
+
+void BootTrace::end(u32 index) {
+    if (index < count) phases[index].end = TSC::read();
+}
+
+void BootTrace::finish() {
+    finished = TSC::read();
+}
+
+void BootTrace::dump_serial() {
+    if (!TSC::is_calibrated()) return;
+    
+    u64 origin = get_origin();
+    Serial::writeln("bootchart,phase,start_us,us");
+    for (u32 i = 0; i < count; i++) {
+        const BootPhase& p = phases[i];
+        u64 end = p.end ? p.end : finished;
+        u32 values[] = {TSC::to_us(p.start - origin), TSC::to_us(end - p.start)};
+        
+        Serial::write("bootchart,");
+        Serial::write(p.name);
+        for (u32 v : values) {
+            char num[12];
+            str::utoa(v, num);
+            Serial::write(",");
+            Serial::write(num);
+        }
+        Serial::writeln();
+    }
+    
+    char num[12];
+    str::utoa(TSC::to_us(finished - origin), num);
+    Serial::write("bootchart,total,0,");
+    Serial::writeln(num);
+}
+
+} // namespace bolt::sys
@@ -0,0 +1,63 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Boot Trace
+ * ===========================================================================
+ * TSC timestamps for each phase of kernel_main, plus the bootloader's own
+ * stamps around the kernel load (config::BOOT_TSC_ADDR). Cycles are kept
+ * raw, since most phases run before the TSC is calibrated; `bootchart`
+ * and the serial dump convert them afterwards.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+
+namespace bolt::sys {
+
+struct BootPhase {
+    const char* name;
+    u64 start;                  // TSC
+    u64 end;                    // 0 while the phase runs
+};
+
+class BootTrace {
+public:
+    static constexpr u32 MAX_PHASES = 32;
+    
+    // First thing in kernel_main; adds the bootloader's phases if its
+    // stamps are there
+    static void init();
+    
+    // Phases are listed in the order they begin
+    static u32 begin(const char* name);
+    static void end(u32 index);
+    static void finish();                   // Boot complete, shell next
+    
+    static u32 get_count() { return count; }
+    static const BootPhase* get_phase(u32 index) {
+        return index < count ? &phases[index] : nullptr;
+    }
+    static u64 get_origin() { return count ? phases[0].start : 0; }
+    static u64 get_finish() { return finished; }
+    
+    // "bootchart,phase,start_us,us" per phase, after a header line
+    static void dump_serial();
+
+private:
+    static BootPhase phases[MAX_PHASES];
+    static u32 count;
+    static u64 finished;
+};
+
+// Times one boot phase for as long as it is in scope
+class BootScope {
+public:
+    explicit BootScope(const char* name) : index(BootTrace::begin(name)) {}
+    ~BootScope() { BootTrace::end(index); }
+    
+    BootScope(const BootScope&) = delete;
+    BootScope& operator=(const BootScope&) = delete;
+
+private:
+    u32 index;
+};
+
+} // namespace bolt::sys
@@ -32,17 +32,47 @@ constexpr const char* CODENAME = "BOLT";
 constexpr unsigned long BIOS_DATA_START     = 0x00000;    // BIOS data area
 constexpr unsigned long STACK_TOP           = 0x90000;    // Kernel stack
 constexpr unsigned long BOOTLOADER_ADDR     = 0x7C00;     // Where BIOS loads bootloader
+constexpr unsigned long AP_TRAMPOLINE_ADDR  = 0x8000;     // AP startup code (SIPI vector 0x08)
+constexpr unsigned long BOOT_TSC_ADDR       = 0x618;      // Bootloader TSC stamps: load start, load end
 
 // High memory (>= 1MB) - kernel and heap
 constexpr unsigned long KERNEL_LOAD_ADDR    = 0x100000;   // 1MB - kernel load address
 constexpr unsigned long PMM_BITMAP_START    = 0x200000;   // 2MB - PMM bitmap
 constexpr unsigned long HEAP_START          = 0x210000;   // 2MB + 64KB - heap after PMM bitmap
-constexpr unsigned long HEAP_SIZE           = 0x400000;   // 4MB heap (expandable)
-constexpr unsigned long MAX_MEMORY          = 0x10000000; // 256MB max supported
+constexpr unsigned long HEAP_SIZE           = 0x400000;   // 4MB bootstrap heap, grows via the VMM
+constexpr unsigned long MAX_MEMORY          = 0xFFFFF000; // 4GB - 4KB (32-bit physical limit)
+constexpr unsigned long IDENTITY_MAP_SIZE   = 0x1000000;  // 16MB identity-mapped by the VMM
 
 // Page size
 constexpr unsigned long PAGE_SIZE           = 0x1000;     // 4KB pages
 
+// Virtual window the heap grows into once paging is on (PMM frames)
+#ifndef BOLT_HOST
+constexpr unsigned long HEAP_VIRT_BASE      = 0x80000000; // Right above the VMM's VMA window
+constexpr unsigned long HEAP_VIRT_LIMIT     = 0xC0000000; // 1GB of growth
+#else
+// Host harness: ASan's shadow memory starts just under 2GB
+constexpr unsigned long HEAP_VIRT_BASE      = 0x40000000;
+constexpr unsigned long HEAP_VIRT_LIMIT     = 0x50000000; // 256MB of growth
+#endif
+constexpr unsigned long HEAP_GROW_MIN       = 0x40000;    // 256KB per growth chunk
+
+// Virtual window for slab pages (small objects, one 4KB page per slab)
+constexpr unsigned long SLAB_VIRT_BASE      = 0xC0000000; // Right above the heap window
+constexpr unsigned long SLAB_VIRT_SIZE      = 0x2000000;  // 32MB of slab pages
+
+// Upper bound on processors with their own allocator caches
+constexpr unsigned int MAX_CPUS             = 8;
+
+// Below these, allocators ask registered cache shrinkers for memory back
+constexpr unsigned long HEAP_LOW_WATER      = 0x40000;    // 256KB free heap
+constexpr unsigned long PMM_LOW_WATER_PAGES = 256;        // 1MB of free frames
+
+// Heap debugging: record the call site of every live allocation so
+// `meminfo -l` can list leaks (costs a table scan per alloc/free)
+constexpr bool HEAP_DEBUG                   = false;
+constexpr unsigned int HEAP_DEBUG_SITES     = 512;        // Allocations tracked at once
+
 // ===========================================================================
 // Video Configuration
 // ===========================================================================
@@ -114,6 +144,16 @@ constexpr unsigned int PIT_CHANNEL0         = 0x40;
 constexpr unsigned int PIT_COMMAND          = 0x43;
 constexpr unsigned long PIT_FREQUENCY       = 1193182;    // Base frequency
 constexpr unsigned int PIT_TARGET_HZ        = 1000;       // 1ms ticks
+constexpr unsigned int PIT_CHANNEL2         = 0x42;       // Speaker channel, used for delays
+constexpr unsigned int PIT_GATE_PORT        = 0x61;       // Channel 2 gate/output
+
+// APIC (used instead of the PIC when the firmware describes one)
+constexpr unsigned long LAPIC_DEFAULT_BASE  = 0xFEE00000;
+constexpr unsigned int APIC_SPURIOUS_VECTOR = 0xFF;
+constexpr unsigned int RESCHED_VECTOR       = 0xF0;       // IPI waking an idle CPU
+constexpr unsigned int TLB_SHOOTDOWN_VECTOR = 0xF1;       // IPI flushing another CPU's TLB
+constexpr unsigned int APIC_TIMER_VECTOR    = 0xF2;       // Scheduler tick on the APs
+constexpr unsigned int APIC_TIMER_HZ        = 100;        // Matches the 10-tick time slice
 
 // Serial ports
 constexpr unsigned int COM1_PORT            = 0x3F8;
@@ -130,7 +170,8 @@ constexpr unsigned int ATA_SECONDARY_CTRL   = 0x376;
 // Kernel Limits
 // ===========================================================================
 
-constexpr unsigned long MAX_KERNEL_SIZE     = 131072;     // 128KB (256 sectors)
+constexpr unsigned long MAX_KERNEL_SIZE     = 262144;     // 256KB (512 sectors)
+constexpr unsigned int KERNEL_RESERVED_SECTORS = 512;     // Disk sectors after the boot sector
 constexpr unsigned int MAX_TASKS            = 32;
 constexpr unsigned int MAX_INTERRUPTS       = 256;
 
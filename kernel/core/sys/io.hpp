@@ -31,4 +31,12 @@ inline void io_wait() {
     outb(0x80, 0);
 }
 
+// Read a value the bootloader left at a fixed low address. The address is
+// hidden from GCC, which flags constant pointers into the first page.
+template <typename T>
+inline T read_fixed(u32 addr) {
+    asm("" : "+r"(addr));
+    return *reinterpret_cast<const volatile T*>(addr);
+}
+
 } // namespace bolt::io
@@ -0,0 +1,68 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Spinlocks
+ * ===========================================================================
+ * Interrupt-safe locks for state shared between CPUs. The holding CPU may
+ * take a lock again (the PMM reclaims from inside the heap), so each lock
+ * remembers its owner and how deep it is nested. Spinners keep serving
+ * TLB shootdowns so a holder waiting on one cannot deadlock.
+ *
+ * Host builds (scripts/build_host.sh) take the stand-in from host/ instead:
+ * cli and the per-CPU block do not exist in a Linux process.
+ * =========================================================================== */
+
+#ifdef BOLT_HOST
+#include "host_spinlock.hpp"
+#else
+
+#include "../../lib/types.hpp"
+#include "../arch/smp.hpp"
+
+namespace bolt {
+
+class Spinlock {
+public:
+    static constexpr u32 NO_OWNER = 0xFFFFFFFF;
+    
+    // Disables interrupts and returns the caller's EFLAGS for unlock()
+    u32 lock() {
+        u32 flags;
+        asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+        
+        u32 cpu = SMP::this_cpu()->index;
+        if (owner == cpu) {
+            depth++;
+            return flags;
+        }
+        // Interrupts are off while spinning, so shootdowns are polled:
+        // the holder may be waiting for this CPU's TLB flush
+        while (__atomic_exchange_n(&locked, 1, __ATOMIC_ACQUIRE)) {
+            while (locked) {
+                SMP::poll_tlb_shootdown();
+                asm volatile("pause");
+            }
+        }
+        owner = cpu;
+        depth = 1;
+        return flags;
+    }
+    
+    void unlock(u32 flags) {
+        if (--depth == 0) {
+            owner = NO_OWNER;
+            __atomic_store_n(&locked, 0, __ATOMIC_RELEASE);
+        }
+        asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+    }
+    
+    bool is_held() const { return locked != 0; }
+
+private:
+    volatile u32 locked = 0;
+    volatile u32 owner = NO_OWNER;
+    u32 depth = 0;
+};
+
+} // namespace bolt
+
+#endif // BOLT_HOST
@@ -82,11 +82,13 @@ void System::detect_cpu() {
     
     // Feature flags (EDX)
     sys_info.cpu.has_fpu = (edx & (1 << 0)) != 0;
+    sys_info.cpu.has_tsc = (edx & (1 << 4)) != 0;
     sys_info.cpu.has_apic = (edx & (1 << 9)) != 0;
     sys_info.cpu.has_mmx = (edx & (1 << 23)) != 0;
     sys_info.cpu.has_sse = (edx & (1 << 25)) != 0;
     sys_info.cpu.has_sse2 = (edx & (1 << 26)) != 0;
     sys_info.cpu.has_pae = (edx & (1 << 6)) != 0;
+    sys_info.cpu.has_pge = (edx & (1 << 13)) != 0;
     
     // Try to get brand string (extended CPUID)
     cpuid(0x80000000, eax, ebx, ecx, edx);
@@ -207,11 +209,13 @@ void System::print_info() {
     Console::print("Features:   ");
     Console::set_color(Color::LightGreen);
     if (sys_info.cpu.has_fpu) Console::print("FPU ");
+    if (sys_info.cpu.has_tsc) Console::print("TSC ");
     if (sys_info.cpu.has_mmx) Console::print("MMX ");
     if (sys_info.cpu.has_sse) Console::print("SSE ");
     if (sys_info.cpu.has_sse2) Console::print("SSE2 ");
     if (sys_info.cpu.has_pae) Console::print("PAE ");
     if (sys_info.cpu.has_apic) Console::print("APIC ");
+    if (sys_info.cpu.has_pge) Console::print("PGE ");
     Console::println("");
     Console::set_color(Color::LightCyan);
     
@@ -44,11 +44,13 @@ struct CPUInfo {
     u32 model;
     u32 stepping;
     bool has_fpu;
+    bool has_tsc;
     bool has_mmx;
     bool has_sse;
     bool has_sse2;
     bool has_pae;
     bool has_apic;
+    bool has_pge;           // Global pages (CR4.PGE)
 };
 
 // Complete system information - detected at boot
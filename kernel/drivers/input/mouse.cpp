@@ -113,6 +113,9 @@ void Mouse::init() {
 
 // Poll for mouse data - check if data is available and process it
 void Mouse::poll() {
+    // IRQ 12 feeds the same packet buffer; keep it out until we are done
+    u32 flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
     u8 status = io::inb(STATUS_PORT);
     
     // Check if data available (bit 0) and from mouse (bit 5)
@@ -155,6 +158,7 @@ void Mouse::poll() {
         
         status = io::inb(STATUS_PORT);
     }
+    asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
 }
 
 void Mouse::handle_interrupt() {
@@ -4,6 +4,8 @@
 
 #include "pit.hpp"
 #include "rtc.hpp"
+#include "../../core/sys/io.hpp"
+#include "../../core/sys/config.hpp"
 
 namespace bolt::drivers {
 
@@ -42,4 +44,25 @@ u32 PIT::get_milliseconds() {
     return get_seconds() * 1000;
 }
 
+void PIT::delay_us(u32 us) {
+    while (us > 0) {
+        // One-shot countdown of at most ~50ms per round
+        u32 chunk = us > 50000 ? 50000 : us;
+        us -= chunk;
+        u32 count = chunk * (config::PIT_FREQUENCY / 1000) / 1000;
+        if (count == 0) count = 1;
+        
+        // Gate on, speaker off; mode 0 on channel 2, lobyte/hibyte
+        u8 gate = io::inb(config::PIT_GATE_PORT);
+        io::outb(config::PIT_GATE_PORT, static_cast<u8>((gate & ~0x02) | 0x01));
+        io::outb(config::PIT_COMMAND, 0xB0);
+        io::outb(config::PIT_CHANNEL2, static_cast<u8>(count & 0xFF));
+        io::outb(config::PIT_CHANNEL2, static_cast<u8>(count >> 8));
+        
+        // OUT2 (bit 5) goes high when the count reaches zero
+        while (!(io::inb(config::PIT_GATE_PORT) & 0x20)) {}
+        io::outb(config::PIT_GATE_PORT, gate);
+    }
+}
+
 } // namespace bolt::drivers
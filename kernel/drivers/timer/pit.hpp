@@ -16,6 +16,9 @@ public:
     static u32 get_seconds();
     static u32 get_milliseconds();
     
+    // Busy-wait on PIT channel 2 (works with interrupts off)
+    static void delay_us(u32 us);
+    
 private:
     static u32 boot_hour;
     static u32 boot_minute;
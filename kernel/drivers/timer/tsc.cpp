@@ -0,0 +1,51 @@
+/* ===========================================================================
+ * BOLT OS - Time Stamp Counter Implementation
+ * =========================================================================== */
+
+#include "tsc.hpp"
+#include "pit.hpp"
+
+namespace bolt::drivers {
+
+u32 TSC::khz = 0;
+
+// 64-by-32 division with divl; the quotient saturates when it would not
+// fit in 32 bits (divl would fault)
+static u32 div_sat(u64 dividend, u32 divisor) {
+    u32 hi = static_cast<u32>(dividend >> 32);
+    u32 lo = static_cast<u32>(dividend);
+    if (hi >= divisor) return 0xFFFFFFFF;
+    
+    u32 quotient, remainder;
+    asm("divl %4" : "=a"(quotient), "=d"(remainder) : "a"(lo), "d"(hi), "rm"(divisor));
+    return quotient;
+}
+
+void TSC::calibrate() {
+    // Best of three, so an interrupt in one window doesn't skew the rate
+    u64 best = ~0ull;
+    for (u32 i = 0; i < 3; i++) {
+        u32 flags;
+        asm volatile("pushf; pop %0; cli" : "=r"(flags) :: "memory");
+        u64 start = read();
+        PIT::delay_us(CALIBRATE_US);
+        u64 elapsed = read() - start;
+        asm volatile("push %0; popf" :: "r"(flags) : "memory", "cc");
+        if (elapsed < best) best = elapsed;
+    }
+    khz = div_sat(best, CALIBRATE_US / 1000);
+}
+
+// Past 2^44 cycles both results saturate at any realistic rate, and below
+// it the scaled product still fits in 64 bits
+u32 TSC::to_us(u64 cycles) {
+    if (!khz) return 0;
+    return cycles >> 44 ? 0xFFFFFFFF : div_sat(cycles * 1000, khz);
+}
+
+u32 TSC::to_ns(u64 cycles) {
+    if (!khz) return 0;
+    return cycles >> 44 ? 0xFFFFFFFF : div_sat(cycles * 1000000, khz);
+}
+
+} // namespace bolt::drivers
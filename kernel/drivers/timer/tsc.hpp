@@ -0,0 +1,51 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Time Stamp Counter
+ * ===========================================================================
+ * Cycle-resolution timestamps for benchmarks and latency measurements.
+ * The rate is calibrated once against PIT channel 2; conversions use 32-bit
+ * division only (no libgcc), so they saturate instead of overflowing.
+ * =========================================================================== */
+
+#include "../../lib/types.hpp"
+
+namespace bolt::drivers {
+
+class TSC {
+public:
+    // Measure the counter rate over CALIBRATE_US of PIT time
+    static void calibrate();
+    static bool is_calibrated() { return khz != 0; }
+    static u32 get_khz() { return khz; }
+    
+    static u64 read() {
+        u32 lo, hi;
+        asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+        return (static_cast<u64>(hi) << 32) | lo;
+    }
+    
+    // Elapsed time for a cycle count (0 before calibration)
+    static u32 to_us(u64 cycles);       // Saturates at ~71 minutes
+    static u32 to_ns(u64 cycles);       // Saturates at ~4.2 seconds
+    
+    // count per second over `us` microseconds, without 64-bit division
+    static u32 per_second(u32 count, u32 us) {
+        if (us == 0) return 0;
+        
+        // count * 10^6 / us, scaled down until the dividend fits in 32 bits
+        u64 dividend = static_cast<u64>(count) * 1000000;
+        while (dividend >> 32) {
+            dividend >>= 1;
+            us >>= 1;
+            if (us == 0) return 0xFFFFFFFF;
+        }
+        return static_cast<u32>(dividend) / us;
+    }
+    
+    static constexpr u32 CALIBRATE_US = 10000;
+
+private:
+    static u32 khz;
+};
+
+} // namespace bolt::drivers
@@ -52,15 +52,11 @@ void Framebuffer::init() {
         return;
     }
     
-    // Calculate framebuffer size (round up to page boundary)
+    // Framebuffer size (map_range rounds up to page boundary)
     u32 fb_size = fb_pitch * fb_height;
-    u32 fb_pages = (fb_size + 0xFFF) / 0x1000;
     
-    // Identity-map the framebuffer memory region
-    for (u32 i = 0; i < fb_pages; i++) {
-        u32 addr = fb_phys + (i * 0x1000);
-        mem::VMM::map_page(addr, addr, mem::PageFlags::Present | mem::PageFlags::ReadWrite);
-    }
+    // Identity-map the framebuffer memory region in one batch
+    mem::VMM::map_range(fb_phys, fb_phys, fb_size, mem::PageFlags::Present | mem::PageFlags::ReadWrite);
     
     fb_ptr = reinterpret_cast<u8*>(fb_phys);
     available = true;
@@ -7,9 +7,12 @@
 #include "core/memory/heap.hpp"
 #include "core/memory/pmm.hpp"
 #include "core/memory/vmm.hpp"
+#include "core/memory/slab.hpp"
 #include "core/arch/gdt.hpp"
 #include "core/arch/idt.hpp"
+#include "core/arch/smp.hpp"
 #include "core/sched/task.hpp"
+#include "core/sys/boottrace.hpp"
 #include "core/sys/events.hpp"
 #include "core/sys/log.hpp"
 #include "core/sys/panic.hpp"
@@ -20,6 +23,7 @@
 #include "drivers/input/mouse.hpp"
 #include "drivers/timer/pit.hpp"
 #include "drivers/timer/rtc.hpp"
+#include "drivers/timer/tsc.hpp"
 #include "drivers/serial/serial.hpp"
 #include "drivers/video/graphics.hpp"
 #include "drivers/bus/pci.hpp"
@@ -39,24 +43,46 @@ using namespace bolt::panic;
 using namespace bolt::sched;
 
 extern "C" void kernel_main() {
+    // Each phase below runs in a BootScope, reported by `bootchart`
+    sys::BootTrace::init();
+    
     // =========================================================================
     // Phase 0: Hardware Detection (before anything else)
     // =========================================================================
-    sys::System::init();  // Detect CPU, memory, etc.
+    {
+        sys::BootScope phase("cpu detect");
+        sys::System::init();  // Detect CPU, memory, etc.
+        SMP::init_bsp();      // Kernel GDT/TSS and the boot CPU's GS
+    }
     
     // =========================================================================
     // Phase 1: Early initialization (before we can log)
     // =========================================================================
     
     // Always init VGA text mode first (needed for fallback)
-    VGA::init();
+    {
+        sys::BootScope phase("vga");
+        VGA::init();
+    }
     
     // Initialize serial for debug output
-    Serial::init();
+    {
+        sys::BootScope phase("serial");
+        Serial::init();
+    }
     
     // Initialize timer (needed for logging timestamps)
-    PIT::init();
-    RTC::init();
+    {
+        sys::BootScope phase("pit/rtc");
+        PIT::init();
+        RTC::init();
+    }
+    
+    // Cycle counter for sub-millisecond timing (benchmarks)
+    if (sys::g_system->cpu.has_tsc) {
+        sys::BootScope phase("tsc calibrate");
+        TSC::calibrate();
+    }
     
     // =========================================================================
     // Phase 2: Core systems with logging
@@ -71,48 +97,96 @@ extern "C" void kernel_main() {
         .show_level = true,
         .use_colors = true
     };
-    Logger::init(log_config);
-    
-    // Initialize panic handler
-    Panic::init();
-    LOG_INFO("Panic handler ready");
+    {
+        sys::BootScope phase("logger");
+        Logger::init(log_config);
+        
+        // Initialize panic handler
+        Panic::init();
+        LOG_INFO("Panic handler ready");
+    }
     
     // Initialize legacy heap (for compatibility)
-    mem::Heap::init();
-    LOG_INFO("Legacy heap initialized");
+    {
+        sys::BootScope phase("heap");
+        mem::Heap::init();
+        LOG_INFO("Legacy heap initialized");
+    }
     
     // Initialize Physical Memory Manager
-    mem::PMM::init();
-    auto pmm_stats = mem::PMM::get_stats();
-    LOGF_INFO("PMM: %u MB total, %u pages free", 
-              static_cast<u32>(pmm_stats.total_memory / (1024 * 1024)),
-              pmm_stats.free_pages);
+    {
+        sys::BootScope phase("pmm");
+        mem::PMM::init();
+        auto pmm_stats = mem::PMM::get_stats();
+        LOGF_INFO("PMM: %u MB total, %u pages free", 
+                  static_cast<u32>(pmm_stats.total_memory / (1024 * 1024)),
+                  pmm_stats.free_pages);
+    }
+    
+    // Firmware MP tables are read through physical addresses, so before paging
+    {
+        sys::BootScope phase("smp detect");
+        if (SMP::detect()) {
+            LOGF_INFO("SMP: %u CPU(s) found", SMP::get_cpu_count());
+        }
+    }
     
     // Initialize IDT (interrupts) - needed before VMM for page fault handler
-    IDT::init();
-    LOG_INFO("IDT initialized - interrupts ready");
+    {
+        sys::BootScope phase("idt");
+        IDT::init();
+        LOG_INFO("IDT initialized - interrupts ready");
+    }
     
     // Initialize Virtual Memory Manager
-    LOG_DEBUG("Setting up paging structures...");
-    mem::VMM::init();
-    mem::VMM::register_page_fault_handler();
-    LOG_INFO("VMM: Page tables ready, enabling paging...");
-    
-    // Enable paging!
-    mem::VMM::enable_paging();
-    LOG_INFO("VMM: Paging ENABLED - virtual memory active");
+    {
+        sys::BootScope phase("vmm");
+        LOG_DEBUG("Setting up paging structures...");
+        mem::VMM::init();
+        mem::VMM::register_page_fault_handler();
+        LOG_INFO("VMM: Page tables ready, enabling paging...");
+        
+        // Enable paging!
+        mem::VMM::enable_paging();
+        LOG_INFO("VMM: Paging ENABLED - virtual memory active");
+    }
     
     // Now that paging is enabled, init framebuffer (VESA graphics)
-    Framebuffer::init();
-    if (Framebuffer::is_available()) {
-        LOG_INFO("Framebuffer: VESA graphics initialized");
-    } else {
-        LOG_INFO("Framebuffer: Not available, using VGA text mode");
+    {
+        sys::BootScope phase("framebuffer");
+        Framebuffer::init();
+        if (Framebuffer::is_available()) {
+            LOG_INFO("Framebuffer: VESA graphics initialized");
+        } else {
+            LOG_INFO("Framebuffer: Not available, using VGA text mode");
+        }
+    }
+    
+    // The heap may now grow past its bootstrap region (after the
+    // framebuffer, so its mapping can't land in the growth window)
+    {
+        sys::BootScope phase("slab");
+        mem::Heap::enable_growth();
+        mem::Slab::init();
     }
     
     // Initialize task manager (multitasking)
-    TaskManager::init();
-    LOG_INFO("Task manager ready");
+    {
+        sys::BootScope phase("tasks");
+        TaskManager::init();
+        LOG_INFO("Task manager ready");
+    }
+    
+    // Local/I/O APICs and the application processors, which join the
+    // scheduler with their own run queues
+    {
+        sys::BootScope phase("smp start");
+        SMP::start_aps();
+    }
+    
+    // IDT and interrupt controllers are ready: the boot CPU takes IRQs and
+    // IPIs from now on, so shootdowns no longer wait for it to spin on a lock
+    IDT::enable_interrupts();
     
     // Initialize event system
     EventQueue::init();
@@ -122,71 +196,91 @@ extern "C" void kernel_main() {
     // Phase 3: Device drivers
     // =========================================================================
     
-    Keyboard::init();
-    LOG_INFO("Keyboard driver loaded");
+    {
+        sys::BootScope phase("keyboard");
+        Keyboard::init();
+        LOG_INFO("Keyboard driver loaded");
+    }
     
     // Initialize mouse
-    Mouse::init();
-    if (Framebuffer::is_available()) {
-        Mouse::set_bounds(static_cast<i32>(Framebuffer::width()), 
-                          static_cast<i32>(Framebuffer::height()));
+    {
+        sys::BootScope phase("mouse");
+        Mouse::init();
+        if (Framebuffer::is_available()) {
+            Mouse::set_bounds(static_cast<i32>(Framebuffer::width()), 
+                              static_cast<i32>(Framebuffer::height()));
+        }
+        LOG_INFO("Mouse driver loaded");
     }
-    LOG_INFO("Mouse driver loaded");
     
     // Initialize PCI bus
-    PCI::init();
-    LOG_INFO("PCI bus enumeration complete");
+    {
+        sys::BootScope phase("pci");
+        PCI::init();
+        LOG_INFO("PCI bus enumeration complete");
+    }
     
     // Initialize ATA/IDE
-    ATA::init();
-    LOG_INFO("ATA/IDE driver loaded");
+    {
+        sys::BootScope phase("ata");
+        ATA::init();
+        LOG_INFO("ATA/IDE driver loaded");
+    }
     
     // =========================================================================
     // Phase 4: Storage Subsystem
     // =========================================================================
     
     // Initialize the new unified storage subsystem
-    auto storage_result = storage::Storage::init();
-    switch (storage_result) {
-        case storage::StorageInitResult::Success:
-            LOG_INFO("Storage: All systems operational");
-            break;
-        case storage::StorageInitResult::PartialSuccess:
-            LOG_WARN("Storage: Some devices unavailable");
-            break;
-        case storage::StorageInitResult::DegradedRAMFS:
-            LOG_WARN("Storage: Running in RAMFS fallback mode");
-            break;
-        case storage::StorageInitResult::Failed:
-            LOG_ERROR("Storage: Initialization failed!");
-            break;
-    }
-    
-    // Print storage status
-    storage::Storage::print_status();
+    {
+        sys::BootScope phase("storage");
+        auto storage_result = storage::Storage::init();
+        switch (storage_result) {
+            case storage::StorageInitResult::Success:
+                LOG_INFO("Storage: All systems operational");
+                break;
+            case storage::StorageInitResult::PartialSuccess:
+                LOG_WARN("Storage: Some devices unavailable");
+                break;
+            case storage::StorageInitResult::DegradedRAMFS:
+                LOG_WARN("Storage: Running in RAMFS fallback mode");
+                break;
+            case storage::StorageInitResult::Failed:
+                LOG_ERROR("Storage: Initialization failed!");
+                break;
+        }
+        
+        // Print storage status
+        storage::Storage::print_status();
+    }
     
     // Legacy filesystem support (keeping for compatibility)
-    RAMFS::init();
-    LOG_DEBUG("Legacy RAMFS available");
-    
-    // Create default files in RAMFS for shell
-    RAMFS::create("/readme.txt");
-    FileHandle f = RAMFS::open("/readme.txt");
-    const char* readme = "Welcome to BOLT OS!\nType 'help' for commands.\n";
-    RAMFS::write(f, readme, 46);
-    RAMFS::close(f);
-    
-    RAMFS::create("/sysinfo.txt");
-    f = RAMFS::open("/sysinfo.txt");
-    const char* sysinfo = "BOLT OS v0.4\nArchitecture: x86 (32-bit)\nFeatures: PMM, Paging, Logging\n";
-    RAMFS::write(f, sysinfo, 70);
-    RAMFS::close(f);
+    {
+        sys::BootScope phase("ramfs");
+        RAMFS::init();
+        LOG_DEBUG("Legacy RAMFS available");
+        
+        // Create default files in RAMFS for shell
+        RAMFS::create("/readme.txt");
+        FileHandle f = RAMFS::open("/readme.txt");
+        const char* readme = "Welcome to BOLT OS!\nType 'help' for commands.\n";
+        RAMFS::write(f, readme, 46);
+        RAMFS::close(f);
+        
+        RAMFS::create("/sysinfo.txt");
+        f = RAMFS::open("/sysinfo.txt");
+        const char* sysinfo = "BOLT OS v0.4\nArchitecture: x86 (32-bit)\nFeatures: PMM, Paging, Logging\n";
+        RAMFS::write(f, sysinfo, 70);
+        RAMFS::close(f);
+    }
     
     // =========================================================================
     // Phase 5: User interface
     // =========================================================================
     
     LOG_INFO("Boot complete - starting shell");
+    sys::BootTrace::finish();
+    sys::BootTrace::dump_serial();
     
     // Display banner using appropriate driver
     if (Framebuffer::is_available()) {
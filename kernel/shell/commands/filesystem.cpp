@@ -12,12 +12,80 @@
 #include "../../drivers/serial/serial.hpp"
 #include "../../drivers/input/keyboard.hpp"
 #include "../../storage/vfs.hpp"
+#include "../../storage/fat32fs.hpp"
+#include "../../storage/ramfs.hpp"
+#include "../../storage/bench.hpp"
+#include "../../drivers/timer/pit.hpp"
+#include "../../drivers/timer/tsc.hpp"
+#include "../../core/memory/heap.hpp"
 #include "../../lib/string.hpp"
 
 namespace bolt::shell::cmd {
 
 using namespace drivers;
 using namespace storage;
+using namespace mem;
+
+// ===========================================================================
+// Batched Directory Reader
+// ===========================================================================
+
+// Pulls entries through VFS::getdents a batch at a time so each directory
+// is walked once. "." and ".." are filtered here for every caller.
+static constexpr u32 DIR_BATCH = 16;
+
+struct DirReader {
+    u32 fd = 0;
+    FileInfo* batch = nullptr;
+    u32 count = 0;
+    u32 pos = 0;
+    bool done = true;
+    
+    VFSResult begin(const char* path) {
+        VFSResult result = VFS::opendir(path, fd);
+        if (result != VFSResult::Success) return result;
+        batch = static_cast<FileInfo*>(Heap::alloc(sizeof(FileInfo) * DIR_BATCH, MemTag::Shell));
+        if (!batch) {
+            VFS::closedir(fd);
+            return VFSResult::NoSpace;
+        }
+        count = pos = 0;
+        done = false;
+        return VFSResult::Success;
+    }
+    
+    // True if another entry is available (refills the batch when drained,
+    // which invalidates pointers previously returned by next())
+    bool has_more() {
+        while (!done) {
+            while (pos < count) {
+                const char* n = batch[pos].name;
+                if (!(n[0] == '.' && (n[1] == 0 || (n[1] == '.' && n[2] == 0)))) {
+                    return true;
+                }
+                pos++;
+            }
+            if (VFS::getdents(fd, batch, DIR_BATCH, count) != VFSResult::Success || count == 0) {
+                done = true;
+            }
+            pos = 0;
+        }
+        return false;
+    }
+    
+    const FileInfo* next() {
+        return has_more() ? &batch[pos++] : nullptr;
+    }
+    
+    void end() {
+        if (batch) {
+            Heap::free(batch);
+            VFS::closedir(fd);
+            batch = nullptr;
+        }
+        done = true;
+    }
+};
 
 void ls(int argc, char** argv) {
     DBG("CMD", "ls: Listing directory");
@@ -41,8 +109,8 @@ void ls(int argc, char** argv) {
     }
     
     // Open directory via VFS
-    u32 fd = 0;
-    VFSResult result = VFS::opendir(path, fd);
+    DirReader dir;
+    VFSResult result = dir.begin(path);
     
     if (result != VFSResult::Success) {
         Serial::log("CMD", LogType::Error, "opendir failed: ", vfs_result_string(result));
@@ -61,27 +129,26 @@ void ls(int argc, char** argv) {
     Console::set_color(Color::LightGray);
     
     // Read directory entries
-    FileInfo info;
     i32 count = 0;
     
-    while (VFS::readdir(fd, info) == VFSResult::Success) {
+    while (const FileInfo* info = dir.next()) {
         Console::print("  ");
         
-        if (info.is_directory()) {
+        if (info->is_directory()) {
             Console::set_color(Color::LightBlue);
-            Console::print(info.name);
+            Console::print(info->name);
             Console::println("/");
         } else {
             Console::set_color(Color::White);
-            Console::print(info.name);
+            Console::print(info->name);
             Console::print("  (");
-            Console::print_dec(static_cast<i32>(info.size));
+            Console::print_dec(static_cast<i32>(info->size));
             Console::println(" bytes)");
         }
         count++;
     }
     
-    VFS::closedir(fd);
+    dir.end();
     
     if (count == 0) {
         Console::println("  (empty)");
@@ -534,19 +601,26 @@ void cp(int argc, char** argv) {
         return;
     }
     
-    // Copy in chunks
-    char buffer[512];
-    u64 bytes_read = 0, bytes_written = 0;
+    // Let the filesystem copy in place where it can
+    FileInfo info;
     u64 total_copied = 0;
-    
-    while (VFS::read(src_fd, buffer, sizeof(buffer), bytes_read) == VFSResult::Success && bytes_read > 0) {
-        VFS::write(dst_fd, buffer, bytes_read, bytes_written);
-        total_copied += bytes_written;
+    result = VFS::stat(src_path, info);
+    if (result == VFSResult::Success) {
+        result = VFS::copy_range(src_fd, dst_fd, info.size, total_copied);
     }
     
     VFS::close(src_fd);
     VFS::close(dst_fd);
     
+    if (result != VFSResult::Success) {
+        Serial::log("CMD", LogType::Error, "cp failed: ", vfs_result_string(result));
+        Console::set_color(Color::LightRed);
+        Console::print("Copy failed: ");
+        Console::println(vfs_result_string(result));
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
     Console::set_color(Color::LightGreen);
     Console::print("Copied ");
     Console::print_dec(static_cast<i32>(total_copied));
@@ -587,21 +661,40 @@ void mv(int argc, char** argv) {
         return;
     }
     
-    // Try rename first (for same filesystem)
+    // Moving onto a directory moves into it
+    if (VFS::is_directory(dst_path)) {
+        char name[64];
+        path::basename(src_path, name, sizeof(name));
+        if (dst_path[str::len(dst_path) - 1] != '/') str::cat(dst_path, "/");
+        if (str::len(dst_path) + str::len(name) >= sizeof(dst_path)) {
+            Console::set_color(Color::LightRed);
+            Console::println("Destination path too long");
+            Console::set_color(Color::LightGray);
+            return;
+        }
+        str::cat(dst_path, name);
+    }
+    
+    // Try rename first; on one filesystem only the entry moves
     VFSResult result = VFS::rename(src_path, dst_path);
     
     if (result == VFSResult::Success) {
         Console::set_color(Color::LightGreen);
         Console::println("Moved.");
         Serial::log("CMD", LogType::Success, "Moved/renamed");
-    } else if (result == VFSResult::Unsupported) {
+    } else if (result == VFSResult::Unsupported || result == VFSResult::CrossDevice) {
         // Fallback: copy + delete (for files only)
         if (!VFS::is_directory(src_path)) {
             // Simulate with cp + rm
-            char* fake_argv[3] = {argv[0], argv[1], argv[2]};
+            char* fake_argv[3] = {argv[0], src_path, dst_path};
             cp(3, fake_argv);
             
-            result = VFS::unlink(src_path);
+            // Keep the source unless the whole copy landed
+            FileInfo src_info, dst_info;
+            bool landed = VFS::stat(src_path, src_info) == VFSResult::Success &&
+                          VFS::stat(dst_path, dst_info) == VFSResult::Success &&
+                          src_info.size == dst_info.size;
+            result = landed ? VFS::unlink(src_path) : VFSResult::IOError;
             if (result == VFSResult::Success) {
                 Console::set_color(Color::LightGreen);
                 Console::println("Moved (via copy).");
@@ -613,7 +706,8 @@ void mv(int argc, char** argv) {
     } else {
         Serial::log("CMD", LogType::Error, "mv failed: ", vfs_result_string(result));
         Console::set_color(Color::LightRed);
-        Console::println("Move failed.");
+        Console::print("Move failed: ");
+        Console::println(vfs_result_string(result));
     }
     Console::set_color(Color::LightGray);
 }
@@ -690,28 +784,14 @@ void stat_cmd(int argc, char** argv) {
 static void tree_recurse(const char* path, int depth, int* file_count, int* dir_count, bool* last_at_depth) {
     if (depth > 8) return;  // Prevent infinite recursion
     
-    u32 fd = 0;
-    if (VFS::opendir(path, fd) != VFSResult::Success) return;
+    DirReader dir;
+    if (dir.begin(path) != VFSResult::Success) return;
     
-    // First, count entries to know when we're at the last one
+    // Single pass: copy the entry out, then peek to know if it was the last
     FileInfo info;
-    int entry_count = 0;
-    while (VFS::readdir(fd, info) == VFSResult::Success) {
-        if (str::cmp(info.name, ".") == 0 || str::cmp(info.name, "..") == 0) continue;
-        entry_count++;
-    }
-    VFS::closedir(fd);
-    
-    // Reopen and iterate
-    if (VFS::opendir(path, fd) != VFSResult::Success) return;
-    
-    int current_entry = 0;
-    while (VFS::readdir(fd, info) == VFSResult::Success) {
-        // Skip . and ..
-        if (str::cmp(info.name, ".") == 0 || str::cmp(info.name, "..") == 0) continue;
-        
-        current_entry++;
-        bool is_last = (current_entry == entry_count);
+    while (const FileInfo* entry = dir.next()) {
+        str::memcpy(&info, entry, sizeof(FileInfo));
+        bool is_last = !dir.has_more();
         
         // Print indent with proper tree lines
         for (int i = 0; i < depth; i++) {
@@ -749,7 +829,7 @@ static void tree_recurse(const char* path, int depth, int* file_count, int* dir_
         }
     }
     
-    VFS::closedir(fd);
+    dir.end();
     Console::set_color(Color::LightGray);
 }
 
@@ -790,6 +870,19 @@ void tree(int argc, char** argv) {
     Console::println(" files");
 }
 
+static void print_column(const char* text, usize width) {
+    Console::print(text);
+    for (usize i = str::len(text); i < width; i++) {
+        Console::print(" ");
+    }
+}
+
+static void print_column(u32 value, usize width) {
+    char buf[12];
+    str::utoa(value, buf);
+    print_column(buf, width);
+}
+
 void df() {
     DBG("CMD", "df: Disk free space");
     
@@ -801,13 +894,459 @@ void df() {
     }
     
     Console::set_color(Color::LightCyan);
-    Console::println("Filesystem      Type       Mounted on");
+    Console::println("Filesystem  Type    Size(K)   Used(K)   Avail(K)  Use%  Mounted on");
+    Console::set_color(Color::White);
+    
+    for (u32 i = 0; i < VFS::get_mount_count(); i++) {
+        MountPoint* mp = VFS::get_mount_by_index(i);
+        if (!mp || !mp->active || !mp->fs) continue;
+        
+        // KB fits in 32 bits up to 4TB, which keeps the math off libgcc
+        u32 total = static_cast<u32>(mp->fs->total_space() >> 10);
+        u32 avail = static_cast<u32>(mp->fs->free_space() >> 10);
+        u32 used = total > avail ? total - avail : 0;
+        u32 percent = 0;
+        if (total) {
+            percent = (total < 0x01000000) ? (used * 100 + total - 1) / total
+                                           : (used >> 8) * 100 / (total >> 8);
+        }
+        
+        char pct[8];
+        str::utoa(percent, pct);
+        str::cat(pct, "%");
+        
+        print_column(mp->device ? mp->device->get_info().name : "none", 12);
+        print_column(mp->fs->name(), 8);
+        print_column(total, 10);
+        print_column(used, 10);
+        print_column(avail, 10);
+        print_column(pct, 6);
+        Console::println(mp->path);
+    }
+    
+    Console::set_color(Color::LightGray);
+}
+
+void fsstat() {
+    DBG("CMD", "fsstat: Filesystem cache statistics");
+    
+    if (!VFS::is_ready()) {
+        Console::set_color(Color::LightRed);
+        Console::println("Filesystem not ready");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    for (u32 i = 0; i < VFS::get_mount_count(); i++) {
+        MountPoint* mp = VFS::get_mount_by_index(i);
+        if (!mp || !mp->active || !mp->fs) continue;
+        
+        Console::set_color(Color::LightCyan);
+        Console::print(mp->path);
+        Console::print(" (");
+        Console::print(mp->fs->name());
+        Console::println(")");
+        Console::set_color(Color::White);
+        
+        FSCacheStats st;
+        if (!mp->fs->get_cache_stats(st)) {
+            Console::println("  no cache");
+            continue;
+        }
+        
+        u32 lookups = st.hits + st.misses;
+        Console::print("  Cache:      ");
+        Console::print_dec(st.blocks);
+        Console::print(" x ");
+        Console::print_dec(st.block_size);
+        Console::println(" bytes");
+        
+        Console::print("  Hits:       ");
+        Console::print_dec(st.hits);
+        Console::print(" / ");
+        Console::print_dec(lookups);
+        Console::print(" (");
+        Console::print_dec(lookups ? (st.hits * 100) / lookups : 0);
+        Console::println("%)");
+        
+        Console::print("  Read-ahead: ");
+        Console::print_dec(st.readahead_issued);
+        Console::print(" issued, ");
+        Console::print_dec(st.readahead_hits);
+        Console::print(" used (");
+        Console::print_dec(st.readahead_issued ? (st.readahead_hits * 100) / st.readahead_issued : 0);
+        Console::print("%), ");
+        Console::print_dec(st.readahead_wasted);
+        Console::println(" wasted");
+        
+        Console::print("  Device:     ");
+        Console::print_dec(st.device_reads);
+        Console::print(" reads, ");
+        Console::print_dec(st.sectors_read);
+        Console::println(" sectors");
+    }
+    
+    Console::set_color(Color::LightGray);
+}
+
+void sync() {
+    DBG("CMD", "sync: Flush filesystems");
+    
+    if (!VFS::is_ready()) {
+        Console::set_color(Color::LightRed);
+        Console::println("Filesystem not ready");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    VFSResult result = VFS::sync_all();
+    if (result != VFSResult::Success) {
+        Console::set_color(Color::LightRed);
+        Console::print("sync: ");
+        Console::println(vfs_result_string(result));
+        Console::set_color(Color::LightGray);
+    }
+}
+
+static void fsck_line(const char* label, u32 value) {
+    Console::print(label);
+    Console::print_dec(value);
+    Console::println("");
+}
+
+void fsck(int argc, char** argv) {
+    DBG("CMD", "fsck: Check filesystem");
+    
+    bool repair = false;
+    const char* target = "/";
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "-r") == 0) {
+            repair = true;
+        } else {
+            target = argv[i];
+        }
+    }
+    
+    if (!VFS::is_ready()) {
+        Console::set_color(Color::LightRed);
+        Console::println("Filesystem not ready");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    char path[128];
+    Shell::resolve_path(target, path);
+    
+    MountPoint* mp = VFS::get_mount(path);
+    if (!mp || !mp->fs) {
+        Console::set_color(Color::LightRed);
+        Console::println("fsck: not mounted");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    if (mp->fs->type() != FilesystemType::FAT32) {
+        Console::set_color(Color::Yellow);
+        Console::print("fsck: nothing to check on ");
+        Console::println(mp->fs->name());
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    // Pending writes must reach the disk before the FAT is read back
+    VFS::sync_all();
+    
+    Console::set_color(Color::LightCyan);
+    Console::print("Checking ");
+    Console::print(mp->path);
+    Console::println(repair ? " (repair)" : "");
+    Console::set_color(Color::White);
+    
+    FAT32Filesystem* fat = static_cast<FAT32Filesystem*>(mp->fs);
+    FAT32CheckReport report;
+    u32 start = PIT::get_milliseconds();
+    bool ok = fat->check(report, repair);
+    u32 elapsed = PIT::get_milliseconds() - start;
+    
+    if (!ok) {
+        Console::set_color(Color::LightRed);
+        Console::println("fsck: check failed (I/O error or out of memory)");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    fsck_line("  FAT copies:     ", report.fat_copies);
+    fsck_line("  Clusters:       ", report.clusters);
+    fsck_line("  Free:           ", report.free);
+    fsck_line("  Bad:            ", report.bad);
+    fsck_line("  Chains:         ", report.chains);
+    
+    if (report.free_recorded != 0xFFFFFFFF && report.free_recorded != report.free) {
+        Console::set_color(Color::Yellow);
+        fsck_line("  Recorded free:  ", report.free_recorded);
+        Console::set_color(Color::White);
+    }
+    
+    if (report.errors() > 0) {
+        Console::set_color(Color::LightRed);
+        if (report.mirror_mismatches) fsck_line("  Mirror diffs:   ", report.mirror_mismatches);
+        if (report.bad_links)         fsck_line("  Bad links:      ", report.bad_links);
+        if (report.cross_links)       fsck_line("  Cross-links:    ", report.cross_links);
+        if (report.dangling_links)    fsck_line("  Dangling links: ", report.dangling_links);
+    }
+    
+    Console::set_color(Color::DarkGray);
+    Console::print("  Volume was ");
+    Console::print(report.was_clean ? "clean" : "dirty");
+    Console::print(", ");
+    Console::print_dec(report.sectors_read);
+    Console::print(" FAT sectors in ");
+    Console::print_dec(elapsed);
+    Console::println(" ms");
+    
+    if (report.errors() == 0) {
+        Console::set_color(Color::LightGreen);
+        Console::println("No errors found");
+    } else if (repair) {
+        Console::set_color(Color::Yellow);
+        Console::print_dec(report.repaired);
+        Console::println(" entries repaired");
+    } else {
+        Console::set_color(Color::Yellow);
+        Console::print_dec(report.errors());
+        Console::println(" errors, run 'fsck -r' to repair");
+    }
+    
+    Console::set_color(Color::LightGray);
+}
+
+static void fsinfo_histogram(const char* title, const u32* hist) {
+    Console::set_color(Color::LightCyan);
+    Console::println(title);
+    Console::set_color(Color::White);
+    
+    for (u32 b = 0; b < FAT32SpaceStats::BUCKETS; b++) {
+        if (!hist[b]) continue;
+        
+        char label[24];
+        str::utoa(1u << b, label);
+        if (b > 0) {
+            char upper[12];
+            str::utoa((2u << b) - 1, upper);
+            str::cat(label, "-");
+            str::cat(label, upper);
+        }
+        
+        Console::print("  ");
+        print_column(label, 14);
+        Console::print_dec(hist[b]);
+        Console::println("");
+    }
+}
+
+void fsinfo(int argc, char** argv) {
+    DBG("CMD", "fsinfo: Filesystem space map");
+    
+    bool rescan = false;
+    const char* target = "/";
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "-r") == 0) {
+            rescan = true;
+        } else {
+            target = argv[i];
+        }
+    }
+    
+    if (!VFS::is_ready()) {
+        Console::set_color(Color::LightRed);
+        Console::println("Filesystem not ready");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    char path[128];
+    Shell::resolve_path(target, path);
+    
+    MountPoint* mp = VFS::get_mount(path);
+    if (!mp || !mp->fs) {
+        Console::set_color(Color::LightRed);
+        Console::println("fsinfo: not mounted");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    if (mp->fs->type() != FilesystemType::FAT32) {
+        Console::set_color(Color::Yellow);
+        Console::print("fsinfo: no space map on ");
+        Console::println(mp->fs->name());
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    FAT32Filesystem* fat = static_cast<FAT32Filesystem*>(mp->fs);
+    if (rescan) {
+        VFS::sync_all();
+        if (!fat->scan_space()) {
+            Console::set_color(Color::LightRed);
+            Console::println("fsinfo: scan failed (I/O error or out of memory)");
+            Console::set_color(Color::LightGray);
+            return;
+        }
+    }
+    
+    const FAT32SpaceStats& st = fat->get_space_stats();
+    
+    Console::set_color(Color::LightCyan);
+    Console::print(mp->path);
+    Console::print(" (");
+    Console::print(fat->get_volume_label());
+    Console::println(")");
     Console::set_color(Color::White);
     
-    // Get mount info from VFS
-    Console::print("/dev/hda1       FAT32      /\n");
-    Console::println("(Detailed disk stats not yet implemented)");
+    fsck_line("  Cluster size:   ", fat->get_cluster_size());
+    fsck_line("  Clusters:       ", fat->get_total_clusters());
+    fsck_line("  Free:           ", fat->get_free_clusters());
+    
+    if (!st.valid) {
+        Console::set_color(Color::DarkGray);
+        Console::println("  No space map (mount scan disabled), run 'fsinfo -r'");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    fsck_line("  Used:           ", st.used_clusters);
+    fsck_line("  Bad:            ", st.bad_clusters);
+    fsck_line("  Chains:         ", st.chains);
+    fsck_line("  Extents:        ", st.extents);
+    if (st.chains) {
+        // Tenths of an extent per chain; 1.0 means no fragmentation
+        u32 tenths = (st.extents * 10) / st.chains;
+        Console::print("  Extents/chain:  ");
+        Console::print_dec(tenths / 10);
+        Console::print(".");
+        Console::print_dec(tenths % 10);
+        Console::println("");
+    }
+    fsck_line("  Free runs:      ", st.free_runs);
+    fsck_line("  Largest run:    ", st.largest_free_run);
+    
+    fsinfo_histogram("Extent lengths (clusters)", st.extent_hist);
+    fsinfo_histogram("Free run lengths (clusters)", st.free_hist);
+    
+    Console::set_color(Color::DarkGray);
+    Console::print("Scanned in ");
+    Console::print_dec(st.scan_ms);
+    Console::println(" ms");
+    Console::set_color(Color::LightGray);
+}
+
+// ===========================================================================
+// Storage Benchmarks
+// ===========================================================================
+
+// One console row per result; the CSV row goes to serial for scripts
+static void bench_report(const BenchResult& r, void*) {
+    char line[StorageBench::CSV_LINE];
+    StorageBench::format_csv(r, line);
+    Serial::writeln(line);
+    
+    Console::set_color(Color::White);
+    print_column(r.workload, 12);
+    print_column(r.param, 8);
+    print_column(r.ops, 8);
+    print_column(r.us, 12);
+    print_column(TSC::per_second(r.ops, r.us), 10);
+    print_column(TSC::per_second(static_cast<u32>(r.bytes >> 10), r.us), 10);
+    
+    if (r.status == VFSResult::Success) {
+        Console::set_color(Color::LightGreen);
+        Console::println("ok");
+    } else if (r.status == VFSResult::NoSpace) {
+        Console::set_color(Color::Yellow);
+        Console::println("limit");
+    } else {
+        Console::set_color(Color::LightRed);
+        Console::println(vfs_result_string(r.status));
+    }
+    Console::set_color(Color::LightGray);
+}
+
+static void bench_header(const char* fs) {
+    Console::set_color(Color::LightCyan);
+    Console::print("Benchmark: ");
+    Console::println(fs);
+    print_column("Workload", 12);
+    print_column("Param", 8);
+    print_column("Ops", 8);
+    print_column("Time(us)", 12);
+    print_column("Ops/s", 10);
+    print_column("KB/s", 10);
+    Console::println("Status");
+    Console::set_color(Color::LightGray);
+}
+
+void bench(int argc, char** argv) {
+    DBG("CMD", "bench: Storage benchmarks");
+    
+    bool run_fat = true;
+    bool run_ram = true;
+    BenchConfig cfg = BenchConfig::defaults();
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "fat") == 0) {
+            run_ram = false;
+        } else if (str::cmp(argv[i], "ram") == 0) {
+            run_fat = false;
+        } else if (str::cmp(argv[i], "quick") == 0) {
+            cfg = BenchConfig::quick();
+        } else if (str::cmp(argv[i], "all") != 0) {
+            Console::println("Usage: bench [fat|ram|all] [quick]");
+            return;
+        }
+    }
+    
+    if (!TSC::is_calibrated()) {
+        Console::set_color(Color::LightRed);
+        Console::println("bench: no calibrated TSC");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    if (!VFS::is_ready()) {
+        Console::set_color(Color::LightRed);
+        Console::println("VFS not ready");
+        Console::set_color(Color::LightGray);
+        return;
+    }
     
+    Serial::writeln(StorageBench::csv_header());
+    bool ok = true;
+    
+    if (run_fat) {
+        MountPoint* root = VFS::get_mount("/");
+        if (root && root->fs_type == FilesystemType::FAT32) {
+            bench_header(root->fs->name());
+            ok &= StorageBench::run("/", root->fs->name(), cfg, bench_report, nullptr);
+        } else {
+            Console::println("No FAT32 root mounted, skipping disk benchmarks");
+        }
+    }
+    
+    if (run_ram) {
+        RAMFilesystem* ramfs = new (MemTag::RAMFS) RAMFilesystem();
+        VFSResult result = ramfs ? VFS::mount(ramfs, "/RAMBENCH") : VFSResult::NoSpace;
+        if (result == VFSResult::Success) {
+            bench_header(ramfs->name());
+            ok &= StorageBench::run("/RAMBENCH", ramfs->name(), cfg, bench_report, nullptr);
+            VFS::unmount("/RAMBENCH");
+        } else {
+            Console::set_color(Color::LightRed);
+            Console::print("bench: ramfs mount failed: ");
+            Console::println(vfs_result_string(result));
+            Console::set_color(Color::LightGray);
+            delete ramfs;
+        }
+    }
+    
+    Console::set_color(ok ? Color::LightGreen : Color::LightRed);
+    Console::println(ok ? "Benchmarks complete (CSV on serial)" : "Benchmarks finished with errors");
     Console::set_color(Color::LightGray);
 }
 
@@ -991,12 +1530,11 @@ void append(int argc, char** argv) {
 
 // Helper for find command
 static void find_recurse(const char* path, const char* pattern, int* count) {
-    u32 fd = 0;
-    if (VFS::opendir(path, fd) != VFSResult::Success) return;
+    DirReader dir;
+    if (dir.begin(path) != VFSResult::Success) return;
     
-    FileInfo info;
-    while (VFS::readdir(fd, info) == VFSResult::Success) {
-        if (str::cmp(info.name, ".") == 0 || str::cmp(info.name, "..") == 0) continue;
+    while (const FileInfo* entry = dir.next()) {
+        const FileInfo& info = *entry;
         
         // Build full path
         char fullpath[256];
@@ -1034,7 +1572,7 @@ static void find_recurse(const char* path, const char* pattern, int* count) {
         }
     }
     
-    VFS::closedir(fd);
+    dir.end();
 }
 
 void find_cmd(int argc, char** argv) {
@@ -1134,12 +1672,11 @@ void wc(int argc, char** argv) {
 static u64 du_recurse(const char* path, bool show_all) {
     u64 total = 0;
     
-    u32 fd = 0;
-    if (VFS::opendir(path, fd) != VFSResult::Success) return 0;
+    DirReader dir;
+    if (dir.begin(path) != VFSResult::Success) return 0;
     
-    FileInfo info;
-    while (VFS::readdir(fd, info) == VFSResult::Success) {
-        if (str::cmp(info.name, ".") == 0 || str::cmp(info.name, "..") == 0) continue;
+    while (const FileInfo* entry = dir.next()) {
+        const FileInfo& info = *entry;
         
         char fullpath[256];
         str::cpy(fullpath, path);
@@ -1166,7 +1703,7 @@ static u64 du_recurse(const char* path, bool show_all) {
         }
     }
     
-    VFS::closedir(fd);
+    dir.end();
     return total;
 }
 
@@ -22,6 +22,11 @@ void mv(int argc, char** argv);          // Move/rename file
 void stat_cmd(int argc, char** argv);    // File statistics
 void tree(int argc, char** argv);        // Directory tree view
 void df();                               // Disk free space
+void fsstat();                           // Filesystem cache statistics
+void sync();                             // Flush filesystems to disk
+void fsck(int argc, char** argv);        // Check FAT copies and chains
+void fsinfo(int argc, char** argv);      // FAT space map and fragmentation
+void bench(int argc, char** argv);       // Storage benchmarks (CSV on serial)
 void head(int argc, char** argv);        // First N lines
 void tail(int argc, char** argv);        // Last N lines
 void append(int argc, char** argv);      // Append to file
@@ -12,6 +12,7 @@
 #include "../../storage/ata_device.hpp"
 #include "../../lib/string.hpp"
 #include "../../core/memory/heap.hpp"
+#include "../../core/sys/config.hpp"
 #include "../../core/sys/io.hpp"
 
 // Bootloader data (outside namespace)
@@ -35,8 +36,8 @@ static u32 get_kernel_size() {
     // Check if the value was stored during boot
     // The CD bootloader stores kernel_sectors at a known location
     volatile u8* boot_info = (volatile u8*)0x7C00;
-    u32 sectors = boot_info[3];
-    if (sectors == 0 || sectors > 200) sectors = 178;  // Default
+    u32 sectors = boot_info[3] | (boot_info[4] << 8);  // 16-bit count
+    if (sectors == 0 || sectors > config::KERNEL_RESERVED_SECTORS) sectors = 178;  // Default
     return sectors;
 }
 
@@ -84,7 +85,7 @@ static bool confirm(const char* message) {
 // ===========================================================================
 
 static bool create_fat32(BlockDevice* device, u32 partition_start, u32 partition_sectors) {
-    u8* buffer = static_cast<u8*>(Heap::alloc(512));
+    u8* buffer = static_cast<u8*>(Heap::alloc(512, MemTag::Shell));
     if (!buffer) return false;
     
     // Clear buffer
@@ -242,7 +243,7 @@ static bool copy_kernel(BlockDevice* device, u32 kernel_sectors) {
     
     Serial::log("INSTALL", LogType::Info, "Copying kernel to disk...");
     
-    u8* buffer = static_cast<u8*>(Heap::alloc(512));
+    u8* buffer = static_cast<u8*>(Heap::alloc(512, MemTag::Shell));
     if (!buffer) return false;
     
     // Source: kernel loaded at 0x10000
@@ -281,7 +282,7 @@ static bool write_bootloader(BlockDevice* device, u32 kernel_sectors) {
     // Write the bootloader to sector 0
     // The HDD bootloader code is stored in memory or embedded
     
-    u8* buffer = static_cast<u8*>(Heap::alloc(512));
+    u8* buffer = static_cast<u8*>(Heap::alloc(512, MemTag::Shell));
     if (!buffer) return false;
     
     Serial::log("INSTALL", LogType::Info, "Writing bootloader...");
@@ -295,8 +296,9 @@ static bool write_bootloader(BlockDevice* device, u32 kernel_sectors) {
         buffer[i] = (i < (int)sizeof(hdd_bootloader)) ? hdd_bootloader[i] : 0;
     }
     
-    // Patch kernel sectors count at offset 3
-    buffer[3] = (u8)kernel_sectors;
+    // Patch the 16-bit kernel sector count at offset 3
+    buffer[3] = (u8)(kernel_sectors & 0xFF);
+    buffer[4] = (u8)(kernel_sectors >> 8);
     
     // Ensure boot signature is present
     buffer[510] = 0x55;
@@ -437,7 +439,7 @@ void install() {
     
     // Calculate layout
     u32 disk_total_sectors = device->get_info().total_sectors;
-    u32 reserved_kernel_sectors = 256;  // 128KB for kernel
+    u32 reserved_kernel_sectors = config::KERNEL_RESERVED_SECTORS;  // 256KB for kernel
     u32 partition_start = reserved_kernel_sectors + 1;
     u32 partition_sectors = disk_total_sectors - partition_start;
     
@@ -7,14 +7,19 @@
 #include "../../drivers/video/framebuffer.hpp"
 #include "../../drivers/timer/pit.hpp"
 #include "../../drivers/timer/rtc.hpp"
+#include "../../drivers/timer/tsc.hpp"
 #include "../../drivers/bus/pci.hpp"
 #include "../../drivers/storage/ata.hpp"
 #include "../../drivers/serial/serial.hpp"
 #include "../../core/memory/heap.hpp"
 #include "../../core/memory/pmm.hpp"
 #include "../../core/memory/vmm.hpp"
+#include "../../core/memory/reclaim.hpp"
+#include "../../core/memory/slab.hpp"
+#include "../../core/memory/membench.hpp"
 #include "../../core/sched/task.hpp"
 #include "../../core/sys/io.hpp"
+#include "../../core/sys/boottrace.hpp"
 #include "../../core/sys/system.hpp"
 #include "../../storage/vfs.hpp"
 #include "../../lib/string.hpp"
@@ -35,11 +40,17 @@ void help() {
     Console::println("  help     - Show this help");
     Console::println("  clear    - Clear screen");
     Console::println("  mem      - Show heap memory info");
-    Console::println("  vmm      - Show virtual memory / paging info");
+    Console::println("  vmm      - Show virtual memory / paging info (test)");
+    Console::println("  meminfo  - Memory by subsystem (-l leaks, -m mark, -r reclaim)");
+    Console::println("  slabinfo - Slab caches and heap blocks by size class");
+    Console::println("  membench - Heap/PMM benchmarks (quick, stress)");
     Console::println("  ps       - Show running processes");
+    Console::println("  spawn    - Start CPU-bound tasks (spawn [n] [-c cpu])");
+    Console::println("  kill     - Stop a task (kill <pid>)");
     Console::println("  echo     - Print text");
     Console::println("  sysinfo  - System information");
     Console::println("  uptime   - Show system uptime");
+    Console::println("  bootchart - Time spent in each boot phase");
     Console::println("  date     - Show current date/time");
     Console::println("  hexdump  - Dump memory (hexdump <addr> [len])");
     Console::println("  ver      - Show version");
@@ -73,6 +84,11 @@ void help() {
     Console::println("  stat     - File information");
     Console::println("  tree     - Directory tree view");
     Console::println("  df       - Disk free space");
+    Console::println("  fsstat   - Filesystem cache stats");
+    Console::println("  sync     - Flush filesystems to disk");
+    Console::println("  fsck     - Check FAT filesystem (-r)");
+    Console::println("  fsinfo   - FAT space map (-r rescan)");
+    Console::println("  bench    - Storage benchmarks (quick)");
     Console::println("  du       - Directory size usage");
     Console::println("  head     - First N lines (-n)");
     Console::println("  tail     - Last N lines (-n)");
@@ -129,7 +145,16 @@ void mem() {
     Console::set_color(Color::LightGray);
 }
 
-void vmm_info() {
+void vmm_info(int argc, char** argv) {
+    if (argc > 1 && str::cmp(argv[1], "test") == 0) {
+        const char* error = VMM::self_test();
+        Console::set_color(error ? Color::LightRed : Color::LightGreen);
+        Console::print("VMM self-test: ");
+        Console::println(error ? error : "clone, copy-on-write and teardown OK");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
     Console::set_color(Color::Yellow);
     Console::println("=== Virtual Memory Manager ===");
     Console::set_color(Color::LightCyan);
@@ -173,19 +198,475 @@ void vmm_info() {
     auto vmm_stats = VMM::get_stats();
     Console::print("Page Tables:  ");
     Console::print_dec(static_cast<i32>(vmm_stats.page_tables_allocated));
-    Console::println(" allocated");
+    Console::print(" allocated, ");
+    Console::print_dec(static_cast<i32>(vmm_stats.page_tables_freed));
+    Console::println(" freed");
     
     Console::print("Pages Mapped: ");
     Console::print_dec(static_cast<i32>(vmm_stats.pages_mapped));
     Console::println("");
     
+    Console::print("TLB Flushes:  ");
+    Console::print_dec(static_cast<i32>(vmm_stats.tlb_page_flushes));
+    Console::print(" page, ");
+    Console::print_dec(static_cast<i32>(vmm_stats.tlb_full_flushes));
+    Console::print(" full");
+    Console::println(VMM::global_pages_enabled() ? " (global kernel pages)" : "");
+    
     Console::print("Page Faults:  ");
-    if (vmm_stats.page_faults > 0) {
+    if (vmm_stats.page_faults > vmm_stats.demand_faults) {
         Console::set_color(Color::LightRed);
     }
     Console::print_dec(static_cast<i32>(vmm_stats.page_faults));
+    Console::set_color(Color::LightCyan);
+    Console::print(" (");
+    Console::print_dec(static_cast<i32>(vmm_stats.demand_faults));
+    Console::print(" demand, ");
+    Console::print_dec(static_cast<i32>(vmm_stats.cow_faults));
+    Console::println(" copy-on-write)");
+    
+    Console::print("COW Copies:   ");
+    Console::print_dec(static_cast<i32>(vmm_stats.cow_copies));
+    Console::print(" (");
+    Console::print_dec(static_cast<i32>(pmm_stats.shared_pages));
+    Console::println(" frames shared)");
+    
+    // Demand-paged areas
+    bool header = false;
+    for (u32 i = 0; i < VMM::MAX_VMAS; i++) {
+        const VMArea* vma = VMM::get_vma(i);
+        if (!vma || !vma->active) continue;
+        
+        if (!header) {
+            Console::set_color(Color::Yellow);
+            Console::println("Areas:");
+            header = true;
+        }
+        Console::set_color(Color::White);
+        Console::print("  0x");
+        Console::print_hex(vma->start);
+        Console::print("-0x");
+        Console::print_hex(vma->end);
+        Console::print(" ");
+        Console::print(vma->name);
+        Console::set_color(Color::LightCyan);
+        Console::print("  ");
+        Console::print_dec(static_cast<i32>((vma->end - vma->start) / 1024));
+        Console::print(" KB, ");
+        Console::print_dec(static_cast<i32>(vma->resident * 4));
+        Console::print(" KB resident, ");
+        Console::print_dec(static_cast<i32>(vma->faults));
+        Console::print(" faults (");
+        Console::print_dec(static_cast<i32>(vma->zero_maps));
+        Console::println(" zero)");
+    }
+    
+    Console::set_color(Color::LightGray);
+}
+
+static void print_column(const char* text, usize width) {
+    Console::print(text);
+    for (usize i = str::len(text); i < width; i++) {
+        Console::print(" ");
+    }
+}
+
+static void print_column(u32 value, usize width) {
+    char buf[12];
+    str::utoa(value, buf);
+    print_column(buf, width);
+}
+
+// Helper: parse a decimal number from string
+static u32 parse_dec(const char* str) {
+    u32 val = 0;
+    while (*str >= '0' && *str <= '9') {
+        val = val * 10 + (*str - '0');
+        str++;
+    }
+    return val;
+}
+
+static void meminfo_leaks() {
+    if (!config::HEAP_DEBUG) {
+        Console::set_color(Color::Yellow);
+        Console::println("Leak tracking is off (config::HEAP_DEBUG)");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    Console::set_color(Color::Yellow);
+    Console::print("Live allocations since mark ");
+    Console::print_dec(static_cast<i32>(Heap::get_mark()));
+    Console::println(":");
+    Console::set_color(Color::LightCyan);
+    Console::println("  SEQ     CALLER      SIZE      TAG");
+    Console::set_color(Color::White);
+    
+    u32 count = 0;
+    u32 bytes = 0;
+    for (u32 i = 0; i < config::HEAP_DEBUG_SITES; i++) {
+        const HeapAllocSite* site = Heap::get_site(i);
+        if (!site || site->seq <= Heap::get_mark()) continue;
+        
+        Console::print("  ");
+        print_column(site->seq, 8);
+        Console::print("0x");
+        Console::print_hex(reinterpret_cast<u32>(site->caller));
+        Console::print("  ");
+        print_column(site->size, 10);
+        Console::println(mem_tag_name(site->tag));
+        count++;
+        bytes += site->size;
+    }
+    
+    Console::set_color(Color::LightCyan);
+    Console::print_dec(static_cast<i32>(count));
+    Console::print(" allocations, ");
+    Console::print_dec(static_cast<i32>(bytes));
+    Console::println(" bytes");
+    Console::set_color(Color::LightGray);
+}
+
+void meminfo(int argc, char** argv) {
+    DBG("CMD", "meminfo: Memory by subsystem");
+    
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "-m") == 0) {
+            Console::set_color(Color::LightGreen);
+            Console::print("Leak mark set at allocation ");
+            Console::print_dec(static_cast<i32>(Heap::mark()));
+            Console::println("");
+            Console::set_color(Color::LightGray);
+            return;
+        }
+        if (str::cmp(argv[i], "-l") == 0) {
+            meminfo_leaks();
+            return;
+        }
+        if (str::cmp(argv[i], "-r") == 0) {
+            // Drop every reclaimable cache, as a low-memory pass would
+            usize freed = Reclaim::reclaim(Reclaim::reclaimable(), MemTag::Count);
+            usize returned = Heap::trim();
+            Console::set_color(Color::LightGreen);
+            Console::print("Reclaimed ");
+            Console::print_dec(static_cast<i32>(freed / 1024));
+            Console::print(" KB, ");
+            Console::print_dec(static_cast<i32>(returned / 1024));
+            Console::println(" KB of heap chunks back to the PMM");
+            Console::set_color(Color::LightGray);
+            return;
+        }
+    }
+    
+    // Rates are per second since the previous meminfo
+    static u32 last_allocs[static_cast<u32>(MemTag::Count)];
+    static u32 last_ms = 0;
+    u32 now = PIT::get_milliseconds();
+    u32 elapsed = now - last_ms;
+    
+    Console::set_color(Color::Yellow);
+    Console::println("=== Memory by Subsystem ===");
+    Console::set_color(Color::LightCyan);
+    Console::println("  TAG       LIVE KB  PEAK KB  BLOCKS  ALLOCS    FREES     FAIL  ALLOC/s");
+    Console::set_color(Color::White);
+    
+    for (u32 t = 0; t < static_cast<u32>(MemTag::Count); t++) {
+        MemTag tag = static_cast<MemTag>(t);
+        const HeapTagStats& ts = Heap::get_tag_stats(tag);
+        u32 delta = ts.total_allocs - last_allocs[t];
+        last_allocs[t] = ts.total_allocs;
+        if (ts.total_allocs == 0) continue;
+        
+        Console::print("  ");
+        print_column(mem_tag_name(tag), 10);
+        print_column((ts.live_bytes + 1023) / 1024, 9);
+        print_column((ts.peak_bytes + 1023) / 1024, 9);
+        print_column(ts.live_allocs, 8);
+        print_column(ts.total_allocs, 10);
+        print_column(ts.total_frees, 10);
+        if (ts.failed_allocs) Console::set_color(Color::LightRed);
+        print_column(ts.failed_allocs, 6);
+        Console::set_color(Color::White);
+        print_column(elapsed ? delta * 1000 / elapsed : 0, 0);
+        Console::println("");
+    }
+    last_ms = now;
+    
+    // Heap summary
+    HeapClassStats classes;
+    Heap::get_class_stats(classes);
+    Console::set_color(Color::LightCyan);
+    Console::print("Heap:     ");
+    Console::print_dec(static_cast<i32>(Heap::get_used() / 1024));
+    Console::print(" / ");
+    Console::print_dec(static_cast<i32>(Heap::get_total() / 1024));
+    Console::print(" KB used, largest free block ");
+    Console::print_dec(static_cast<i32>(classes.largest_free / 1024));
+    Console::println(" KB");
+    
+    // Chunks grown from PMM frames past the bootstrap region
+    const HeapGrowthStats& gs = Heap::get_growth_stats();
+    Console::print("Growth:   ");
+    Console::print_dec(static_cast<i32>(Heap::get_bootstrap_size() / 1024));
+    Console::print(" KB bootstrap + ");
+    Console::print_dec(static_cast<i32>(gs.chunks));
+    Console::print(" chunks, ");
+    Console::print_dec(static_cast<i32>(gs.grown_bytes / 1024));
+    Console::print(" KB grown, ");
+    Console::print_dec(static_cast<i32>(gs.returned_bytes / 1024));
+    Console::print(" KB returned");
+    if (!Heap::growth_enabled()) Console::print(" (growth off)");
+    if (gs.failed_grows) {
+        Console::print(", ");
+        Console::print_dec(static_cast<i32>(gs.failed_grows));
+        Console::print(" failed");
+    }
+    Console::println("");
+    
+    // Fixed reservations outside the heap
+    Console::print("Static:   console scrollback ");
+    Console::print_dec(static_cast<i32>(SCROLLBACK_LINES * MAX_LINE_LENGTH * sizeof(ConsoleChar) / 1024));
+    Console::println(" KB");
+    
+    // Frames handed out by the PMM
+    auto pmm_stats = PMM::get_stats();
+    auto vmm_stats = VMM::get_stats();
+    u32 vma_resident = 0;
+    for (u32 i = 0; i < VMM::MAX_VMAS; i++) {
+        const VMArea* vma = VMM::get_vma(i);
+        if (vma && vma->active) vma_resident += vma->resident;
+    }
+    Console::print("Pages:    ");
+    Console::print_dec(static_cast<i32>(pmm_stats.used_pages));
+    Console::print(" used, ");
+    Console::print_dec(static_cast<i32>(pmm_stats.free_pages));
+    Console::print(" free, ");
+    Console::print_dec(static_cast<i32>(vmm_stats.page_tables_allocated - vmm_stats.page_tables_freed));
+    Console::print(" page tables, ");
+    Console::print_dec(static_cast<i32>(vma_resident));
+    Console::print(" VMA resident, ");
+    Console::print_dec(static_cast<i32>(pmm_stats.shared_pages));
+    Console::println(" shared");
+    
+    // Shrinkers and what they have given back
+    const ReclaimStats& rs = Reclaim::get_stats();
+    Console::print("Reclaim:  ");
+    Console::print_dec(static_cast<i32>(rs.runs));
+    Console::print(" runs (");
+    Console::print_dec(static_cast<i32>(rs.heap_triggers));
+    Console::print(" heap, ");
+    Console::print_dec(static_cast<i32>(rs.pmm_triggers));
+    Console::print(" pmm, ");
+    Console::print_dec(static_cast<i32>(rs.short_runs));
+    Console::print(" short), ");
+    Console::print_dec(static_cast<i32>(rs.freed_bytes / 1024));
+    Console::println(" KB freed");
+    for (u32 i = 0; i < Reclaim::MAX_SHRINKERS; i++) {
+        const Shrinker* shrinker = Reclaim::get_shrinker(i);
+        if (!shrinker) continue;
+        Console::set_color(Color::White);
+        Console::print("  ");
+        print_column(shrinker->name, 10);
+        print_column(static_cast<u32>(shrinker->count(shrinker->ctx) / 1024), 0);
+        Console::print(" KB reclaimable, ");
+        Console::print_dec(static_cast<i32>(shrinker->calls));
+        Console::print(" calls, ");
+        Console::print_dec(static_cast<i32>(shrinker->freed_bytes / 1024));
+        Console::println(" KB freed");
+    }
+    
+    Console::set_color(Color::LightGray);
+}
+
+void slabinfo() {
+    DBG("CMD", "slabinfo: Slab caches and heap size classes");
+    
+    Console::set_color(Color::Yellow);
+    Console::println("=== Slab Caches ===");
+    if (!Slab::is_ready()) {
+        Console::set_color(Color::LightGray);
+        Console::println("  (not active)");
+    } else {
+        Console::set_color(Color::LightCyan);
+        Console::println("  SIZE   SLABS   LIVE    CACHED  CAPACITY  REFILLS  FLUSHES");
+        Console::set_color(Color::White);
+        for (u32 c = 0; c < Slab::CLASSES; c++) {
+            SlabCacheStats ss;
+            Slab::get_stats(c, ss);
+            Console::print("  ");
+            print_column(ss.object_size, 7);
+            print_column(ss.slabs, 8);
+            print_column(ss.live, 8);
+            print_column(ss.cached, 8);
+            print_column(ss.capacity, 10);
+            print_column(ss.refills, 9);
+            print_column(ss.flushes, 0);
+            Console::println("");
+        }
+    }
+    
+    HeapClassStats classes;
+    Heap::get_class_stats(classes);
+    
+    Console::set_color(Color::Yellow);
+    Console::println("=== Heap Size Classes ===");
+    Console::set_color(Color::LightCyan);
+    Console::println("  SIZE      LIVE    LIVE KB   FREE    FREE KB");
+    Console::set_color(Color::White);
+    
+    u32 free_total = 0;
+    for (u32 c = 0; c < HeapClassStats::CLASSES; c++) {
+        free_total += classes.free_bytes[c];
+        if (!classes.live_blocks[c] && !classes.free_blocks[c]) continue;
+        
+        char label[16];
+        str::utoa(HeapClassStats::class_size(c), label);
+        if (c + 1 == HeapClassStats::CLASSES) str::cat(label, "+");
+        
+        Console::print("  ");
+        print_column(label, 10);
+        print_column(classes.live_blocks[c], 8);
+        print_column(classes.live_bytes[c] / 1024, 10);
+        print_column(classes.free_blocks[c], 8);
+        print_column(classes.free_bytes[c] / 1024, 0);
+        Console::println("");
+    }
+    
+    // Free space not in the largest block is what fragmentation costs
+    Console::set_color(Color::LightCyan);
+    Console::print("Fragmentation: ");
+    u32 frag = free_total ? (free_total - classes.largest_free) * 100 / free_total : 0;
+    Console::print_dec(static_cast<i32>(frag));
+    Console::println("% of free space outside the largest block");
+    Console::set_color(Color::LightGray);
+}
+
+// ===========================================================================
+// Allocator Benchmarks
+// ===========================================================================
+
+static void* membench_heap_alloc(u32 size) { return Heap::alloc(size); }
+static void membench_heap_free(void* ptr, u32) { Heap::free(ptr); }
+
+static bool membench_heap_check(MemShape& shape, const char*& error) {
+    HeapCheck hc;
+    bool ok = Heap::check(hc);
+    shape = {hc.free_bytes, hc.largest_free};
+    error = hc.error;
+    return ok;
+}
+
+static void* membench_pmm_alloc(u32 pages) {
+    return reinterpret_cast<void*>(PMM::alloc_pages(pages));
+}
+
+static void membench_pmm_free(void* ptr, u32 pages) {
+    PMM::free_page_range(reinterpret_cast<u32>(ptr), pages);
+}
+
+static bool membench_pmm_check(MemShape& shape, const char*& error) {
+    PMMCheck pc;
+    bool ok = PMM::check(pc);
+    shape = {pc.free_pages, pc.largest_run};
+    error = pc.error;
+    return ok;
+}
+
+// Small sizes take the slab path, as they would for any caller
+static const MemTarget membench_heap = {
+    "heap", "bytes", 16, 16384,
+    membench_heap_alloc, membench_heap_free, membench_heap_check
+};
+
+static const MemTarget membench_pmm = {
+    "pmm", "pages", 1, 16,
+    membench_pmm_alloc, membench_pmm_free, membench_pmm_check
+};
+
+static void membench_report(const MemBenchResult& r, void*) {
+    char line[MemBench::CSV_LINE];
+    MemBench::format_csv(r, line);
+    Serial::writeln(line);
+    
+    Console::set_color(Color::White);
+    Console::print("  ");
+    print_column(r.trace, 10);
+    print_column(r.ops, 7);
+    if (r.failed) Console::set_color(Color::Yellow);
+    print_column(r.failed, 6);
+    print_column(r.frag_failed, 6);
+    Console::set_color(Color::White);
+    print_column(r.peak_frag, 6);
+    print_column(TSC::per_second(r.ops, r.us), 10);
+    print_column(r.alloc_p50, 7);
+    print_column(r.alloc_p99, 8);
+    print_column(r.free_p50, 7);
+    print_column(r.free_p99, 0);
     Console::println("");
     
+    if (r.error) {
+        Console::set_color(Color::LightRed);
+        Console::print("  Invariant broken after op ");
+        Console::print_dec(static_cast<i32>(r.error_op));
+        Console::print(": ");
+        Console::println(r.error);
+    }
+    Console::set_color(Color::LightGray);
+}
+
+void membench(int argc, char** argv) {
+    DBG("CMD", "membench: Allocator benchmarks");
+    
+    bool run_heap = true;
+    bool run_pmm = true;
+    bool stress = false;
+    MemBenchConfig cfg = MemBenchConfig::defaults();
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "heap") == 0) {
+            run_pmm = false;
+        } else if (str::cmp(argv[i], "pmm") == 0) {
+            run_heap = false;
+        } else if (str::cmp(argv[i], "quick") == 0) {
+            cfg = MemBenchConfig::quick();
+        } else if (str::cmp(argv[i], "stress") == 0) {
+            stress = true;
+        } else if (str::cmp(argv[i], "all") != 0) {
+            Console::println("Usage: membench [heap|pmm|all] [quick] [stress]");
+            return;
+        }
+    }
+    cfg.stress = stress;
+    
+    if (!TSC::is_calibrated()) {
+        Console::set_color(Color::LightRed);
+        Console::println("membench: no calibrated TSC");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    Serial::writeln(MemBench::csv_header());
+    const MemTarget* targets[] = {run_heap ? &membench_heap : nullptr, run_pmm ? &membench_pmm : nullptr};
+    bool ok = true;
+    
+    for (const MemTarget* target : targets) {
+        if (!target) continue;
+        
+        Console::set_color(Color::Yellow);
+        Console::print("=== ");
+        Console::print(target->name);
+        Console::print(" (");
+        Console::print(target->unit);
+        Console::print(", latency in cycles");
+        Console::println(cfg.stress ? ", checked every op) ===" : ") ===");
+        Console::set_color(Color::LightCyan);
+        Console::println("  TRACE     OPS    FAIL  FRAGF FRAG% OPS/s     A-P50  A-P99   F-P50  F-P99");
+        Console::set_color(Color::LightGray);
+        ok &= MemBench::run_all(*target, cfg, membench_report, nullptr);
+    }
+    
+    Console::set_color(ok ? Color::LightGreen : Color::LightRed);
+    Console::println(ok ? "Benchmarks complete (CSV on serial)" : "Allocator invariants broken, see above");
     Console::set_color(Color::LightGray);
 }
 
@@ -195,9 +676,9 @@ void ps() {
     Console::set_color(Color::LightCyan);
     
     // Header
-    Console::println("  PID  PPID  STATE     PRI   CPU     NAME");
+    Console::println("  PID  PPID  STATE     PRI   CPU  TIME    NAME");
     Console::set_color(Color::LightGray);
-    Console::println("  ---  ----  --------  ----  ------  ----------------");
+    Console::println("  ---  ----  --------  ----  ---  ------  ----------------");
     
     // Iterate through tasks
     for (u32 i = 0; i < MAX_TASKS; i++) {
@@ -258,9 +739,11 @@ void ps() {
         }
         Console::print("  ");
         
+        // CPU it runs on or is queued for
+        print_column(task->cpu, 5);
+        
         // CPU time (in ticks)
-        Console::print_dec(static_cast<i32>(task->total_time));
-        Console::print("     ");
+        print_column(task->total_time, 8);
         
         // Name
         Console::println(task->name);
@@ -279,9 +762,110 @@ void ps() {
     Console::print("  Ctx switches: ");
     Console::print_dec(static_cast<i32>(stats.context_switches));
     Console::println("");
+    
+    // Per-CPU run queues
+    Console::println("");
+    Console::println("  CPU  QUEUED  SWITCHES  STEALS  STOLEN  RUNNING");
+    Console::set_color(Color::LightGray);
+    for (u32 cpu = 0; cpu < SMP::get_cpu_count(); cpu++) {
+        PerCpu* info = SMP::get_cpu(cpu);
+        CpuSchedStats cs;
+        TaskManager::get_cpu_stats(cpu, cs);
+        
+        Console::print("  ");
+        print_column(cpu, 5);
+        print_column(cs.queued, 8);
+        print_column(cs.context_switches, 10);
+        print_column(cs.steals, 8);
+        print_column(cs.stolen, 8);
+        if (!info->online) {
+            Console::println("offline");
+        } else if (cs.idle) {
+            Console::println("idle");
+        } else {
+            Console::print("PID ");
+            Console::print_dec(static_cast<i32>(cs.current_pid));
+            Console::println("");
+        }
+    }
+}
+
+// Job for spawn: keeps its CPU busy so the tick has something to preempt
+static constexpr u32 SPIN_JOB_US = 5000000;
+
+static void spin_job() {
+    u64 start = TSC::read();
+    while (TSC::to_us(TSC::read() - start) < SPIN_JOB_US) {
+        asm volatile("pause");
+    }
+}
+
+void spawn(int argc, char** argv) {
+    DBG("CMD", "spawn: Starting CPU-bound tasks");
+    
+    u32 count = 1;
+    u32 cpu = AFFINITY_ALL;
+    for (int i = 1; i < argc; i++) {
+        if (str::cmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cpu = parse_dec(argv[++i]);
+        } else if (argv[i][0] >= '1' && argv[i][0] <= '9') {
+            count = parse_dec(argv[i]);
+        } else {
+            Console::println("Usage: spawn [count] [-c cpu]");
+            return;
+        }
+    }
+    
+    // The boot CPU's idle task is the shell, which never schedules: jobs
+    // only run on the APs and move between them by stealing
+    const char* error = nullptr;
+    if (SMP::get_online_count() < 2) {
+        error = "spawn: no application processors online";
+    } else if (!TSC::is_calibrated()) {
+        error = "spawn: no calibrated TSC";
+    } else if (cpu != AFFINITY_ALL && (cpu == 0 || cpu >= SMP::get_cpu_count() ||
+                                       !SMP::get_cpu(cpu)->online)) {
+        error = "spawn: not an online application processor";
+    }
+    if (error) {
+        Console::set_color(Color::LightRed);
+        Console::println(error);
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    u32 started = 0;
+    for (u32 i = 0; i < count; i++) {
+        u32 pid = TaskManager::create("spin", spin_job, Priority::Normal, ~1u);
+        if (!pid) break;
+        if (cpu != AFFINITY_ALL) TaskManager::set_affinity(pid, 1u << cpu);
+        started++;
+    }
+    
+    Console::set_color(started == count ? Color::LightGreen : Color::Yellow);
+    Console::print("Started ");
+    Console::print_dec(static_cast<i32>(started));
+    Console::print(" of ");
+    Console::print_dec(static_cast<i32>(count));
+    Console::print(" tasks (");
+    Console::print_dec(static_cast<i32>(SPIN_JOB_US / 1000000));
+    Console::println("s each, see ps)");
     Console::set_color(Color::LightGray);
 }
 
+void kill(int argc, char** argv) {
+    if (argc != 2) {
+        Console::println("Usage: kill <pid>");
+        return;
+    }
+    
+    if (!TaskManager::kill(parse_dec(argv[1]))) {
+        Console::set_color(Color::LightRed);
+        Console::println("kill: no such task, or it can't be killed");
+        Console::set_color(Color::LightGray);
+    }
+}
+
 void sysinfo() {
     Console::set_color(Color::Yellow);
     Console::println("=== BOLT OS System Information ===");
@@ -351,6 +935,49 @@ void uptime() {
     Console::set_color(Color::LightGray);
 }
 
+void bootchart() {
+    DBG("CMD", "bootchart: Boot phase timing");
+    
+    if (!TSC::is_calibrated()) {
+        Console::set_color(Color::LightRed);
+        Console::println("bootchart: no calibrated TSC");
+        Console::set_color(Color::LightGray);
+        return;
+    }
+    
+    using sys::BootTrace;
+    u64 origin = BootTrace::get_origin();
+    u32 total = TSC::to_us(BootTrace::get_finish() - origin);
+    
+    Console::set_color(Color::Yellow);
+    Console::println("=== Boot Chart ===");
+    Console::set_color(Color::LightCyan);
+    Console::println("  PHASE            START us  TIME us   %");
+    
+    for (u32 i = 0; i < BootTrace::get_count(); i++) {
+        const sys::BootPhase* phase = BootTrace::get_phase(i);
+        u64 end = phase->end ? phase->end : BootTrace::get_finish();
+        u32 us = TSC::to_us(end - phase->start);
+        u32 pct = total >= 100 ? us / (total / 100) : 0;
+        
+        // The slow phases are the ones worth fixing
+        Console::set_color(pct >= 20 ? Color::LightRed : pct >= 5 ? Color::Yellow : Color::White);
+        Console::print("  ");
+        print_column(phase->name, 17);
+        print_column(TSC::to_us(phase->start - origin), 10);
+        print_column(us, 10);
+        print_column(pct, 5);
+        for (u32 n = pct * 30 / 100; n > 0; n--) Console::print("#");
+        Console::println("");
+    }
+    
+    Console::set_color(Color::LightCyan);
+    Console::print("Boot to shell: ");
+    Console::print_dec(static_cast<i32>(total / 1000));
+    Console::println(" ms");
+    Console::set_color(Color::LightGray);
+}
+
 void date() {
     Console::set_color(Color::LightCyan);
     RTC::print_datetime_to_console();
@@ -373,6 +1000,11 @@ void reboot() {
     Console::println("Rebooting...");
     Console::set_color(Color::LightGray);
     
+    // Leave mounted volumes marked clean
+    if (storage::VFS::is_ready()) {
+        storage::VFS::sync_all();
+    }
+    
     io::outb(0x64, 0xFE);
     
     while (true) {
@@ -480,16 +1112,6 @@ void lsdisk() {
     DBG_OK("CMD", "Drive list complete");
 }
 
-// Helper: parse a decimal number from string
-static u32 parse_dec(const char* str) {
-    u32 val = 0;
-    while (*str >= '0' && *str <= '9') {
-        val = val * 10 + (*str - '0');
-        str++;
-    }
-    return val;
-}
-
 // Helper: skip whitespace
 static const char* skip_space(const char* str) {
     while (*str == ' ' || *str == '\t') str++;
@@ -8,10 +8,16 @@ namespace bolt::shell::cmd {
 void help();
 void clear();
 void mem();
-void vmm_info();
+void vmm_info(int argc, char** argv);   // Paging state (test: clone/COW self-test)
+void meminfo(int argc, char** argv);    // Per-subsystem memory (-l leaks, -m mark, -r reclaim)
+void slabinfo();                        // Heap blocks by size class
+void membench(int argc, char** argv);   // Allocator traces (quick, stress)
 void ps();
+void spawn(int argc, char** argv);      // CPU-bound tasks on the APs (-c pins to one)
+void kill(int argc, char** argv);
 void sysinfo();
 void uptime();
+void bootchart();                       // Time per boot phase (TSC)
 void date();
 void ver();
 void reboot();
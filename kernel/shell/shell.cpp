@@ -23,6 +23,7 @@ namespace Box = drivers::Box;
 // Static member definitions
 char Shell::input_buffer[MAX_CMD_LEN];
 usize Shell::input_pos = 0;
+bool Shell::serial_cr = false;
 char Shell::cwd[128] = "/";
 char Shell::history[HISTORY_SIZE][MAX_CMD_LEN];
 usize Shell::history_count = 0;
@@ -63,6 +64,9 @@ void Shell::run() {
         }
         
         KeyEvent ev = Keyboard::poll_event();
+        if (ev.ascii == 0 && ev.special == SpecialKey::None) {
+            ev = poll_serial();
+        }
         
         // No input yet - continue polling
         if (ev.ascii == 0 && ev.special == SpecialKey::None) {
@@ -146,6 +150,33 @@ void Shell::run() {
     }
 }
 
+// Serial input is echoed back so the remote side sees a normal terminal;
+// the console shows it like typed keys
+KeyEvent Shell::poll_serial() {
+    KeyEvent ev = {0, SpecialKey::None, false, false, false};
+    if (!Serial::has_data()) return ev;
+    
+    char c = Serial::read_char();
+    bool after_cr = serial_cr;
+    serial_cr = (c == '\r');
+    
+    if (c == '\r' || c == '\n') {
+        if (c == '\n' && after_cr) return ev;
+        Serial::write("\r\n");
+        ev.ascii = '\n';
+    } else if (c == 0x7F || c == '\b') {
+        if (input_pos > 0) Serial::write("\b \b");
+        ev.ascii = '\b';
+    } else if (c == 0x03) {
+        ev.ascii = 'c';
+        ev.ctrl = true;
+    } else if (c >= 32 && c < 127) {
+        if (input_pos < MAX_CMD_LEN - 1) Serial::write_char(c);
+        ev.ascii = c;
+    }
+    return ev;
+}
+
 void Shell::clear_line() {
     while (input_pos > 0) {
         Console::putchar('\b');
@@ -215,6 +246,11 @@ void Shell::prompt() {
     Console::set_color(Color::White, Color::Black);
     Console::print("$ ");
     Console::set_color(Color::LightGray, Color::Black);
+    
+    // Same prompt on serial: a headless driver waits for it between commands
+    Serial::write("user@bolt:");
+    Serial::write(cwd);
+    Serial::write("$ ");
 }
 
 void Shell::process_command(char* cmdline) {
@@ -241,17 +277,35 @@ void Shell::process_command(char* cmdline) {
         cmd::mem();
     }
     else if (str::cmp(cmd, "vmm") == 0 || str::cmp(cmd, "paging") == 0) {
-        cmd::vmm_info();
+        cmd::vmm_info(argc, argv);
+    }
+    else if (str::cmp(cmd, "meminfo") == 0) {
+        cmd::meminfo(argc, argv);
+    }
+    else if (str::cmp(cmd, "slabinfo") == 0) {
+        cmd::slabinfo();
+    }
+    else if (str::cmp(cmd, "membench") == 0) {
+        cmd::membench(argc, argv);
     }
     else if (str::cmp(cmd, "ps") == 0 || str::cmp(cmd, "tasks") == 0) {
         cmd::ps();
     }
+    else if (str::cmp(cmd, "spawn") == 0) {
+        cmd::spawn(argc, argv);
+    }
+    else if (str::cmp(cmd, "kill") == 0) {
+        cmd::kill(argc, argv);
+    }
     else if (str::cmp(cmd, "sysinfo") == 0) {
         cmd::sysinfo();
     }
     else if (str::cmp(cmd, "uptime") == 0) {
         cmd::uptime();
     }
+    else if (str::cmp(cmd, "bootchart") == 0) {
+        cmd::bootchart();
+    }
     else if (str::cmp(cmd, "date") == 0) {
         cmd::date();
     }
@@ -356,6 +410,21 @@ void Shell::process_command(char* cmdline) {
     else if (str::cmp(cmd, "df") == 0) {
         cmd::df();
     }
+    else if (str::cmp(cmd, "fsstat") == 0) {
+        cmd::fsstat();
+    }
+    else if (str::cmp(cmd, "sync") == 0) {
+        cmd::sync();
+    }
+    else if (str::cmp(cmd, "fsck") == 0) {
+        cmd::fsck(argc, argv);
+    }
+    else if (str::cmp(cmd, "fsinfo") == 0) {
+        cmd::fsinfo(argc, argv);
+    }
+    else if (str::cmp(cmd, "bench") == 0) {
+        cmd::bench(argc, argv);
+    }
     else if (str::cmp(cmd, "head") == 0) {
         cmd::head(argc, argv);
     }
@@ -4,6 +4,7 @@
  * =========================================================================== */
 
 #include "../lib/types.hpp"
+#include "../drivers/input/keyboard.hpp"
 
 namespace bolt::shell {
 
@@ -25,6 +26,7 @@ private:
     static void prompt();
     static void process_command(char* cmd);
     static void parse_args(char* cmd, char** argv, int& argc);
+    static drivers::KeyEvent poll_serial();  // COM1 as a second keyboard (headless runs)
     
     // Input line editing
     static void clear_line();
@@ -36,6 +38,7 @@ private:
     // Input state
     static char input_buffer[MAX_CMD_LEN];
     static usize input_pos;
+    static bool serial_cr;      // Last serial byte was CR; drop a following LF
     
     // Current working directory
     static char cwd[128];
@@ -3,6 +3,7 @@
  * =========================================================================== */
 
 #include "ata_device.hpp"
+#include "../core/memory/heap.hpp"
 #include "../drivers/serial/serial.hpp"
 #include "../lib/string.hpp"
 
@@ -203,7 +204,7 @@ u32 ATADeviceManager::create_devices() {
         }
         
         // Create wrapper
-        ATABlockDevice* dev = new ATABlockDevice(i);
+        ATABlockDevice* dev = new (mem::MemTag::Device) ATABlockDevice(i);
         if (!dev) {
             DBG_WARN("ATA_BLK", "Failed to allocate device");
             continue;
@@ -0,0 +1,373 @@
+/* ===========================================================================
+ * BOLT OS - Storage Benchmarks Implementation
+ * =========================================================================== */
+
+#include "bench.hpp"
+#include "../core/memory/heap.hpp"
+#include "../drivers/timer/tsc.hpp"
+#include "../lib/string.hpp"
+
+namespace bolt::storage {
+
+using namespace drivers;
+
+static constexpr u32 CHUNK_SIZES[] = {512, 4096, 32768, 131072};
+static constexpr u32 MAX_CHUNK = 131072;
+static constexpr u32 RANDOM_BLOCK = 4096;
+static constexpr u32 MAX_DEPTH = 32;
+static constexpr u32 PATH_MAX = 256;
+
+// State shared by the workloads of one run
+struct BenchRun {
+    const char* fs;
+    const BenchConfig* cfg;
+    StorageBench::Callback callback;
+    void* ctx;
+    u8* buffer;                 // MAX_CHUNK bytes
+    char dir[PATH_MAX];         // Scratch directory
+    bool ok;
+};
+
+// ===========================================================================
+// Helpers
+// ===========================================================================
+
+static void join(char* out, const char* dir, const char* name) {
+    str::cpy(out, dir);
+    usize n = str::len(out);
+    if (n == 0 || out[n - 1] != '/') str::cat(out, "/");
+    str::cat(out, name);
+}
+
+// dir/<prefix>NNNNN, a valid 8.3 name for up to 100000 files
+static void numbered(char* out, const char* dir, char prefix, u32 n) {
+    char name[8];
+    name[0] = prefix;
+    for (int i = 5; i >= 1; i--) {
+        name[i] = static_cast<char>('0' + n % 10);
+        n /= 10;
+    }
+    name[6] = '\0';
+    join(out, dir, name);
+}
+
+static u32 next_random(u32& state) {
+    state = state * 1103515245 + 12345;
+    return state >> 8;
+}
+
+static void fill(u8* buffer, u32 size, u32 seed) {
+    for (u32 i = 0; i < size; i++) {
+        buffer[i] = static_cast<u8>(seed + i * 31);
+    }
+}
+
+static void emit(BenchRun& run, const char* workload, u32 param, u32 ops, u64 bytes,
+                 u64 cycles, VFSResult status) {
+    BenchResult result = {run.fs, workload, param, ops, bytes, TSC::to_us(cycles), status};
+    if (status != VFSResult::Success && status != VFSResult::NoSpace) run.ok = false;
+    run.callback(result, run.ctx);
+}
+
+// Write `bytes` to a new file in `chunk` pieces
+static VFSResult write_file(const char* path, u8* buffer, u32 chunk, u64 bytes, u32& ops) {
+    u32 fd;
+    VFSResult result = VFS::open(path, FileMode::Write | FileMode::Create | FileMode::Truncate, fd);
+    if (result != VFSResult::Success) return result;
+    
+    for (u64 done = 0; done < bytes;) {
+        u32 n = bytes - done < chunk ? static_cast<u32>(bytes - done) : chunk;
+        u64 written = 0;
+        result = VFS::write(fd, buffer, n, written);
+        if (result == VFSResult::Success && written != n) result = VFSResult::NoSpace;
+        if (result != VFSResult::Success) break;
+        done += n;
+        ops++;
+    }
+    
+    VFSResult closed = VFS::close(fd);
+    return result != VFSResult::Success ? result : closed;
+}
+
+// Read a whole file in `chunk` pieces
+static VFSResult read_file(const char* path, u8* buffer, u32 chunk, u64& bytes, u32& ops) {
+    u32 fd;
+    VFSResult result = VFS::open(path, FileMode::Read, fd);
+    if (result != VFSResult::Success) return result;
+    
+    u64 got = 0;
+    while ((result = VFS::read(fd, buffer, chunk, got)) == VFSResult::Success && got > 0) {
+        bytes += got;
+        ops++;
+    }
+    
+    VFS::close(fd);
+    return result;
+}
+
+// ===========================================================================
+// Workloads
+// ===========================================================================
+
+static void bench_sequential(BenchRun& run) {
+    char path[PATH_MAX];
+    join(path, run.dir, "SEQ.DAT");
+    u64 size = static_cast<u64>(run.cfg->file_kb) * 1024;
+    fill(run.buffer, MAX_CHUNK, run.cfg->seed);
+    
+    for (u32 chunk : CHUNK_SIZES) {
+        u32 ops = 0;
+        u64 start = TSC::read();
+        VFSResult result = write_file(path, run.buffer, chunk, size, ops);
+        if (result == VFSResult::Success) result = VFS::sync_all();
+        emit(run, "seq_write", chunk, ops, result == VFSResult::Success ? size : 0,
+             TSC::read() - start, result);
+        if (result != VFSResult::Success) return;
+    }
+    
+    for (u32 chunk : CHUNK_SIZES) {
+        u32 ops = 0;
+        u64 bytes = 0;
+        u64 start = TSC::read();
+        VFSResult result = read_file(path, run.buffer, chunk, bytes, ops);
+        if (result == VFSResult::Success && bytes != size) result = VFSResult::IOError;
+        emit(run, "seq_read", chunk, ops, bytes, TSC::read() - start, result);
+    }
+}
+
+static void bench_random(BenchRun& run) {
+    char path[PATH_MAX];
+    join(path, run.dir, "SEQ.DAT");
+    u32 blocks = run.cfg->file_kb / (RANDOM_BLOCK / 1024);
+    if (blocks == 0) return;
+    
+    u32 fd;
+    VFSResult result = VFS::open(path, FileMode::Read, fd);
+    bool opened = result == VFSResult::Success;
+    u32 ops = 0;
+    u64 bytes = 0;
+    u32 state = run.cfg->seed;
+    u64 start = TSC::read();
+    
+    for (u32 i = 0; result == VFSResult::Success && i < run.cfg->random_reads; i++) {
+        u64 offset = static_cast<u64>(next_random(state) % blocks) * RANDOM_BLOCK;
+        result = VFS::seek(fd, static_cast<i64>(offset), SeekMode::Set);
+        u64 got = 0;
+        if (result == VFSResult::Success) result = VFS::read(fd, run.buffer, RANDOM_BLOCK, got);
+        if (result == VFSResult::Success && got != RANDOM_BLOCK) result = VFSResult::IOError;
+        if (result == VFSResult::Success) {
+            bytes += got;
+            ops++;
+        }
+    }
+    
+    u64 cycles = TSC::read() - start;
+    if (opened) VFS::close(fd);
+    emit(run, "rand_read", RANDOM_BLOCK, ops, bytes, cycles, result);
+    VFS::unlink(path);
+}
+
+static void bench_small_files(BenchRun& run) {
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    join(dir, run.dir, "MANY");
+    u32 count = run.cfg->small_files;
+    u32 size = run.cfg->small_file_bytes;
+    if (size > MAX_CHUNK) size = MAX_CHUNK;
+    
+    VFSResult result = VFS::mkdir(dir);
+    u32 created = 0;
+    u64 start = TSC::read();
+    for (u32 i = 0; result == VFSResult::Success && i < count; i++) {
+        numbered(path, dir, 'F', i);
+        u32 ops = 0;
+        result = write_file(path, run.buffer, size, size, ops);
+        if (result == VFSResult::Success) created++;
+    }
+    if (result == VFSResult::Success) result = VFS::sync_all();
+    emit(run, "create", count, created, static_cast<u64>(created) * size, TSC::read() - start, result);
+    
+    // List in getdents batches, as ls does (the I/O buffer is idle here)
+    FileInfo* batch = reinterpret_cast<FileInfo*>(run.buffer);
+    u32 listed = 0;
+    u32 fd;
+    start = TSC::read();
+    VFSResult list_result = VFS::opendir(dir, fd);
+    if (list_result == VFSResult::Success) {
+        u32 got = 0;
+        while ((list_result = VFS::getdents(fd, batch, 16, got)) == VFSResult::Success && got > 0) {
+            for (u32 i = 0; i < got; i++) {
+                if (batch[i].is_file()) listed++;
+            }
+        }
+        VFS::closedir(fd);
+        if (list_result == VFSResult::Success && listed != created) list_result = VFSResult::IOError;
+    }
+    emit(run, "list", count, listed, 0, TSC::read() - start, list_result);
+    
+    u32 deleted = 0;
+    VFSResult delete_result = VFSResult::Success;
+    start = TSC::read();
+    for (u32 i = 0; i < created; i++) {
+        numbered(path, dir, 'F', i);
+        VFSResult r = VFS::unlink(path);
+        if (r == VFSResult::Success) deleted++;
+        else if (delete_result == VFSResult::Success) delete_result = r;
+    }
+    if (delete_result == VFSResult::Success) delete_result = VFS::sync_all();
+    emit(run, "delete", count, deleted, 0, TSC::read() - start, delete_result);
+    
+    VFS::rmdir(dir);
+}
+
+static void bench_lookup(BenchRun& run) {
+    char path[PATH_MAX];
+    u32 depth = run.cfg->depth > MAX_DEPTH ? MAX_DEPTH : run.cfg->depth;
+    
+    // BENCH/D0/D1/.../Dn-1 with a file at the bottom
+    VFSResult result = VFSResult::Success;
+    str::cpy(path, run.dir);
+    u32 made = 0;
+    for (u32 i = 0; i < depth && result == VFSResult::Success; i++) {
+        char name[8] = "D";
+        str::utoa(i, name + 1);
+        str::cat(path, "/");
+        str::cat(path, name);
+        result = VFS::mkdir(path);
+        if (result == VFSResult::Success) made++;
+    }
+    str::cat(path, "/LEAF.DAT");
+    u32 ignored = 0;
+    if (result == VFSResult::Success) result = write_file(path, run.buffer, 64, 64, ignored);
+    
+    u32 ops = 0;
+    u64 start = TSC::read();
+    for (u32 i = 0; result == VFSResult::Success && i < run.cfg->lookups; i++) {
+        FileInfo info;
+        result = VFS::stat(path, info);
+        if (result == VFSResult::Success) ops++;
+    }
+    emit(run, "lookup", depth, ops, 0, TSC::read() - start, result);
+    
+    // Unwind from the bottom
+    VFS::unlink(path);
+    for (u32 i = made; i > 0; i--) {
+        char* slash = path + str::len(path);
+        while (slash > path && *slash != '/') slash--;
+        *slash = '\0';
+        VFS::rmdir(path);
+    }
+}
+
+static void bench_fragmented(BenchRun& run) {
+    char dir[PATH_MAX];
+    char path[PATH_MAX];
+    join(dir, run.dir, "FRAG");
+    u32 count = run.cfg->frag_files;
+    
+    // Fill the free space front with small files, then punch every other
+    // one out so a new file's clusters have to come from the holes
+    VFSResult result = VFS::mkdir(dir);
+    u32 created = 0;
+    for (u32 i = 0; result == VFSResult::Success && i < count; i++) {
+        numbered(path, dir, 'G', i);
+        u32 ignored = 0;
+        result = write_file(path, run.buffer, RANDOM_BLOCK, RANDOM_BLOCK, ignored);
+        if (result == VFSResult::Success) created++;
+    }
+    for (u32 i = 0; i < created; i += 2) {
+        numbered(path, dir, 'G', i);
+        VFS::unlink(path);
+    }
+    if (result == VFSResult::Success) result = VFS::sync_all();
+    
+    join(path, dir, "BIG.DAT");
+    u64 size = static_cast<u64>(count / 2) * RANDOM_BLOCK;
+    u32 ops = 0;
+    u64 start = TSC::read();
+    if (result == VFSResult::Success) result = write_file(path, run.buffer, RANDOM_BLOCK, size, ops);
+    if (result == VFSResult::Success) result = VFS::sync_all();
+    emit(run, "frag_write", count, ops, result == VFSResult::Success ? size : 0,
+         TSC::read() - start, result);
+    
+    if (result == VFSResult::Success) {
+        u64 bytes = 0;
+        ops = 0;
+        start = TSC::read();
+        result = read_file(path, run.buffer, RANDOM_BLOCK, bytes, ops);
+        if (result == VFSResult::Success && bytes != size) result = VFSResult::IOError;
+        emit(run, "frag_read", count, ops, bytes, TSC::read() - start, result);
+    }
+    
+    VFS::unlink(path);
+    for (u32 i = 1; i < created; i += 2) {
+        numbered(path, dir, 'G', i);
+        VFS::unlink(path);
+    }
+    VFS::rmdir(dir);
+}
+
+// ===========================================================================
+// Driver
+// ===========================================================================
+
+bool StorageBench::run(const char* root, const char* fs_label, const BenchConfig& cfg,
+                       Callback callback, void* ctx) {
+    BenchRun run;
+    run.fs = fs_label;
+    run.cfg = &cfg;
+    run.callback = callback;
+    run.ctx = ctx;
+    run.ok = true;
+    join(run.dir, root, "BENCH");
+    
+    run.buffer = static_cast<u8*>(mem::Heap::alloc(MAX_CHUNK, mem::MemTag::VFS));
+    VFSResult result = run.buffer ? VFS::mkdir(run.dir) : VFSResult::NoSpace;
+    if (result != VFSResult::Success) {
+        emit(run, "setup", 0, 0, 0, 0, result);
+        if (run.buffer) mem::Heap::free(run.buffer);
+        return false;
+    }
+    
+    bench_sequential(run);
+    bench_random(run);
+    bench_small_files(run);
+    bench_lookup(run);
+    bench_fragmented(run);
+    
+    VFS::rmdir(run.dir);
+    VFS::sync_all();
+    mem::Heap::free(run.buffer);
+    return run.ok;
+}
+
+// ===========================================================================
+// Reporting
+// ===========================================================================
+
+const char* StorageBench::csv_header() {
+    return "bench,fs,workload,param,ops,bytes,us,ops_per_s,kb_per_s,status";
+}
+
+void StorageBench::format_csv(const BenchResult& r, char* line) {
+    // Byte counts stay below 4 GB for every workload this suite runs
+    u32 bytes = static_cast<u32>(r.bytes);
+    u32 values[] = {r.param, r.ops, bytes, r.us, TSC::per_second(r.ops, r.us), TSC::per_second(bytes >> 10, r.us)};
+    
+    str::cpy(line, "bench,");
+    str::cat(line, r.fs);
+    str::cat(line, ",");
+    str::cat(line, r.workload);
+    for (u32 v : values) {
+        char num[12];
+        str::utoa(v, num);
+        str::cat(line, ",");
+        str::cat(line, num);
+    }
+    str::cat(line, ",");
+    if (r.status == VFSResult::Success) str::cat(line, "ok");
+    else if (r.status == VFSResult::NoSpace) str::cat(line, "limit");
+    else str::cat(line, vfs_result_string(r.status));
+}
+
+} // namespace bolt::storage
@@ -0,0 +1,67 @@
+#pragma once
+/* ===========================================================================
+ * BOLT OS - Storage Benchmarks
+ * ===========================================================================
+ * Reproducible workloads run through the VFS against any mounted
+ * filesystem: sequential I/O at several chunk sizes, random 4 KB reads,
+ * small-file create/list/delete, deep path lookup and allocation on a
+ * fragmented volume. Timed with the TSC; the same code runs in the kernel
+ * (the `bench` command) and on the host (`boltfs bench`).
+ *
+ * Each result becomes one CSV row:
+ *   bench,fs,workload,param,ops,bytes,us,ops_per_s,kb_per_s,status
+ * where status is ok, limit (the filesystem ran out of space or directory
+ * slots; ops says how far it got) or the VFS error that stopped it.
+ * =========================================================================== */
+
+#include "../core/types.hpp"
+#include "vfs.hpp"
+
+namespace bolt::storage {
+
+struct BenchConfig {
+    u32 file_kb;            // Sequential/random file size (RAMFS caps files at 1 MB)
+    u32 random_reads;       // 4 KB reads at random offsets
+    u32 small_files;        // Files created, listed and deleted in one directory
+    u32 small_file_bytes;
+    u32 depth;              // Nested directories for the lookup workload
+    u32 lookups;            // stat() calls on the deepest path
+    u32 frag_files;         // One-cluster files, every other one deleted
+    u32 seed;               // Random offsets are the same for equal seeds
+    
+    static BenchConfig defaults() {
+        return {1024, 1000, 10000, 128, 16, 1000, 512, 0x2545F491};
+    }
+    
+    // Small enough for a quick check on slow disks
+    static BenchConfig quick() {
+        return {256, 200, 500, 128, 8, 200, 128, 0x2545F491};
+    }
+};
+
+struct BenchResult {
+    const char* fs;         // Label given to run()
+    const char* workload;
+    u32 param;              // Chunk size or count, per workload
+    u32 ops;                // Operations completed
+    u64 bytes;
+    u32 us;
+    VFSResult status;       // First failure, or Success
+};
+
+class StorageBench {
+public:
+    using Callback = void (*)(const BenchResult& result, void* ctx);
+    
+    static constexpr u32 CSV_LINE = 160;
+    
+    // Run every workload in a scratch directory below `root` (which must be
+    // a mounted path). Returns false if any workload failed.
+    static bool run(const char* root, const char* fs_label, const BenchConfig& cfg,
+                    Callback callback, void* ctx);
+    
+    static const char* csv_header();
+    static void format_csv(const BenchResult& result, char* line);
+};
+
+} // namespace bolt::storage
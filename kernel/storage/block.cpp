@@ -331,6 +331,39 @@ IOResult PartitionDevice::write_sectors(u64 lba, u32 count, const void* buffer)
     return result;
 }
 
+// Translate the batch and hand it to the parent in one piece
+IOResult PartitionDevice::write_batch(const IORequest* requests, u32 count) {
+    if (!parent_device) return IOResult::DeviceRemoved;
+    
+    constexpr u32 CHUNK = 16;
+    IORequest translated[CHUNK];
+    
+    for (u32 base = 0; base < count; base += CHUNK) {
+        u32 n = (count - base < CHUNK) ? count - base : CHUNK;
+        u32 sectors = 0;
+        for (u32 i = 0; i < n; i++) {
+            const IORequest& req = requests[base + i];
+            if (req.lba + req.count > info.total_sectors) {
+                return IOResult::OutOfBounds;
+            }
+            translated[i].lba = start_lba + req.lba;
+            translated[i].count = req.count;
+            translated[i].buffer = req.buffer;
+            sectors += req.count;
+        }
+        
+        IOResult result = parent_device->write_batch(translated, n);
+        stats.io_operations++;
+        if (result != IOResult::Success) {
+            stats.write_errors++;
+            return result;
+        }
+        stats.sectors_written += sectors;
+    }
+    
+    return IOResult::Success;
+}
+
 bool PartitionDevice::is_ready() const {
     return parent_device && parent_device->is_ready();
 }
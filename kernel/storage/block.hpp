@@ -90,6 +90,16 @@ struct DeviceInfo {
     u8 device_id;               // Internal device ID
 };
 
+// ===========================================================================
+// Block I/O Request
+// ===========================================================================
+
+struct IORequest {
+    u64 lba;
+    u32 count;
+    const void* buffer;
+};
+
 // ===========================================================================
 // Block Device Base Class
 // ===========================================================================
@@ -102,6 +112,16 @@ public:
     virtual IOResult read_sectors(u64 lba, u32 count, void* buffer) = 0;
     virtual IOResult write_sectors(u64 lba, u32 count, const void* buffer) = 0;
     
+    // Submit several writes at once. Devices with queued or async I/O can
+    // overlap them; the default issues them in order.
+    virtual IOResult write_batch(const IORequest* requests, u32 count) {
+        for (u32 i = 0; i < count; i++) {
+            IOResult result = write_sectors(requests[i].lba, requests[i].count, requests[i].buffer);
+            if (result != IOResult::Success) return result;
+        }
+        return IOResult::Success;
+    }
+    
     // Device info
     virtual const DeviceInfo& get_info() const = 0;
     virtual const DeviceStats& get_stats() const = 0;
@@ -175,6 +195,7 @@ public:
     
     IOResult read_sectors(u64 lba, u32 count, void* buffer) override;
     IOResult write_sectors(u64 lba, u32 count, const void* buffer) override;
+    IOResult write_batch(const IORequest* requests, u32 count) override;
     
     const DeviceInfo& get_info() const override { return info; }
     const DeviceStats& get_stats() const override { return stats; }
@@ -5,6 +5,7 @@
 #include "detect.hpp"
 #include "ramfs.hpp"
 #include "fat32fs.hpp"
+#include "../core/memory/heap.hpp"
 #include "../drivers/serial/serial.hpp"
 #include "../drivers/video/console.hpp"
 #include "../lib/string.hpp"
@@ -104,10 +105,11 @@ FilesystemType FilesystemDetector::detect(BlockDevice* device) {
     
     // Try detection at multiple offsets:
     // - Sector 0: Standard location (superfloppy or MBR)
-    // - Sector 257: Boot + kernel layout (256 reserved sectors + boot)
-    u32 offsets[] = { 0, 257 };
+    // - Sector 513: Boot + kernel layout (512 reserved sectors + boot)
+    // - Sector 257: Older images with 256 reserved sectors
+    u32 offsets[] = { 0, 513, 257 };
     
-    for (int oi = 0; oi < 2; oi++) {
+    for (int oi = 0; oi < 3; oi++) {
         u32 offset = offsets[oi];
         
         // Read boot sector at this offset
@@ -372,11 +374,11 @@ Filesystem* FilesystemDetector::create_filesystem(FilesystemType type) {
     // Fallback built-in filesystems
     switch (type) {
         case FilesystemType::FAT32:
-            return new FAT32Filesystem();
+            return new (mem::MemTag::FAT32) FAT32Filesystem();
             
         case FilesystemType::RAMFS:
         case FilesystemType::TmpFS:
-            return new RAMFilesystem();
+            return new (mem::MemTag::RAMFS) RAMFilesystem();
             
         default:
             DBG_WARN("FSDET", "No driver for filesystem type");
@@ -36,7 +36,7 @@ struct __attribute__((packed)) FATBootSector {
     
     // Extended boot record (FAT32 specific at offset 36)
     union {
-        struct {
+        struct __attribute__((packed)) {
             // FAT12/16 extended
             u8  drive_number;
             u8  reserved;
@@ -46,7 +46,7 @@ struct __attribute__((packed)) FATBootSector {
             u8  fs_type[8];      // "FAT12   " or "FAT16   "
         } fat16;
         
-        struct {
+        struct __attribute__((packed)) {
             // FAT32 extended
             u32 sectors_per_fat_32;
             u16 flags;
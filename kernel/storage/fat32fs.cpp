@@ -6,12 +6,15 @@
 #include "../drivers/serial/serial.hpp"
 #include "../lib/string.hpp"
 #include "../core/memory/heap.hpp"
+#include "../drivers/timer/pit.hpp"
 
 namespace bolt::storage {
 
 using namespace drivers;
 using namespace mem;
 
+bool FAT32Filesystem::mount_scan = true;
+
 // ===========================================================================
 // Constructor / Destructor
 // ===========================================================================
@@ -30,12 +33,48 @@ FAT32Filesystem::FAT32Filesystem()
       root_cluster(0),
       total_clusters(0),
       free_clusters(0),
+      free_count_valid(false),
+      next_free_cluster(2),
+      fs_info_sector(0),
+      fat_dirty(false),
+      volume_dirty(false),
+      read_only(false),
       sector_buffer(nullptr),
       cluster_buffer(nullptr),
-      cached_fat_sector(0xFFFFFFFF),
-      fat_cache(nullptr)
+      fat_clock(0),
+      fat_cache(nullptr),
+      fat_stage(nullptr),
+      free_map(nullptr),
+      cache_slots(nullptr),
+      cache_count(0),
+      cache_target(0),
+      cache_clock(0),
+      cache_data(nullptr),
+      ra_buffer(nullptr),
+      ra_max_clusters(1),
+      open_files(nullptr),
+      dir_index_clock(0)
 {
     volume_label[0] = '\0';
+    cache_stats.clear();
+    space_stats.clear();
+    shrinker = {"fat32", MemTag::FAT32, shrinker_count, shrinker_scan, this, 0, 0};
+    for (u32 i = 0; i < FAT_CACHE_SECTORS; i++) {
+        fat_slots[i].sector = FAT32FatSlot::EMPTY;
+        fat_slots[i].stamp = 0;
+        fat_slots[i].dirty = false;
+        fat_slots[i].data = nullptr;
+    }
+    for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+        dir_index[i].nodes = nullptr;
+        dir_index[i].node_capacity = 0;
+        dir_index[i].free_slots = nullptr;
+        dir_index[i].free_capacity = 0;
+        dir_index[i].names = nullptr;
+        dir_index[i].names_capacity = 0;
+        dir_index[i].buckets = nullptr;
+        dir_index[i].reset(0);
+    }
 }
 
 FAT32Filesystem::~FAT32Filesystem() {
@@ -63,21 +102,22 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
     blk_device = dev;
     device = dev;
     partition_offset = 0;  // Start with no offset
+    read_only = dev->get_info().read_only;
+    open_files = nullptr;
     
     // Allocate buffers
-    sector_buffer = static_cast<u8*>(Heap::alloc(SECTOR_SIZE));
-    cluster_buffer = static_cast<u8*>(Heap::alloc(MAX_CLUSTER_SIZE));
-    fat_cache = static_cast<u32*>(Heap::alloc(SECTOR_SIZE));
+    sector_buffer = static_cast<u8*>(Heap::alloc(SECTOR_SIZE, MemTag::FAT32));
+    cluster_buffer = static_cast<u8*>(Heap::alloc(MAX_CLUSTER_SIZE, MemTag::FAT32));
     
-    if (!sector_buffer || !cluster_buffer || !fat_cache) {
+    if (!sector_buffer || !cluster_buffer) {
         DBG_FAIL("FAT32", "Failed to allocate buffers");
-        return VFSResult::NoSpace;
+        return mount_failed(VFSResult::NoSpace);
     }
     
     // Read sector 0 to check if it's a FAT32 boot sector or MBR/boot+kernel
     if (blk_device->read_sectors(0, 1, sector_buffer) != IOResult::Success) {
         DBG_FAIL("FAT32", "Failed to read sector 0");
-        return VFSResult::IOError;
+        return mount_failed(VFSResult::IOError);
     }
     
     const FAT32BootSector* bpb = reinterpret_cast<const FAT32BootSector*>(sector_buffer);
@@ -90,11 +130,11 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
     
     if (!valid_at_zero) {
         // Not at sector 0 - try to find FAT32 using hidden_sectors hint
-        // Check if there's a partition at sector 257 (our boot + kernel layout)
+        // Check if there's a partition at sector 513 (our boot + kernel layout)
         DBG("FAT32", "Sector 0 not FAT32, scanning for partition...");
         
-        // Try known offset: 257 (256 reserved sectors + 1 boot)
-        u32 try_offsets[] = { 257, 63, 2048, 0 };  // Common partition starts
+        // Try known offsets: 513 (512 reserved sectors + 1 boot), 257 for older images
+        u32 try_offsets[] = { 513, 257, 63, 2048, 0 };  // Common partition starts
         
         for (int i = 0; try_offsets[i] != 0 || i == 0; i++) {
             if (i > 0 && try_offsets[i] == 0) break;
@@ -118,7 +158,7 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
         
         if (partition_offset == 0 && !valid_at_zero) {
             DBG_FAIL("FAT32", "No FAT32 filesystem found");
-            return VFSResult::NoFilesystem;
+            return mount_failed(VFSResult::NoFilesystem);
         }
     }
     
@@ -126,7 +166,7 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
     if (partition_offset > 0) {
         if (!read_sector(0, sector_buffer)) {
             DBG_FAIL("FAT32", "Failed to read partition boot sector");
-            return VFSResult::IOError;
+            return mount_failed(VFSResult::IOError);
         }
         bpb = reinterpret_cast<const FAT32BootSector*>(sector_buffer);
     }
@@ -135,12 +175,12 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
     if (bpb->bytes_per_sector != 512 && bpb->bytes_per_sector != 1024 &&
         bpb->bytes_per_sector != 2048 && bpb->bytes_per_sector != 4096) {
         DBG_FAIL("FAT32", "Invalid bytes per sector");
-        return VFSResult::NoFilesystem;
+        return mount_failed(VFSResult::NoFilesystem);
     }
     
     if (bpb->sectors_per_cluster == 0 || bpb->fat_count == 0) {
         DBG_FAIL("FAT32", "Invalid BPB parameters");
-        return VFSResult::NoFilesystem;
+        return mount_failed(VFSResult::NoFilesystem);
     }
     
     // Extract parameters
@@ -171,18 +211,83 @@ VFSResult FAT32Filesystem::mount(BlockDevice* dev, const char* mnt_point) {
     }
     
     // Read FSInfo for free cluster count
+    fs_info_sector = 0;
+    free_count_valid = false;
+    next_free_cluster = 2;
     if (bpb->fs_info_sector > 0 && bpb->fs_info_sector < reserved_sectors) {
-        if (read_sector(bpb->fs_info_sector, sector_buffer)) {
+        fs_info_sector = bpb->fs_info_sector;
+        if (read_sector(fs_info_sector, sector_buffer)) {
             const FAT32FSInfo* fsinfo = reinterpret_cast<const FAT32FSInfo*>(sector_buffer);
             if (fsinfo->is_valid() && fsinfo->free_clusters != 0xFFFFFFFF) {
                 free_clusters = fsinfo->free_clusters;
+                free_count_valid = true;
+            }
+            if (fsinfo->is_valid() && fsinfo->next_free_cluster != 0xFFFFFFFF) {
+                next_free_cluster = fsinfo->next_free_cluster;
             }
         }
     }
     
+    // FAT sector cache
+    fat_cache = static_cast<u8*>(Heap::alloc(FAT_CACHE_SECTORS * bytes_per_sector, MemTag::FAT32));
+    fat_stage = static_cast<u8*>(Heap::alloc(FAT_CACHE_SECTORS * bytes_per_sector, MemTag::FAT32));
+    if (!fat_cache || !fat_stage) {
+        DBG_FAIL("FAT32", "Failed to allocate FAT cache");
+        return mount_failed(VFSResult::NoSpace);
+    }
+    for (u32 i = 0; i < FAT_CACHE_SECTORS; i++) {
+        fat_slots[i].sector = FAT32FatSlot::EMPTY;
+        fat_slots[i].stamp = 0;
+        fat_slots[i].dirty = false;
+        fat_slots[i].data = reinterpret_cast<u32*>(fat_cache + i * bytes_per_sector);
+    }
+    fat_dirty = false;
+    
+    // Cluster cache: at least two full read-ahead windows
+    ra_max_clusters = READAHEAD_BYTES / cluster_size;
+    if (ra_max_clusters == 0) ra_max_clusters = 1;
+    cache_target = CACHE_BYTES / cluster_size;
+    if (cache_target < 2 * ra_max_clusters + 2) cache_target = 2 * ra_max_clusters + 2;
+    cache_count = 0;
+    
+    cache_slots = static_cast<FAT32CacheSlot*>(Heap::alloc(sizeof(FAT32CacheSlot) * cache_target, MemTag::FAT32));
+    ra_buffer = static_cast<u8*>(Heap::alloc(ra_max_clusters * cluster_size, MemTag::FAT32));
+    if (!cache_slots || !ra_buffer) {
+        DBG_FAIL("FAT32", "Failed to allocate cluster cache");
+        return mount_failed(VFSResult::NoSpace);
+    }
+    
+    cache_stats.clear();
+    cache_stats.block_size = cluster_size;
+    if (!grow_cluster_cache()) {
+        DBG_WARN("FAT32", "Cluster cache deferred, heap is low");
+    }
+    
+    // A cleared clean-shutdown bit means the last session never synced
+    const u32* fat0 = fat_sector(0, false);
+    if (!fat0) {
+        DBG_FAIL("FAT32", "Failed to read FAT");
+        return mount_failed(VFSResult::IOError);
+    }
+    volume_dirty = (fat0[1] & FAT32_CLEAN_SHUTDOWN) == 0;
+    if (volume_dirty) {
+        DBG_WARN("FAT32", read_only ? "Volume was not cleanly unmounted, read-only check"
+                                    : "Volume was not cleanly unmounted, checking");
+        check_volume();
+    }
+    
+    space_stats.clear();
+    if (mount_scan && !scan_space()) {
+        DBG_WARN("FAT32", "Mount scan failed, using FSInfo free count");
+    }
+    
     mount_path = mnt_point;
     mounted = true;
     
+    if (!Reclaim::register_shrinker(&shrinker)) {
+        DBG_WARN("FAT32", "Shrinker registry full, caches stay pinned");
+    }
+    
     DBG_SUCCESS("FAT32", volume_label);
     
     return VFSResult::Success;
@@ -193,17 +298,13 @@ VFSResult FAT32Filesystem::unmount() {
         return VFSResult::NotMounted;
     }
     
-    // Sync pending writes
-    sync();
+    Reclaim::unregister_shrinker(&shrinker);
     
-    // Free buffers
-    if (sector_buffer) Heap::free(sector_buffer);
-    if (cluster_buffer) Heap::free(cluster_buffer);
-    if (fat_cache) Heap::free(fat_cache);
+    // Sync pending writes, including files still open
+    sync();
+    open_files = nullptr;
     
-    sector_buffer = nullptr;
-    cluster_buffer = nullptr;
-    fat_cache = nullptr;
+    release_buffers();
     
     blk_device = nullptr;
     device = nullptr;
@@ -214,6 +315,45 @@ VFSResult FAT32Filesystem::unmount() {
     return VFSResult::Success;
 }
 
+// Everything mount allocates; unmount and a failed mount both end here
+void FAT32Filesystem::release_buffers() {
+    if (sector_buffer) Heap::free(sector_buffer);
+    if (cluster_buffer) Heap::free(cluster_buffer);
+    if (fat_cache) Heap::free(fat_cache);
+    if (fat_stage) Heap::free(fat_stage);
+    if (free_map) Heap::free(free_map);
+    for (u32 i = 0; i < FAT_CACHE_SECTORS; i++) {
+        fat_slots[i].sector = FAT32FatSlot::EMPTY;
+        fat_slots[i].dirty = false;
+        fat_slots[i].data = nullptr;
+    }
+    for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+        dir_index[i].release();
+    }
+    if (cache_slots) Heap::free(cache_slots);
+    if (cache_data) Heap::free(cache_data);
+    if (ra_buffer) Heap::free(ra_buffer);
+    
+    cache_slots = nullptr;
+    cache_data = nullptr;
+    ra_buffer = nullptr;
+    cache_count = 0;
+    cache_target = 0;
+    sector_buffer = nullptr;
+    cluster_buffer = nullptr;
+    fat_cache = nullptr;
+    fat_stage = nullptr;
+    free_map = nullptr;
+    space_stats.clear();
+}
+
+VFSResult FAT32Filesystem::mount_failed(VFSResult result) {
+    release_buffers();
+    blk_device = nullptr;
+    device = nullptr;
+    return result;
+}
+
 // ===========================================================================
 // Low-level I/O
 // ===========================================================================
@@ -250,110 +390,738 @@ bool FAT32Filesystem::write_cluster(u32 cluster, const void* buffer) {
     }
     u64 lba = partition_offset + cluster_to_lba(cluster);
     
+    mark_volume_dirty();
     IOResult result = blk_device->write_sectors(lba, sectors_per_cluster, buffer);
     if (result != IOResult::Success) {
         DBG_FAIL("FAT32", "write_cluster: write_sectors failed");
         return false;
     }
+    cache_update(cluster, buffer);
     return true;
 }
 
 bool FAT32Filesystem::read_fat_entry(u32 cluster, u32& value) {
-    u32 fat_sector = fat_start_lba + (cluster * 4) / bytes_per_sector;
-    u32 offset = (cluster * 4) % bytes_per_sector;
+    u32 per_sector = bytes_per_sector / 4;
+    const u32* entries = fat_sector(cluster / per_sector, false);
+    if (!entries) {
+        return false;
+    }
     
-    // Check cache
-    if (fat_sector != cached_fat_sector) {
-        if (!read_sector(fat_sector, fat_cache)) {
-            return false;
+    value = entries[cluster % per_sector] & 0x0FFFFFFF;
+    return true;
+}
+
+// ===========================================================================
+// Cluster Cache
+// ===========================================================================
+
+bool FAT32Filesystem::grow_cluster_cache() {
+    if (cache_data || !cache_slots) return cache_data != nullptr;
+    
+    cache_data = static_cast<u8*>(Heap::alloc(cache_target * cluster_size, MemTag::FAT32));
+    if (!cache_data) return false;
+    
+    for (u32 i = 0; i < cache_target; i++) {
+        cache_slots[i].cluster = 0;
+        cache_slots[i].stamp = 0;
+        cache_slots[i].prefetched = false;
+        cache_slots[i].data = cache_data + i * cluster_size;
+    }
+    cache_count = cache_target;
+    cache_stats.blocks = cache_count;
+    return true;
+}
+
+const u8* FAT32Filesystem::cache_lookup(u32 cluster) {
+    for (u32 i = 0; i < cache_count; i++) {
+        FAT32CacheSlot& slot = cache_slots[i];
+        if (slot.cluster == cluster) {
+            if (slot.prefetched) {
+                cache_stats.readahead_hits++;
+                slot.prefetched = false;
+            }
+            slot.stamp = ++cache_clock;
+            cache_stats.hits++;
+            return slot.data;
+        }
+    }
+    return nullptr;
+}
+
+void FAT32Filesystem::cache_insert(u32 cluster, const u8* data, bool prefetched) {
+    if (cache_count == 0) {
+        // Reclaimed earlier: come back only once the heap has room again
+        u32 want = cache_target * cluster_size;
+        if (Heap::get_free() < want + 2 * config::HEAP_LOW_WATER || !grow_cluster_cache()) {
+            return;
         }
-        cached_fat_sector = fat_sector;
     }
     
-    value = fat_cache[offset / 4] & 0x0FFFFFFF;
-    return true;
+    FAT32CacheSlot* victim = &cache_slots[0];
+    for (u32 i = 0; i < cache_count; i++) {
+        if (cache_slots[i].cluster == cluster) {
+            victim = &cache_slots[i];
+            break;
+        }
+        if (cache_slots[i].stamp < victim->stamp) {
+            victim = &cache_slots[i];
+        }
+    }
+    
+    if (victim->prefetched && victim->cluster != cluster) {
+        cache_stats.readahead_wasted++;
+    }
+    
+    mem::memcpy(victim->data, data, cluster_size);
+    victim->cluster = cluster;
+    victim->stamp = ++cache_clock;
+    victim->prefetched = prefetched;
+}
+
+void FAT32Filesystem::cache_update(u32 cluster, const void* data) {
+    for (u32 i = 0; i < cache_count; i++) {
+        if (cache_slots[i].cluster == cluster) {
+            mem::memcpy(cache_slots[i].data, data, cluster_size);
+            return;
+        }
+    }
 }
 
 // ===========================================================================
-// FAT Write Operations
+// Memory Pressure
 // ===========================================================================
 
-bool FAT32Filesystem::set_fat_entry(u32 cluster, u32 value) {
-    u32 fat_offset = cluster * 4;
-    u32 fat_sector_offset = fat_offset / bytes_per_sector;
-    u32 offset_in_sector = (fat_offset % bytes_per_sector) / 4;
+static usize dir_index_bytes(const FAT32DirIndex& index) {
+    return index.node_capacity * sizeof(FAT32DirIndex::Node) +
+           index.free_capacity * sizeof(FAT32DirIndex::FreeSlot) +
+           index.names_capacity + index.bucket_bytes();
+}
+
+usize FAT32Filesystem::reclaimable_bytes() const {
+    if (!mounted) return 0;
     
-    DBG_DEBUG("FAT32", "set_fat_entry");
+    usize total = 0;
+    for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+        total += dir_index_bytes(dir_index[i]);
+    }
+    if (cache_data) total += cache_count * cluster_size;
+    if (free_map) total += (total_clusters + 2) / 8 + 1;
+    return total;
+}
+
+usize FAT32Filesystem::shrink(usize target) {
+    if (!mounted) return 0;
+    usize freed = 0;
+    
+    // Directory indexes rebuild from one directory read, oldest first
+    while (freed < target) {
+        FAT32DirIndex* victim = nullptr;
+        for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+            if (dir_index_bytes(dir_index[i]) == 0) continue;
+            if (!victim || dir_index[i].stamp < victim->stamp) {
+                victim = &dir_index[i];
+            }
+        }
+        if (!victim) break;
+        freed += dir_index_bytes(*victim);
+        victim->release();
+    }
     
-    // Read FAT sector
-    u32 fat_lba = fat_start_lba + fat_sector_offset;
-    if (!read_sector(fat_lba, sector_buffer)) {
-        DBG_FAIL("FAT32", "Failed to read FAT sector");
-        return false;
+    // The cluster cache is write-through, so its contents are always clean
+    if (freed < target && cache_data) {
+        freed += cache_count * cluster_size;
+        Heap::free(cache_data);
+        cache_data = nullptr;
+        cache_count = 0;
+        cache_stats.blocks = 0;
     }
     
-    // Modify entry
-    u32* fat_entries = reinterpret_cast<u32*>(sector_buffer);
-    fat_entries[offset_in_sector] = (fat_entries[offset_in_sector] & 0xF0000000) | (value & 0x0FFFFFFF);
+    // Allocation falls back to scanning the FAT; fsinfo -r rebuilds the map
+    if (freed < target && free_map) {
+        freed += (total_clusters + 2) / 8 + 1;
+        Heap::free(free_map);
+        free_map = nullptr;
+        space_stats.valid = false;
+    }
     
-    // Write to all FAT copies
-    for (u32 i = 0; i < fat_count; i++) {
-        u32 this_fat_lba = fat_start_lba + (i * fat_size) + fat_sector_offset;
-        if (!write_sector(this_fat_lba, sector_buffer)) {
+    return freed;
+}
+
+usize FAT32Filesystem::shrinker_count(void* ctx) {
+    return static_cast<FAT32Filesystem*>(ctx)->reclaimable_bytes();
+}
+
+usize FAT32Filesystem::shrinker_scan(void* ctx, usize target) {
+    return static_cast<FAT32Filesystem*>(ctx)->shrink(target);
+}
+
+bool FAT32Filesystem::get_cache_stats(FSCacheStats& stats) const {
+    stats = cache_stats;
+    return mounted;
+}
+
+// ===========================================================================
+// FAT Sector Cache
+// ===========================================================================
+
+FAT32FatSlot* FAT32Filesystem::fat_slot(u32 sector) {
+    FAT32FatSlot* victim = nullptr;
+    for (u32 i = 0; i < FAT_CACHE_SECTORS; i++) {
+        FAT32FatSlot& slot = fat_slots[i];
+        if (slot.sector == sector) {
+            slot.stamp = ++fat_clock;
+            return &slot;
+        }
+        // Prefer clean victims so FAT scans never force early writes
+        if (!victim || (victim->dirty && !slot.dirty) ||
+            (victim->dirty == slot.dirty && slot.stamp < victim->stamp)) {
+            victim = &slot;
+        }
+    }
+    
+    if (victim->dirty && !commit_fat()) {
+        return nullptr;
+    }
+    
+    victim->sector = FAT32FatSlot::EMPTY;
+    if (!read_sector(fat_start_lba + sector, victim->data)) {
+        return nullptr;
+    }
+    victim->sector = sector;
+    victim->stamp = ++fat_clock;
+    victim->dirty = false;
+    return victim;
+}
+
+u32* FAT32Filesystem::fat_sector(u32 sector, bool modify) {
+    // The dirty flag goes to disk before the first FAT change it covers
+    if (modify) mark_volume_dirty();
+    
+    FAT32FatSlot* slot = fat_slot(sector);
+    if (!slot) return nullptr;
+    
+    if (modify) {
+        slot->dirty = true;
+        fat_dirty = true;
+    }
+    return slot->data;
+}
+
+bool FAT32Filesystem::write_fat_sector(FAT32FatSlot& slot) {
+    IORequest requests[2];
+    for (u32 i = 0; i < fat_count; i += 2) {
+        u32 n = 0;
+        for (; n < 2 && i + n < fat_count; n++) {
+            requests[n].lba = partition_offset + fat_start_lba + (i + n) * fat_size + slot.sector;
+            requests[n].count = 1;
+            requests[n].buffer = slot.data;
+        }
+        if (blk_device->write_batch(requests, n) != IOResult::Success) {
             DBG_FAIL("FAT32", "Failed to write FAT sector");
             return false;
         }
     }
+    slot.dirty = false;
+    return true;
+}
+
+// Write back every dirty FAT sector. Adjacent sectors are staged into
+// runs, and the runs for all FAT copies are submitted as one batch.
+bool FAT32Filesystem::commit_fat() {
+    if (!fat_dirty) return true;
+    
+    struct Run { u32 sector; u32 count; u32 offset; };
+    Run runs[FAT_CACHE_SECTORS];
+    FAT32FatSlot* staged[FAT_CACHE_SECTORS];
+    u32 run_count = 0;
+    u32 staged_count = 0;
+    
+    // Gather dirty sectors in ascending order
+    u32 floor = 0;
+    while (true) {
+        FAT32FatSlot* next = nullptr;
+        for (u32 i = 0; i < FAT_CACHE_SECTORS; i++) {
+            FAT32FatSlot& slot = fat_slots[i];
+            if (slot.dirty && slot.sector >= floor && (!next || slot.sector < next->sector)) {
+                next = &slot;
+            }
+        }
+        if (!next) break;
+        
+        mem::memcpy(fat_stage + staged_count * bytes_per_sector, next->data, bytes_per_sector);
+        if (run_count > 0 && runs[run_count - 1].sector + runs[run_count - 1].count == next->sector) {
+            runs[run_count - 1].count++;
+        } else {
+            runs[run_count].sector = next->sector;
+            runs[run_count].count = 1;
+            runs[run_count].offset = staged_count;
+            run_count++;
+        }
+        staged[staged_count++] = next;
+        floor = next->sector + 1;
+    }
+    
+    // Every copy's runs in one submission (two copies per batch)
+    IORequest requests[FAT_CACHE_SECTORS * 2];
+    for (u32 copy = 0; copy < fat_count; copy += 2) {
+        u32 n = 0;
+        for (u32 c = copy; c < copy + 2 && c < fat_count; c++) {
+            for (u32 r = 0; r < run_count; r++) {
+                requests[n].lba = partition_offset + fat_start_lba + c * fat_size + runs[r].sector;
+                requests[n].count = runs[r].count;
+                requests[n].buffer = fat_stage + runs[r].offset * bytes_per_sector;
+                n++;
+            }
+        }
+        if (blk_device->write_batch(requests, n) != IOResult::Success) {
+            DBG_FAIL("FAT32", "Failed to write FAT");
+            return false;
+        }
+    }
+    
+    for (u32 i = 0; i < staged_count; i++) {
+        staged[i]->dirty = false;
+    }
+    fat_dirty = false;
+    return true;
+}
+
+bool FAT32Filesystem::write_fsinfo() {
+    if (fs_info_sector == 0) return true;
     
-    // Invalidate cache if this was the cached sector
-    if (fat_lba == cached_fat_sector) {
-        cached_fat_sector = 0xFFFFFFFF;
+    if (!read_sector(fs_info_sector, sector_buffer)) {
+        return false;
     }
     
-    fat_dirty = true;
+    FAT32FSInfo* fsinfo = reinterpret_cast<FAT32FSInfo*>(sector_buffer);
+    if (!fsinfo->is_valid()) return true;
+    
+    fsinfo->free_clusters = free_count_valid ? free_clusters : 0xFFFFFFFF;
+    fsinfo->next_free_cluster = next_free_cluster;
+    return write_sector(fs_info_sector, sector_buffer);
+}
+
+// ===========================================================================
+// Volume State
+// ===========================================================================
+
+bool FAT32Filesystem::set_volume_clean(bool clean) {
+    FAT32FatSlot* slot = fat_slot(0);
+    if (!slot) return false;
+    
+    if (clean) {
+        slot->data[1] |= FAT32_CLEAN_SHUTDOWN;
+    } else {
+        slot->data[1] &= ~FAT32_CLEAN_SHUTDOWN;
+    }
+    
+    if (!write_fat_sector(*slot)) return false;
+    volume_dirty = !clean;
     return true;
 }
 
-u32 FAT32Filesystem::alloc_cluster() {
-    DBG_DEBUG("FAT32", "alloc_cluster: Finding free cluster");
+void FAT32Filesystem::mark_volume_dirty() {
+    if (volume_dirty) return;
+    volume_dirty = true;
+    if (!set_volume_clean(false)) {
+        DBG_WARN("FAT32", "Failed to set volume dirty flag");
+    }
+}
+
+// Mount-time check after an unclean shutdown; a write-protected volume is
+// only reported on and stays read-only
+bool FAT32Filesystem::check_volume() {
+    FAT32CheckReport report;
+    if (!check(report, !read_only)) {
+        DBG_FAIL("FAT32", "Volume check failed");
+        return false;
+    }
     
-    // Start searching from next_free_cluster hint or cluster 2
-    u32 search_start = (next_free_cluster >= 2 && next_free_cluster < total_clusters + 2) 
-                       ? next_free_cluster : 2;
+    if (read_only) {
+        DBG_HEX("FAT32", "Volume check errors (not repaired, read-only):", report.errors());
+    } else if (report.repaired > 0) {
+        DBG_HEX("FAT32", "Volume check repaired entries:", report.repaired);
+    } else {
+        DBG_OK("FAT32", "Volume check found no chain errors");
+    }
+    return true;
+}
+
+static inline bool map_test(const u8* map, u32 bit) {
+    return (map[bit / 8] & (1 << (bit % 8))) != 0;
+}
+
+static inline void map_set(u8* map, u32 bit) {
+    map[bit / 8] |= 1 << (bit % 8);
+}
+
+// Streaming pass over the FAT in large multi-sector batches. Each batch
+// of FAT 0 is compared with the same range of every mirror, and links are
+// checked for range and cross-links against a bitmap of targets. Links
+// into free clusters are found from the bitmaps afterwards; in repair
+// mode a second pass cuts them. Directory contents are not walked.
+bool FAT32Filesystem::check(FAT32CheckReport& report, bool repair) {
+    if (read_only) repair = false;
+    report.clear();
+    report.fat_copies = fat_count;
+    report.clusters = total_clusters;
+    report.free_recorded = free_count_valid ? free_clusters : 0xFFFFFFFF;
+    
+    const u32* fat0 = fat_sector(0, false);
+    if (!fat0) return false;
+    report.was_clean = (fat0[1] & FAT32_CLEAN_SHUTDOWN) != 0;
+    
+    // The scan reads the disk, so pending FAT changes go out first
+    if (!commit_fat()) return false;
+    
+    u32 per_sector = bytes_per_sector / 4;
+    u32 batch = CHECK_BATCH_BYTES / bytes_per_sector;
+    u32 limit = total_clusters + 2;
+    u32 sectors = (limit + per_sector - 1) / per_sector;
+    u32 map_bytes = limit / 8 + 1;
+    
+    u8* primary = static_cast<u8*>(Heap::alloc(CHECK_BATCH_BYTES, MemTag::FAT32));
+    u8* mirror = static_cast<u8*>(Heap::alloc(CHECK_BATCH_BYTES, MemTag::FAT32));
+    u8* referenced = static_cast<u8*>(Heap::alloc(map_bytes, MemTag::FAT32));
+    u8* free_map = static_cast<u8*>(Heap::alloc(map_bytes, MemTag::FAT32));
+    if (!primary || !mirror || !referenced || !free_map) {
+        if (primary) Heap::free(primary);
+        if (mirror) Heap::free(mirror);
+        if (referenced) Heap::free(referenced);
+        if (free_map) Heap::free(free_map);
+        DBG_WARN("FAT32", "Not enough memory for FAT check");
+        return false;
+    }
+    mem::memset(referenced, 0, map_bytes);
+    mem::memset(free_map, 0, map_bytes);
     
-    // Search for a free cluster
-    for (u32 offset = 0; offset < total_clusters; offset++) {
-        u32 cluster = search_start + offset;
-        if (cluster >= total_clusters + 2) {
-            cluster -= total_clusters;  // Wrap around
+    u32 first_free = 0;
+    u32 used = 0;
+    u32 links = 0;
+    bool ok = true;
+    
+    // Pass 1
+    for (u32 sector = 0; ok && sector < sectors; sector += batch) {
+        u32 count = (sectors - sector < batch) ? sectors - sector : batch;
+        u64 lba = partition_offset + fat_start_lba + sector;
+        if (blk_device->read_sectors(lba, count, primary) != IOResult::Success) {
+            ok = false;
+            break;
         }
+        report.sectors_read += count;
         
-        u32 value;
-        if (!read_fat_entry(cluster, value)) {
-            continue;
+        // Mirrors: compare sector by sector, rewrite the batch on mismatch
+        for (u32 copy = 1; ok && copy < fat_count; copy++) {
+            if (blk_device->read_sectors(lba + copy * fat_size, count, mirror) != IOResult::Success) {
+                ok = false;
+                break;
+            }
+            report.sectors_read += count;
+            
+            u32 mismatched = 0;
+            for (u32 i = 0; i < count; i++) {
+                u32 off = i * bytes_per_sector;
+                if (mem::memcmp(primary + off, mirror + off, bytes_per_sector) != 0) {
+                    mismatched++;
+                }
+            }
+            report.mirror_mismatches += mismatched;
+            
+            if (repair && mismatched > 0) {
+                if (blk_device->write_sectors(lba + copy * fat_size, count, primary) != IOResult::Success) {
+                    ok = false;
+                    break;
+                }
+                report.repaired += mismatched;
+            }
         }
+        if (!ok) break;
         
-        if (value == 0) {  // Free cluster
-            // Mark as end of chain
-            if (!set_fat_entry(cluster, 0x0FFFFFFF)) {
-                return 0;
+        const u32* entries = reinterpret_cast<const u32*>(primary);
+        u32 base = sector * per_sector;
+        for (u32 i = 0; i < count * per_sector; i++) {
+            u32 cluster = base + i;
+            if (cluster < 2) continue;
+            if (cluster >= limit) break;
+            
+            u32 value = entries[i] & 0x0FFFFFFF;
+            if (value == 0) {
+                map_set(free_map, cluster);
+                report.free++;
+                if (first_free == 0) first_free = cluster;
+                continue;
+            }
+            if (value == 0x0FFFFFF7) {
+                report.bad++;
+                continue;
             }
+            used++;
+            if (value >= 0x0FFFFFF8) continue;  // End of chain
             
-            // Update hint and free count
-            next_free_cluster = cluster + 1;
-            if (free_clusters > 0) free_clusters--;
+            bool out_of_range = value < 2 || value >= limit;
+            bool cross = !out_of_range && map_test(referenced, value);
+            if (out_of_range || cross) {
+                if (out_of_range) report.bad_links++;
+                else report.cross_links++;
+                if (repair) {
+                    set_fat_entry(cluster, 0x0FFFFFFF);
+                    report.repaired++;
+                }
+            } else {
+                map_set(referenced, value);
+                links++;
+            }
+        }
+    }
+    
+    // The root directory must stay allocated
+    if (ok && repair && root_cluster >= 2 && root_cluster < limit && map_test(free_map, root_cluster)) {
+        set_fat_entry(root_cluster, 0x0FFFFFFF);
+        free_map[root_cluster / 8] &= ~(1 << (root_cluster % 8));
+        report.free--;
+        used++;
+        report.repaired++;
+    }
+    
+    // Targets that are free clusters
+    u32 dangling = 0;
+    for (u32 i = 0; ok && i < map_bytes; i++) {
+        u8 both = referenced[i] & free_map[i];
+        while (both) {
+            dangling++;
+            both &= both - 1;
+        }
+    }
+    report.dangling_links = dangling;
+    report.chains = used - (links - dangling);
+    
+    // Pass 2 (repair only): cut the links that lead into free clusters
+    if (ok && repair && dangling > 0 && (ok = commit_fat())) {
+        for (u32 sector = 0; ok && sector < sectors; sector += batch) {
+            u32 count = (sectors - sector < batch) ? sectors - sector : batch;
+            u64 lba = partition_offset + fat_start_lba + sector;
+            if (blk_device->read_sectors(lba, count, primary) != IOResult::Success) {
+                ok = false;
+                break;
+            }
+            report.sectors_read += count;
+            
+            const u32* entries = reinterpret_cast<const u32*>(primary);
+            u32 base = sector * per_sector;
+            for (u32 i = 0; i < count * per_sector; i++) {
+                u32 cluster = base + i;
+                if (cluster < 2) continue;
+                if (cluster >= limit) break;
+                
+                u32 value = entries[i] & 0x0FFFFFFF;
+                if (value >= 2 && value < limit && map_test(free_map, value)) {
+                    set_fat_entry(cluster, 0x0FFFFFFF);
+                    report.repaired++;
+                }
+            }
+        }
+    }
+    
+    Heap::free(primary);
+    Heap::free(mirror);
+    Heap::free(referenced);
+    Heap::free(free_map);
+    
+    if (!ok) {
+        DBG_FAIL("FAT32", "FAT check could not read the FAT");
+        return false;
+    }
+    
+    // The scan's count is exact, so it replaces the recorded one
+    free_clusters = report.free;
+    free_count_valid = true;
+    if (first_free) next_free_cluster = first_free;
+    
+    if (repair) {
+        return commit_fat() && write_fsinfo();
+    }
+    return true;
+}
+
+// ===========================================================================
+// Space Map
+// ===========================================================================
+
+static inline u32 length_bucket(u32 length) {
+    u32 bucket = 0;
+    while ((length >> (bucket + 1)) != 0 && bucket + 1 < FAT32SpaceStats::BUCKETS) {
+        bucket++;
+    }
+    return bucket;
+}
+
+// One streaming pass over FAT 0 in large reads. Rebuilds the free bitmap
+// and the exact free count, and records how the used clusters split into
+// contiguous extents and how the free space splits into runs.
+bool FAT32Filesystem::scan_space() {
+    if (!commit_fat()) return false;
+    
+    u32 start = PIT::get_milliseconds();
+    u32 per_sector = bytes_per_sector / 4;
+    u32 batch = CHECK_BATCH_BYTES / bytes_per_sector;
+    u32 limit = total_clusters + 2;
+    u32 sectors = (limit + per_sector - 1) / per_sector;
+    u32 map_bytes = limit / 8 + 1;
+    
+    if (!free_map) {
+        free_map = static_cast<u8*>(Heap::alloc(map_bytes, MemTag::FAT32));
+        if (!free_map) return false;
+    }
+    u8* buffer = static_cast<u8*>(Heap::alloc(CHECK_BATCH_BYTES, MemTag::FAT32));
+    if (!buffer) {
+        Heap::free(free_map);
+        free_map = nullptr;
+        return false;
+    }
+    mem::memset(free_map, 0, map_bytes);
+    
+    FAT32SpaceStats stats;
+    stats.clear();
+    u32 links = 0;
+    u32 extent = 0;
+    u32 free_run = 0;
+    u32 first_free = 0;
+    bool ok = true;
+    
+    for (u32 sector = 0; sector < sectors; sector += batch) {
+        u32 count = (sectors - sector < batch) ? sectors - sector : batch;
+        u64 lba = partition_offset + fat_start_lba + sector;
+        if (blk_device->read_sectors(lba, count, buffer) != IOResult::Success) {
+            ok = false;
+            break;
+        }
+        
+        const u32* entries = reinterpret_cast<const u32*>(buffer);
+        u32 base = sector * per_sector;
+        for (u32 i = 0; i < count * per_sector; i++) {
+            u32 cluster = base + i;
+            if (cluster < 2) continue;
+            if (cluster >= limit) break;
             
-            // Zero out the cluster
-            mem::memset(cluster_buffer, 0, cluster_size);
-            write_cluster(cluster, cluster_buffer);
+            u32 value = entries[i] & 0x0FFFFFFF;
+            if (value == 0 || value == 0x0FFFFFF7) {
+                if (extent) {
+                    stats.extent_hist[length_bucket(extent)]++;
+                    stats.extents++;
+                    extent = 0;
+                }
+                if (value == 0) {
+                    map_set(free_map, cluster);
+                    stats.free_clusters++;
+                    if (first_free == 0) first_free = cluster;
+                    free_run++;
+                } else {
+                    stats.bad_clusters++;
+                }
+                continue;
+            }
+            
+            if (free_run) {
+                stats.free_hist[length_bucket(free_run)]++;
+                stats.free_runs++;
+                if (free_run > stats.largest_free_run) stats.largest_free_run = free_run;
+                free_run = 0;
+            }
             
-            DBG_OK("FAT32", "Allocated cluster");
-            return cluster;
+            stats.used_clusters++;
+            if (value >= 2 && value < limit) links++;
+            
+            // An extent continues while each cluster links to the next one
+            extent++;
+            if (value != cluster + 1) {
+                stats.extent_hist[length_bucket(extent)]++;
+                stats.extents++;
+                extent = 0;
+            }
+        }
+    }
+    
+    Heap::free(buffer);
+    
+    if (!ok) {
+        Heap::free(free_map);
+        free_map = nullptr;
+        DBG_FAIL("FAT32", "Space scan could not read the FAT");
+        return false;
+    }
+    
+    if (extent) {
+        stats.extent_hist[length_bucket(extent)]++;
+        stats.extents++;
+    }
+    if (free_run) {
+        stats.free_hist[length_bucket(free_run)]++;
+        stats.free_runs++;
+        if (free_run > stats.largest_free_run) stats.largest_free_run = free_run;
+    }
+    
+    stats.chains = stats.used_clusters > links ? stats.used_clusters - links : 0;
+    stats.scan_ms = PIT::get_milliseconds() - start;
+    stats.valid = true;
+    space_stats = stats;
+    
+    if (free_count_valid && free_clusters != stats.free_clusters) {
+        DBG_WARN("FAT32", "FSInfo free count was stale, corrected");
+    }
+    free_clusters = stats.free_clusters;
+    free_count_valid = true;
+    if (first_free) next_free_cluster = first_free;
+    
+    DBG_OK("FAT32", "Space map built");
+    return true;
+}
+
+// ===========================================================================
+// FAT Write Operations
+// ===========================================================================
+
+bool FAT32Filesystem::set_fat_entry(u32 cluster, u32 value) {
+    u32 per_sector = bytes_per_sector / 4;
+    
+    DBG_DEBUG("FAT32", "set_fat_entry");
+    
+    // Modify the cached sector; commit_fat() writes it to all FAT copies
+    u32* entries = fat_sector(cluster / per_sector, true);
+    if (!entries) {
+        DBG_FAIL("FAT32", "Failed to read FAT sector");
+        return false;
+    }
+    
+    u32& entry = entries[cluster % per_sector];
+    bool was_free = (entry & 0x0FFFFFFF) == 0;
+    entry = (entry & 0xF0000000) | (value & 0x0FFFFFFF);
+    
+    // Keep the space map in step
+    if (free_map) {
+        bool now_free = (value & 0x0FFFFFFF) == 0;
+        if (was_free && !now_free) {
+            free_map[cluster / 8] &= ~(1 << (cluster % 8));
+        } else if (!was_free && now_free) {
+            map_set(free_map, cluster);
         }
     }
+    return true;
+}
+
+u32 FAT32Filesystem::alloc_cluster() {
+    DBG_DEBUG("FAT32", "alloc_cluster: Finding free cluster");
+    
+    u32 cluster, length;
+    if (!alloc_extent(1, next_free_cluster, cluster, length)) {
+        return 0;
+    }
+    
+    // Zero out the cluster
+    mem::memset(cluster_buffer, 0, cluster_size);
+    write_cluster(cluster, cluster_buffer);
     
-    DBG_FAIL("FAT32", "No free clusters");
-    return 0;  // No free cluster found
+    DBG_OK("FAT32", "Allocated cluster");
+    return cluster;
 }
 
 u32 FAT32Filesystem::extend_cluster_chain(u32 last_cluster) {
@@ -373,6 +1141,103 @@ u32 FAT32Filesystem::extend_cluster_chain(u32 last_cluster) {
     return new_cluster;
 }
 
+// First free run of count clusters at or after hint, else the longest
+// run on the volume. The run is linked and terminated in the FAT. With a
+// space map the search reads the bitmap instead of FAT entries.
+bool FAT32Filesystem::alloc_extent(u32 count, u32 hint, u32& first, u32& length) {
+    DBG_DEBUG("FAT32", "alloc_extent: Finding contiguous clusters");
+    
+    if (hint < 2 || hint >= total_clusters + 2) hint = 2;
+    
+    u32 best_start = 0;
+    u32 best_len = 0;
+    u32 run_start = 0;
+    u32 run_len = 0;
+    
+    for (u32 offset = 0; offset < total_clusters; offset++) {
+        u32 cluster = hint + offset;
+        if (cluster >= total_clusters + 2) {
+            cluster -= total_clusters;  // Wrap around
+        }
+        if (cluster == 2) run_len = 0;  // Runs cannot span the wrap
+        
+        bool is_free;
+        if (free_map) {
+            // Skip bytes of fully allocated clusters at once
+            if ((cluster % 8) == 0 && free_map[cluster / 8] == 0 &&
+                cluster + 8 <= total_clusters + 2 && offset + 8 <= total_clusters) {
+                run_len = 0;
+                offset += 7;
+                continue;
+            }
+            is_free = map_test(free_map, cluster);
+        } else {
+            u32 value;
+            if (!read_fat_entry(cluster, value)) {
+                return false;
+            }
+            is_free = value == 0;
+        }
+        if (!is_free) {
+            run_len = 0;
+            continue;
+        }
+        
+        if (run_len == 0) run_start = cluster;
+        run_len++;
+        if (run_len > best_len) {
+            best_start = run_start;
+            best_len = run_len;
+        }
+        if (run_len == count) break;
+    }
+    
+    if (best_len == 0) {
+        DBG_FAIL("FAT32", "No free clusters");
+        return false;
+    }
+    
+    if (!set_fat_run(best_start, best_len)) {
+        return false;
+    }
+    
+    next_free_cluster = best_start + best_len;
+    free_clusters = free_clusters > best_len ? free_clusters - best_len : 0;
+    
+    first = best_start;
+    length = best_len;
+    return true;
+}
+
+// Chain first..first+count-1 and mark the end, touching each FAT sector
+// once. Runs longer than the FAT cache push older sectors out early.
+bool FAT32Filesystem::set_fat_run(u32 first, u32 count) {
+    u32 per_sector = bytes_per_sector / 4;
+    u32 end = first + count;
+    u32 cluster = first;
+    
+    while (cluster < end) {
+        u32 sector = cluster / per_sector;
+        u32* entries = fat_sector(sector, true);
+        if (!entries) {
+            DBG_FAIL("FAT32", "Failed to read FAT sector");
+            return false;
+        }
+        
+        u32 base = sector * per_sector;
+        u32 limit = base + per_sector;
+        for (; cluster < end && cluster < limit; cluster++) {
+            u32 value = (cluster + 1 < end) ? cluster + 1 : 0x0FFFFFFF;
+            entries[cluster - base] = (entries[cluster - base] & 0xF0000000) | value;
+            if (free_map) {
+                free_map[cluster / 8] &= ~(1 << (cluster % 8));
+            }
+        }
+    }
+    
+    return true;
+}
+
 bool FAT32Filesystem::free_cluster_chain(u32 start_cluster) {
     DBG_DEBUG("FAT32", "free_cluster_chain");
     
@@ -396,130 +1261,724 @@ bool FAT32Filesystem::free_cluster_chain(u32 start_cluster) {
 }
 
 // ===========================================================================
-// Directory Write Operations
+// Directory Index
 // ===========================================================================
 
-u32 FAT32Filesystem::find_free_dir_entry(u32 parent_cluster) {
-    u32 cluster = parent_cluster;
+// FNV-1a over the 11-byte 8.3 name, folded to upper case
+static u32 hash_name83(const char* name83) {
+    u32 hash = 2166136261u;
+    for (int i = 0; i < 11; i++) {
+        char c = name83[i];
+        if (c >= 'a' && c <= 'z') c -= 32;
+        hash = (hash ^ static_cast<u8>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+static bool match_name83(const char* a, const char* b) {
+    for (int i = 0; i < 11; i++) {
+        char ca = a[i];
+        char cb = b[i];
+        if (ca >= 'a' && ca <= 'z') ca -= 32;
+        if (cb >= 'a' && cb <= 'z') cb -= 32;
+        if (ca != cb) return false;
+    }
+    return true;
+}
+
+// FNV-1a over a NUL-terminated long name, ASCII folded to upper case
+static u32 hash_long_name(const char* name) {
+    u32 hash = 2166136261u;
+    while (*name) {
+        char c = *name++;
+        if (c >= 'a' && c <= 'z') c -= 32;
+        hash = (hash ^ static_cast<u8>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+static bool match_long_name(const char* a, const char* b) {
+    while (*a && *b) {
+        char ca = *a++;
+        char cb = *b++;
+        if (ca >= 'a' && ca <= 'z') ca -= 32;
+        if (cb >= 'a' && cb <= 'z') cb -= 32;
+        if (ca != cb) return false;
+    }
+    return *a == *b;
+}
+
+// Double a heap array, starting at 32 elements
+static void* grow_array(void* old, u32 count, u32& capacity, u32 elem_size) {
+    u32 new_capacity = capacity ? capacity * 2 : 32;
+    void* array = Heap::alloc(new_capacity * elem_size, MemTag::FAT32);
+    if (!array) return nullptr;
+    if (old) {
+        mem::memcpy(array, old, count * elem_size);
+        Heap::free(old);
+    }
+    capacity = new_capacity;
+    return array;
+}
+
+void FAT32DirIndex::reset(u32 cluster) {
+    dir_cluster = cluster;
+    last_cluster = cluster;
+    end_cluster = 0;
+    end_slot = 0;
+    has_end = false;
+    stamp = 0;
+    node_count = 0;
+    free_count = 0;
+    names_used = 0;
+    
+    // Back to the inline table; the next build sizes it again
+    if (buckets && buckets != inline_buckets) Heap::free(buckets);
+    buckets = inline_buckets;
+    lbuckets = inline_buckets + MIN_BUCKETS;
+    bucket_count = MIN_BUCKETS;
+    for (u32 i = 0; i < 2 * MIN_BUCKETS; i++) {
+        inline_buckets[i] = NIL;
+    }
+}
+
+void FAT32DirIndex::release() {
+    if (nodes) Heap::free(nodes);
+    if (free_slots) Heap::free(free_slots);
+    if (names) Heap::free(names);
+    nodes = nullptr;
+    free_slots = nullptr;
+    names = nullptr;
+    node_capacity = 0;
+    free_capacity = 0;
+    names_capacity = 0;
+    reset(0);
+}
+
+FAT32DirIndex::Node* FAT32DirIndex::find(const char* name83) {
+    u32 bucket = hash_name83(name83) & (bucket_count - 1);
+    for (u32 i = buckets[bucket]; i != NIL; i = nodes[i].next) {
+        if (match_name83(reinterpret_cast<const char*>(nodes[i].entry.name), name83)) {
+            return &nodes[i];
+        }
+    }
+    return nullptr;
+}
+
+FAT32DirIndex::Node* FAT32DirIndex::find_long(const char* name) {
+    u32 bucket = hash_long_name(name) & (bucket_count - 1);
+    for (u32 i = lbuckets[bucket]; i != NIL; i = nodes[i].lnext) {
+        if (match_long_name(names + nodes[i].long_name, name)) {
+            return &nodes[i];
+        }
+    }
+    return nullptr;
+}
+
+// Linear; only for positions whose name lookup was ambiguous
+FAT32DirIndex::Node* FAT32DirIndex::find_at(u32 cluster, u32 slot) {
+    for (u32 i = 0; i < node_count; i++) {
+        if (nodes[i].cluster == cluster && nodes[i].slot == slot) {
+            return &nodes[i];
+        }
+    }
+    return nullptr;
+}
+
+// Push node `index` onto the heads of its bucket chains
+void FAT32DirIndex::link(u32 index) {
+    Node& node = nodes[index];
+    u32 bucket = hash_name83(reinterpret_cast<const char*>(node.entry.name)) & (bucket_count - 1);
+    node.next = buckets[bucket];
+    buckets[bucket] = index;
+    
+    node.lnext = NIL;
+    if (node.long_name != NO_NAME) {
+        u32 lbucket = hash_long_name(names + node.long_name) & (bucket_count - 1);
+        node.lnext = lbuckets[lbucket];
+        lbuckets[lbucket] = index;
+    }
+}
+
+// Rehash into a table big enough for `count` entries. Without heap room
+// the current table stays; lookups only get slower.
+void FAT32DirIndex::grow_buckets(u32 count) {
+    u32 target = bucket_count;
+    while (target < MAX_BUCKETS && target * 2 < count) target *= 2;
+    if (target == bucket_count) return;
+    
+    u32* table = static_cast<u32*>(Heap::alloc(2 * target * sizeof(u32), MemTag::FAT32));
+    if (!table) return;
+    if (buckets != inline_buckets) Heap::free(buckets);
+    
+    buckets = table;
+    lbuckets = table + target;
+    bucket_count = target;
+    for (u32 i = 0; i < 2 * target; i++) {
+        table[i] = NIL;
+    }
+    for (u32 i = 0; i < node_count; i++) {
+        link(i);
+    }
+}
+
+bool FAT32DirIndex::insert(const FAT32DirEntry& entry, u32 cluster, u32 slot, const char* long_name,
+                           u32 lfn_cluster, u32 lfn_slot, u32 lfn_count) {
+    if (node_count == node_capacity) {
+        void* grown = grow_array(nodes, node_count, node_capacity, sizeof(Node));
+        if (!grown) return false;
+        nodes = static_cast<Node*>(grown);
+    }
+    
+    Node& node = nodes[node_count];
+    node.long_name = NO_NAME;
+    
+    if (long_name) {
+        u32 len = str::len(long_name) + 1;
+        while (names_used + len > names_capacity) {
+            void* grown = grow_array(names, names_used, names_capacity, 1);
+            if (!grown) return false;
+            names = static_cast<char*>(grown);
+        }
+        str::cpy(names + names_used, long_name);
+        node.long_name = names_used;
+        names_used += len;
+    }
+    
+    node.entry = entry;
+    node.cluster = cluster;
+    node.slot = static_cast<u16>(slot);
+    node.lfn_cluster = lfn_cluster;
+    node.lfn_slot = static_cast<u16>(lfn_slot);
+    node.lfn_count = static_cast<u8>(lfn_count);
+    
+    if (node_count >= 2 * bucket_count) grow_buckets(node_count + 1);
+    link(node_count++);
+    return true;
+}
+
+void FAT32DirIndex::remove(Node* node) {
+    u32 index = static_cast<u32>(node - nodes);
+    u32 last = node_count - 1;
+    u32 mask = bucket_count - 1;
+    
+    // Unlink from its bucket chains
+    u32* chain = &buckets[hash_name83(reinterpret_cast<const char*>(node->entry.name)) & mask];
+    while (*chain != index) chain = &nodes[*chain].next;
+    *chain = node->next;
+    if (node->long_name != NO_NAME) {
+        chain = &lbuckets[hash_long_name(names + node->long_name) & mask];
+        while (*chain != index) chain = &nodes[*chain].lnext;
+        *chain = node->lnext;
+    }
+    
+    // Move the last node into the hole so the array stays dense
+    if (index != last) {
+        Node& moved = nodes[last];
+        chain = &buckets[hash_name83(reinterpret_cast<const char*>(moved.entry.name)) & mask];
+        while (*chain != last) chain = &nodes[*chain].next;
+        *chain = index;
+        if (moved.long_name != NO_NAME) {
+            chain = &lbuckets[hash_long_name(names + moved.long_name) & mask];
+            while (*chain != last) chain = &nodes[*chain].lnext;
+            *chain = index;
+        }
+        nodes[index] = moved;
+    }
+    node_count--;
+}
+
+bool FAT32DirIndex::push_free(u32 cluster, u32 slot) {
+    if (free_count == free_capacity) {
+        void* grown = grow_array(free_slots, free_count, free_capacity, sizeof(FreeSlot));
+        if (!grown) return false;
+        free_slots = static_cast<FreeSlot*>(grown);
+    }
+    free_slots[free_count].cluster = cluster;
+    free_slots[free_count].slot = slot;
+    free_count++;
+    return true;
+}
+
+FAT32DirIndex* FAT32Filesystem::get_dir_index(u32 dir_cluster) {
+    if (dir_cluster == 0) dir_cluster = root_cluster;
+    
+    FAT32DirIndex* victim = &dir_index[0];
+    for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+        if (dir_index[i].dir_cluster == dir_cluster) {
+            dir_index[i].stamp = ++dir_index_clock;
+            return &dir_index[i];
+        }
+        if (dir_index[i].stamp < victim->stamp) {
+            victim = &dir_index[i];
+        }
+    }
+    
+    // Not cached - evict the least recently used index and rebuild. A
+    // failed build is usually the heap: give the other indexes back (no
+    // caller holds one across this call) and try once more.
+    if (!build_dir_index(victim, dir_cluster)) {
+        DBG_WARN("FAT32", "Directory index build failed, retrying with cache released");
+        for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+            dir_index[i].release();
+        }
+        if (!build_dir_index(victim, dir_cluster)) {
+            DBG_FAIL("FAT32", "Failed to index directory");
+            victim->reset(0);
+            return nullptr;
+        }
+    }
+    victim->stamp = ++dir_index_clock;
+    return victim;
+}
+
+// One pass over the directory chain: live entries go into the hash,
+// deleted slots into the free list, and the end marker is remembered.
+bool FAT32Filesystem::build_dir_index(FAT32DirIndex* index, u32 dir_cluster) {
+    index->reset(dir_cluster);
+    lfn_scratch.reset();
+    
+    u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
+    u32 cluster = dir_cluster;
     
     while (cluster >= 2 && cluster < 0x0FFFFFF8) {
         if (!read_cluster(cluster, cluster_buffer)) {
-            return 0xFFFFFFFF;
+            return false;
         }
+        index->last_cluster = cluster;
         
-        FAT32DirEntry* entries = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
-        u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
+        const FAT32DirEntry* entries = reinterpret_cast<const FAT32DirEntry*>(cluster_buffer);
+        for (u32 i = 0; i < entries_per_cluster; i++) {
+            if (entries[i].is_end()) {
+                index->end_cluster = cluster;
+                index->end_slot = i;
+                index->has_end = true;
+                return true;
+            }
+            
+            if (entries[i].is_free()) {
+                lfn_scratch.reset();
+                if (!index->push_free(cluster, i)) return false;
+            } else if (entries[i].is_lfn()) {
+                lfn_scratch.feed(reinterpret_cast<const FAT32LFNEntry&>(entries[i]), cluster, i);
+            } else if (entries[i].is_volume_label()) {
+                lfn_scratch.reset();
+            } else {
+                // Capture the run position before finish() clears it
+                u32 lfn_cluster = lfn_scratch.start_cluster;
+                u32 lfn_slot = lfn_scratch.start_slot;
+                u32 lfn_count = lfn_scratch.count;
+                char long_name[256];
+                if (!lfn_scratch.finish(entries[i], long_name, sizeof(long_name))) {
+                    if (!index->insert(entries[i], cluster, i, nullptr, 0, 0, 0)) return false;
+                } else if (!index->insert(entries[i], cluster, i, long_name,
+                                          lfn_cluster, lfn_slot, lfn_count)) {
+                    return false;
+                }
+            }
+        }
+        
+        cluster = get_next_cluster(cluster);
+    }
+    
+    return true;
+}
+
+void FAT32Filesystem::drop_dir_index(u32 dir_cluster) {
+    for (u32 i = 0; i < DIR_INDEX_CACHE; i++) {
+        if (dir_index[i].dir_cluster == dir_cluster) {
+            dir_index[i].reset(0);
+        }
+    }
+}
+
+// ===========================================================================
+// VFAT Long File Names
+// ===========================================================================
+
+static u8 lfn_checksum(const char* name83) {
+    u8 sum = 0;
+    for (int i = 0; i < 11; i++) {
+        sum = static_cast<u8>(((sum & 1) << 7) + (sum >> 1) + static_cast<u8>(name83[i]));
+    }
+    return sum;
+}
+
+// Decode UTF-8 into UCS-2; returns the length, or 0 if it exceeds max.
+// Sequences outside the BMP or malformed bytes become '_'.
+static u32 utf8_to_ucs2(const char* in, u16* out, u32 max) {
+    const u8* p = reinterpret_cast<const u8*>(in);
+    u32 len = 0;
+    
+    while (*p) {
+        if (len >= max) return 0;
+        
+        u16 c;
+        if (p[0] < 0x80) {
+            c = p[0];
+            p += 1;
+        } else if ((p[0] & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+            c = static_cast<u16>(((p[0] & 0x1F) << 6) | (p[1] & 0x3F));
+            p += 2;
+        } else if ((p[0] & 0xF0) == 0xE0 && (p[1] & 0xC0) == 0x80 && (p[2] & 0xC0) == 0x80) {
+            c = static_cast<u16>(((p[0] & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F));
+            p += 3;
+        } else {
+            c = '_';
+            p += 1;
+        }
+        out[len++] = c;
+    }
+    
+    return len;
+}
+
+void FAT32LFNState::feed(const FAT32LFNEntry& lfn, u32 cluster, u32 slot) {
+    u32 order = lfn.order & 0x1F;
+    
+    if (lfn.order & 0x40) {
+        // The last fragment of the name is stored first and opens a run
+        if (order == 0 || order > MAX_ENTRIES) {
+            reset();
+            return;
+        }
+        checksum = lfn.checksum;
+        total = static_cast<u8>(order);
+        count = 0;
+        start_cluster = cluster;
+        start_slot = slot;
+    } else if (count == 0 || order != expect || lfn.checksum != checksum) {
+        reset();
+        return;
+    }
+    
+    u16* dst = &chars[(order - 1) * CHARS_PER_ENTRY];
+    for (int i = 0; i < 5; i++) *dst++ = lfn.name1[i];
+    for (int i = 0; i < 6; i++) *dst++ = lfn.name2[i];
+    for (int i = 0; i < 2; i++) *dst++ = lfn.name3[i];
+    
+    expect = static_cast<u8>(order - 1);
+    count++;
+}
+
+bool FAT32LFNState::finish(const FAT32DirEntry& entry, char* out, u32 out_size) {
+    bool valid = count > 0 && expect == 0 &&
+                 checksum == lfn_checksum(reinterpret_cast<const char*>(entry.name));
+    u32 limit = total * CHARS_PER_ENTRY;
+    reset();
+    if (!valid) return false;
+    
+    // UCS-2 to UTF-8, stopping at the 0x0000 terminator or 0xFFFF padding
+    u32 pos = 0;
+    for (u32 i = 0; i < limit && chars[i] != 0x0000 && chars[i] != 0xFFFF; i++) {
+        u16 c = chars[i];
+        u32 need = c < 0x80 ? 1 : (c < 0x800 ? 2 : 3);
+        if (pos + need >= out_size) break;
+        
+        if (need == 1) {
+            out[pos++] = static_cast<char>(c);
+        } else if (need == 2) {
+            out[pos++] = static_cast<char>(0xC0 | (c >> 6));
+            out[pos++] = static_cast<char>(0x80 | (c & 0x3F));
+        } else {
+            out[pos++] = static_cast<char>(0xE0 | (c >> 12));
+            out[pos++] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            out[pos++] = static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    out[pos] = '\0';
+    return pos > 0;
+}
+
+// Choose the 8.3 name for a new entry. Names that are already plain
+// upper-case 8.3 are stored as-is; anything else gets a unique alias
+// (BASE~N.EXT) and needs_lfn is set so the real name goes in LFN entries.
+bool FAT32Filesystem::make_short_name(FAT32DirIndex* index, const char* name, char* out83, bool& needs_lfn) {
+    to_8_3_name(name, out83);
+    
+    char round_trip[13];
+    format_short_name(out83, round_trip);
+    needs_lfn = out83[0] == ' ' || str::cmp(round_trip, name) != 0;
+    for (const char* p = name; *p && !needs_lfn; p++) {
+        u8 c = static_cast<u8>(*p);
+        if (c >= 0x80 || c == '+' || c == ',' || c == ';' || c == '=' || c == '[' || c == ']') {
+            needs_lfn = true;
+        }
+    }
+    if (!needs_lfn) return true;
+    
+    // Basis name: upper case, spaces and inner dots dropped, invalid chars as '_'
+    const char* dot = nullptr;
+    for (const char* p = name + 1; *p; p++) {
+        if (*p == '.') dot = p;
+    }
+    
+    char base[8];
+    char ext[3];
+    u32 base_len = 0;
+    u32 ext_len = 0;
+    bool lossy = false;
+    
+    for (const char* p = name; *p; p++) {
+        u8 c = static_cast<u8>(*p);
+        if (p == dot) continue;
+        if (c == ' ' || c == '.') {
+            lossy = true;
+            continue;
+        }
+        if (c >= 'a' && c <= 'z') {
+            c -= 32;
+        } else if (c >= 0x80 || c == '+' || c == ',' || c == ';' || c == '=' || c == '[' || c == ']') {
+            c = '_';
+            lossy = true;
+        }
+        
+        if (dot && p > dot) {
+            if (ext_len < 3) ext[ext_len++] = static_cast<char>(c);
+            else lossy = true;
+        } else {
+            if (base_len < 8) base[base_len++] = static_cast<char>(c);
+            else lossy = true;
+        }
+    }
+    if (base_len == 0) lossy = true;
+    
+    // Only the case differs: try the plain name first, then numeric tails
+    for (u32 n = lossy ? 1 : 0; n < 1000000; n++) {
+        char tail[8];
+        u32 tail_len = 0;
+        if (n > 0) {
+            tail[0] = '~';
+            str::utoa(n, tail + 1);
+            tail_len = str::len(tail);
+        }
+        
+        u32 keep = base_len;
+        if (keep > 8 - tail_len) keep = 8 - tail_len;
+        
+        str::set(out83, ' ', 11);
+        for (u32 i = 0; i < keep; i++) out83[i] = base[i];
+        for (u32 i = 0; i < tail_len; i++) out83[keep + i] = tail[i];
+        for (u32 i = 0; i < ext_len; i++) out83[8 + i] = ext[i];
+        
+        if (!index->find(out83)) return true;
+    }
+    
+    return false;
+}
+
+// ===========================================================================
+// Directory Write Operations
+// ===========================================================================
+
+bool FAT32Filesystem::advance_slot(u32& cluster, u32& slot) {
+    if (++slot < cluster_size / sizeof(FAT32DirEntry)) return true;
+    
+    u32 next = get_next_cluster(cluster);
+    if (next == 0) return false;
+    cluster = next;
+    slot = 0;
+    return true;
+}
+
+// Reserve count consecutive slots. Single entries reuse deleted slots;
+// longer runs (LFN + short entry) go at the end marker, growing the
+// chain as needed. at_end tells the caller the run replaced the marker.
+bool FAT32Filesystem::find_free_dir_entry(FAT32DirIndex* index, u32 count,
+                                          u32& cluster, u32& slot, bool& at_end) {
+    if (count == 1 && index->free_count > 0) {
+        index->free_count--;
+        cluster = index->free_slots[index->free_count].cluster;
+        slot = index->free_slots[index->free_count].slot;
+        at_end = false;
+        return true;
+    }
+    
+    // No room left past the entries, extend directory (new clusters come back zeroed)
+    if (!index->has_end) {
+        u32 new_cluster = extend_cluster_chain(index->last_cluster);
+        if (new_cluster == 0) {
+            return false;
+        }
+        index->last_cluster = new_cluster;
+        index->end_cluster = new_cluster;
+        index->end_slot = 0;
+        index->has_end = true;
+    }
+    
+    // Make sure the chain holds the whole run
+    u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
+    u32 room = entries_per_cluster - index->end_slot;
+    u32 tail = index->end_cluster;
+    while (room < count) {
+        u32 next = get_next_cluster(tail);
+        if (next == 0) {
+            next = extend_cluster_chain(tail);
+            if (next == 0) return false;
+            index->last_cluster = next;
+        }
+        tail = next;
+        room += entries_per_cluster;
+    }
+    
+    cluster = index->end_cluster;
+    slot = index->end_slot;
+    at_end = true;
+    
+    // Move the end marker past the run
+    for (u32 i = 0; i < count; i++) {
+        if (!advance_slot(index->end_cluster, index->end_slot)) {
+            index->has_end = false;
+            break;
+        }
+    }
+    
+    return true;
+}
+
+// Write count entries starting at (cluster, slot), following the chain.
+// With entries == nullptr the slots are marked deleted instead.
+bool FAT32Filesystem::write_dir_slots(u32 cluster, u32 slot, const FAT32DirEntry* entries, u32 count) {
+    if (!read_cluster(cluster, cluster_buffer)) {
+        return false;
+    }
+    
+    FAT32DirEntry* slots = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
+    for (u32 i = 0; i < count; i++) {
+        if (entries) {
+            slots[slot] = entries[i];
+        } else {
+            slots[slot].name[0] = static_cast<char>(0xE5);
+        }
+        if (i + 1 == count) break;
         
-        for (u32 i = 0; i < entries_per_cluster; i++) {
-            if (entries[i].is_end() || entries[i].is_free()) {
-                // Found a free slot
-                // Return combined info: (cluster << 16) | index_in_cluster
-                return (cluster << 16) | i;
+        // Crossing into the next cluster: flush this one first
+        u32 prev = cluster;
+        if (!advance_slot(cluster, slot)) return false;
+        if (cluster != prev) {
+            if (!write_cluster(prev, cluster_buffer) || !read_cluster(cluster, cluster_buffer)) {
+                return false;
             }
         }
-        
-        cluster = get_next_cluster(cluster);
-    }
-    
-    // No free entry, need to extend directory
-    u32 last_cluster = parent_cluster;
-    while (true) {
-        u32 next = get_next_cluster(last_cluster);
-        if (next == 0 || next >= 0x0FFFFFF8) break;
-        last_cluster = next;
     }
     
-    // Allocate new cluster for directory
-    u32 new_cluster = extend_cluster_chain(last_cluster);
-    if (new_cluster == 0) {
-        return 0xFFFFFFFF;
-    }
-    
-    // Return first entry in new cluster
-    return (new_cluster << 16) | 0;
+    return write_cluster(cluster, cluster_buffer);
 }
 
 bool FAT32Filesystem::create_dir_entry(u32 parent_cluster, const char* name, u8 attr, 
-                                       u32 file_cluster, u32 file_size) {
+                                       u32 file_cluster, u32 file_size, char* out_name83) {
+    FAT32DirEntry entry;
+    mem::memset(&entry, 0, sizeof(FAT32DirEntry));
+    entry.attributes = attr;
+    entry.set_cluster(file_cluster);
+    entry.file_size = file_size;
+    
+    return link_dir_entry(parent_cluster, name, entry, out_name83);
+}
+
+// Write a new name into parent_cluster for the entry described by source.
+// Attributes, timestamps, first cluster and size are taken from source.
+bool FAT32Filesystem::link_dir_entry(u32 parent_cluster, const char* name, 
+                                     const FAT32DirEntry& source, char* out_name83) {
     DBG_DEBUG("FAT32", "create_dir_entry");
     Serial::log("FAT32", LogType::Debug, "  Name: ", name);
     
-    // Find a free slot
-    u32 slot = find_free_dir_entry(parent_cluster);
-    if (slot == 0xFFFFFFFF) {
-        DBG_FAIL("FAT32", "No free directory entry");
-        return false;
-    }
+    FAT32DirIndex* index = get_dir_index(parent_cluster);
+    if (!index) return false;
     
-    u32 cluster = slot >> 16;
-    u32 entry_index = slot & 0xFFFF;
-    
-    // Debug: print slot info
-    char slot_info[64];
-    slot_info[0] = 'S'; slot_info[1] = 'l'; slot_info[2] = 'o'; slot_info[3] = 't';
-    slot_info[4] = ' '; slot_info[5] = 'c'; slot_info[6] = 'l'; slot_info[7] = 'u';
-    slot_info[8] = 's'; slot_info[9] = 't'; slot_info[10] = 'e'; slot_info[11] = 'r';
-    slot_info[12] = '='; int pos = 13;
-    if (cluster == 0) { slot_info[pos++] = '0'; }
-    else { char digits[12]; int dpos = 0; u32 tmp = cluster;
-           while (tmp > 0) { digits[dpos++] = '0' + (tmp % 10); tmp /= 10; }
-           while (dpos > 0) slot_info[pos++] = digits[--dpos]; }
-    slot_info[pos++] = ' '; slot_info[pos++] = 'i'; slot_info[pos++] = 'n';
-    slot_info[pos++] = 'd'; slot_info[pos++] = 'e'; slot_info[pos++] = 'x'; slot_info[pos++] = '=';
-    if (entry_index == 0) { slot_info[pos++] = '0'; }
-    else { char digits[12]; int dpos = 0; u32 tmp = entry_index;
-           while (tmp > 0) { digits[dpos++] = '0' + (tmp % 10); tmp /= 10; }
-           while (dpos > 0) slot_info[pos++] = digits[--dpos]; }
-    slot_info[pos] = '\0';
-    Serial::log("FAT32", LogType::Debug, slot_info);
-    
-    // Read the cluster
-    if (!read_cluster(cluster, cluster_buffer)) {
-        DBG_FAIL("FAT32", "Cannot read cluster for entry");
+    char name83[11];
+    bool needs_lfn;
+    if (!make_short_name(index, name, name83, needs_lfn)) {
+        DBG_FAIL("FAT32", "No short name available");
         return false;
     }
     
-    FAT32DirEntry* entries = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
-    FAT32DirEntry& entry = entries[entry_index];
+    // Build the run: LFN fragments (highest order first), short entry,
+    // and room for a new end marker
+    constexpr u32 MAX_CHARS = FAT32LFNState::MAX_ENTRIES * FAT32LFNState::CHARS_PER_ENTRY;
+    FAT32DirEntry run[FAT32LFNState::MAX_ENTRIES + 2];
+    u32 lfn_count = 0;
+    
+    if (needs_lfn) {
+        u16 ucs[MAX_CHARS];
+        u32 len = utf8_to_ucs2(name, ucs, 255);
+        if (len == 0) {
+            DBG_FAIL("FAT32", "Name too long");
+            return false;
+        }
+        
+        lfn_count = (len + FAT32LFNState::CHARS_PER_ENTRY - 1) / FAT32LFNState::CHARS_PER_ENTRY;
+        u8 checksum = lfn_checksum(name83);
+        
+        for (u32 k = 0; k < lfn_count; k++) {
+            u32 order = lfn_count - k;
+            FAT32LFNEntry& lfn = reinterpret_cast<FAT32LFNEntry&>(run[k]);
+            lfn.order = static_cast<u8>(order | (k == 0 ? 0x40 : 0));
+            lfn.attributes = 0x0F;
+            lfn.type = 0;
+            lfn.checksum = checksum;
+            lfn.first_cluster = 0;
+            
+            // Terminate with 0x0000, then pad with 0xFFFF
+            u32 first = (order - 1) * FAT32LFNState::CHARS_PER_ENTRY;
+            for (u32 j = 0; j < FAT32LFNState::CHARS_PER_ENTRY; j++) {
+                u32 i = first + j;
+                u16 c = i < len ? ucs[i] : (i == len ? 0x0000 : 0xFFFF);
+                if (j < 5) lfn.name1[j] = c;
+                else if (j < 11) lfn.name2[j - 5] = c;
+                else lfn.name3[j - 11] = c;
+            }
+        }
+    }
     
-    // Check if current slot was an end marker - we'll need to set a new one
-    bool was_end_marker = entry.is_end();
-    Serial::log("FAT32", LogType::Debug, was_end_marker ? "  Was end marker" : "  Reusing free slot");
+    FAT32DirEntry& entry = run[lfn_count];
+    entry = source;
+    mem::memcpy(&entry, name83, 11);  // name[8] + ext[3]
+    entry.reserved = 0;               // Case flags belong to the old name
     
-    // Convert name to 8.3 format - write to the full 11-byte name region (name[8]+ext[3])
-    char* entry_name = reinterpret_cast<char*>(&entry.name[0]);
-    to_8_3_name(name, entry_name);
+    u32 count = lfn_count + 1;
+    u32 cluster, slot;
+    bool at_end;
+    if (!find_free_dir_entry(index, count, cluster, slot, at_end)) {
+        DBG_FAIL("FAT32", "No free directory entry");
+        return false;
+    }
     
-    // Set attributes
-    entry.attributes = attr;
-    entry.reserved = 0;
-    entry.create_time_tenths = 0;
-    entry.create_time = 0;
-    entry.create_date = 0;
-    entry.access_date = 0;
-    entry.modify_time = 0;
-    entry.modify_date = 0;
-    entry.set_cluster(file_cluster);
-    entry.file_size = file_size;
+    // If we overwrote the end marker, the slot after the run becomes the new one
+    u32 write_count = count;
+    if (at_end && index->has_end) {
+        mem::memset(&run[count], 0, sizeof(FAT32DirEntry));
+        write_count++;
+    }
     
-    // If we overwrote an end marker, set the next entry as end marker
-    u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
-    if (was_end_marker && entry_index + 1 < entries_per_cluster) {
-        // Set next entry as end marker (zero out the entry)
-        FAT32DirEntry* next = &entries[entry_index + 1];
-        for (u32 k = 0; k < sizeof(FAT32DirEntry); k++) {
-            reinterpret_cast<u8*>(next)[k] = 0;
-        }
-        DBG_DEBUG("FAT32", "  Set new end marker");
+    // Clusters the entry refers to, and any directory growth, are linked
+    // in the FAT before the entry itself is written
+    if (!commit_fat()) {
+        return false;
     }
     
-    // Write back
-    DBG_DEBUG("FAT32", "  Writing cluster");
-    if (!write_cluster(cluster, cluster_buffer)) {
+    DBG_DEBUG("FAT32", "  Writing entries");
+    if (!write_dir_slots(cluster, slot, run, write_count)) {
         DBG_FAIL("FAT32", "Failed to write directory entry");
+        drop_dir_index(index->dir_cluster);
         return false;
     }
     
+    // Keep the index in step with the new entry
+    u32 entry_cluster = cluster;
+    u32 entry_slot = slot;
+    for (u32 i = 0; i < lfn_count; i++) {
+        advance_slot(entry_cluster, entry_slot);
+    }
+    if (!index->insert(entry, entry_cluster, entry_slot, needs_lfn ? name : nullptr,
+                       cluster, slot, lfn_count)) {
+        drop_dir_index(index->dir_cluster);
+    }
+    
+    if (out_name83) {
+        mem::memcpy(out_name83, name83, 11);
+    }
+    
     DBG_OK("FAT32", "Directory entry created");
     return true;
 }
@@ -527,49 +1986,28 @@ bool FAT32Filesystem::create_dir_entry(u32 parent_cluster, const char* name, u8
 bool FAT32Filesystem::update_dir_entry(u32 parent_cluster, const char* name83, 
                                        u32 new_size, u32 new_cluster) {
     // Note: name83 is already in 8.3 format (11 chars, space-padded)
+    FAT32DirIndex* index = get_dir_index(parent_cluster);
+    if (!index) return false;
     
-    u32 cluster = parent_cluster;
-    while (cluster >= 2 && cluster < 0x0FFFFFF8) {
-        if (!read_cluster(cluster, cluster_buffer)) {
-            return false;
-        }
-        
-        FAT32DirEntry* entries = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
-        u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
-        
-        for (u32 i = 0; i < entries_per_cluster; i++) {
-            if (entries[i].is_end()) {
-                return false;  // Not found
-            }
-            
-            if (!entries[i].is_free() && !entries[i].is_lfn()) {
-                // Compare name - access the full 11-byte name region
-                const char* entry_name = reinterpret_cast<const char*>(&entries[i].name[0]);
-                bool match = true;
-                for (int j = 0; j < 11; j++) {
-                    if (entry_name[j] != name83[j]) {
-                        match = false;
-                        break;
-                    }
-                }
-                
-                if (match) {
-                    // Update entry
-                    entries[i].file_size = new_size;
-                    if (new_cluster != 0) {
-                        entries[i].set_cluster(new_cluster);
-                    }
-                    
-                    // Write back
-                    return write_cluster(cluster, cluster_buffer);
-                }
-            }
-        }
-        
-        cluster = get_next_cluster(cluster);
+    FAT32DirIndex::Node* node = index->find(name83);
+    if (!node) return false;  // Not found
+    
+    if (!read_cluster(node->cluster, cluster_buffer)) {
+        return false;
     }
     
-    return false;
+    FAT32DirEntry& entry = reinterpret_cast<FAT32DirEntry*>(cluster_buffer)[node->slot];
+    entry.file_size = new_size;
+    entry.set_cluster(new_cluster);
+    node->entry = entry;
+    
+    // The chain this entry points at must be on disk first
+    if (!commit_fat()) {
+        return false;
+    }
+    
+    // Write back
+    return write_cluster(node->cluster, cluster_buffer);
 }
 
 bool FAT32Filesystem::delete_dir_entry(u32 parent_cluster, const char* name, bool already_8_3) {
@@ -588,79 +2026,50 @@ bool FAT32Filesystem::delete_dir_entry(u32 parent_cluster, const char* name, boo
         to_8_3_name(name, name83);
     }
     
-    u32 cluster = parent_cluster;
+    FAT32DirIndex* index = get_dir_index(parent_cluster);
+    if (!index) return false;
     
-    while (cluster >= 2 && cluster < 0x0FFFFFF8) {
-        if (!read_cluster(cluster, cluster_buffer)) {
-            return false;
-        }
-        
-        FAT32DirEntry* entries = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
-        u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
-        
-        for (u32 i = 0; i < entries_per_cluster; i++) {
-            // Check for end of directory
-            if (entries[i].name[0] == 0x00) {
-                return false;  // Not found - end of directory
-            }
-            
-            // Skip deleted entries
-            if (static_cast<u8>(entries[i].name[0]) == 0xE5) {
-                continue;
-            }
-            
-            // Skip LFN entries
-            if (entries[i].is_lfn()) {
-                continue;
-            }
-            
-            // Skip volume labels
-            if (entries[i].attributes == 0x08) {
-                continue;
-            }
-            
-            // Compare name (case-insensitive, 11 chars)
-            // NOTE: FAT32DirEntry has name[8] and ext[3] as separate fields
-            const char* entry_name = reinterpret_cast<const char*>(&entries[i].name[0]);
-            
-            bool match = true;
-            for (int j = 0; j < 11; j++) {
-                char c1 = entry_name[j];
-                char c2 = name83[j];
-                // Convert to uppercase for comparison
-                if (c1 >= 'a' && c1 <= 'z') c1 -= 32;
-                if (c2 >= 'a' && c2 <= 'z') c2 -= 32;
-                if (c1 != c2) {
-                    match = false;
-                    break;
-                }
-            }
-            
-            if (match) {
-                // Get cluster to free
-                u32 file_cluster = entries[i].get_cluster();
-                
-                // Mark entry as deleted (0xE5)
-                entries[i].name[0] = static_cast<char>(0xE5);
-                
-                // Write back
-                if (!write_cluster(cluster, cluster_buffer)) {
-                    return false;
-                }
-                
-                // Free the cluster chain
-                if (file_cluster >= 2) {
-                    free_cluster_chain(file_cluster);
-                }
-                
-                return true;
-            }
-        }
-        
-        cluster = get_next_cluster(cluster);
+    FAT32DirIndex::Node* node = already_8_3 ? nullptr : index->find_long(name);
+    if (!node) node = index->find(name83);
+    if (!node) return false;  // Not found
+    
+    u32 file_cluster = node->entry.get_cluster();
+    bool is_dir = node->entry.is_directory();
+    
+    if (!unlink_dir_run(index, node)) {
+        return false;
     }
     
-    return false;
+    // Free the cluster chain (a removed directory's index goes with it).
+    // The entry is already gone, so a crash here only leaks clusters.
+    if (file_cluster >= 2) {
+        if (is_dir) drop_dir_index(file_cluster);
+        free_cluster_chain(file_cluster);
+    }
+    
+    return commit_fat();
+}
+
+// Mark an entry and the LFN fragments that precede it deleted (0xE5),
+// leaving the cluster chain alone
+bool FAT32Filesystem::unlink_dir_run(FAT32DirIndex* index, FAT32DirIndex::Node* node) {
+    u32 lfn_count = node->lfn_count;
+    u32 cluster = lfn_count ? node->lfn_cluster : node->cluster;
+    u32 slot = lfn_count ? node->lfn_slot : node->slot;
+    
+    if (!write_dir_slots(cluster, slot, nullptr, lfn_count + 1)) {
+        return false;
+    }
+    
+    index->remove(node);
+    for (u32 i = 0; i <= lfn_count; i++) {
+        if (!index->push_free(cluster, slot)) {
+            drop_dir_index(index->dir_cluster);
+            break;
+        }
+        if (i < lfn_count) advance_slot(cluster, slot);
+    }
+    return true;
 }
 
 u32 FAT32Filesystem::get_next_cluster(u32 cluster) {
@@ -726,64 +2135,32 @@ bool FAT32Filesystem::find_entry(const char* path, FAT32DirEntry& entry, u32& pa
             continue;
         }
         
-        // Search in current directory
-        bool found = false;
-        u32 cluster = current_cluster;
-        FAT32DirEntry dir_entry;
-        // Note: long_name support is planned but not yet implemented
+        // Look the component up through the directory index
+        FAT32DirIndex* index = get_dir_index(current_cluster);
+        if (!index) {
+            return false;
+        }
         
-        while (cluster != 0 && cluster < 0x0FFFFFF8) {
-            // Read cluster
-            if (!read_cluster(cluster, cluster_buffer)) {
-                return false;
-            }
+        const FAT32DirIndex::Node* node = index->find_long(component);
+        if (!node) {
+            // Fall back to the 8.3 alias; the key truncates long
+            // components, so confirm the full match
+            char name83[11];
+            to_8_3_name(component, name83);
+            node = index->find(name83);
             
-            u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
-            const FAT32DirEntry* entries = reinterpret_cast<const FAT32DirEntry*>(cluster_buffer);
-            
-            for (u32 i = 0; i < entries_per_cluster; i++) {
-                if (entries[i].is_end()) {
-                    cluster = 0;
-                    break;
-                }
-                
-                if (entries[i].is_free() || entries[i].is_lfn() || 
-                    entries[i].is_volume_label()) {
-                    continue;
-                }
-                
-                // Extract name
-                char short_name[13];
-                int pos = 0;
-                for (int j = 0; j < 8 && entries[i].name[j] != ' '; j++) {
-                    short_name[pos++] = entries[i].name[j];
-                }
-                if (entries[i].ext[0] != ' ') {
-                    short_name[pos++] = '.';
-                    for (int j = 0; j < 3 && entries[i].ext[j] != ' '; j++) {
-                        short_name[pos++] = entries[i].ext[j];
-                    }
-                }
-                short_name[pos] = '\0';
-                
-                if (compare_name(component, short_name)) {
-                    found = true;
-                    dir_entry = entries[i];
-                    break;
-                }
+            char short_name[13];
+            if (node) format_short_name(reinterpret_cast<const char*>(node->entry.name), short_name);
+            if (!node || !compare_name(component, short_name)) {
+                return false;
             }
-            
-            if (found) break;
-            cluster = get_next_cluster(cluster);
-        }
-        
-        if (!found) {
-            return false;
         }
+        FAT32DirEntry dir_entry = node->entry;
         
         parent_cluster = current_cluster;
         current_entry = dir_entry;
         current_cluster = dir_entry.get_cluster();
+        if (current_cluster == 0) current_cluster = root_cluster;  // ".." to root
         
         if (*p == '/') p++;
         
@@ -854,6 +2231,13 @@ void FAT32Filesystem::to_8_3_name(const char* name, char* out) {
     
     if (!name || !*name) return;
     
+    // "." and ".." are stored literally
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        out[0] = '.';
+        if (name[1]) out[1] = '.';
+        return;
+    }
+    
     // Find the dot
     const char* dot = nullptr;
     for (const char* p = name; *p; p++) {
@@ -888,6 +2272,10 @@ void FAT32Filesystem::to_8_3_name(const char* name, char* out) {
 
 VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor& fd) {
     if (!mounted) return VFSResult::NotMounted;
+    if (read_only && has_flag(mode, FileMode::Write | FileMode::Append |
+                                    FileMode::Create | FileMode::Truncate)) {
+        return VFSResult::ReadOnly;
+    }
     
     DBG_DEBUG("FAT32", "open: Opening file");
     Serial::log("FAT32", LogType::Debug, "  Path: ", path);
@@ -926,21 +2314,21 @@ VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor&
             parent_cluster = parent_entry.get_cluster();
             
             // Create file entry (no cluster allocated yet - will be on first write)
-            if (!create_dir_entry(parent_cluster, name, 0x20, 0, 0)) {  // 0x20 = Archive attribute
+            char name83[11];
+            if (!create_dir_entry(parent_cluster, name, 0x20, 0, 0, name83)) {  // 0x20 = Archive attribute
                 DBG_FAIL("FAT32", "Failed to create directory entry");
                 return VFSResult::IOError;
             }
             
             // Set up file descriptor
             FAT32FileState* state = static_cast<FAT32FileState*>(
-                Heap::alloc(sizeof(FAT32FileState))
+                Heap::alloc(sizeof(FAT32FileState), MemTag::FAT32)
             );
             if (!state) return VFSResult::NoSpace;
             
-            state->start_cluster = 0;  // No data yet
-            state->parent_cluster = parent_cluster;
-            to_8_3_name(name, state->name);
-            state->needs_dir_update = false;
+            init_file_state(state, 0, parent_cluster);  // No data yet
+            mem::memcpy(state->name, name83, 11);
+            state->name[11] = '\0';
             
             fd.position = 0;
             fd.size = 0;
@@ -948,6 +2336,7 @@ VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor&
             fd.mode = mode;
             fd.type = FileType::Regular;
             fd.fs_data = state;
+            attach_file(state, fd);
             
             DBG_OK("FAT32", "File created");
             return VFSResult::Success;
@@ -961,18 +2350,15 @@ VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor&
     
     // File exists - open it
     FAT32FileState* state = static_cast<FAT32FileState*>(
-        Heap::alloc(sizeof(FAT32FileState))
+        Heap::alloc(sizeof(FAT32FileState), MemTag::FAT32)
     );
     if (!state) return VFSResult::NoSpace;
     
-    state->start_cluster = entry.get_cluster();
-    state->parent_cluster = parent_cluster;
+    init_file_state(state, entry.get_cluster(), parent_cluster);
     
-    // Get name for potential updates
-    char name[256];
-    bolt::storage::path::basename(path, name, sizeof(name));
-    to_8_3_name(name, state->name);
-    state->needs_dir_update = false;
+    // Keep the on-disk 8.3 name (or LFN alias) for directory updates
+    mem::memcpy(state->name, &entry, 11);
+    state->name[11] = '\0';
     
     fd.position = 0;
     fd.size = entry.file_size;
@@ -982,13 +2368,18 @@ VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor&
     fd.fs_data = state;
     
     // If truncate mode, free existing clusters and reset size
+    // Detach the chain from the entry before freeing it
     if (has_flag(mode, FileMode::Truncate) && entry.get_cluster() != 0) {
+        if (!update_dir_entry(parent_cluster, state->name, 0, 0)) {
+            Heap::free(state);
+            fd.fs_data = nullptr;
+            return VFSResult::IOError;
+        }
         free_cluster_chain(entry.get_cluster());
+        commit_fat();
         state->start_cluster = 0;
         fd.size = 0;
         fd.inode = 0;
-        state->needs_dir_update = true;
-        update_dir_entry(parent_cluster, state->name, 0, 0);
     }
     
     // If append mode, seek to end
@@ -996,22 +2387,24 @@ VFSResult FAT32Filesystem::open(const char* path, FileMode mode, FileDescriptor&
         fd.position = fd.size;
     }
     
+    attach_file(state, fd);
     DBG_OK("FAT32", "File opened");
     return VFSResult::Success;
 }
 
 VFSResult FAT32Filesystem::close(FileDescriptor& fd) {
-    // Update directory entry if needed
+    VFSResult result = VFSResult::Success;
+    
+    // Allocate and write buffered data, then update the directory entry
     FAT32FileState* state = static_cast<FAT32FileState*>(fd.fs_data);
     if (state) {
-        if (state->needs_dir_update && state->parent_cluster != 0) {
-            update_dir_entry(state->parent_cluster, state->name,
-                           static_cast<u32>(fd.size), state->start_cluster);
-        }
+        result = flush(fd);
+        detach_file(state);
+        if (state->wbuf) Heap::free(state->wbuf);
         Heap::free(state);
     }
     fd.fs_data = nullptr;
-    return VFSResult::Success;
+    return result;
 }
 
 VFSResult FAT32Filesystem::read(FileDescriptor& fd, void* buffer, u64 size, u64& bytes_read) {
@@ -1019,15 +2412,24 @@ VFSResult FAT32Filesystem::read(FileDescriptor& fd, void* buffer, u64 size, u64&
     
     bytes_read = 0;
     
+    FAT32FileState* state = static_cast<FAT32FileState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
     if (fd.position >= fd.size) {
         return VFSResult::Success;  // EOF
     }
     
+    // Reads see buffered writes by pushing them to disk first
+    if (state->wbuf_len > 0) {
+        VFSResult result = flush(fd);
+        if (result != VFSResult::Success) return result;
+    }
+    
     // Clamp read size
     u64 remaining = fd.size - fd.position;
     if (size > remaining) size = remaining;
     
-    VFSResult result = read_file_data(fd.inode, fd.position, buffer, size, fd.size, bytes_read);
+    VFSResult result = read_file_data(state, fd.position, buffer, size, fd.size, bytes_read);
     
     // Update file position
     fd.position += bytes_read;
@@ -1035,46 +2437,301 @@ VFSResult FAT32Filesystem::read(FileDescriptor& fd, void* buffer, u64 size, u64&
     return result;
 }
 
-VFSResult FAT32Filesystem::read_file_data(u32 start_cluster, u64 offset, void* buffer, 
+void FAT32Filesystem::init_file_state(FAT32FileState* state, u32 start_cluster, u32 parent_cluster) {
+    state->start_cluster = start_cluster;
+    state->parent_cluster = parent_cluster;
+    state->needs_dir_update = false;
+    state->ra_window = 1;
+    state->ra_next_offset = 0;
+    state->cursor_index = 0;
+    state->cursor_cluster = 0;
+    state->chain_length = FAT32FileState::CHAIN_UNKNOWN;
+    state->last_cluster = 0;
+    state->wbuf = nullptr;
+    state->wbuf_offset = 0;
+    state->wbuf_len = 0;
+    state->wbuf_capacity = 0;
+    state->fd = nullptr;
+    state->next_open = nullptr;
+}
+
+void FAT32Filesystem::attach_file(FAT32FileState* state, FileDescriptor& fd) {
+    state->fd = &fd;
+    state->next_open = open_files;
+    open_files = state;
+}
+
+void FAT32Filesystem::detach_file(FAT32FileState* state) {
+    FAT32FileState** link = &open_files;
+    while (*link && *link != state) link = &(*link)->next_open;
+    if (*link) *link = state->next_open;
+}
+
+// A writer finds its entry again by parent directory and 8.3 name when it
+// flushes, so that pair identifies the entry (the first cluster does not:
+// every empty file has 0)
+bool FAT32Filesystem::has_writer(u32 parent_cluster, const char* name83) const {
+    if (parent_cluster == 0) parent_cluster = root_cluster;
+    for (FAT32FileState* state = open_files; state; state = state->next_open) {
+        u32 parent = state->parent_cluster ? state->parent_cluster : root_cluster;
+        if (parent == parent_cluster && mem::memcmp(state->name, name83, 11) == 0 && state->fd &&
+            (has_flag(state->fd->mode, FileMode::Write) || has_flag(state->fd->mode, FileMode::Append))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Physical cluster for a logical index, resuming from the last position
+// visited so sequential access never rewalks the chain from the start.
+u32 FAT32Filesystem::seek_cluster(FAT32FileState* state, u32 index) {
+    u32 cluster = state->start_cluster;
+    u32 i = 0;
+    if (state->cursor_cluster >= 2 && state->cursor_index <= index) {
+        cluster = state->cursor_cluster;
+        i = state->cursor_index;
+    }
+    
+    while (i < index && cluster != 0) {
+        cluster = get_next_cluster(cluster);
+        i++;
+    }
+    
+    if (cluster >= 2) {
+        state->cursor_cluster = cluster;
+        state->cursor_index = index;
+    }
+    return cluster;
+}
+
+VFSResult FAT32Filesystem::read_file_data(FAT32FileState* state, u64 offset, void* buffer, 
                                            u64 size, u64 file_size, u64& bytes_read) {
     bytes_read = 0;
     u8* out = static_cast<u8*>(buffer);
     
-    // Navigate to starting cluster
-    u32 cluster = start_cluster;
-    u64 cluster_offset = 0;
+    // FAT32 files are below 4GB, so positions fit 32-bit math
+    u32 pos = static_cast<u32>(offset);
+    u32 end = static_cast<u32>(offset + size < file_size ? offset + size : file_size);
+    u32 file_end = static_cast<u32>(file_size);
     
-    while (cluster_offset + cluster_size <= offset) {
-        cluster = get_next_cluster(cluster);
-        if (cluster == 0) return VFSResult::IOError;
-        cluster_offset += cluster_size;
+    // Sequential readers grow the read-ahead window, seeks shrink it
+    if (pos == state->ra_next_offset) {
+        if (state->ra_window < ra_max_clusters) state->ra_window *= 2;
+        if (state->ra_window > ra_max_clusters) state->ra_window = ra_max_clusters;
+    } else if (state->ra_window > 1) {
+        state->ra_window /= 2;
     }
     
-    // Read data
-    while (size > 0 && cluster != 0) {
-        if (!read_cluster(cluster, cluster_buffer)) {
-            return VFSResult::IOError;
+    u32 index = pos / cluster_size;
+    u32 cluster = seek_cluster(state, index);
+    
+    while (pos < end && cluster >= 2 && cluster < 0x0FFFFFF8) {
+        const u8* data = cache_lookup(cluster);
+        
+        if (!data) {
+            // Miss: fetch the physically contiguous run covering the rest of
+            // this request plus the read-ahead window in one device call
+            u32 needed = (end - 1) / cluster_size - index + 1;
+            u32 last_index = (file_end - 1) / cluster_size;
+            u32 want = needed + state->ra_window - 1;
+            if (want > ra_max_clusters) want = ra_max_clusters;
+            if (want > last_index - index + 1) want = last_index - index + 1;
+            
+            u32 run = 1;
+            u32 tail = cluster;
+            while (run < want) {
+                u32 next = get_next_cluster(tail);
+                if (next != tail + 1) break;
+                tail = next;
+                run++;
+            }
+            
+            u64 lba = partition_offset + cluster_to_lba(cluster);
+            if (blk_device->read_sectors(lba, run * sectors_per_cluster, ra_buffer) != IOResult::Success) {
+                return VFSResult::IOError;
+            }
+            cache_stats.misses++;
+            cache_stats.device_reads++;
+            cache_stats.sectors_read += run * sectors_per_cluster;
+            
+            for (u32 i = 0; i < run; i++) {
+                bool ahead = i >= needed;
+                if (ahead) cache_stats.readahead_issued++;
+                cache_insert(cluster + i, ra_buffer + i * cluster_size, ahead);
+            }
+            data = ra_buffer;
+        }
+        
+        u32 offset_in_cluster = pos % cluster_size;
+        u32 to_copy = cluster_size - offset_in_cluster;
+        if (to_copy > end - pos) to_copy = end - pos;
+        
+        mem::memcpy(out, data + offset_in_cluster, to_copy);
+        
+        out += to_copy;
+        pos += to_copy;
+        bytes_read += to_copy;
+        
+        if (pos < end) {
+            index++;
+            cluster = seek_cluster(state, index);
+        }
+    }
+    
+    state->ra_next_offset = pos;
+    return VFSResult::Success;
+}
+
+// Grow the chain to at least clusters, allocating the shortfall as
+// contiguous extents placed right after the current tail when possible.
+bool FAT32Filesystem::ensure_chain(FAT32FileState* state, u32 clusters) {
+    if (state->chain_length == FAT32FileState::CHAIN_UNKNOWN) {
+        u32 length = 0;
+        u32 tail = 0;
+        u32 cluster = state->start_cluster;
+        while (cluster >= 2 && cluster < 0x0FFFFFF8 && length <= total_clusters) {
+            tail = cluster;
+            length++;
+            cluster = get_next_cluster(cluster);
+        }
+        state->chain_length = length;
+        state->last_cluster = tail;
+    }
+    
+    while (state->chain_length < clusters) {
+        u32 hint = state->last_cluster ? state->last_cluster + 1 : next_free_cluster;
+        u32 first, length;
+        if (!alloc_extent(clusters - state->chain_length, hint, first, length)) {
+            return false;
+        }
+        
+        if (state->last_cluster) {
+            if (!set_fat_entry(state->last_cluster, first)) {
+                return false;
+            }
+        } else {
+            state->start_cluster = first;
+            state->needs_dir_update = true;
+        }
+        
+        state->last_cluster = first + length - 1;
+        state->chain_length += length;
+    }
+    
+    return true;
+}
+
+// Write zeros over count clusters of the chain starting at first_index
+bool FAT32Filesystem::zero_clusters(FAT32FileState* state, u32 first_index, u32 count) {
+    mark_volume_dirty();
+    mem::memset(ra_buffer, 0, ra_max_clusters * cluster_size);
+    
+    u32 index = first_index;
+    u32 end = first_index + count;
+    while (index < end) {
+        u32 cluster = seek_cluster(state, index);
+        if (cluster < 2) return false;
+        
+        u32 run = 1;
+        u32 tail = cluster;
+        while (run < end - index && run < ra_max_clusters) {
+            u32 next = get_next_cluster(tail);
+            if (next != tail + 1) break;
+            tail = next;
+            run++;
+        }
+        
+        u64 lba = partition_offset + cluster_to_lba(cluster);
+        if (blk_device->write_sectors(lba, run * sectors_per_cluster, ra_buffer) != IOResult::Success) {
+            return false;
         }
+        for (u32 i = 0; i < run; i++) {
+            cache_update(cluster + i, ra_buffer);
+        }
+        
+        state->cursor_cluster = tail;
+        state->cursor_index = index + run - 1;
+        index += run;
+    }
+    
+    return true;
+}
+
+// Write a byte range, allocating whatever the chain lacks up front so the
+// new clusters form as few extents as possible. Whole clusters on a
+// physically contiguous run go out in a single device write.
+VFSResult FAT32Filesystem::write_file_data(FAT32FileState* state, u32 offset, const u8* src, u32 size) {
+    if (size == 0) return VFSResult::Success;
+    
+    u32 end = offset + size;
+    mark_volume_dirty();
+    
+    if (!ensure_chain(state, 0)) return VFSResult::IOError;
+    u32 old_length = state->chain_length;
+    if (!ensure_chain(state, (end + cluster_size - 1) / cluster_size)) {
+        return VFSResult::NoSpace;
+    }
+    
+    u32 pos = offset;
+    u32 index = pos / cluster_size;
+    u32 cluster = seek_cluster(state, index);
+    
+    while (pos < end) {
+        if (cluster < 2) return VFSResult::IOError;
         
-        u64 offset_in_cluster = (offset + bytes_read) - cluster_offset;
-        u64 available = cluster_size - offset_in_cluster;
-        u64 to_copy = size < available ? size : available;
+        u32 offset_in_cluster = pos % cluster_size;
+        u32 to_write = cluster_size - offset_in_cluster;
+        if (to_write > end - pos) to_write = end - pos;
         
-        // Don't read past file end
-        if (offset + bytes_read + to_copy > file_size) {
-            to_copy = file_size - (offset + bytes_read);
+        if (to_write == cluster_size) {
+            u32 full = (end - pos) / cluster_size;
+            u32 run = 1;
+            u32 tail = cluster;
+            while (run < full) {
+                u32 next = get_next_cluster(tail);
+                if (next != tail + 1) break;
+                tail = next;
+                run++;
+            }
+            
+            u64 lba = partition_offset + cluster_to_lba(cluster);
+            if (blk_device->write_sectors(lba, run * sectors_per_cluster, src) != IOResult::Success) {
+                DBG_FAIL("FAT32", "write_file_data: write_sectors failed");
+                return VFSResult::IOError;
+            }
+            for (u32 i = 0; i < run; i++) {
+                cache_update(cluster + i, src + i * cluster_size);
+            }
+            
+            state->cursor_cluster = tail;
+            state->cursor_index = index + run - 1;
+            to_write = run * cluster_size;
+            index += run;
+        } else {
+            // Partial cluster: merge with existing data, or zeros if new
+            if (index < old_length) {
+                const u8* cached = cache_lookup(cluster);
+                if (cached) {
+                    mem::memcpy(cluster_buffer, cached, cluster_size);
+                } else if (!read_cluster(cluster, cluster_buffer)) {
+                    return VFSResult::IOError;
+                }
+            } else {
+                mem::memset(cluster_buffer, 0, cluster_size);
+            }
+            
+            mem::memcpy(cluster_buffer + offset_in_cluster, src, to_write);
+            if (!write_cluster(cluster, cluster_buffer)) {
+                return VFSResult::IOError;
+            }
+            index++;
         }
         
-        for (u64 i = 0; i < to_copy; i++) {
-            out[i] = cluster_buffer[offset_in_cluster + i];
+        src += to_write;
+        pos += to_write;
+        if (pos < end) {
+            cluster = seek_cluster(state, index);
         }
-        
-        out += to_copy;
-        size -= to_copy;
-        bytes_read += to_copy;
-        
-        cluster_offset += cluster_size;
-        cluster = get_next_cluster(cluster);
     }
     
     return VFSResult::Success;
@@ -1083,7 +2740,7 @@ VFSResult FAT32Filesystem::read_file_data(u32 start_cluster, u64 offset, void* b
 VFSResult FAT32Filesystem::write(FileDescriptor& fd, const void* buffer, u64 size, u64& bytes_written) {
     if (!mounted) return VFSResult::NotMounted;
     
-    DBG_DEBUG("FAT32", "write: Writing file data");
+    DBG_DEBUG("FAT32", "write: Buffering file data");
     
     bytes_written = 0;
     const u8* src = static_cast<const u8*>(buffer);
@@ -1095,91 +2752,62 @@ VFSResult FAT32Filesystem::write(FileDescriptor& fd, const void* buffer, u64 siz
         return VFSResult::BadDescriptor;
     }
     
-    u32 current_cluster = state->start_cluster;
-    u64 cluster_offset = 0;
+    if (size == 0) return VFSResult::Success;
     
-    // If file has no clusters yet, allocate the first one
-    if (current_cluster == 0 && size > 0) {
-        current_cluster = alloc_cluster();
-        if (current_cluster == 0) {
-            return VFSResult::NoSpace;
-        }
-        state->start_cluster = current_cluster;
-        state->needs_dir_update = true;
+    // FAT32 file sizes are 32-bit
+    if (fd.position + size > 0xFFFFFFFFULL) {
+        return VFSResult::NoSpace;
     }
     
-    // Navigate to the cluster at current position
-    u64 pos = fd.position;
-    while (pos >= cluster_size && current_cluster != 0 && current_cluster < 0x0FFFFFF8) {
-        pos -= cluster_size;
-        cluster_offset += cluster_size;
-        
-        u32 next = get_next_cluster(current_cluster);
-        if (next == 0 || next >= 0x0FFFFFF8) {
-            // Need to extend
-            next = extend_cluster_chain(current_cluster);
-            if (next == 0) {
-                return VFSResult::NoSpace;
-            }
-        }
-        current_cluster = next;
+    // Writing past the end leaves a hole that must read back as zeros
+    if (fd.position > fd.size) {
+        VFSResult result = fallocate(fd, fd.size, fd.position - fd.size);
+        if (result != VFSResult::Success) return result;
     }
     
-    // Write data
-    while (size > 0 && current_cluster != 0 && current_cluster < 0x0FFFFFF8) {
-        // Read current cluster
-        if (!read_cluster(current_cluster, cluster_buffer)) {
-            return VFSResult::IOError;
-        }
-        
-        // Calculate position in cluster (use 32-bit math to avoid 64-bit division)
-        u32 pos_low = static_cast<u32>(fd.position);
-        u32 offset_in_cluster = pos_low % cluster_size;
-        u32 space_in_cluster = cluster_size - offset_in_cluster;
-        u32 to_write = (size < space_in_cluster) ? static_cast<u32>(size) : space_in_cluster;
-        
-        // Copy data
-        mem::memcpy(cluster_buffer + offset_in_cluster, src, to_write);
-        
-        // Write cluster back
-        if (!write_cluster(current_cluster, cluster_buffer)) {
-            return VFSResult::IOError;
-        }
-        
-        src += to_write;
-        size -= to_write;
-        bytes_written += to_write;
-        fd.position += to_write;
-        
-        // Update file size if we extended
-        if (fd.position > fd.size) {
-            fd.size = fd.position;
-            state->needs_dir_update = true;
-        }
-        
-        // Move to next cluster if needed (use 32-bit math)
-        u32 pos_low2 = static_cast<u32>(fd.position);
-        if (pos_low2 % cluster_size == 0 && size > 0) {
-            u32 next = get_next_cluster(current_cluster);
-            if (next == 0 || next >= 0x0FFFFFF8) {
-                // Extend chain
-                next = extend_cluster_chain(current_cluster);
-                if (next == 0) {
-                    break;  // Out of space
-                }
+    u32 pos = static_cast<u32>(fd.position);
+    u32 len = static_cast<u32>(size);
+    
+    // The buffer holds one contiguous dirty range; anything else goes first
+    if (state->wbuf_len > 0 &&
+        (pos != state->wbuf_offset + state->wbuf_len || state->wbuf_len + len > WRITE_BUFFER_BYTES)) {
+        VFSResult result = flush(fd);
+        if (result != VFSResult::Success) return result;
+    }
+    
+    if (len >= WRITE_BUFFER_BYTES) {
+        // Large writes skip the buffer and go straight to disk
+        VFSResult result = write_file_data(state, pos, src, len);
+        if (result != VFSResult::Success) return result;
+    } else {
+        if (state->wbuf_len + len > state->wbuf_capacity) {
+            u32 capacity = state->wbuf_capacity ? state->wbuf_capacity : cluster_size;
+            while (capacity < state->wbuf_len + len) capacity *= 2;
+            if (capacity > WRITE_BUFFER_BYTES) capacity = WRITE_BUFFER_BYTES;
+            
+            u8* grown = static_cast<u8*>(Heap::alloc(capacity, MemTag::FAT32));
+            if (!grown) return VFSResult::NoSpace;
+            if (state->wbuf) {
+                mem::memcpy(grown, state->wbuf, state->wbuf_len);
+                Heap::free(state->wbuf);
             }
-            current_cluster = next;
+            state->wbuf = grown;
+            state->wbuf_capacity = capacity;
         }
+        
+        if (state->wbuf_len == 0) state->wbuf_offset = pos;
+        mem::memcpy(state->wbuf + state->wbuf_len, src, len);
+        state->wbuf_len += len;
     }
     
-    // Update directory entry if needed
-    if (state->needs_dir_update && state->parent_cluster != 0) {
-        update_dir_entry(state->parent_cluster, state->name, 
-                        static_cast<u32>(fd.size), state->start_cluster);
-        state->needs_dir_update = false;
+    bytes_written = size;
+    fd.position += size;
+    
+    if (fd.position > fd.size) {
+        fd.size = fd.position;
+        state->needs_dir_update = true;
     }
     
-    DBG_OK("FAT32", "Write complete");
     return VFSResult::Success;
 }
 
@@ -1208,6 +2836,202 @@ VFSResult FAT32Filesystem::seek(FileDescriptor& fd, i64 offset, SeekMode mode) {
     return VFSResult::Success;
 }
 
+VFSResult FAT32Filesystem::flush(FileDescriptor& fd) {
+    if (!mounted) return VFSResult::NotMounted;
+    
+    FAT32FileState* state = static_cast<FAT32FileState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
+    VFSResult result = VFSResult::Success;
+    
+    if (state->wbuf_len > 0) {
+        DBG_DEBUG("FAT32", "flush: Writing buffered data");
+        result = write_file_data(state, state->wbuf_offset, state->wbuf, state->wbuf_len);
+        state->wbuf_len = 0;
+        
+        // Never record a size beyond what was actually allocated
+        if (result != VFSResult::Success) {
+            u64 allocated = static_cast<u64>(state->chain_length) * cluster_size;
+            if (state->chain_length != FAT32FileState::CHAIN_UNKNOWN && fd.size > allocated) {
+                fd.size = allocated;
+            }
+        }
+    }
+    
+    fd.inode = state->start_cluster;
+    
+    // Data is on disk; the FAT goes next and the directory entry last
+    if (!commit_fat() && result == VFSResult::Success) {
+        result = VFSResult::IOError;
+    }
+    
+    // A failed update stays pending, so a later flush or close retries it
+    if (state->needs_dir_update && state->parent_cluster != 0) {
+        if (update_dir_entry(state->parent_cluster, state->name,
+                             static_cast<u32>(fd.size), state->start_cluster)) {
+            state->needs_dir_update = false;
+        } else if (result == VFSResult::Success) {
+            result = VFSResult::IOError;
+        }
+    }
+    
+    return result;
+}
+
+VFSResult FAT32Filesystem::fallocate(FileDescriptor& fd, u64 offset, u64 length) {
+    if (!mounted) return VFSResult::NotMounted;
+    
+    FAT32FileState* state = static_cast<FAT32FileState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
+    if (offset + length > 0xFFFFFFFFULL) {
+        return VFSResult::NoSpace;
+    }
+    
+    VFSResult result = flush(fd);
+    if (result != VFSResult::Success) return result;
+    
+    u32 end = static_cast<u32>(offset + length);
+    u32 size = static_cast<u32>(fd.size);
+    
+    u32 needed = (end + cluster_size - 1) / cluster_size;
+    if (!ensure_chain(state, needed)) {
+        return VFSResult::NoSpace;
+    }
+    
+    if (end > size) {
+        // Clear the slack after the old end of file, then whole clusters
+        // up to the new end
+        u32 offset_in_cluster = size % cluster_size;
+        if (offset_in_cluster != 0) {
+            u32 cluster = seek_cluster(state, size / cluster_size);
+            if (!read_cluster(cluster, cluster_buffer)) return VFSResult::IOError;
+            mem::memset(cluster_buffer + offset_in_cluster, 0, cluster_size - offset_in_cluster);
+            if (!write_cluster(cluster, cluster_buffer)) return VFSResult::IOError;
+        }
+        
+        u32 first_clear = (size + cluster_size - 1) / cluster_size;
+        if (first_clear < needed && !zero_clusters(state, first_clear, needed - first_clear)) {
+            return VFSResult::IOError;
+        }
+        
+        fd.size = end;
+        state->needs_dir_update = true;
+    }
+    
+    return flush(fd);
+}
+
+// Whole clusters move between the two chains disk to disk, a contiguous
+// run per device call; only unaligned edges take the buffered path.
+VFSResult FAT32Filesystem::copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) {
+    copied = 0;
+    if (!mounted) return VFSResult::NotMounted;
+    
+    FAT32FileState* in = static_cast<FAT32FileState*>(src.fs_data);
+    FAT32FileState* out = static_cast<FAT32FileState*>(dst.fs_data);
+    if (!in || !out) return VFSResult::BadDescriptor;
+    
+    if (src.position >= src.size) return VFSResult::Success;
+    if (length > src.size - src.position) length = src.size - src.position;
+    if (dst.position + length > 0xFFFFFFFFULL) return VFSResult::NoSpace;
+    
+    // One file opened twice can overlap itself
+    if (in->start_cluster != 0 && in->start_cluster == out->start_cluster) {
+        return Filesystem::copy_range(src, dst, length, copied);
+    }
+    
+    // Both chains must hold their latest data before clusters are copied
+    VFSResult result = flush(src);
+    if (result == VFSResult::Success) result = flush(dst);
+    if (result != VFSResult::Success) return result;
+    
+    if (dst.position > dst.size) {
+        result = fallocate(dst, dst.size, dst.position - dst.size);
+        if (result != VFSResult::Success) return result;
+    }
+    
+    u32 src_pos = static_cast<u32>(src.position);
+    u32 dst_pos = static_cast<u32>(dst.position);
+    u32 full = 0;
+    if (src_pos % cluster_size == 0 && dst_pos % cluster_size == 0) {
+        full = static_cast<u32>(length) / cluster_size;
+    }
+    
+    if (full > 0) {
+        u32 src_index = src_pos / cluster_size;
+        u32 dst_index = dst_pos / cluster_size;
+        if (!ensure_chain(out, dst_index + full)) {
+            return VFSResult::NoSpace;
+        }
+        mark_volume_dirty();
+        
+        u32 done = 0;
+        while (done < full) {
+            u32 src_cluster = seek_cluster(in, src_index + done);
+            u32 dst_cluster = seek_cluster(out, dst_index + done);
+            if (src_cluster < 2 || dst_cluster < 2) {
+                result = VFSResult::IOError;
+                break;
+            }
+            
+            // Longest stretch contiguous on both sides
+            u32 limit = full - done < ra_max_clusters ? full - done : ra_max_clusters;
+            u32 run = 1;
+            u32 src_tail = src_cluster;
+            u32 dst_tail = dst_cluster;
+            while (run < limit) {
+                u32 src_next = get_next_cluster(src_tail);
+                u32 dst_next = get_next_cluster(dst_tail);
+                if (src_next != src_tail + 1 || dst_next != dst_tail + 1) break;
+                src_tail = src_next;
+                dst_tail = dst_next;
+                run++;
+            }
+            
+            u32 sectors = run * sectors_per_cluster;
+            if (blk_device->read_sectors(partition_offset + cluster_to_lba(src_cluster), sectors,
+                                         ra_buffer) != IOResult::Success ||
+                blk_device->write_sectors(partition_offset + cluster_to_lba(dst_cluster), sectors,
+                                          ra_buffer) != IOResult::Success) {
+                DBG_FAIL("FAT32", "copy_range: cluster copy failed");
+                result = VFSResult::IOError;
+                break;
+            }
+            cache_stats.device_reads++;
+            cache_stats.sectors_read += sectors;
+            for (u32 i = 0; i < run; i++) {
+                cache_update(dst_cluster + i, ra_buffer + i * cluster_size);
+            }
+            
+            in->cursor_cluster = src_tail;
+            in->cursor_index = src_index + done + run - 1;
+            out->cursor_cluster = dst_tail;
+            out->cursor_index = dst_index + done + run - 1;
+            done += run;
+        }
+        
+        u32 bytes = done * cluster_size;
+        src.position += bytes;
+        dst.position += bytes;
+        copied = bytes;
+        if (dst.position > dst.size) {
+            dst.size = dst.position;
+            out->needs_dir_update = true;
+        }
+    }
+    
+    if (result == VFSResult::Success && copied < length) {
+        u64 rest = 0;
+        result = Filesystem::copy_range(src, dst, length - copied, rest);
+        copied += rest;
+    }
+    
+    // Extents, then the size in the directory entry
+    VFSResult flushed = flush(dst);
+    return result != VFSResult::Success ? result : flushed;
+}
+
 // ===========================================================================
 // Directory Operations
 // ===========================================================================
@@ -1226,95 +3050,137 @@ VFSResult FAT32Filesystem::opendir(const char* path, FileDescriptor& fd) {
         return VFSResult::NotDirectory;
     }
     
-    // Allocate state
+    // Allocate state plus a private cluster buffer for the cursor
     FAT32DirState* state = static_cast<FAT32DirState*>(
-        Heap::alloc(sizeof(FAT32DirState))
+        Heap::alloc(sizeof(FAT32DirState), MemTag::FAT32)
     );
     if (!state) return VFSResult::NoSpace;
     
-    state->cluster = entry.get_cluster();
-    state->sector_in_cluster = 0;
-    state->entry_in_sector = 0;
+    state->buffer = static_cast<u8*>(Heap::alloc(cluster_size, MemTag::FAT32));
+    if (!state->buffer) {
+        Heap::free(state);
+        return VFSResult::NoSpace;
+    }
+    
+    u32 dir_cluster = entry.get_cluster();
+    if (dir_cluster == 0) dir_cluster = root_cluster;
+    
+    state->cluster = dir_cluster;
+    state->slot = 0;
+    state->loaded_cluster = 0;
     state->entry_index = 0;
     state->at_end = false;
+    state->lfn.reset();
     
-    fd.inode = entry.get_cluster();
+    fd.inode = dir_cluster;
     fd.type = FileType::Directory;
     fd.fs_data = state;
     
     return VFSResult::Success;
 }
 
-VFSResult FAT32Filesystem::readdir(FileDescriptor& fd, FileInfo& info) {
-    if (!mounted) return VFSResult::NotMounted;
-    
-    FAT32DirState* state = static_cast<FAT32DirState*>(fd.fs_data);
-    if (!state) return VFSResult::BadDescriptor;
-    
-    if (state->at_end) {
-        return VFSResult::NotFound;
+void FAT32Filesystem::format_short_name(const char* name83, char* out) {
+    int pos = 0;
+    for (int j = 0; j < 8 && name83[j] != ' '; j++) {
+        out[pos++] = name83[j];
+    }
+    if (name83[8] != ' ') {
+        out[pos++] = '.';
+        for (int j = 8; j < 11 && name83[j] != ' '; j++) {
+            out[pos++] = name83[j];
+        }
     }
+    out[pos] = '\0';
+}
+
+// Return the next visible entry at the cursor. The cursor is an exact
+// (cluster, slot) position, so each call only touches the slots it skips
+// and a directory cluster is read from disk once per pass.
+VFSResult FAT32Filesystem::next_dir_entry(FAT32DirState* state, FileInfo& info) {
+    u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
     
-    u32 cluster = state->cluster;
-    u32 entry_to_return = state->entry_index;  // Which valid entry to return (0 = first, 1 = second, etc.)
-    u32 valid_count = 0;  // Count of valid (non-deleted, non-LFN, non-volume) entries seen
-    
-    while (cluster != 0 && cluster < 0x0FFFFFF8) {
-        if (!read_cluster(cluster, cluster_buffer)) {
-            return VFSResult::IOError;
+    while (!state->at_end) {
+        if (state->cluster < 2 || state->cluster >= 0x0FFFFFF8) {
+            state->at_end = true;
+            break;
         }
         
-        u32 entries_per_cluster = cluster_size / sizeof(FAT32DirEntry);
-        const FAT32DirEntry* entries = reinterpret_cast<const FAT32DirEntry*>(cluster_buffer);
+        if (state->slot >= entries_per_cluster) {
+            state->cluster = get_next_cluster(state->cluster);
+            state->slot = 0;
+            continue;
+        }
         
-        for (u32 i = 0; i < entries_per_cluster; i++) {
-            if (entries[i].is_end()) {
-                state->at_end = true;
-                return VFSResult::NotFound;
-            }
-            
-            // Skip free/deleted, LFN, and volume label entries
-            if (entries[i].is_free() || entries[i].is_lfn() || 
-                entries[i].is_volume_label()) {
-                continue;
-            }
-            
-            // This is a valid entry
-            if (valid_count == entry_to_return) {
-                // Found the entry we want to return
-                char name[13];
-                int pos = 0;
-                for (int j = 0; j < 8 && entries[i].name[j] != ' '; j++) {
-                    name[pos++] = entries[i].name[j];
-                }
-                if (entries[i].ext[0] != ' ') {
-                    name[pos++] = '.';
-                    for (int j = 0; j < 3 && entries[i].ext[j] != ' '; j++) {
-                        name[pos++] = entries[i].ext[j];
-                    }
-                }
-                name[pos] = '\0';
-                
-                fill_file_info(entries[i], name, info);
-                
-                state->entry_index++;  // Next call returns the next valid entry
-                state->cluster = cluster;
-                
-                return VFSResult::Success;
+        if (state->loaded_cluster != state->cluster) {
+            if (!read_cluster(state->cluster, state->buffer)) {
+                return VFSResult::IOError;
             }
-            
-            valid_count++;
+            state->loaded_cluster = state->cluster;
         }
         
-        cluster = get_next_cluster(cluster);
+        const FAT32DirEntry* entries = reinterpret_cast<const FAT32DirEntry*>(state->buffer);
+        const FAT32DirEntry& e = entries[state->slot++];
+        
+        if (e.is_end()) {
+            state->at_end = true;
+            break;
+        }
+        
+        // Collect LFN fragments; skip free/deleted and volume label entries
+        if (e.is_free() || (e.is_volume_label() && !e.is_lfn())) {
+            state->lfn.reset();
+            continue;
+        }
+        if (e.is_lfn()) {
+            state->lfn.feed(reinterpret_cast<const FAT32LFNEntry&>(e), state->cluster, state->slot - 1);
+            continue;
+        }
+        
+        char name[256];
+        if (!state->lfn.finish(e, name, sizeof(name))) {
+            format_short_name(reinterpret_cast<const char*>(e.name), name);
+        }
+        fill_file_info(e, name, info);
+        state->entry_index++;
+        return VFSResult::Success;
     }
     
-    state->at_end = true;
     return VFSResult::NotFound;
 }
 
+VFSResult FAT32Filesystem::readdir(FileDescriptor& fd, FileInfo& info) {
+    if (!mounted) return VFSResult::NotMounted;
+    
+    FAT32DirState* state = static_cast<FAT32DirState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
+    return next_dir_entry(state, info);
+}
+
+VFSResult FAT32Filesystem::readdir_batch(FileDescriptor& fd, FileInfo* entries,
+                                         u32 max_entries, u32& count) {
+    count = 0;
+    if (!mounted) return VFSResult::NotMounted;
+    
+    FAT32DirState* state = static_cast<FAT32DirState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
+    while (count < max_entries) {
+        VFSResult result = next_dir_entry(state, entries[count]);
+        if (result == VFSResult::NotFound) break;
+        if (result != VFSResult::Success) {
+            return count > 0 ? VFSResult::Success : result;
+        }
+        count++;
+    }
+    
+    return VFSResult::Success;
+}
+
 VFSResult FAT32Filesystem::closedir(FileDescriptor& fd) {
     if (fd.fs_data) {
+        FAT32DirState* state = static_cast<FAT32DirState*>(fd.fs_data);
+        if (state->buffer) Heap::free(state->buffer);
         Heap::free(fd.fs_data);
         fd.fs_data = nullptr;
     }
@@ -1323,6 +3189,7 @@ VFSResult FAT32Filesystem::closedir(FileDescriptor& fd) {
 
 VFSResult FAT32Filesystem::mkdir(const char* path) {
     if (!mounted) return VFSResult::NotMounted;
+    if (read_only) return VFSResult::ReadOnly;
     
     DBG_DEBUG("FAT32", "mkdir: Creating directory");
     Serial::log("FAT32", LogType::Debug, "  Path: ", path);
@@ -1404,6 +3271,7 @@ VFSResult FAT32Filesystem::mkdir(const char* path) {
 
 VFSResult FAT32Filesystem::rmdir(const char* path) {
     if (!mounted) return VFSResult::NotMounted;
+    if (read_only) return VFSResult::ReadOnly;
     
     DBG_DEBUG("FAT32", "rmdir: Removing directory");
     Serial::log("FAT32", LogType::Debug, "  Path: ", path);
@@ -1486,6 +3354,7 @@ VFSResult FAT32Filesystem::stat(const char* path, FileInfo& info) {
 
 VFSResult FAT32Filesystem::unlink(const char* path) {
     if (!mounted) return VFSResult::NotMounted;
+    if (read_only) return VFSResult::ReadOnly;
     
     DBG_DEBUG("FAT32", "unlink: Deleting file");
     Serial::log("FAT32", LogType::Debug, "  Path: ", path);
@@ -1504,6 +3373,12 @@ VFSResult FAT32Filesystem::unlink(const char* path) {
         return VFSResult::IsDirectory;
     }
     
+    // A writer's buffered data and directory update would land on a
+    // deleted entry and leak every cluster it allocates
+    if (has_writer(parent_cluster, reinterpret_cast<const char*>(entry.name))) {
+        return VFSResult::Busy;
+    }
+    
     // Get name from path
     char name[256];
     bolt::storage::path::basename(path, name, sizeof(name));
@@ -1517,9 +3392,147 @@ VFSResult FAT32Filesystem::unlink(const char* path) {
     return VFSResult::Success;
 }
 
-VFSResult FAT32Filesystem::rename(const char* /* old_path */, const char* /* new_path */) {
-    // TODO: Implement
-    return VFSResult::Unsupported;
+// True if dir_cluster is ancestor_cluster or lies somewhere beneath it
+bool FAT32Filesystem::is_within(u32 dir_cluster, u32 ancestor_cluster) {
+    static const char dotdot[11] = {'.', '.', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+    
+    // The depth bound stops a corrupted '..' loop
+    for (u32 depth = 0; depth < 256; depth++) {
+        if (dir_cluster == ancestor_cluster) return true;
+        if (dir_cluster == root_cluster) return false;
+        
+        FAT32DirIndex* index = get_dir_index(dir_cluster);
+        if (!index) return false;
+        FAT32DirIndex::Node* parent = index->find(dotdot);
+        if (!parent) return false;
+        
+        dir_cluster = parent->entry.get_cluster();
+        if (dir_cluster == 0) dir_cluster = root_cluster;
+    }
+    return false;
+}
+
+// Only directory entries move; the cluster chain stays where it is. The new
+// entry is written before the old one is removed, so a crash in between
+// leaves two names for one chain rather than none.
+VFSResult FAT32Filesystem::rename(const char* old_path, const char* new_path) {
+    if (!mounted) return VFSResult::NotMounted;
+    if (read_only) return VFSResult::ReadOnly;
+    
+    DBG_DEBUG("FAT32", "rename: Moving entry");
+    Serial::log("FAT32", LogType::Debug, "  From: ", old_path);
+    Serial::log("FAT32", LogType::Debug, "  To: ", new_path);
+    
+    // Can't rename root
+    if (old_path[0] == '/' && old_path[1] == '\0') {
+        return VFSResult::AccessDenied;
+    }
+    
+    FAT32DirEntry entry;
+    u32 old_parent;
+    if (!find_entry(old_path, entry, old_parent)) {
+        DBG_FAIL("FAT32", "Source not found");
+        return VFSResult::NotFound;
+    }
+    if (old_parent == 0) old_parent = root_cluster;
+    
+    // The entry cannot move underneath a writer's write-back
+    if (!entry.is_directory() && has_writer(old_parent, reinterpret_cast<const char*>(entry.name))) {
+        return VFSResult::Busy;
+    }
+    
+    char parent_path[256];
+    char new_name[256];
+    if (!split_path(new_path, parent_path, new_name)) {
+        return VFSResult::InvalidPath;
+    }
+    if (str::cmp(new_name, ".") == 0 || str::cmp(new_name, "..") == 0) {
+        return VFSResult::InvalidPath;
+    }
+    
+    FAT32DirEntry parent_entry;
+    u32 dummy;
+    if (!find_entry(parent_path, parent_entry, dummy)) {
+        DBG_FAIL("FAT32", "Destination parent not found");
+        return VFSResult::NotFound;
+    }
+    if (!parent_entry.is_directory()) {
+        return VFSResult::NotDirectory;
+    }
+    u32 new_parent = parent_entry.get_cluster();
+    if (new_parent == 0) new_parent = root_cluster;
+    
+    // Locate the source entry itself; its position identifies it below
+    char old_name[256];
+    bolt::storage::path::basename(old_path, old_name, sizeof(old_name));
+    FAT32DirIndex* index = get_dir_index(old_parent);
+    if (!index) return VFSResult::IOError;
+    FAT32DirIndex::Node* node = index->find_long(old_name);
+    if (!node) {
+        char name83[11];
+        to_8_3_name(old_name, name83);
+        node = index->find(name83);
+    }
+    if (!node) return VFSResult::NotFound;
+    u32 entry_cluster = node->cluster;
+    u32 entry_slot = node->slot;
+    
+    // An existing target is only acceptable if it is the source itself
+    // (a change of case within one directory)
+    FAT32DirEntry existing;
+    u32 existing_parent;
+    if (find_entry(new_path, existing, existing_parent)) {
+        if (existing_parent == 0) existing_parent = root_cluster;
+        bool same = existing_parent == old_parent &&
+                    mem::memcmp(existing.name, entry.name, 11) == 0;
+        if (!same) {
+            DBG_WARN("FAT32", "Destination exists");
+            return VFSResult::AlreadyExists;
+        }
+        if (str::cmp(old_name, new_name) == 0) {
+            return VFSResult::Success;
+        }
+    }
+    
+    u32 dir_cluster = entry.get_cluster();
+    bool moves_dir = entry.is_directory() && new_parent != old_parent;
+    if (moves_dir && is_within(new_parent, dir_cluster)) {
+        DBG_FAIL("FAT32", "Cannot move a directory into itself");
+        return VFSResult::InvalidArgument;
+    }
+    
+    if (!link_dir_entry(new_parent, new_name, entry)) {
+        return VFSResult::IOError;
+    }
+    
+    // The index may have been rebuilt or grown by the insert. Short names
+    // are unique within a directory, so the old one still finds the
+    // source; the position check guards against damaged directories.
+    index = get_dir_index(old_parent);
+    node = index ? index->find(reinterpret_cast<const char*>(entry.name)) : nullptr;
+    if (node && (node->cluster != entry_cluster || node->slot != entry_slot)) {
+        node = index->find_at(entry_cluster, entry_slot);
+    }
+    if (!node || !unlink_dir_run(index, node)) {
+        DBG_FAIL("FAT32", "Failed to remove old entry");
+        return VFSResult::IOError;
+    }
+    
+    // A moved directory's '..' must name its new parent
+    if (moves_dir && dir_cluster >= 2) {
+        if (!read_cluster(dir_cluster, cluster_buffer)) {
+            return VFSResult::IOError;
+        }
+        FAT32DirEntry* entries = reinterpret_cast<FAT32DirEntry*>(cluster_buffer);
+        entries[1].set_cluster(new_parent == root_cluster ? 0 : new_parent);
+        if (!write_cluster(dir_cluster, cluster_buffer)) {
+            return VFSResult::IOError;
+        }
+        drop_dir_index(dir_cluster);
+    }
+    
+    DBG_OK("FAT32", "Entry renamed");
+    return VFSResult::Success;
 }
 
 // ===========================================================================
@@ -1534,8 +3547,32 @@ u64 FAT32Filesystem::free_space() const {
     return (u64)free_clusters * cluster_size;
 }
 
+// Buffered file data, then FAT sectors go out before the FSInfo hint and
+// the clean flag, so the flag is only ever set over a consistent volume.
 VFSResult FAT32Filesystem::sync() {
-    // No write caching implemented yet
+    if (!mounted) return VFSResult::NotMounted;
+    
+    VFSResult result = VFSResult::Success;
+    for (FAT32FileState* state = open_files; state; state = state->next_open) {
+        VFSResult r = flush(*state->fd);
+        if (r != VFSResult::Success) result = r;
+    }
+    
+    if (!commit_fat()) {
+        return VFSResult::IOError;
+    }
+    
+    // Data that could not be written keeps the volume dirty
+    if (result != VFSResult::Success) {
+        return result;
+    }
+    
+    if (volume_dirty && !read_only) {
+        if (!write_fsinfo() || !set_volume_clean(true)) {
+            return VFSResult::IOError;
+        }
+    }
+    
     return VFSResult::Success;
 }
 
@@ -1544,7 +3581,7 @@ VFSResult FAT32Filesystem::sync() {
 // ===========================================================================
 
 Filesystem* create_fat32_filesystem() {
-    return new FAT32Filesystem();
+    return new (MemTag::FAT32) FAT32Filesystem();
 }
 
 } // namespace bolt::storage
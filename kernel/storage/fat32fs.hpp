@@ -11,6 +11,7 @@
 #include "../core/types.hpp"
 #include "vfs.hpp"
 #include "block.hpp"
+#include "../core/memory/reclaim.hpp"
 
 namespace bolt::storage {
 
@@ -109,16 +110,117 @@ struct __attribute__((packed)) FAT32FSInfo {
     }
 };
 
+// ===========================================================================
+// VFAT Long File Name Assembly
+// ===========================================================================
+
+// Collects LFN fragments while a directory is scanned front to back.
+// Fragments are stored highest order first, and each one is copied to its
+// final position, so the name is complete when its short entry is reached.
+struct FAT32LFNState {
+    static constexpr u32 MAX_ENTRIES = 20;      // 20 * 13 = 260 UCS-2 chars
+    static constexpr u32 CHARS_PER_ENTRY = 13;
+    
+    u16 chars[MAX_ENTRIES * CHARS_PER_ENTRY];
+    u8  checksum;           // Checksum of the owning short name
+    u8  total;              // Fragments in the run
+    u8  count;              // Fragments collected so far (0 = no run)
+    u8  expect;             // Order of the next fragment
+    u32 start_cluster;      // Position of the first fragment on disk
+    u32 start_slot;
+    
+    void reset() { count = 0; expect = 0; }
+    void feed(const FAT32LFNEntry& lfn, u32 cluster, u32 slot);
+    // Validate against the short entry and emit the name as UTF-8
+    bool finish(const FAT32DirEntry& entry, char* out, u32 out_size);
+};
+
 // ===========================================================================
 // FAT32 Directory Iteration State
 // ===========================================================================
 
 struct FAT32DirState {
-    u32 cluster;
-    u32 sector_in_cluster;
-    u32 entry_in_sector;
-    u32 entry_index;
+    u32 cluster;            // Cluster the cursor is in
+    u32 slot;               // Next 32-byte slot to examine within cluster
+    u32 loaded_cluster;     // Cluster currently held in buffer (0 = none)
+    u32 entry_index;        // Entries returned so far
+    u8* buffer;             // Cached copy of one directory cluster
     bool at_end;
+    FAT32LFNState lfn;      // Long name being assembled
+};
+
+// ===========================================================================
+// FAT32 Directory Index
+// ===========================================================================
+
+// Hashed name -> slot map for one directory, built lazily on first lookup
+// and kept in step with create/update/delete so later lookups and slot
+// allocation cost no directory scan. Entries are hashed twice: by 8.3
+// name and, when present, by long name (both case-insensitive).
+struct FAT32DirIndex {
+    // The bucket tables grow with the directory (two entries per bucket)
+    // up to MAX_BUCKETS. Small directories and a heap without room for a
+    // bigger table use the inline one.
+    static constexpr u32 MIN_BUCKETS = 64;
+    static constexpr u32 MAX_BUCKETS = 8192;
+    static constexpr u32 NIL = 0xFFFFFFFF;
+    static constexpr u32 NO_NAME = 0xFFFFFFFF;
+    
+    struct Node {
+        FAT32DirEntry entry;    // Copy of the on-disk entry
+        u32 cluster;            // Directory cluster holding the entry
+        u16 slot;               // Entry index within that cluster
+        u16 lfn_slot;           // First LFN fragment (if lfn_count > 0)
+        u32 next;               // Next node in 8.3 bucket chain
+        u32 lnext;              // Next node in long-name bucket chain
+        u32 lfn_cluster;
+        u32 long_name;          // Offset into name pool (NO_NAME if none)
+        u8  lfn_count;          // LFN fragments preceding the entry
+    };
+    
+    struct FreeSlot {
+        u32 cluster;
+        u32 slot;
+    };
+    
+    u32 dir_cluster;            // First cluster of the directory (0 = unused)
+    u32 last_cluster;           // Tail of the directory's cluster chain
+    u32 end_cluster;            // Position of the end-of-directory marker
+    u32 end_slot;
+    bool has_end;               // False if the chain has no room past its entries
+    u32 stamp;                  // LRU stamp
+    
+    u32* buckets;               // bucket_count 8.3 chain heads
+    u32* lbuckets;              // bucket_count long-name chain heads
+    u32 bucket_count;           // Power of two
+    u32 inline_buckets[2 * MIN_BUCKETS];
+    Node* nodes;
+    u32 node_count;
+    u32 node_capacity;
+    FreeSlot* free_slots;       // Deleted (0xE5) slots before the end marker
+    u32 free_count;
+    u32 free_capacity;
+    char* names;                // Pool of NUL-terminated long names
+    u32 names_used;
+    u32 names_capacity;
+    
+    void reset(u32 cluster);
+    void release();
+    Node* find(const char* name83);
+    Node* find_long(const char* name);
+    Node* find_at(u32 cluster, u32 slot);   // Entry at an on-disk position
+    const char* long_name(const Node* node) const {
+        return node->long_name == NO_NAME ? nullptr : names + node->long_name;
+    }
+    bool insert(const FAT32DirEntry& entry, u32 cluster, u32 slot, const char* long_name,
+                u32 lfn_cluster, u32 lfn_slot, u32 lfn_count);
+    void remove(Node* node);
+    bool push_free(u32 cluster, u32 slot);
+    void grow_buckets(u32 count);
+    void link(u32 index);
+    usize bucket_bytes() const {
+        return buckets == inline_buckets ? 0 : 2 * bucket_count * sizeof(u32);
+    }
 };
 
 // ===========================================================================
@@ -130,6 +232,135 @@ struct FAT32FileState {
     u32 parent_cluster;     // Parent directory cluster
     char name[12];          // 8.3 name for directory update
     bool needs_dir_update;  // Directory entry needs updating
+    
+    // Sequential read detection
+    u32 ra_window;          // Read-ahead window in clusters
+    u32 ra_next_offset;     // Offset a sequential reader continues from
+    u32 cursor_index;       // Logical index of cursor_cluster in the chain
+    u32 cursor_cluster;     // Last chain position visited (0 = none)
+    
+    // Allocated chain, measured on first write
+    static constexpr u32 CHAIN_UNKNOWN = 0xFFFFFFFF;
+    u32 chain_length;       // Clusters in the chain
+    u32 last_cluster;       // Tail of the chain (0 = empty)
+    
+    // Delayed allocation: dirty bytes held until flush or close
+    u8* wbuf;
+    u32 wbuf_offset;        // File offset of wbuf[0]
+    u32 wbuf_len;
+    u32 wbuf_capacity;
+    
+    // Open files on the volume, so sync() can flush them
+    FileDescriptor* fd;
+    FAT32FileState* next_open;
+};
+
+// ===========================================================================
+// FAT32 Cluster Cache
+// ===========================================================================
+
+struct FAT32CacheSlot {
+    u32 cluster;            // Cached cluster (0 = empty)
+    u32 stamp;              // LRU stamp
+    bool prefetched;        // Loaded by read-ahead and not yet used
+    u8* data;
+};
+
+// ===========================================================================
+// FAT32 FAT Sector Cache
+// ===========================================================================
+
+// FAT[1] flag bits (FAT32)
+constexpr u32 FAT32_CLEAN_SHUTDOWN = 0x08000000;  // Clear while mounted read-write
+constexpr u32 FAT32_NO_DISK_ERROR  = 0x04000000;  // Clear after an I/O error
+
+// FAT updates stay in these slots until commit_fat(), so file data reaches
+// the disk before the FAT that references it.
+struct FAT32FatSlot {
+    static constexpr u32 EMPTY = 0xFFFFFFFF;
+    
+    u32 sector;             // Sector index within the FAT (EMPTY = unused)
+    u32 stamp;              // LRU stamp
+    bool dirty;             // Modified since the last commit
+    u32* data;
+};
+
+// ===========================================================================
+// FAT32 Consistency Check
+// ===========================================================================
+
+struct FAT32CheckReport {
+    u32 fat_copies;
+    u32 clusters;           // Data clusters on the volume
+    u32 free;               // Free clusters counted in the FAT
+    u32 free_recorded;      // Free count before the check (0xFFFFFFFF = unknown)
+    u32 bad;                // Clusters marked bad
+    u32 chains;             // Chain heads (files and directories)
+    u32 bad_links;          // Links outside the data area
+    u32 cross_links;        // Clusters reached from two chains
+    u32 dangling_links;     // Links into free clusters
+    u32 mirror_mismatches;  // FAT sectors that differ between copies
+    u32 repaired;           // Entries or sectors rewritten
+    u32 sectors_read;       // FAT sectors streamed from disk
+    bool was_clean;         // Clean-shutdown bit when the check started
+    
+    void clear() {
+        fat_copies = 0;
+        clusters = 0;
+        free = 0;
+        free_recorded = 0xFFFFFFFF;
+        bad = 0;
+        chains = 0;
+        bad_links = 0;
+        cross_links = 0;
+        dangling_links = 0;
+        mirror_mismatches = 0;
+        repaired = 0;
+        sectors_read = 0;
+        was_clean = false;
+    }
+    
+    u32 errors() const {
+        return bad_links + cross_links + dangling_links + mirror_mismatches;
+    }
+};
+
+// ===========================================================================
+// FAT32 Space Map Statistics
+// ===========================================================================
+
+// Filled by the mount-time FAT scan. Histograms count runs by length in
+// clusters: bucket n holds lengths 2^n .. 2^(n+1)-1.
+struct FAT32SpaceStats {
+    static constexpr u32 BUCKETS = 16;
+    
+    bool valid;                 // A full scan has completed
+    u32 free_clusters;
+    u32 used_clusters;
+    u32 bad_clusters;
+    u32 chains;                 // Chain heads (files and directories)
+    u32 extents;                // Contiguous runs inside chains
+    u32 free_runs;
+    u32 largest_free_run;
+    u32 extent_hist[BUCKETS];
+    u32 free_hist[BUCKETS];
+    u32 scan_ms;
+    
+    void clear() {
+        valid = false;
+        free_clusters = 0;
+        used_clusters = 0;
+        bad_clusters = 0;
+        chains = 0;
+        extents = 0;
+        free_runs = 0;
+        largest_free_run = 0;
+        for (u32 i = 0; i < BUCKETS; i++) {
+            extent_hist[i] = 0;
+            free_hist[i] = 0;
+        }
+        scan_ms = 0;
+    }
 };
 
 // ===========================================================================
@@ -153,9 +384,13 @@ public:
     VFSResult read(FileDescriptor& fd, void* buffer, u64 size, u64& bytes_read) override;
     VFSResult write(FileDescriptor& fd, const void* buffer, u64 size, u64& bytes_written) override;
     VFSResult seek(FileDescriptor& fd, i64 offset, SeekMode mode) override;
+    VFSResult flush(FileDescriptor& fd) override;
+    VFSResult fallocate(FileDescriptor& fd, u64 offset, u64 length) override;
+    VFSResult copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) override;
     
     VFSResult opendir(const char* path, FileDescriptor& fd) override;
     VFSResult readdir(FileDescriptor& fd, FileInfo& info) override;
+    VFSResult readdir_batch(FileDescriptor& fd, FileInfo* entries, u32 max_entries, u32& count) override;
     VFSResult closedir(FileDescriptor& fd) override;
     VFSResult mkdir(const char* path) override;
     VFSResult rmdir(const char* path) override;
@@ -168,11 +403,26 @@ public:
     u64 free_space() const override;
     
     VFSResult sync() override;
+    bool get_cache_stats(FSCacheStats& stats) const override;
     
     // FAT32-specific info
     const char* get_volume_label() const { return volume_label; }
     u32 get_cluster_size() const { return cluster_size; }
     
+    // Stream every FAT copy, compare them and validate the chains. With
+    // repair set, bad links are cut and mirrors rewritten from FAT 0.
+    bool check(FAT32CheckReport& report, bool repair);
+    
+    // Space map: free bitmap, exact free count and fragmentation histograms
+    bool scan_space();
+    const FAT32SpaceStats& get_space_stats() const { return space_stats; }
+    u32 get_total_clusters() const { return total_clusters; }
+    u32 get_free_clusters() const { return free_clusters; }
+    
+    // Build the space map during mount (on by default)
+    static void set_mount_scan(bool enable) { mount_scan = enable; }
+    static bool get_mount_scan() { return mount_scan; }
+    
 private:
     // FAT operations
     u32 get_next_cluster(u32 cluster);
@@ -185,21 +435,74 @@ private:
     bool set_fat_entry(u32 cluster, u32 value);   // Write FAT entry
     bool free_cluster_chain(u32 start_cluster);   // Free a chain of clusters
     u32 extend_cluster_chain(u32 last_cluster);   // Add a cluster to an existing chain
+    bool alloc_extent(u32 count, u32 hint, u32& first, u32& length);  // Contiguous run
+    bool set_fat_run(u32 first, u32 count);       // Link a run in one FAT update
+    
+    // FAT sector cache and write ordering
+    FAT32FatSlot* fat_slot(u32 sector);           // Lookup or load
+    u32* fat_sector(u32 sector, bool modify);     // Cached FAT sector
+    bool write_fat_sector(FAT32FatSlot& slot);    // Write to every FAT copy
+    bool commit_fat();                            // Batched write-back to all copies
+    bool write_fsinfo();
+    
+    // Clean-shutdown flag (FAT[1] bit 27) and the check run when it is clear
+    bool set_volume_clean(bool clean);
+    void mark_volume_dirty();
+    bool check_volume();
     
     // Write support - Directory operations
-    bool create_dir_entry(u32 parent_cluster, const char* name, u8 attr, u32 file_cluster, u32 file_size);
+    bool create_dir_entry(u32 parent_cluster, const char* name, u8 attr, u32 file_cluster, u32 file_size,
+                          char* out_name83 = nullptr);
+    bool link_dir_entry(u32 parent_cluster, const char* name, const FAT32DirEntry& source,
+                        char* out_name83 = nullptr);  // Entry copied from source, renamed
     bool update_dir_entry(u32 parent_cluster, const char* name83, u32 new_size, u32 new_cluster);
     bool delete_dir_entry(u32 parent_cluster, const char* name, bool already_8_3 = false);
-    u32 find_free_dir_entry(u32 parent_cluster);  // Find slot for new entry
+    bool unlink_dir_run(FAT32DirIndex* index, FAT32DirIndex::Node* node);  // Entry and its LFN run
+    bool is_within(u32 dir_cluster, u32 ancestor_cluster);  // Walks '..' links
+    bool find_free_dir_entry(FAT32DirIndex* index, u32 count, u32& cluster, u32& slot, bool& at_end);
+    bool write_dir_slots(u32 cluster, u32 slot, const FAT32DirEntry* entries, u32 count);
+    bool advance_slot(u32& cluster, u32& slot);   // Step one entry along the chain
+    bool make_short_name(FAT32DirIndex* index, const char* name, char* out83, bool& needs_lfn);
+    
+    // Directory index cache
+    FAT32DirIndex* get_dir_index(u32 dir_cluster);  // Lookup or build
+    bool build_dir_index(FAT32DirIndex* index, u32 dir_cluster);
+    void drop_dir_index(u32 dir_cluster);
     
     // Directory operations
     bool find_entry(const char* path, FAT32DirEntry& entry, u32& parent_cluster);
     bool read_dir_entry(u32 cluster, u32 index, FAT32DirEntry& entry, char* long_name);
     void fill_file_info(const FAT32DirEntry& entry, const char* name, FileInfo& info);
+    VFSResult next_dir_entry(FAT32DirState* state, FileInfo& info);  // Advance cursor
+    void format_short_name(const char* name83, char* out);
     
     // File operations
-    VFSResult read_file_data(u32 start_cluster, u64 offset, void* buffer, 
+    VFSResult read_file_data(FAT32FileState* state, u64 offset, void* buffer, 
                              u64 size, u64 file_size, u64& bytes_read);
+    void init_file_state(FAT32FileState* state, u32 start_cluster, u32 parent_cluster);
+    void attach_file(FAT32FileState* state, FileDescriptor& fd);
+    void detach_file(FAT32FileState* state);
+    bool has_writer(u32 parent_cluster, const char* name83) const;
+    u32 seek_cluster(FAT32FileState* state, u32 index);  // Chain walk via cursor
+    bool ensure_chain(FAT32FileState* state, u32 clusters);
+    VFSResult write_file_data(FAT32FileState* state, u32 offset, const u8* src, u32 size);
+    bool zero_clusters(FAT32FileState* state, u32 first_index, u32 count);
+    
+    void release_buffers();
+    VFSResult mount_failed(VFSResult result);       // Frees what mount allocated
+    
+    // Memory pressure: directory indexes, then the clean cluster cache,
+    // then the space map are handed back to the heap
+    usize reclaimable_bytes() const;
+    usize shrink(usize target);
+    static usize shrinker_count(void* ctx);
+    static usize shrinker_scan(void* ctx, usize target);
+    
+    // Cluster cache
+    bool grow_cluster_cache();                   // (Re)allocate cache_data
+    const u8* cache_lookup(u32 cluster);
+    void cache_insert(u32 cluster, const u8* data, bool prefetched);
+    void cache_update(u32 cluster, const void* data);    // Write-through
     
     // Path utilities
     bool split_path(const char* path, char* dir, char* name);
@@ -224,18 +527,59 @@ private:
     u32 root_cluster;
     u32 total_clusters;
     u32 free_clusters;
+    bool free_count_valid;  // free_clusters came from FSInfo or a scan
     u32 next_free_cluster;  // Hint for finding free clusters
     u32 fs_info_sector;     // Location of FSInfo
     char volume_label[12];
-    bool fat_dirty;         // FAT needs to be written back
+    bool fat_dirty;         // FAT cache holds uncommitted sectors
+    bool volume_dirty;      // Clean-shutdown bit is cleared on disk
+    bool read_only;         // Device is write-protected: no repair, no writes
     
     // Sector buffer
     static constexpr u32 SECTOR_SIZE = 512;
     static constexpr u32 MAX_CLUSTER_SIZE = 32 * SECTOR_SIZE;  // 32 sectors max
     u8* sector_buffer;
     u8* cluster_buffer;
-    u32 cached_fat_sector;
-    u32* fat_cache;  // One sector of FAT
+    
+    // FAT sector cache (write-back)
+    static constexpr u32 FAT_CACHE_SECTORS = 16;
+    FAT32FatSlot fat_slots[FAT_CACHE_SECTORS];
+    u32 fat_clock;
+    u8* fat_cache;
+    u8* fat_stage;          // Dirty sectors gathered into runs for commit
+    
+    // Streaming FAT check batch size
+    static constexpr u32 CHECK_BATCH_BYTES = 64 * 1024;
+    
+    // Free-cluster bitmap (bit set = free), null until a scan builds it
+    u8* free_map;
+    FAT32SpaceStats space_stats;
+    static bool mount_scan;
+    
+    // Cluster cache and read-ahead staging buffer. The cache gives its
+    // data back under memory pressure, so it can be generous.
+    static constexpr u32 CACHE_BYTES = 256 * 1024;
+    static constexpr u32 READAHEAD_BYTES = 32 * 1024;
+    FAT32CacheSlot* cache_slots;
+    u32 cache_count;        // Live slots (0 while reclaimed)
+    u32 cache_target;       // Slots allocated at mount
+    u32 cache_clock;
+    u8* cache_data;
+    u8* ra_buffer;
+    u32 ra_max_clusters;
+    FSCacheStats cache_stats;
+    
+    // Per-file write buffer limit before dirty data is allocated and written
+    static constexpr u32 WRITE_BUFFER_BYTES = 64 * 1024;
+    FAT32FileState* open_files;
+    
+    // Recently used directory indexes (LRU)
+    static constexpr u32 DIR_INDEX_CACHE = 4;
+    FAT32DirIndex dir_index[DIR_INDEX_CACHE];
+    u32 dir_index_clock;
+    FAT32LFNState lfn_scratch;  // LFN assembly while building an index
+    
+    mem::Shrinker shrinker;
     
     // Read helpers
     bool read_sector(u64 lba, void* buffer);
@@ -3,6 +3,7 @@
  * =========================================================================== */
 
 #include "partition.hpp"
+#include "../core/memory/heap.hpp"
 #include "../drivers/serial/serial.hpp"
 #include "../drivers/video/console.hpp"
 #include "../lib/string.hpp"
@@ -332,7 +333,7 @@ u32 PartitionManager::parse_gpt(BlockDevice* device) {
 
 bool PartitionManager::create_partition(BlockDevice* parent, const PartitionInfo& info) {
     // Create partition device wrapper
-    PartitionDevice* part = new PartitionDevice(
+    PartitionDevice* part = new (mem::MemTag::Device) PartitionDevice(
         parent, 
         info.start_lba, 
         info.sector_count,
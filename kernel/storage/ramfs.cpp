@@ -6,6 +6,7 @@
 #include "../drivers/serial/serial.hpp"
 #include "../lib/string.hpp"
 #include "../core/memory/heap.hpp"
+#include "../core/memory/vmm.hpp"
 
 namespace bolt::storage {
 
@@ -75,9 +76,8 @@ VFSResult RAMFilesystem::unmount() {
     
     // Free all file data
     for (u32 i = 0; i < MAX_NODES; i++) {
-        if (nodes[i].is_valid() && nodes[i].data) {
-            Heap::free(nodes[i].data);
-            nodes[i].data = nullptr;
+        if (nodes[i].is_valid()) {
+            free_data(&nodes[i]);
         }
         nodes[i].init();
     }
@@ -113,10 +113,7 @@ void RAMFilesystem::free_node(RAMFSNode* node) {
     if (!node || !node->is_valid()) return;
     
     // Free file data
-    if (node->data) {
-        used_bytes -= node->capacity;
-        Heap::free(node->data);
-    }
+    free_data(node);
     
     // Remove from parent's children list
     if (node->parent_id != RAMFSNode::INVALID_ID) {
@@ -271,13 +268,8 @@ VFSResult RAMFilesystem::open(const char* path, FileMode mode, FileDescriptor& f
     
     // Truncate if requested
     if (has_flag(mode, FileMode::Truncate)) {
-        if (node->data) {
-            used_bytes -= node->capacity;
-            Heap::free(node->data);
-            node->data = nullptr;
-            node->size = 0;
-            node->capacity = 0;
-        }
+        free_data(node);
+        node->size = 0;
     }
     
     // Set up file descriptor
@@ -400,6 +392,80 @@ VFSResult RAMFilesystem::seek(FileDescriptor& fd, i64 offset, SeekMode mode) {
     return VFSResult::Success;
 }
 
+VFSResult RAMFilesystem::fallocate(FileDescriptor& fd, u64 offset, u64 length) {
+    if (!mounted) return VFSResult::NotMounted;
+    
+    RAMFSNode* node = static_cast<RAMFSNode*>(fd.fs_data);
+    if (!node) return VFSResult::BadDescriptor;
+    
+    u64 new_end = offset + length;
+    if (new_end > MAX_FILE_SIZE) {
+        return VFSResult::NoSpace;
+    }
+    
+    // Reserve the whole range now so later writes never reallocate
+    if (new_end > node->capacity) {
+        if (!resize_file(node, new_end)) {
+            return VFSResult::NoSpace;
+        }
+    }
+    
+    if (new_end > node->size) {
+        for (u64 i = node->size; i < new_end; i++) {
+            node->data[i] = 0;
+        }
+        node->size = new_end;
+    }
+    fd.size = node->size;
+    
+    return VFSResult::Success;
+}
+
+// Both files live in memory, so the copy is one pass from source
+// buffer to destination buffer with the destination sized up front
+VFSResult RAMFilesystem::copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) {
+    copied = 0;
+    if (!mounted) return VFSResult::NotMounted;
+    
+    RAMFSNode* in = static_cast<RAMFSNode*>(src.fs_data);
+    RAMFSNode* out = static_cast<RAMFSNode*>(dst.fs_data);
+    if (!in || !out) return VFSResult::BadDescriptor;
+    
+    // Overlapping ranges within one file need the bounce buffer
+    if (in == out) {
+        return Filesystem::copy_range(src, dst, length, copied);
+    }
+    
+    if (src.position >= in->size) return VFSResult::Success;
+    if (length > in->size - src.position) length = in->size - src.position;
+    
+    u64 new_end = dst.position + length;
+    if (new_end > MAX_FILE_SIZE) return VFSResult::NoSpace;
+    
+    if (new_end > out->capacity) {
+        if (!resize_file(out, new_end)) {
+            return VFSResult::NoSpace;
+        }
+    }
+    
+    // A gap before the destination position reads back as zeros
+    for (u64 i = out->size; i < dst.position; i++) {
+        out->data[i] = 0;
+    }
+    
+    mem::memcpy(out->data + dst.position, in->data + src.position, static_cast<usize>(length));
+    
+    src.position += length;
+    dst.position += length;
+    if (dst.position > out->size) {
+        out->size = dst.position;
+    }
+    dst.size = out->size;
+    copied = length;
+    
+    return VFSResult::Success;
+}
+
 bool RAMFilesystem::resize_file(RAMFSNode* node, u64 new_size) {
     // Round up to 4KB blocks
     u64 new_cap = (new_size + 4095) & ~4095ULL;
@@ -411,7 +477,22 @@ bool RAMFilesystem::resize_file(RAMFSNode* node, u64 new_size) {
         return false;
     }
     
-    u8* new_data = static_cast<u8*>(Heap::alloc(new_cap));
+    // With paging on, a file gets address space for its largest size up
+    // front. Growing it is then only bookkeeping: pages appear zero-filled
+    // on first touch and nothing is ever copied.
+    if (!node->data && VMM::is_paging_enabled()) {
+        node->area = VMM::reserve(static_cast<u32>(MAX_FILE_SIZE), PageFlags::KernelPage, "ramfs");
+        if (node->area) {
+            node->data = reinterpret_cast<u8*>(static_cast<usize>(node->area));
+        }
+    }
+    if (node->area) {
+        used_bytes += delta;
+        node->capacity = new_cap;
+        return true;
+    }
+    
+    u8* new_data = static_cast<u8*>(Heap::alloc(new_cap, MemTag::RAMFS));
     if (!new_data) {
         return false;
     }
@@ -438,6 +519,20 @@ bool RAMFilesystem::resize_file(RAMFSNode* node, u64 new_size) {
     return true;
 }
 
+void RAMFilesystem::free_data(RAMFSNode* node) {
+    if (!node->data) return;
+    
+    used_bytes -= node->capacity;
+    if (node->area) {
+        VMM::release(node->area);
+    } else {
+        Heap::free(node->data);
+    }
+    node->data = nullptr;
+    node->capacity = 0;
+    node->area = 0;
+}
+
 // ===========================================================================
 // Directory Operations
 // ===========================================================================
@@ -453,7 +548,7 @@ VFSResult RAMFilesystem::opendir(const char* path, FileDescriptor& fd) {
     }
     
     // Allocate directory state
-    RAMFSDirState* state = static_cast<RAMFSDirState*>(Heap::alloc(sizeof(RAMFSDirState)));
+    RAMFSDirState* state = static_cast<RAMFSDirState*>(Heap::alloc(sizeof(RAMFSDirState), MemTag::RAMFS));
     if (!state) return VFSResult::NoSpace;
     
     state->node_id = node->id;
@@ -490,6 +585,29 @@ VFSResult RAMFilesystem::readdir(FileDescriptor& fd, FileInfo& info) {
     return VFSResult::Success;
 }
 
+VFSResult RAMFilesystem::readdir_batch(FileDescriptor& fd, FileInfo* entries,
+                                       u32 max_entries, u32& count) {
+    count = 0;
+    if (!mounted) return VFSResult::NotMounted;
+    
+    RAMFSDirState* state = static_cast<RAMFSDirState*>(fd.fs_data);
+    if (!state) return VFSResult::BadDescriptor;
+    
+    // Resolve the directory once for the whole batch
+    RAMFSNode* dir = get_node(state->node_id);
+    if (!dir || !dir->is_directory()) {
+        return VFSResult::NotDirectory;
+    }
+    
+    while (count < max_entries && state->index < dir->child_count) {
+        RAMFSNode* child = get_node(dir->children[state->index++]);
+        if (!child) continue;
+        fill_info(child, entries[count++]);
+    }
+    
+    return VFSResult::Success;
+}
+
 VFSResult RAMFilesystem::closedir(FileDescriptor& fd) {
     if (fd.fs_data) {
         Heap::free(fd.fs_data);
@@ -33,6 +33,7 @@ struct RAMFSNode {
     u8*         data;
     u64         size;
     u64         capacity;
+    u32         area;             // Demand-paged VMM area behind data, 0 for a heap block
     
     // Metadata
     u32         permissions;
@@ -51,6 +52,7 @@ struct RAMFSNode {
         data = nullptr;
         size = 0;
         capacity = 0;
+        area = 0;
         permissions = 0755;
         created = 0;
         modified = 0;
@@ -94,9 +96,12 @@ public:
     VFSResult read(FileDescriptor& fd, void* buffer, u64 size, u64& bytes_read) override;
     VFSResult write(FileDescriptor& fd, const void* buffer, u64 size, u64& bytes_written) override;
     VFSResult seek(FileDescriptor& fd, i64 offset, SeekMode mode) override;
+    VFSResult fallocate(FileDescriptor& fd, u64 offset, u64 length) override;
+    VFSResult copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) override;
     
     VFSResult opendir(const char* path, FileDescriptor& fd) override;
     VFSResult readdir(FileDescriptor& fd, FileInfo& info) override;
+    VFSResult readdir_batch(FileDescriptor& fd, FileInfo* entries, u32 max_entries, u32& count) override;
     VFSResult closedir(FileDescriptor& fd) override;
     VFSResult mkdir(const char* path) override;
     VFSResult rmdir(const char* path) override;
@@ -127,6 +132,7 @@ private:
     
     // Data management
     bool resize_file(RAMFSNode* node, u64 new_size);
+    void free_data(RAMFSNode* node);
     
     // Fill FileInfo from node
     void fill_info(RAMFSNode* node, FileInfo& info);
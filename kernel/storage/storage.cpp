@@ -3,6 +3,7 @@
  * =========================================================================== */
 
 #include "storage.hpp"
+#include "../core/memory/heap.hpp"
 #include "../drivers/serial/serial.hpp"
 #include "../drivers/video/console.hpp"
 #include "../lib/string.hpp"
@@ -183,7 +184,7 @@ bool Storage::mount_root() {
 
 bool Storage::mount_ramfs_fallback() {
     // Create RAMFS instance
-    RAMFilesystem* ramfs = new RAMFilesystem();
+    RAMFilesystem* ramfs = new (mem::MemTag::RAMFS) RAMFilesystem();
     if (!ramfs) {
         DBG_FAIL("STORAGE", "Failed to create RAMFS");
         return false;
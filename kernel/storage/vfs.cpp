@@ -7,10 +7,12 @@
 #include "../drivers/serial/serial.hpp"
 #include "../drivers/video/console.hpp"
 #include "../lib/string.hpp"
+#include "../core/memory/heap.hpp"
 
 namespace bolt::storage {
 
 using namespace drivers;
+using namespace mem;
 
 // Static storage
 MountPoint VFS::mounts[MAX_MOUNTS];
@@ -142,7 +144,7 @@ VFSResult VFS::mount(const char* device_name, const char* mount_point, Filesyste
     mp.fs = fs;
     mp.device = device;
     mp.fs_type = fs_type;
-    mp.read_only = false;
+    mp.read_only = device->get_info().read_only;
     mp.active = true;
     
     Serial::write("[VFS] Mounted ");
@@ -382,10 +384,118 @@ VFSResult VFS::seek(u32 fd, i64 offset, SeekMode mode) {
     return desc.fs->seek(desc, offset, mode);
 }
 
+VFSResult VFS::flush(u32 fd) {
+    if (!initialized) return VFSResult::NotMounted;
+    if (fd >= MAX_OPEN_FILES || !file_descriptors[fd].valid) {
+        return VFSResult::BadDescriptor;
+    }
+    
+    FileDescriptor& desc = file_descriptors[fd];
+    if (!desc.fs) return VFSResult::IOError;
+    
+    return desc.fs->flush(desc);
+}
+
+VFSResult VFS::fallocate(u32 fd, u64 offset, u64 length) {
+    if (!initialized) return VFSResult::NotMounted;
+    if (fd >= MAX_OPEN_FILES || !file_descriptors[fd].valid) {
+        return VFSResult::BadDescriptor;
+    }
+    if (length == 0) return VFSResult::InvalidArgument;
+    
+    FileDescriptor& desc = file_descriptors[fd];
+    if (!desc.fs) return VFSResult::IOError;
+    
+    if (!has_flag(desc.mode, FileMode::Write)) {
+        return VFSResult::AccessDenied;
+    }
+    
+    return desc.fs->fallocate(desc, offset, length);
+}
+
+// Read/write loop for filesystems without a native copy, and for copies
+// between two filesystems
+static constexpr u32 COPY_BUFFER_BYTES = 64 * 1024;
+
+static VFSResult copy_buffered(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) {
+    copied = 0;
+    if (length == 0) return VFSResult::Success;
+    
+    u32 chunk = length < COPY_BUFFER_BYTES ? static_cast<u32>(length) : COPY_BUFFER_BYTES;
+    u8* buffer = static_cast<u8*>(Heap::alloc(chunk, MemTag::VFS));
+    if (!buffer) return VFSResult::NoSpace;
+    
+    VFSResult result = VFSResult::Success;
+    while (copied < length) {
+        u64 want = length - copied < chunk ? length - copied : chunk;
+        u64 got = 0;
+        result = src.fs->read(src, buffer, want, got);
+        if (result != VFSResult::Success || got == 0) break;
+        
+        u64 put = 0;
+        result = dst.fs->write(dst, buffer, got, put);
+        copied += put;
+        if (result != VFSResult::Success) break;
+        if (put != got) {
+            result = VFSResult::NoSpace;
+            break;
+        }
+    }
+    
+    Heap::free(buffer);
+    return result;
+}
+
+VFSResult Filesystem::copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied) {
+    return copy_buffered(src, dst, length, copied);
+}
+
+VFSResult VFS::copy_range(u32 src_fd, u32 dst_fd, u64 length, u64& copied) {
+    copied = 0;
+    if (!initialized) return VFSResult::NotMounted;
+    if (src_fd >= MAX_OPEN_FILES || !file_descriptors[src_fd].valid ||
+        dst_fd >= MAX_OPEN_FILES || !file_descriptors[dst_fd].valid) {
+        return VFSResult::BadDescriptor;
+    }
+    if (src_fd == dst_fd) return VFSResult::InvalidArgument;
+    
+    FileDescriptor& src = file_descriptors[src_fd];
+    FileDescriptor& dst = file_descriptors[dst_fd];
+    if (!src.fs || !dst.fs) return VFSResult::IOError;
+    if (src.type != FileType::Regular || dst.type != FileType::Regular) {
+        return VFSResult::IsDirectory;
+    }
+    
+    if (!has_flag(src.mode, FileMode::Read) || !has_flag(dst.mode, FileMode::Write)) {
+        return VFSResult::AccessDenied;
+    }
+    
+    if (src.fs == dst.fs) {
+        return src.fs->copy_range(src, dst, length, copied);
+    }
+    return copy_buffered(src, dst, length, copied);
+}
+
 // ===========================================================================
 // Directory Operations
 // ===========================================================================
 
+// Generic batch read built on readdir; filesystems with a cheaper
+// cursor override this.
+VFSResult Filesystem::readdir_batch(FileDescriptor& fd, FileInfo* entries,
+                                    u32 max_entries, u32& count) {
+    count = 0;
+    while (count < max_entries) {
+        VFSResult result = readdir(fd, entries[count]);
+        if (result == VFSResult::NotFound) break;
+        if (result != VFSResult::Success) {
+            return count > 0 ? VFSResult::Success : result;
+        }
+        count++;
+    }
+    return VFSResult::Success;
+}
+
 VFSResult VFS::opendir(const char* path, u32& fd) {
     if (!initialized) return VFSResult::NotMounted;
     if (!path) return VFSResult::InvalidPath;
@@ -426,6 +536,23 @@ VFSResult VFS::readdir(u32 fd, FileInfo& info) {
     return desc.fs->readdir(desc, info);
 }
 
+VFSResult VFS::getdents(u32 fd, FileInfo* entries, u32 max_entries, u32& count) {
+    count = 0;
+    if (!initialized) return VFSResult::NotMounted;
+    if (!entries) return VFSResult::InvalidArgument;
+    if (fd >= MAX_OPEN_FILES || !file_descriptors[fd].valid) {
+        return VFSResult::BadDescriptor;
+    }
+    
+    FileDescriptor& desc = file_descriptors[fd];
+    if (desc.type != FileType::Directory) {
+        return VFSResult::NotDirectory;
+    }
+    if (!desc.fs) return VFSResult::IOError;
+    
+    return desc.fs->readdir_batch(desc, entries, max_entries, count);
+}
+
 VFSResult VFS::closedir(u32 fd) {
     if (!initialized) return VFSResult::NotMounted;
     if (fd >= MAX_OPEN_FILES || !file_descriptors[fd].valid) {
@@ -593,6 +720,17 @@ VFSResult VFS::sync_all() {
     
     VFSResult result = VFSResult::Success;
     
+    // Push buffered file data down before the filesystems sync
+    for (u32 i = 0; i < MAX_OPEN_FILES; i++) {
+        FileDescriptor& desc = file_descriptors[i];
+        if (desc.valid && desc.fs && desc.type == FileType::Regular) {
+            VFSResult r = desc.fs->flush(desc);
+            if (r != VFSResult::Success) {
+                result = r;
+            }
+        }
+    }
+    
     for (u32 i = 0; i < mount_count; i++) {
         if (mounts[i].active && mounts[i].fs) {
             VFSResult r = mounts[i].fs->sync();
@@ -179,6 +179,34 @@ enum class VFSResult : u8 {
 
 const char* vfs_result_string(VFSResult result);
 
+// ===========================================================================
+// Filesystem Cache Statistics
+// ===========================================================================
+
+struct FSCacheStats {
+    u32 block_size;         // Cache block size in bytes
+    u32 blocks;             // Cache capacity in blocks
+    u32 hits;               // Lookups served from the cache
+    u32 misses;             // Lookups that went to the device
+    u32 readahead_issued;   // Blocks fetched ahead of the reader
+    u32 readahead_hits;     // Read-ahead blocks later consumed
+    u32 readahead_wasted;   // Read-ahead blocks evicted unused
+    u32 device_reads;       // read_sectors calls
+    u32 sectors_read;
+    
+    void clear() {
+        block_size = 0;
+        blocks = 0;
+        hits = 0;
+        misses = 0;
+        readahead_issued = 0;
+        readahead_hits = 0;
+        readahead_wasted = 0;
+        device_reads = 0;
+        sectors_read = 0;
+    }
+};
+
 // ===========================================================================
 // Mount Point
 // ===========================================================================
@@ -226,9 +254,25 @@ public:
     virtual VFSResult write(FileDescriptor& fd, const void* buffer, u64 size, u64& bytes_written) = 0;
     virtual VFSResult seek(FileDescriptor& fd, i64 offset, SeekMode mode) = 0;
     
+    // Write out data buffered for this descriptor
+    virtual VFSResult flush(FileDescriptor& /* fd */) { return VFSResult::Success; }
+    
+    // Reserve storage for [offset, offset + length); the file grows with
+    // zeros if the range ends past its size
+    virtual VFSResult fallocate(FileDescriptor& /* fd */, u64 /* offset */, u64 /* length */) {
+        return VFSResult::Unsupported;
+    }
+    
+    // Copy up to length bytes from src's position to dst's position, both
+    // on this filesystem, advancing both. Stops early at the end of src.
+    // The default goes through a large bounce buffer.
+    virtual VFSResult copy_range(FileDescriptor& src, FileDescriptor& dst, u64 length, u64& copied);
+    
     // Directory operations
     virtual VFSResult opendir(const char* path, FileDescriptor& fd) = 0;
     virtual VFSResult readdir(FileDescriptor& fd, FileInfo& info) = 0;
+    // Fill up to max_entries; count == 0 means end of directory
+    virtual VFSResult readdir_batch(FileDescriptor& fd, FileInfo* entries, u32 max_entries, u32& count);
     virtual VFSResult closedir(FileDescriptor& fd) = 0;
     virtual VFSResult mkdir(const char* path) = 0;
     virtual VFSResult rmdir(const char* path) = 0;
@@ -246,6 +290,12 @@ public:
     // Sync all pending writes
     virtual VFSResult sync() = 0;
     
+    // Buffer cache statistics (false if the filesystem has no cache)
+    virtual bool get_cache_stats(FSCacheStats& stats) const {
+        stats.clear();
+        return false;
+    }
+    
     // Is filesystem mounted?
     bool is_mounted() const { return mounted; }
     
@@ -283,10 +333,14 @@ public:
     static VFSResult read(u32 fd, void* buffer, u64 size, u64& bytes_read);
     static VFSResult write(u32 fd, const void* buffer, u64 size, u64& bytes_written);
     static VFSResult seek(u32 fd, i64 offset, SeekMode mode);
+    static VFSResult flush(u32 fd);
+    static VFSResult fallocate(u32 fd, u64 offset, u64 length);
+    static VFSResult copy_range(u32 src_fd, u32 dst_fd, u64 length, u64& copied);
     
     // Directory operations
     static VFSResult opendir(const char* path, u32& fd);
     static VFSResult readdir(u32 fd, FileInfo& info);
+    static VFSResult getdents(u32 fd, FileInfo* entries, u32 max_entries, u32& count);
     static VFSResult closedir(u32 fd);
     static VFSResult mkdir(const char* path);
     static VFSResult rmdir(const char* path);
@@ -0,0 +1,64 @@
+#!/usr/bin/env bash
+# ==============================================================================
+# BOLT OS - Benchmark Regression Check
+# ==============================================================================
+# Compares two storage benchmark runs (the `bench` CSV, from boltfs or a raw
+# serial log) and fails when a workload got slower than the threshold, did
+# fewer operations, or stopped succeeding.
+#
+#   scripts/bench_compare.sh <baseline.csv> <current.csv> [threshold%]
+#
+# Workloads faster than MIN_US (default 1000) in the baseline are reported
+# but never fail the check; they are mostly timer noise.
+# ==============================================================================
+
+set -euo pipefail
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 <baseline.csv> <current.csv> [threshold%]" >&2
+    exit 2
+fi
+
+BASELINE="$1"
+CURRENT="$2"
+THRESHOLD="${3:-10}"
+MIN_US="${MIN_US:-1000}"
+
+# The awk below tells the files apart by FNR == NR, which an empty
+# baseline would turn into "the current run is the baseline"
+if [ ! -s "$BASELINE" ]; then
+    echo "[ERROR] Baseline $BASELINE is missing or empty" >&2
+    exit 2
+fi
+
+# Rows are bench,fs,workload,param,ops,bytes,us,ops_per_s,kb_per_s,status;
+# serial logs may carry a CR and other output around them
+awk -F, -v threshold="$THRESHOLD" -v min_us="$MIN_US" '
+    { sub(/\r$/, "") }
+    $1 != "bench" || $2 == "fs" { next }
+    {
+        key = $2 "," $3 "," $4
+        if (FNR == NR) {
+            base_us[key] = $7; base_ops[key] = $5; base_status[key] = $10
+            next
+        }
+        if (!(key in base_us)) {
+            printf "%-36s %10s %10d  new\n", key, "-", $7
+            next
+        }
+        seen[key] = 1
+        change = base_us[key] > 0 ? ($7 - base_us[key]) * 100.0 / base_us[key] : 0
+        verdict = ""
+        if ($10 != base_status[key] && base_status[key] == "ok") verdict = "FAIL status " $10
+        else if ($5 < base_ops[key]) verdict = "FAIL ops " base_ops[key] " -> " $5
+        else if (change > threshold && base_us[key] >= min_us) verdict = "FAIL slower"
+        else if (change > threshold) verdict = "noise"
+        if (verdict ~ /^FAIL/) failed++
+        printf "%-36s %10d %10d %+7.1f%%  %s\n", key, base_us[key], $7, change, verdict
+    }
+    END {
+        for (key in base_us) if (!(key in seen)) { printf "%-36s missing\n", key; failed++ }
+        if (failed) { printf "%d regression(s) over %s%%\n", failed, threshold; exit 1 }
+        printf "no regressions over %s%%\n", threshold
+    }
+' "$BASELINE" "$CURRENT"
@@ -0,0 +1,170 @@
+#!/usr/bin/env bash
+# ==============================================================================
+# BOLT OS - Headless Benchmark Runner (Linux)
+# ==============================================================================
+# Builds the hard disk image, boots a scratch copy of it in QEMU with no
+# display, types shell commands over the serial port and collects the CSV
+# rows they write (bench, membench, bootchart) into a results file.
+#
+#   scripts/bench_qemu.sh [options] [command...]
+#
+#   -o FILE       Results file (default build/bench/<date>.csv); the full
+#                 serial log is kept next to it as FILE.log
+#   -b FILE       Compare against a baseline with bench_compare.sh
+#   -n            Skip the build and use the existing build/harddisk.img
+#   -t SECONDS    Timeout per command (default 900)
+#
+# Commands default to "bench quick" and "membench quick"; the bootchart rows
+# come from the boot itself. QEMU, ACCEL (kvm when /dev/kvm is usable, else
+# tcg), THRESHOLD (default 10) and BOOT_TIMEOUT (default 120) can be set in
+# the environment. Under tcg the numbers only compare with other tcg runs.
+# ==============================================================================
+
+set -euo pipefail
+
+PROJECT_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$PROJECT_ROOT/build"
+
+QEMU="${QEMU:-qemu-system-i386}"
+THRESHOLD="${THRESHOLD:-10}"
+BOOT_TIMEOUT="${BOOT_TIMEOUT:-120}"
+CMD_TIMEOUT=900
+RESULTS=""
+BASELINE=""
+BUILD=1
+
+# The shell mirrors its prompt to serial after boot and after every command
+PROMPT="user@bolt:"
+CSV_ROWS="^(bench|membench|bootchart),"
+
+usage() {
+    sed -n '9,20p' "${BASH_SOURCE[0]}" | sed 's/^# \{0,1\}//' >&2
+    exit 2
+}
+
+while getopts "o:b:nt:h" opt; do
+    case "$opt" in
+        o) RESULTS="$OPTARG" ;;
+        b) BASELINE="$OPTARG" ;;
+        n) BUILD=0 ;;
+        t) CMD_TIMEOUT="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+COMMANDS=("$@")
+if [ ${#COMMANDS[@]} -eq 0 ]; then
+    COMMANDS=("bench quick" "membench quick")
+fi
+
+if [ -z "${ACCEL:-}" ]; then
+    if [ -r /dev/kvm ] && [ -w /dev/kvm ]; then ACCEL=kvm; else ACCEL=tcg; fi
+fi
+
+if [ -z "$RESULTS" ]; then
+    mkdir -p "$BUILD_DIR/bench"
+    RESULTS="$BUILD_DIR/bench/$(date +%Y%m%d-%H%M%S).csv"
+fi
+LOG="$RESULTS.log"
+
+if [ "$BUILD" -eq 1 ]; then
+    "$PROJECT_ROOT/scripts/build.sh"
+fi
+if [ ! -f "$BUILD_DIR/harddisk.img" ]; then
+    echo "[ERROR] build/harddisk.img not found; run scripts/build.sh" >&2
+    exit 1
+fi
+
+# ==============================================================================
+# Boot
+# ==============================================================================
+
+# The benchmarks write to the root volume, so they get a throwaway copy
+WORK="$(mktemp -d)"
+QEMU_PID=""
+READER_PID=""
+
+cleanup() {
+    exec 3>&- 2> /dev/null || true
+    if [ -n "$QEMU_PID" ]; then kill "$QEMU_PID" 2> /dev/null || true; fi
+    if [ -n "$READER_PID" ]; then kill "$READER_PID" 2> /dev/null || true; fi
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+cp "$BUILD_DIR/harddisk.img" "$WORK/disk.img"
+mkfifo "$WORK/serial.in" "$WORK/serial.out"
+
+echo "[QEMU] Booting ($ACCEL), serial log: $LOG"
+"$QEMU" \
+    -accel "$ACCEL" \
+    -m 256 \
+    -cpu pentium3 \
+    -drive file="$WORK/disk.img",format=raw,if=ide,index=0,media=disk \
+    -boot c \
+    -display none \
+    -monitor none \
+    -no-reboot \
+    -serial pipe:"$WORK/serial" &
+QEMU_PID=$!
+
+# QEMU opens both FIFOs read-write; opening ours the same way means
+# neither side blocks on the other
+cat "$WORK/serial.out" > "$LOG" &
+READER_PID=$!
+exec 3<> "$WORK/serial.in"
+
+prompt_count() {
+    grep -ao "$PROMPT" "$LOG" | wc -l
+}
+
+# Wait until the shell has printed its N-th prompt
+wait_prompt() {
+    local want="$1" timeout="$2" waited=0
+    while [ "$(prompt_count)" -lt "$want" ]; do
+        if ! kill -0 "$QEMU_PID" 2> /dev/null; then
+            echo "[ERROR] QEMU exited; see $LOG" >&2
+            return 1
+        fi
+        if [ "$waited" -ge "$timeout" ]; then
+            echo "[ERROR] No prompt after ${timeout}s; see $LOG" >&2
+            return 1
+        fi
+        sleep 1
+        waited=$((waited + 1))
+    done
+}
+
+# ==============================================================================
+# Drive the Shell
+# ==============================================================================
+
+wait_prompt 1 "$BOOT_TIMEOUT"
+
+prompts=1
+for cmd in "${COMMANDS[@]}"; do
+    echo "[RUN ] $cmd"
+    start=$SECONDS
+    printf '%s\r' "$cmd" >&3
+    prompts=$((prompts + 1))
+    wait_prompt "$prompts" "$CMD_TIMEOUT"
+    echo "[DONE] $cmd ($((SECONDS - start))s)"
+done
+
+kill "$QEMU_PID" 2> /dev/null || true
+wait "$QEMU_PID" 2> /dev/null || true
+QEMU_PID=""
+wait "$READER_PID" 2> /dev/null || true
+READER_PID=""
+
+# ==============================================================================
+# Results
+# ==============================================================================
+
+tr -d '\r' < "$LOG" | grep -aE "$CSV_ROWS" > "$RESULTS" || true
+echo "[OK] $(wc -l < "$RESULTS") rows in $RESULTS"
+
+if [ -n "$BASELINE" ]; then
+    "$PROJECT_ROOT/scripts/bench_compare.sh" "$BASELINE" "$RESULTS" "$THRESHOLD"
+fi
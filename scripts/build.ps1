@@ -333,6 +333,7 @@ Write-Host "[INFO] Generated bootloader header with $($bootHddBytes.Length) byte
 $asmFiles = @(
     "core\arch\isr.asm",
     "core\arch\gdt.asm",
+    "core\arch\ap_trampoline.asm",
     "core\sched\context.asm"
 )
 
@@ -364,12 +365,18 @@ $cppFiles = @(
     "core\memory\heap.cpp",
     "core\memory\pmm.cpp",
     "core\memory\vmm.cpp",
+    "core\memory\reclaim.cpp",
+    "core\memory\slab.cpp",
+    "core\memory\membench.cpp",
     # Core - Scheduler
     "core\sched\task.cpp",
     # Core - Architecture
     "core\arch\gdt.cpp",
     "core\arch\idt.cpp",
+    "core\arch\apic.cpp",
+    "core\arch\smp.cpp",
     # Core - System
+    "core\sys\boottrace.cpp",
     "core\sys\events.cpp",
     "core\sys\log.cpp",
     "core\sys\panic.cpp",
@@ -389,6 +396,7 @@ $cppFiles = @(
     # Drivers - Timer
     "drivers\timer\pit.cpp",
     "drivers\timer\rtc.cpp",
+    "drivers\timer\tsc.cpp",
     # Drivers - Serial
     "drivers\serial\serial.cpp",
     # Drivers - Bus
@@ -407,6 +415,7 @@ $cppFiles = @(
     "storage\fat32fs.cpp",
     "storage\ata_device.cpp",
     "storage\storage.cpp",
+    "storage\bench.cpp",
     # Shell
     "shell\shell.cpp",
     "shell\commands\filesystem.cpp",
@@ -464,8 +473,8 @@ if ($LASTEXITCODE -ne 0) { Write-Host "[ERROR] Link failed" -ForegroundColor Red
 $kernelSize = (Get-Item "$BuildDir\kernel.bin").Length
 $sectorsNeeded = [Math]::Ceiling($kernelSize / 512)
 if ($sectorsNeeded -lt 1) { $sectorsNeeded = 1 }
-if ($sectorsNeeded -gt 200) { 
-    Write-Host "[ERROR] Kernel too large ($kernelSize bytes, max ~100KB)" -ForegroundColor Red
+if ($sectorsNeeded -gt 512) { 
+    Write-Host "[ERROR] Kernel too large ($kernelSize bytes, max 512 sectors)" -ForegroundColor Red
     exit 1
 }
 Write-Host "[INFO] Kernel size: $kernelSize bytes ($sectorsNeeded sectors)" -ForegroundColor Gray
@@ -475,8 +484,9 @@ Write-Host "[IMG ] bolt_os.img (floppy)" -ForegroundColor Cyan
 $bootBin = [System.IO.File]::ReadAllBytes("$BuildDir\boot.bin")
 $kernelBin = [System.IO.File]::ReadAllBytes("$BuildDir\kernel.bin")
 
-# Patch the kernel sector count at offset 3 in boot sector
-$bootBin[3] = [byte]$sectorsNeeded
+# Patch the 16-bit kernel sector count at offset 3 in boot sector
+$bootBin[3] = [byte]($sectorsNeeded -band 0xFF)
+$bootBin[4] = [byte]($sectorsNeeded -shr 8)
 Write-Host "[INFO] Patched boot sector: $sectorsNeeded sectors" -ForegroundColor Gray
 
 # Create 1.44MB floppy image
@@ -502,15 +512,16 @@ Write-Host "[IMG ] Creating bootable hard disk..." -ForegroundColor Yellow
 $bootHddBin = [System.IO.File]::ReadAllBytes("$BuildDir\boot_hdd.bin")
 
 # Patch kernel sectors in HDD boot
-$bootHddBin[3] = [byte]$sectorsNeeded
+$bootHddBin[3] = [byte]($sectorsNeeded -band 0xFF)
+$bootHddBin[4] = [byte]($sectorsNeeded -shr 8)
 
 # Calculate layout:
 # - Sector 0: Boot sector
 # - Sectors 1-N: Kernel (N = sectorsNeeded)
 # - Sector N+1 onwards: FAT32 filesystem
-# We'll reserve 256 sectors (128KB) for kernel to allow growth
+# We'll reserve 512 sectors (256KB) for kernel to allow growth
 
-$reservedKernelSectors = 256
+$reservedKernelSectors = 512
 
 # Total disk size: 64MB
 $diskSizeMB = 64
@@ -671,7 +682,8 @@ if ($LASTEXITCODE -ne 0) { Write-Host "[ERROR] CD boot assembly failed" -Foregro
 
 $bootCdBin = [System.IO.File]::ReadAllBytes("$BuildDir\boot_cd.bin")
 # Patch kernel sectors
-$bootCdBin[3] = [byte]$sectorsNeeded
+$bootCdBin[3] = [byte]($sectorsNeeded -band 0xFF)
+$bootCdBin[4] = [byte]($sectorsNeeded -shr 8)
 
 # Create ISO 9660 image with El Torito boot
 # ISO structure:
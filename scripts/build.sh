@@ -0,0 +1,127 @@
+#!/usr/bin/env bash
+# ==============================================================================
+# BOLT OS - Build Script (Linux)
+# ==============================================================================
+# Linux counterpart of build.ps1 for the bootable hard disk: builds the
+# kernel and writes build/harddisk.img (boot sector, kernel in sectors
+# 1-512, FAT32 from sector 513, 64 MB). The floppy and ISO images and
+# bootloader_data.hpp are still produced by build.ps1 only.
+#
+#   scripts/build.sh
+#
+# Needs nasm and mkfs.fat (dosfstools). Uses the i686-elf cross tools when
+# they are on PATH, otherwise the host gcc/binutils with -m32.
+# ==============================================================================
+
+set -euo pipefail
+
+PROJECT_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+KERNEL_DIR="$PROJECT_ROOT/kernel"
+BUILD_DIR="$PROJECT_ROOT/build"
+
+if command -v i686-elf-g++ > /dev/null; then
+    CROSS="${CROSS:-i686-elf-}"
+else
+    CROSS="${CROSS:-}"
+fi
+NASM="${NASM:-nasm}"
+GCC="${CROSS}gcc"
+GXX="${CROSS}g++"
+LD="${CROSS}ld"
+OBJCOPY="${CROSS}objcopy"
+MKFS_FAT="${MKFS_FAT:-mkfs.fat}"
+
+# Same flags as build.ps1
+CFLAGS="-ffreestanding -m32 -Os -fno-pic -fno-stack-protector -mno-red-zone -Wall -Wextra -ffunction-sections -fdata-sections"
+CXXFLAGS="$CFLAGS -fno-exceptions -fno-rtti -fno-use-cxa-atexit"
+
+# Disk layout (see build.ps1)
+DISK_MB=64
+RESERVED_KERNEL_SECTORS=512
+FAT32_START=$((RESERVED_KERNEL_SECTORS + 1))
+
+# build.ps1 owns the source lists; read them from there so both stay in step
+ps1_list() {
+    sed -n "/^\\\$$1 = @(/,/^)/p" "$PROJECT_ROOT/scripts/build.ps1" \
+        | grep -o '"[^"]*"' | tr -d '"' | tr '\\' '/'
+}
+mapfile -t ASM_FILES < <(ps1_list asmFiles)
+mapfile -t CPP_FILES < <(ps1_list cppFiles)
+
+if [ ${#ASM_FILES[@]} -eq 0 ] || [ ${#CPP_FILES[@]} -eq 0 ]; then
+    echo "[ERROR] Could not read the source lists from build.ps1" >&2
+    exit 1
+fi
+
+mkdir -p "$BUILD_DIR"
+
+# ==============================================================================
+# Bootloader
+# ==============================================================================
+
+echo "[ASM ] boot.asm"
+$NASM -f bin "$PROJECT_ROOT/boot.asm" -o "$BUILD_DIR/boot.bin"
+
+# ==============================================================================
+# Kernel
+# ==============================================================================
+
+OBJECTS=("$BUILD_DIR/entry.o")
+
+for file in "${ASM_FILES[@]}"; do
+    obj="$BUILD_DIR/${file%.asm}_asm.o"
+    mkdir -p "$(dirname "$obj")"
+    echo "[ASM ] kernel/$file"
+    $NASM -f elf32 "$KERNEL_DIR/$file" -o "$obj"
+    OBJECTS+=("$obj")
+done
+
+echo "[CC  ] kernel/entry.c"
+$GCC $CFLAGS -c "$KERNEL_DIR/entry.c" -o "$BUILD_DIR/entry.o"
+
+for file in "${CPP_FILES[@]}"; do
+    obj="$BUILD_DIR/${file%.cpp}.o"
+    mkdir -p "$(dirname "$obj")"
+    echo "[CXX ] kernel/$file"
+    $GXX $CXXFLAGS -I"$KERNEL_DIR" -c "$KERNEL_DIR/$file" -o "$obj"
+    OBJECTS+=("$obj")
+done
+
+echo "[LINK] kernel.elf"
+$LD -m elf_i386 --gc-sections -T "$KERNEL_DIR/linker.ld" -o "$BUILD_DIR/kernel.elf" "${OBJECTS[@]}"
+$OBJCOPY -O binary "$BUILD_DIR/kernel.elf" "$BUILD_DIR/kernel.bin"
+
+KERNEL_SIZE=$(stat -c %s "$BUILD_DIR/kernel.bin")
+SECTORS_NEEDED=$(( (KERNEL_SIZE + 511) / 512 ))
+if [ "$SECTORS_NEEDED" -lt 1 ]; then SECTORS_NEEDED=1; fi
+if [ "$SECTORS_NEEDED" -gt "$RESERVED_KERNEL_SECTORS" ]; then
+    echo "[ERROR] Kernel too large ($KERNEL_SIZE bytes, max $RESERVED_KERNEL_SECTORS sectors)" >&2
+    exit 1
+fi
+echo "[INFO] Kernel size: $KERNEL_SIZE bytes ($SECTORS_NEEDED sectors)"
+
+# ==============================================================================
+# Bootable Hard Disk Image
+# ==============================================================================
+
+IMAGE="$BUILD_DIR/harddisk.img"
+echo "[IMG ] harddisk.img (${DISK_MB} MB, FAT32 at sector $FAT32_START)"
+
+rm -f "$IMAGE"
+truncate -s "${DISK_MB}M" "$IMAGE"
+
+# Boot sector with the 16-bit kernel sector count patched in at offset 3
+dd if="$BUILD_DIR/boot.bin" of="$IMAGE" bs=512 count=1 conv=notrunc status=none
+printf "$(printf '\\x%02x\\x%02x' $((SECTORS_NEEDED & 0xFF)) $((SECTORS_NEEDED >> 8)))" \
+    | dd of="$IMAGE" bs=1 seek=3 conv=notrunc status=none
+
+# Kernel from sector 1
+dd if="$BUILD_DIR/kernel.bin" of="$IMAGE" bs=512 seek=1 conv=notrunc status=none
+
+# FAT32 over the rest: 512-byte clusters, 32 reserved sectors, 2 FATs;
+# the block count is in KB
+FAT32_SECTORS=$(( DISK_MB * 2048 - FAT32_START ))
+$MKFS_FAT -F 32 -s 1 -R 32 -f 2 -h "$FAT32_START" --offset "$FAT32_START" \
+    -n "BOLT DRIVE" "$IMAGE" $(( FAT32_SECTORS / 2 )) > /dev/null
+
+echo "[OK] build/harddisk.img"
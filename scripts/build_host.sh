@@ -0,0 +1,103 @@
+#!/usr/bin/env bash
+# ==============================================================================
+# BOLT OS - Host Build Script (Linux)
+# ==============================================================================
+# Builds the kernel storage stack (VFS, FAT32, RAMFS, partitions, detection)
+# as a native Linux program, build/host/boltfs, on top of the shims in host/,
+# plus build/host/membench, which runs the allocator traces against the
+# kernel's own Heap and PMM.
+#
+#   scripts/build_host.sh [debug|release|asan]
+#
+# Example:
+#   mkfs.vfat -F 32 -C /tmp/disk.img 65536
+#   build/host/boltfs /tmp/disk.img workload 64 256
+#
+# Reclaim under the asan build (shrinkers run on every allocation):
+#   BOLT_LOW_WATER=1 build/host/boltfs /tmp/disk.img workload 2000 1
+#
+# Allocator invariants checked after every operation:
+#   build/host/membench quick stress
+# ==============================================================================
+
+set -euo pipefail
+
+PROJECT_ROOT="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+KERNEL_DIR="$PROJECT_ROOT/kernel"
+HOST_DIR="$PROJECT_ROOT/host"
+BUILD_DIR="$PROJECT_ROOT/build/host"
+
+CXX="${CXX:-g++}"
+MODE="${1:-release}"
+
+# Same language subset as the kernel build; the kernel's packed on-disk
+# structs trip -Waddress-of-packed-member on 64-bit hosts
+CXXFLAGS="-std=c++17 -g -Wall -Wextra -fno-exceptions -fno-rtti -Wno-address-of-packed-member"
+case "$MODE" in
+    release) CXXFLAGS="$CXXFLAGS -O2" ;;
+    debug)   CXXFLAGS="$CXXFLAGS -O0" ;;
+    asan)    CXXFLAGS="$CXXFLAGS -O1 -fsanitize=address,undefined -fno-omit-frame-pointer" ;;
+    *)       echo "usage: $0 [debug|release|asan]" >&2; exit 2 ;;
+esac
+# BOLT_HOST swaps in host/host_spinlock.hpp and moves the heap window
+# below ASan's shadow
+CXXFLAGS="$CXXFLAGS -DBOLT_HOST -I$KERNEL_DIR -I$HOST_DIR"
+
+# Sources (from the project root) shared by both programs
+COMMON_SOURCES=(
+    "kernel/lib/string.cpp"
+    "kernel/core/memory/reclaim.cpp"
+    "kernel/core/memory/membench.cpp"
+    "host/shim.cpp"
+)
+
+# The storage stack, built unchanged, on a malloc heap
+BOLTFS_SOURCES=(
+    "kernel/storage/bench.cpp"
+    "kernel/storage/block.cpp"
+    "kernel/storage/detect.cpp"
+    "kernel/storage/partition.cpp"
+    "kernel/storage/fat32fs.cpp"
+    "kernel/storage/ramfs.cpp"
+    "kernel/storage/vfs.cpp"
+    "host/image_device.cpp"
+    "host/malloc_heap.cpp"
+)
+
+# The kernel's own allocators on an mmap'd arena
+MEMBENCH_SOURCES=(
+    "kernel/core/memory/heap.cpp"
+    "kernel/core/memory/pmm.cpp"
+    "host/kernel_mem.cpp"
+)
+
+mkdir -p "$BUILD_DIR/obj"
+
+# compile <array> <sources...>: objects are named after their path and
+# appended to the named array
+compile() {
+    local -n objects="$1"
+    shift
+    local src obj
+    for src in "$@"; do
+        obj="$BUILD_DIR/obj/$(echo "${src%.cpp}" | tr '/' '_').o"
+        echo "  CXX  $src"
+        $CXX $CXXFLAGS -c "$PROJECT_ROOT/$src" -o "$obj"
+        objects+=("$obj")
+    done
+}
+
+COMMON_OBJECTS=()
+BOLTFS_OBJECTS=()
+MEMBENCH_OBJECTS=()
+compile COMMON_OBJECTS "${COMMON_SOURCES[@]}"
+compile BOLTFS_OBJECTS "${BOLTFS_SOURCES[@]}"
+compile MEMBENCH_OBJECTS "${MEMBENCH_SOURCES[@]}"
+
+echo "  LD   build/host/boltfs"
+$CXX $CXXFLAGS "$HOST_DIR/boltfs.cpp" "${COMMON_OBJECTS[@]}" "${BOLTFS_OBJECTS[@]}" -o "$BUILD_DIR/boltfs"
+
+echo "  LD   build/host/membench"
+$CXX $CXXFLAGS "$HOST_DIR/membench.cpp" "${COMMON_OBJECTS[@]}" "${MEMBENCH_OBJECTS[@]}" -o "$BUILD_DIR/membench"
+
+echo "[OK] build/host/boltfs build/host/membench ($MODE)"
@@ -17,7 +17,7 @@ $SerialLog = Join-Path $BuildDir "serial.log"
 
 $QEMU = "C:\Program Files\qemu\qemu-system-i386.exe"
 
-# Function to check if harddisk has a bootable OS (FAT32 at sector 257)
+# Function to check if harddisk has a bootable OS (FAT32 at sector 513)
 function Test-BootableHardDisk {
     param($diskPath)
     
@@ -35,11 +35,12 @@ function Test-BootableHardDisk {
             return $false
         }
         
-        # Check FAT32 at sector 257 (our boot+kernel layout)
-        # Sector 257 = byte offset 257 * 512 = 131584
-        $fat32Offset = 257 * 512
+        # Check FAT32 at sector 513 (our boot+kernel layout)
+        # Sector 513 = byte offset 513 * 512 = 262656
+        # Older disks with FAT32 at 257 can't hold the current kernel
+        $fat32Offset = 513 * 512
         
-        # Check boot signature at sector 257
+        # Check boot signature at sector 513
         $fs.Seek($fat32Offset + 510, [System.IO.SeekOrigin]::Begin) | Out-Null
         $sig1 = $fs.ReadByte()
         $sig2 = $fs.ReadByte()